@@ -278,6 +278,64 @@ int cloud_encode_light_sensor_data(const struct light_sensor_data *sensor_data,
 				   struct cloud_msg *output);
 #endif /* CONFIG_LIGHT_SENSOR */
 
+/** Keys of the CBOR map a message is encoded as. The values of the channel
+ *  and group items are the values of @ref cloud_channel and
+ *  @ref cloud_cmd_group, the decoder on the cloud side depends on them.
+ */
+#define CLOUD_CBOR_KEY_CHANNEL 0
+#define CLOUD_CBOR_KEY_DATA 1
+#define CLOUD_CBOR_KEY_GROUP 2
+
+/**
+ * @brief Check if data of a channel is encoded as CBOR.
+ *
+ * @param channel The cloud channel type.
+ *
+ * @return true If CBOR encoding is enabled for the channel.
+ */
+bool cloud_encode_cbor_enabled(const enum cloud_channel channel);
+
+/**
+ * @brief Encode cloud data as CBOR, without allocating memory.
+ *
+ * The message is a map of the channel, the data as a text string, and the
+ * group, see CLOUD_CBOR_KEY_CHANNEL. The output points to the buffer, and
+ * must not be released with @ref cloud_release_data.
+ *
+ * @param channel The cloud channel type.
+ * @param group The channel data's group.
+ * @param buf Buffer to encode the message into.
+ * @param size Size of the buffer.
+ * @param output Pointer to the cloud data output.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If a parameter is invalid.
+ * @retval -ENOMEM If the buffer is too small.
+ */
+int cloud_encode_data_cbor(const struct cloud_channel_data *channel,
+			   const enum cloud_cmd_group group,
+			   uint8_t *buf, size_t size,
+			   struct cloud_msg *output);
+
+/**
+ * @brief Encode environment sensor data as CBOR, without allocating memory.
+ *
+ * Same as @ref cloud_encode_data_cbor, with the value encoded as a
+ * single-precision float instead of a text string.
+ *
+ * @param sensor_data Environment sensor sample.
+ * @param buf Buffer to encode the message into.
+ * @param size Size of the buffer.
+ * @param output Pointer to the cloud data output.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If a parameter is invalid.
+ * @retval -ENOMEM If the buffer is too small.
+ */
+int cloud_encode_env_sensors_data_cbor(const env_sensor_data_t *sensor_data,
+				       uint8_t *buf, size_t size,
+				       struct cloud_msg *output);
+
 /**
  * @brief Checks if data could be sent to the cloud based on config.
  *
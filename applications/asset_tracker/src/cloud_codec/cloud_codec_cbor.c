@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <zephyr.h>
+#include <tinycbor/cbor.h>
+#include <tinycbor/cbor_buf_writer.h>
+
+#include "cloud_codec.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(cloud_codec_cbor, CONFIG_ASSET_TRACKER_LOG_LEVEL);
+
+typedef CborError (*cbor_data_encode_t)(CborEncoder *encoder,
+					const void *data);
+
+bool cloud_encode_cbor_enabled(const enum cloud_channel channel)
+{
+	switch (channel) {
+	case CLOUD_CHANNEL_GPS:
+		return IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR_GPS);
+	case CLOUD_CHANNEL_BUTTON:
+		return IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR_BUTTON);
+	case CLOUD_CHANNEL_LTE_LINK_RSRP:
+		return IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR_RSRP);
+	case CLOUD_CHANNEL_TEMP:
+	case CLOUD_CHANNEL_HUMID:
+	case CLOUD_CHANNEL_AIR_PRESS:
+	case CLOUD_CHANNEL_AIR_QUAL:
+		return IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR_ENVIRONMENT);
+	default:
+		return false;
+	}
+}
+
+static int cbor_msg_encode(enum cloud_channel channel,
+			   enum cloud_cmd_group group,
+			   cbor_data_encode_t data_encode, const void *data,
+			   uint8_t *buf, size_t size, struct cloud_msg *output)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder encoder;
+	CborEncoder map;
+	CborError err;
+
+	cbor_buf_writer_init(&writer, buf, size);
+	cbor_encoder_init(&encoder, &writer.enc, 0);
+
+	err = cbor_encoder_create_map(&encoder, &map, 3);
+	err |= cbor_encode_uint(&map, CLOUD_CBOR_KEY_CHANNEL);
+	err |= cbor_encode_uint(&map, channel);
+	err |= cbor_encode_uint(&map, CLOUD_CBOR_KEY_DATA);
+	err |= data_encode(&map, data);
+	err |= cbor_encode_uint(&map, CLOUD_CBOR_KEY_GROUP);
+	err |= cbor_encode_uint(&map, group);
+	err |= cbor_encoder_close_container(&encoder, &map);
+
+	if (err == CborErrorOutOfMemory) {
+		LOG_WRN("%zu byte buffer too small for channel %d", size,
+			channel);
+		return -ENOMEM;
+	} else if (err != CborNoError) {
+		LOG_ERR("CBOR encoding failed, error %d", err);
+		return -EINVAL;
+	}
+
+	output->buf = (char *)buf;
+	output->len = writer.ptr - buf;
+
+	return 0;
+}
+
+static CborError text_encode(CborEncoder *encoder, const void *data)
+{
+	const struct cloud_data *text = data;
+
+	return cbor_encode_text_string(encoder, text->buf, text->len);
+}
+
+static CborError float_encode(CborEncoder *encoder, const void *data)
+{
+	return cbor_encode_float(encoder, *(const float *)data);
+}
+
+int cloud_encode_data_cbor(const struct cloud_channel_data *channel,
+			   const enum cloud_cmd_group group,
+			   uint8_t *buf, size_t size,
+			   struct cloud_msg *output)
+{
+	if (channel == NULL || channel->data.buf == NULL ||
+	    channel->data.len == 0 || buf == NULL || output == NULL ||
+	    channel->type >= CLOUD_CHANNEL__TOTAL ||
+	    group >= CLOUD_CMD_GROUP__TOTAL) {
+		return -EINVAL;
+	}
+
+	return cbor_msg_encode(channel->type, group, text_encode,
+			       &channel->data, buf, size, output);
+}
+
+int cloud_encode_env_sensors_data_cbor(const env_sensor_data_t *sensor_data,
+				       uint8_t *buf, size_t size,
+				       struct cloud_msg *output)
+{
+	enum cloud_channel channel;
+	float value;
+
+	if (sensor_data == NULL || buf == NULL || output == NULL) {
+		return -EINVAL;
+	}
+
+	switch (sensor_data->type) {
+	case ENV_SENSOR_TEMPERATURE:
+		channel = CLOUD_CHANNEL_TEMP;
+		break;
+
+	case ENV_SENSOR_HUMIDITY:
+		channel = CLOUD_CHANNEL_HUMID;
+		break;
+
+	case ENV_SENSOR_AIR_PRESSURE:
+		channel = CLOUD_CHANNEL_AIR_PRESS;
+		break;
+
+	case ENV_SENSOR_AIR_QUALITY:
+		channel = CLOUD_CHANNEL_AIR_QUAL;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	value = (float)sensor_data->value;
+
+	return cbor_msg_encode(channel, CLOUD_CMD_GROUP_DATA, float_encode,
+			       &value, buf, size, output);
+}
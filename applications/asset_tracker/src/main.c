@@ -20,6 +20,7 @@
 #include <modem/modem_info.h>
 #endif /* CONFIG_BSD_LIBRARY */
 #include <net/cloud.h>
+#include <net/cloud_queue.h>
 #include <net/socket.h>
 #include <net/nrf_cloud.h>
 #if defined(CONFIG_NRF_CLOUD_AGPS)
@@ -201,6 +202,8 @@ static void device_status_send(struct k_work *work);
 static void cycle_cloud_connection(struct k_work *work);
 static void set_gps_enable(const bool enable);
 static bool data_send_enabled(void);
+static bool sensor_data_send_enabled(void);
+static void queue_send_update(void);
 static void connection_evt_handler(const struct cloud_event *const evt);
 static void no_sim_go_offline(struct k_work *work);
 
@@ -479,6 +482,32 @@ void bsd_recoverable_error_handler(uint32_t err)
 	error_handler(ERROR_BSD_RECOVERABLE, (int)err);
 }
 
+/**@brief Send a message, or store it to be sent with the next messages. */
+static int msg_send(struct cloud_msg *msg,
+		    enum cloud_queue_priority priority)
+{
+#if defined(CONFIG_CLOUD_QUEUE)
+	return cloud_queue_add(msg, priority, CONFIG_CLOUD_QUEUE_DATA_TTL);
+#else
+	ARG_UNUSED(priority);
+
+	return cloud_send(cloud_backend, msg);
+#endif
+}
+
+static enum cloud_queue_priority sensor_data_priority(
+					enum cloud_channel type)
+{
+	switch (type) {
+	case CLOUD_CHANNEL_BUTTON:
+		return CLOUD_QUEUE_PRIORITY_HIGH;
+	case CLOUD_CHANNEL_GPS:
+		return CLOUD_QUEUE_PRIORITY_NORMAL;
+	default:
+		return CLOUD_QUEUE_PRIORITY_LOW;
+	}
+}
+
 static void send_gps_data_work_fn(struct k_work *work)
 {
 	sensor_data_send(&gps_cloud_data);
@@ -628,17 +657,20 @@ static void gps_handler(struct device *dev, struct gps_event *evt)
 	case GPS_EVT_SEARCH_STARTED:
 		LOG_INF("GPS_EVT_SEARCH_STARTED");
 		gps_control_set_active(true);
+		queue_send_update();
 		ui_led_set_pattern(UI_LED_GPS_SEARCHING);
 		gps_last_search_start_time = k_uptime_get();
 		break;
 	case GPS_EVT_SEARCH_STOPPED:
 		LOG_INF("GPS_EVT_SEARCH_STOPPED");
 		gps_control_set_active(false);
+		queue_send_update();
 		ui_led_set_pattern(UI_CLOUD_CONNECTED);
 		break;
 	case GPS_EVT_SEARCH_TIMEOUT:
 		LOG_INF("GPS_EVT_SEARCH_TIMEOUT");
 		gps_control_set_active(false);
+		queue_send_update();
 		LOG_INF("GPS will be attempted again in %d seconds",
 			gps_control_get_gps_reporting_interval());
 		break;
@@ -668,6 +700,7 @@ static void gps_handler(struct device *dev, struct gps_event *evt)
 				gps_last_search_start_time) / 1000;
 		ui_led_set_pattern(UI_LED_GPS_FIX);
 		gps_control_set_active(false);
+		queue_send_update();
 		LOG_INF("GPS will be started in %lld seconds",
 			CONFIG_GPS_CONTROL_FIX_TRY_TIME -
 			gps_time_from_start_to_fix_seconds +
@@ -820,8 +853,7 @@ static void motion_data_send(struct k_work *work)
 {
 	ARG_UNUSED(work);
 
-	if (!flip_mode_enabled || !data_send_enabled() ||
-	    gps_control_is_active()) {
+	if (!flip_mode_enabled || !sensor_data_send_enabled()) {
 		return;
 	}
 
@@ -833,7 +865,7 @@ static void motion_data_send(struct k_work *work)
 	int err = 0;
 
 	if (cloud_encode_motion_data(&last_motion_data, &msg) == 0) {
-		err = cloud_send(cloud_backend, &msg);
+		err = msg_send(&msg, CLOUD_QUEUE_PRIORITY_NORMAL);
 		cloud_release_data(&msg);
 		if (err) {
 			LOG_ERR("Transmisison of motion data failed: %d", err);
@@ -1102,16 +1134,52 @@ static void device_config_send(struct k_work *work)
 	}
 }
 
-/**@brief Get environment data from sensors and send to cloud. */
-static void env_data_send(void)
+/**@brief Encode and send an environment sensor sample, if allowed by the
+ * channel configuration.
+ */
+static int env_sample_send(const env_sensor_data_t *env_data,
+			   enum cloud_channel channel)
 {
 	int err;
-	env_sensor_data_t env_data;
 	struct cloud_msg msg = {
 		.qos = CLOUD_QOS_AT_MOST_ONCE,
 		.endpoint.type = CLOUD_EP_TOPIC_MSG
 	};
 
+	if (!cloud_is_send_allowed(channel, env_data->value)) {
+		return 0;
+	}
+
+#if defined(CONFIG_CLOUD_CODEC_CBOR)
+	if (cloud_encode_cbor_enabled(channel)) {
+		uint8_t buf[CONFIG_CLOUD_CODEC_CBOR_BUF_SIZE];
+
+		if (cloud_encode_env_sensors_data_cbor(env_data, buf,
+						       sizeof(buf), &msg)) {
+			return 0;
+		}
+
+		return msg_send(&msg, CLOUD_QUEUE_PRIORITY_LOW);
+	}
+#endif
+
+	if (cloud_encode_env_sensors_data(env_data, &msg)) {
+		return 0;
+	}
+
+	err = msg_send(&msg, CLOUD_QUEUE_PRIORITY_LOW);
+	cloud_release_data(&msg);
+
+	return err;
+}
+
+/**@brief Get environment data from sensors and send to cloud. */
+static void env_data_send(void)
+{
+	int err;
+	env_sensor_data_t env_data;
+
+#if !defined(CONFIG_CLOUD_QUEUE)
 	if (!data_send_enabled()) {
 		return;
 	}
@@ -1122,51 +1190,33 @@ static void env_data_send(void)
 	}
 
 	env_sensors_set_backoff_enable(false);
+#endif
 
 	if (env_sensors_get_temperature(&env_data) == 0) {
-		if (cloud_is_send_allowed(CLOUD_CHANNEL_TEMP, env_data.value) &&
-		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
-			cloud_release_data(&msg);
-			if (err) {
-				goto error;
-			}
+		err = env_sample_send(&env_data, CLOUD_CHANNEL_TEMP);
+		if (err) {
+			goto error;
 		}
 	}
 
 	if (env_sensors_get_humidity(&env_data) == 0) {
-		if (cloud_is_send_allowed(CLOUD_CHANNEL_HUMID,
-					  env_data.value) &&
-		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
-			cloud_release_data(&msg);
-			if (err) {
-				goto error;
-			}
+		err = env_sample_send(&env_data, CLOUD_CHANNEL_HUMID);
+		if (err) {
+			goto error;
 		}
 	}
 
 	if (env_sensors_get_pressure(&env_data) == 0) {
-		if (cloud_is_send_allowed(CLOUD_CHANNEL_AIR_PRESS,
-					  env_data.value) &&
-		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
-			cloud_release_data(&msg);
-			if (err) {
-				goto error;
-			}
+		err = env_sample_send(&env_data, CLOUD_CHANNEL_AIR_PRESS);
+		if (err) {
+			goto error;
 		}
 	}
 
 	if (env_sensors_get_air_quality(&env_data) == 0) {
-		if (cloud_is_send_allowed(CLOUD_CHANNEL_AIR_QUAL,
-					  env_data.value) &&
-		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
-			cloud_release_data(&msg);
-			if (err) {
-				goto error;
-			}
+		err = env_sample_send(&env_data, CLOUD_CHANNEL_AIR_QUAL);
+		if (err) {
+			goto error;
 		}
 	}
 
@@ -1184,7 +1234,7 @@ void light_sensor_data_send(void)
 	struct cloud_msg msg = { .qos = CLOUD_QOS_AT_MOST_ONCE,
 				 .endpoint.type = CLOUD_EP_TOPIC_MSG };
 
-	if (!data_send_enabled() || gps_control_is_active()) {
+	if (!sensor_data_send_enabled()) {
 		return;
 	}
 
@@ -1209,7 +1259,7 @@ void light_sensor_data_send(void)
 		return;
 	}
 
-	err = cloud_send(cloud_backend, &msg);
+	err = msg_send(&msg, CLOUD_QUEUE_PRIORITY_LOW);
 	cloud_release_data(&msg);
 
 	if (err) {
@@ -1229,15 +1279,36 @@ static void sensor_data_send(struct cloud_channel_data *data)
 			.endpoint.type = CLOUD_EP_TOPIC_MSG
 		};
 
-	if (!data_send_enabled() || gps_control_is_active()) {
+	if (!sensor_data_send_enabled()) {
 		return;
 	}
 
+#if defined(CONFIG_CLOUD_CODEC_CBOR)
+	if (cloud_encode_cbor_enabled(data->type)) {
+		uint8_t buf[CONFIG_CLOUD_CODEC_CBOR_BUF_SIZE];
+
+		err = cloud_encode_data_cbor(data, CLOUD_CMD_GROUP_DATA, buf,
+					     sizeof(buf), &msg);
+		if (err) {
+			LOG_ERR("Unable to encode cloud data: %d", err);
+			return;
+		}
+
+		err = msg_send(&msg, sensor_data_priority(data->type));
+		if (err) {
+			LOG_ERR("%s failed, data was not sent: %d", __func__,
+			err);
+		}
+
+		return;
+	}
+#endif
+
 	err = cloud_encode_data(data, CLOUD_CMD_GROUP_DATA, &msg);
 	if (err) {
 		LOG_ERR("Unable to encode cloud data: %d", err);
 	} else {
-		err = cloud_send(cloud_backend, &msg);
+		err = msg_send(&msg, sensor_data_priority(data->type));
 		cloud_release_data(&msg);
 		if (err) {
 			LOG_ERR("%s failed, data was not sent: %d", __func__,
@@ -1258,6 +1329,27 @@ static bool data_send_enabled(void)
 		   CLOUD_ASSOCIATION_STATE_READY);
 }
 
+/**@brief Check if sensor data can be sent, or stored to be sent later. */
+static bool sensor_data_send_enabled(void)
+{
+#if defined(CONFIG_CLOUD_QUEUE)
+	return true;
+#else
+	return data_send_enabled() && !gps_control_is_active();
+#endif
+}
+
+/**@brief Send queued data only when the cloud is ready and GPS is not
+ *	  searching, sending would interrupt the search.
+ */
+static void queue_send_update(void)
+{
+#if defined(CONFIG_CLOUD_QUEUE)
+	cloud_queue_send_enable(data_send_enabled() &&
+				!gps_control_is_active());
+#endif
+}
+
 /**@brief Callback for sensor attached event from nRF Cloud. */
 void sensors_start(void)
 {
@@ -1364,6 +1456,7 @@ void cloud_event_handler(const struct cloud_backend *const backend,
 		boot_write_img_confirmed();
 #endif
 		atomic_set(&cloud_association, CLOUD_ASSOCIATION_STATE_READY);
+		queue_send_update();
 		sensors_start();
 		break;
 	case CLOUD_EVT_ERROR:
@@ -1397,6 +1490,49 @@ void cloud_event_handler(const struct cloud_backend *const backend,
 #endif /* defined(CONFIG_GPS_USE_AGPS) */
 		break;
 	}
+#if defined(CONFIG_NRF_CLOUD_AGPS)
+	case CLOUD_EVT_DATA_RECEIVED_CHUNK: {
+		static bool agps_chunks;
+		int err;
+		const struct cloud_msg_chunk *chunk = &evt->data.chunk;
+
+		if (chunk->offset == 0) {
+			agps_chunks = (chunk->err == 0) &&
+				nrf_cloud_agps_is_agps_data(chunk->msg.buf,
+							    chunk->msg.len);
+			if (!agps_chunks) {
+				LOG_WRN("Message received in chunks dropped");
+				break;
+			}
+		} else if (!agps_chunks) {
+			break;
+		}
+
+		if (chunk->err) {
+			LOG_WRN("A-GPS data not received, err: %d", chunk->err);
+			nrf_cloud_agps_process_abort();
+			agps_chunks = false;
+			break;
+		}
+
+		err = nrf_cloud_agps_process_chunk(chunk->msg.buf,
+						   chunk->msg.len,
+						   chunk->offset,
+						   chunk->total_len,
+						   NULL);
+		if (err == -ECANCELED) {
+			break;
+		} else if (err) {
+			LOG_WRN("Data was not valid A-GPS data, err: %d", err);
+			break;
+		}
+
+		if (chunk->offset + chunk->msg.len == chunk->total_len) {
+			LOG_INF("A-GPS data processed");
+		}
+		break;
+	}
+#endif /* defined(CONFIG_NRF_CLOUD_AGPS) */
 	case CLOUD_EVT_PAIR_REQUEST:
 		LOG_INF("CLOUD_EVT_PAIR_REQUEST");
 		on_user_pairing_req(evt);
@@ -1443,6 +1579,9 @@ void connection_evt_handler(const struct cloud_event *const evt)
 
 		LOG_INF("CLOUD_EVT_DISCONNECTED: %d", evt->data.err);
 		ui_led_set_pattern(UI_LTE_CONNECTED);
+#if defined(CONFIG_CLOUD_QUEUE)
+		cloud_queue_send_enable(false);
+#endif
 
 		switch (evt->data.err) {
 		case CLOUD_DISCONNECT_INVALID_REQUEST:
@@ -1571,6 +1710,15 @@ static void cloud_api_init(void)
 		cloud_error_handler(ret);
 	}
 
+#if defined(CONFIG_CLOUD_QUEUE)
+	ret = cloud_queue_init(cloud_backend);
+	if (ret) {
+		LOG_ERR("Cloud queue could not be initialized, error: %d",
+			ret);
+		cloud_error_handler(ret);
+	}
+#endif
+
 	ret = cloud_decode_init(cloud_cmd_handler);
 	if (ret) {
 		LOG_ERR("Cloud command decoder could not be initialized, error: %d",
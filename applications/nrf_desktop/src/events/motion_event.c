@@ -26,6 +26,26 @@ static void profile_motion_event(struct log_event_buf *buf,
 }
 
 
+static bool merge_motion_event(struct event_header *pending,
+			       const struct event_header *eh)
+{
+	struct motion_event *dst = cast_motion_event(pending);
+	const struct motion_event *src = cast_motion_event(eh);
+	int32_t dx = (int32_t)dst->dx + src->dx;
+	int32_t dy = (int32_t)dst->dy + src->dy;
+
+	if ((dx < INT16_MIN) || (dx > INT16_MAX) ||
+	    (dy < INT16_MIN) || (dy > INT16_MAX)) {
+		return false;
+	}
+
+	dst->dx = dx;
+	dst->dy = dy;
+
+	return true;
+}
+
+
 EVENT_INFO_DEFINE(motion_event,
 		  ENCODE(PROFILER_ARG_S32, PROFILER_ARG_S32),
 		  ENCODE("dx", "dy"),
@@ -34,4 +54,5 @@ EVENT_INFO_DEFINE(motion_event,
 EVENT_TYPE_DEFINE(motion_event,
 		  IS_ENABLED(CONFIG_DESKTOP_INIT_LOG_MOTION_EVENT),
 		  log_motion_event,
-		  &motion_event_info);
+		  &motion_event_info,
+		  EVENT_ATTR_COALESCE(merge_motion_event));
@@ -16,7 +16,24 @@ static int log_wheel_event(const struct event_header *eh, char *buf,
 	return snprintf(buf, buf_len, "wheel=%d", event->wheel);
 }
 
+static bool merge_wheel_event(struct event_header *pending,
+			      const struct event_header *eh)
+{
+	struct wheel_event *dst = cast_wheel_event(pending);
+	const struct wheel_event *src = cast_wheel_event(eh);
+	int32_t wheel = (int32_t)dst->wheel + src->wheel;
+
+	if ((wheel < INT16_MIN) || (wheel > INT16_MAX)) {
+		return false;
+	}
+
+	dst->wheel = wheel;
+
+	return true;
+}
+
 EVENT_TYPE_DEFINE(wheel_event,
 		  IS_ENABLED(CONFIG_DESKTOP_INIT_LOG_WHEEL_EVENT),
 		  log_wheel_event,
-		  NULL);
+		  NULL,
+		  EVENT_ATTR_COALESCE(merge_wheel_event));
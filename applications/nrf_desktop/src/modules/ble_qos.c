@@ -358,6 +358,7 @@ static void ble_chn_stats_print(bool update_channel_map)
 	send_uart_data(cdc_dev, str, str_len);
 }
 
+#if CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE
 static void hid_pkt_stats_print(uint32_t ble_recv)
 {
 	static uint32_t prev_ble;
@@ -404,6 +405,7 @@ static void hid_pkt_stats_print(uint32_t ble_recv)
 	}
 	send_uart_data(cdc_dev, str, str_len);
 }
+#endif /* CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE */
 
 static bool on_vs_evt(struct net_buf_simple *buf)
 {
@@ -628,92 +630,91 @@ static void fetch_config(const uint8_t opt_id, uint8_t *data, size_t *size)
 	}
 }
 
-static bool event_handler(const struct event_header *eh)
+#if CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE
+static bool handle_hid_report_event(const struct hid_report_event *event)
 {
-	if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE) &&
-	    IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT)) {
+	if (IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT)) {
 		static int32_t hid_pkt_recv_count;
 		static uint32_t cdc_notify_count;
 
 		/* Count number of HID packets received via BLE. */
 		/* Send stats printout via CDC every 100 packets. */
+		hid_pkt_recv_count++;
+		cdc_notify_count++;
 
-		if (is_hid_report_event(eh)) {
-			hid_pkt_recv_count++;
-			cdc_notify_count++;
-
-			if (cdc_notify_count == 100) {
-				hid_pkt_stats_print(hid_pkt_recv_count);
-				cdc_notify_count = 0;
-			}
-
-			return false;
+		if (cdc_notify_count == 100) {
+			hid_pkt_stats_print(hid_pkt_recv_count);
+			cdc_notify_count = 0;
 		}
 	}
 
-	if (is_module_state_event(eh)) {
-		const struct module_state_event *event =
-			cast_module_state_event(eh);
-
-		if (check_state(
-			    event,
-			    MODULE_ID(main),
-			    MODULE_STATE_READY)) {
-			static bool initialized;
-			int err;
+	return false;
+}
+#endif /* CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE */
 
-			__ASSERT_NO_MSG(!initialized);
+static bool handle_module_state_event(const struct module_state_event *event)
+{
+	if (check_state(
+		    event,
+		    MODULE_ID(main),
+		    MODULE_STATE_READY)) {
+		static bool initialized;
+		int err;
 
-			initialized = true;
+		__ASSERT_NO_MSG(!initialized);
 
-			chmap_filter_init();
+		initialized = true;
 
-			chmap_inst =
-				(struct chmap_instance *) chmap_instance_buf;
-			err = chmap_filter_instance_init(
-				chmap_inst,
-				sizeof(chmap_instance_buf));
-			if (err) {
-				LOG_ERR("Failed to initialize filter");
-				module_set_state(MODULE_STATE_ERROR);
-				return false;
-			}
+		chmap_filter_init();
 
-			LOG_DBG("Chmap lib version: %s",
-				chmap_filter_version());
+		chmap_inst =
+			(struct chmap_instance *) chmap_instance_buf;
+		err = chmap_filter_instance_init(
+			chmap_inst,
+			sizeof(chmap_instance_buf));
+		if (err) {
+			LOG_ERR("Failed to initialize filter");
+			module_set_state(MODULE_STATE_ERROR);
+			return false;
+		}
 
-			chmap_filter_params_get(chmap_inst, &filter_params);
+		LOG_DBG("Chmap lib version: %s",
+			chmap_filter_version());
 
-			k_mutex_init(&data_access_mutex);
-			new_blacklist = INVALID_BLACKLIST;
-			atomic_set(&params_updated, false);
+		chmap_filter_params_get(chmap_inst, &filter_params);
 
-			if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE)) {
-				cdc_dev = device_get_binding(
-					USB_SERIAL_DEVICE_NAME "_0");
-				__ASSERT_NO_MSG(cdc_dev != NULL);
-				/* CONFIG_UART_LINE_CTRL == 1: dynamic dtr */
-				cdc_dtr = !IS_ENABLED(CONFIG_UART_LINE_CTRL);
-			}
+		k_mutex_init(&data_access_mutex);
+		new_blacklist = INVALID_BLACKLIST;
+		atomic_set(&params_updated, false);
 
-			k_thread_create(&thread, thread_stack,
-					THREAD_STACK_SIZE,
-					(k_thread_entry_t)ble_qos_thread_fn,
-					NULL, NULL, NULL,
-					THREAD_PRIORITY, 0, K_NO_WAIT);
-			k_thread_name_set(&thread, MODULE_NAME "_thread");
+		if (IS_ENABLED(CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE)) {
+			cdc_dev = device_get_binding(
+				USB_SERIAL_DEVICE_NAME "_0");
+			__ASSERT_NO_MSG(cdc_dev != NULL);
+			/* CONFIG_UART_LINE_CTRL == 1: dynamic dtr */
+			cdc_dtr = !IS_ENABLED(CONFIG_UART_LINE_CTRL);
 		}
 
-		if (check_state(
-			    event,
-			    MODULE_ID(ble_state),
-			    MODULE_STATE_READY)) {
-			enable_qos_reporting();
-		}
+		k_thread_create(&thread, thread_stack,
+				THREAD_STACK_SIZE,
+				(k_thread_entry_t)ble_qos_thread_fn,
+				NULL, NULL, NULL,
+				THREAD_PRIORITY, 0, K_NO_WAIT);
+		k_thread_name_set(&thread, MODULE_NAME "_thread");
+	}
 
-		return false;
+	if (check_state(
+		    event,
+		    MODULE_ID(ble_state),
+		    MODULE_STATE_READY)) {
+		enable_qos_reporting();
 	}
 
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
 	GEN_CONFIG_EVENT_HANDLERS("qos", opt_descr, update_config,
 				  fetch_config);
 
@@ -803,9 +804,10 @@ static void ble_qos_thread_fn(void)
 }
 
 EVENT_LISTENER(MODULE, event_handler);
-EVENT_SUBSCRIBE(MODULE, module_state_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, module_state_event,
+			handle_module_state_event);
 #if CONFIG_DESKTOP_BLE_QOS_STATS_PRINTOUT_ENABLE
-EVENT_SUBSCRIBE(MODULE, hid_report_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, hid_report_event, handle_hid_report_event);
 #endif
 #if CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE
 EVENT_SUBSCRIBE_EARLY(MODULE, config_event);
@@ -828,129 +828,126 @@ static void send_enqueued_report(struct subscriber *sub)
 	}
 }
 
-static bool event_handler(const struct event_header *eh)
+static bool handle_hid_report_sent_event(
+		const struct hid_report_sent_event *event)
 {
-	if (is_hid_report_sent_event(eh)) {
-		const struct hid_report_sent_event *event =
-			cast_hid_report_sent_event(eh);
-		struct subscriber *sub = NULL;
+	struct subscriber *sub = NULL;
 
-		for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
-			if (subscribers[i].id == event->subscriber) {
-				sub = &subscribers[i];
-				break;
-			}
+	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
+		if (subscribers[i].id == event->subscriber) {
+			sub = &subscribers[i];
+			break;
 		}
-		__ASSERT_NO_MSG(sub);
-
-		sub->busy = false;
-		send_enqueued_report(sub);
-
-		return false;
 	}
+	__ASSERT_NO_MSG(sub);
 
-	if (is_module_state_event(eh)) {
-		const struct module_state_event *event =
-			cast_module_state_event(eh);
+	sub->busy = false;
+	send_enqueued_report(sub);
 
-		if (check_state(event, MODULE_ID(ble_state),
-				MODULE_STATE_READY)) {
-			static bool initialized;
+	return false;
+}
 
-			__ASSERT_NO_MSG(!initialized);
-			initialized = true;
+static bool handle_module_state_event(const struct module_state_event *event)
+{
+	if (check_state(event, MODULE_ID(ble_state), MODULE_STATE_READY)) {
+		static bool initialized;
 
-			init();
-			module_set_state(MODULE_STATE_READY);
-		}
+		__ASSERT_NO_MSG(!initialized);
+		initialized = true;
 
-		return false;
+		init();
+		module_set_state(MODULE_STATE_READY);
 	}
 
-	if (is_ble_discovery_complete_event(eh)) {
-		const struct ble_discovery_complete_event *event =
-			cast_ble_discovery_complete_event(eh);
-
-		register_peripheral(event->dm, event->pid,
-				    event->hwid, sizeof(event->hwid));
-
-		return false;
-	}
+	return false;
+}
 
-	if (is_hid_report_subscription_event(eh)) {
-		const struct hid_report_subscription_event *event =
-			cast_hid_report_subscription_event(eh);
+static bool handle_ble_discovery_complete_event(
+		const struct ble_discovery_complete_event *event)
+{
+	register_peripheral(event->dm, event->pid,
+			    event->hwid, sizeof(event->hwid));
 
-		struct subscriber *sub = NULL;
+	return false;
+}
 
-		for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
-			if ((subscribers[i].id == event->subscriber) ||
-			    (subscribers[i].id == NULL)) {
-				sub = &subscribers[i];
-			}
+static bool handle_hid_report_subscription_event(
+		const struct hid_report_subscription_event *event)
+{
+	struct subscriber *sub = NULL;
 
-			if (subscribers[i].id == event->subscriber) {
-				break;
-			}
+	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
+		if ((subscribers[i].id == event->subscriber) ||
+		    (subscribers[i].id == NULL)) {
+			sub = &subscribers[i];
 		}
-		__ASSERT_NO_MSG(sub);
 
-		if (!sub->id) {
-			sub->id = event->subscriber;
+		if (subscribers[i].id == event->subscriber) {
+			break;
 		}
+	}
+	__ASSERT_NO_MSG(sub);
 
-		__ASSERT_NO_MSG(event->report_id < __CHAR_BIT__ * sizeof(sub->enabled_reports_bm));
-		if (event->enabled) {
-			sub->enabled_reports_bm |= BIT(event->report_id);
-			send_enqueued_report(sub);
-		} else {
-			sub->enabled_reports_bm &= ~BIT(event->report_id);
-			clear_state();
-		}
+	if (!sub->id) {
+		sub->id = event->subscriber;
+	}
 
-		return false;
+	__ASSERT_NO_MSG(event->report_id < __CHAR_BIT__ * sizeof(sub->enabled_reports_bm));
+	if (event->enabled) {
+		sub->enabled_reports_bm |= BIT(event->report_id);
+		send_enqueued_report(sub);
+	} else {
+		sub->enabled_reports_bm &= ~BIT(event->report_id);
+		clear_state();
 	}
 
-	if (is_ble_peer_event(eh)) {
-		const struct ble_peer_event *event =
-			cast_ble_peer_event(eh);
+	return false;
+}
 
-		if (event->state == PEER_STATE_DISCONNECTED) {
-			for (size_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
-				if ((bt_gatt_hids_c_assign_check(&peripherals[i].hidc)) &&
-				    (bt_gatt_hids_c_conn(&peripherals[i].hidc) == event->id)) {
-					disconnect_peripheral(&peripherals[i]);
-				}
+static bool handle_ble_peer_event(const struct ble_peer_event *event)
+{
+	if (event->state == PEER_STATE_DISCONNECTED) {
+		for (size_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
+			if ((bt_gatt_hids_c_assign_check(&peripherals[i].hidc)) &&
+			    (bt_gatt_hids_c_conn(&peripherals[i].hidc) == event->id)) {
+				disconnect_peripheral(&peripherals[i]);
 			}
 		}
-
-		return false;
 	}
 
-	if (is_ble_peer_operation_event(eh)) {
-		const struct ble_peer_operation_event *event =
-			cast_ble_peer_operation_event(eh);
-
-		if (event->op == PEER_OPERATION_ERASED) {
-			reset_peripheral_address();
-			store_peripheral_address();
-		}
+	return false;
+}
 
-		return false;
+static bool handle_ble_peer_operation_event(
+		const struct ble_peer_operation_event *event)
+{
+	if (event->op == PEER_OPERATION_ERASED) {
+		reset_peripheral_address();
+		store_peripheral_address();
 	}
 
-	if (is_wake_up_event(eh)) {
-		suspended = false;
+	return false;
+}
 
-		return false;
-	}
+static bool handle_wake_up_event(const struct wake_up_event *event)
+{
+	suspended = false;
 
-	if (is_power_down_event(eh)) {
-		suspended = true;
+	return false;
+}
 
-		return false;
-	}
+static bool handle_power_down_event(const struct power_down_event *event)
+{
+	suspended = true;
+
+	return false;
+}
 
+static bool event_handler(const struct event_header *eh)
+{
+	/* Only config_event, which exists in configurations with the config
+	 * channel, uses the listener callback.
+	 */
 	if (IS_ENABLED(CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE)) {
 		if (is_config_event(eh)) {
 			return handle_config_event(cast_config_event(eh));
@@ -964,14 +961,19 @@ static bool event_handler(const struct event_header *eh)
 }
 
 EVENT_LISTENER(MODULE, event_handler);
-EVENT_SUBSCRIBE(MODULE, module_state_event);
-EVENT_SUBSCRIBE_EARLY(MODULE, ble_discovery_complete_event);
-EVENT_SUBSCRIBE(MODULE, ble_peer_event);
-EVENT_SUBSCRIBE(MODULE, ble_peer_operation_event);
-EVENT_SUBSCRIBE(MODULE, hid_report_subscription_event);
-EVENT_SUBSCRIBE(MODULE, hid_report_sent_event);
-EVENT_SUBSCRIBE(MODULE, power_down_event);
-EVENT_SUBSCRIBE(MODULE, wake_up_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, module_state_event,
+			handle_module_state_event);
+EVENT_SUBSCRIBE_EARLY_HANDLER(MODULE, ble_discovery_complete_event,
+			      handle_ble_discovery_complete_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, ble_peer_event, handle_ble_peer_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, ble_peer_operation_event,
+			handle_ble_peer_operation_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, hid_report_subscription_event,
+			handle_hid_report_subscription_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, hid_report_sent_event,
+			handle_hid_report_sent_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, power_down_event, handle_power_down_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, wake_up_event, handle_wake_up_event);
 #if CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE
 EVENT_SUBSCRIBE_EARLY(MODULE, config_event);
 #endif
@@ -1284,7 +1284,8 @@ static void init(void)
 
 static bool handle_motion_event(const struct motion_event *event)
 {
-	if (!IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT)) {
+	if (IS_ENABLED(CONFIG_DESKTOP_MOTION_NONE) ||
+	    !IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT)) {
 		return false;
 	}
 
@@ -1301,7 +1302,8 @@ static bool handle_motion_event(const struct motion_event *event)
 
 static bool handle_wheel_event(const struct wheel_event *event)
 {
-	if (!IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT)) {
+	if (!IS_ENABLED(CONFIG_DESKTOP_WHEEL_ENABLE) ||
+	    !IS_ENABLED(CONFIG_DESKTOP_HID_REPORT_MOUSE_SUPPORT)) {
 		return false;
 	}
 
@@ -1317,6 +1319,10 @@ static bool handle_wheel_event(const struct wheel_event *event)
 
 static bool handle_button_event(const struct button_event *event)
 {
+	if (IS_ENABLED(CONFIG_DESKTOP_BUTTONS_NONE)) {
+		return false;
+	}
+
 	/* Get usage ID and target report from HID Keymap */
 	struct hid_keymap *map = hid_keymap_get(event->key_id);
 
@@ -1378,6 +1384,10 @@ static bool handle_ble_peer_event(const struct ble_peer_event *event)
 
 static bool handle_usb_hid_event(const struct usb_hid_event *event)
 {
+	if (!IS_ENABLED(CONFIG_DESKTOP_USB_ENABLE)) {
+		return false;
+	}
+
 	if (event->enabled) {
 		if (!get_subscriber_by_type(true)) {
 			connect_subscriber(event->id, true, 1);
@@ -1404,58 +1414,15 @@ static bool handle_module_state_event(const struct module_state_event *event)
 	return false;
 }
 
-static bool event_handler(const struct event_header *eh)
-{
-	if (!IS_ENABLED(CONFIG_DESKTOP_MOTION_NONE) &&
-	    is_motion_event(eh)) {
-		return handle_motion_event(cast_motion_event(eh));
-	}
-
-	if (is_hid_report_sent_event(eh)) {
-		return handle_hid_report_sent_event(
-				cast_hid_report_sent_event(eh));
-	}
-
-	if (IS_ENABLED(CONFIG_DESKTOP_WHEEL_ENABLE) &&
-	    is_wheel_event(eh)) {
-		return handle_wheel_event(cast_wheel_event(eh));
-	}
-
-	if (!IS_ENABLED(CONFIG_DESKTOP_BUTTONS_NONE) &&
-	    is_button_event(eh)) {
-		return handle_button_event(cast_button_event(eh));
-	}
-
-	if (is_hid_report_subscription_event(eh)) {
-		return handle_hid_report_subscription_event(
-				cast_hid_report_subscription_event(eh));
-	}
-
-	if (is_ble_peer_event(eh)) {
-		return handle_ble_peer_event(cast_ble_peer_event(eh));
-	}
-
-	if (IS_ENABLED(CONFIG_DESKTOP_USB_ENABLE) &&
-	    is_usb_hid_event(eh)) {
-		return handle_usb_hid_event(cast_usb_hid_event(eh));
-	}
-
-	if (is_module_state_event(eh)) {
-		return handle_module_state_event(cast_module_state_event(eh));
-	}
-
-	/* If event is unhandled, unsubscribe. */
-	__ASSERT_NO_MSG(false);
-
-	return false;
-}
-
-EVENT_LISTENER(MODULE, event_handler);
-EVENT_SUBSCRIBE(MODULE, ble_peer_event);
-EVENT_SUBSCRIBE(MODULE, usb_hid_event);
-EVENT_SUBSCRIBE(MODULE, hid_report_sent_event);
-EVENT_SUBSCRIBE(MODULE, hid_report_subscription_event);
-EVENT_SUBSCRIBE(MODULE, module_state_event);
-EVENT_SUBSCRIBE_FINAL(MODULE, button_event);
-EVENT_SUBSCRIBE(MODULE, motion_event);
-EVENT_SUBSCRIBE(MODULE, wheel_event);
+EVENT_LISTENER(MODULE, NULL);
+EVENT_SUBSCRIBE_HANDLER(MODULE, ble_peer_event, handle_ble_peer_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, usb_hid_event, handle_usb_hid_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, hid_report_sent_event,
+			handle_hid_report_sent_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, hid_report_subscription_event,
+			handle_hid_report_subscription_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, module_state_event,
+			handle_module_state_event);
+EVENT_SUBSCRIBE_FINAL_HANDLER(MODULE, button_event, handle_button_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, motion_event, handle_motion_event);
+EVENT_SUBSCRIBE_HANDLER(MODULE, wheel_event, handle_wheel_event);
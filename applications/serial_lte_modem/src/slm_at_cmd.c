@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <zephyr.h>
+#include <ctype.h>
+#include <string.h>
+#include <logging/log.h>
+#include "slm_at_host.h"
+
+LOG_MODULE_REGISTER(at_cmd, CONFIG_SLM_LOG_LEVEL);
+
+/* Longest name of an SLM AT command */
+#define SLM_AT_CMD_NAME_MAX_LEN	24
+
+/* global functions defined in different files */
+void rsp_send(const uint8_t *str, size_t len);
+
+/* global variable defined in different files */
+extern struct at_param_list at_param_list;
+
+/**
+ * @brief Find the SLM AT command of a command string
+ */
+const struct slm_at_cmd *slm_at_cmd_find(const char *at_cmd)
+{
+	char name[SLM_AT_CMD_NAME_MAX_LEN + 1];
+	const struct slm_at_cmd *first = _slm_at_cmd_list_start;
+	const struct slm_at_cmd *last = _slm_at_cmd_list_end;
+	size_t len;
+
+	/* The name ends with the parameters, SET "=", READ and TEST "?", or
+	 * with the termination of the command.
+	 */
+	for (len = 0; at_cmd[len] != '\0' && at_cmd[len] != '=' &&
+		      at_cmd[len] != '?' && at_cmd[len] != '\r' &&
+		      at_cmd[len] != '\n'; len++) {
+		if (len == SLM_AT_CMD_NAME_MAX_LEN) {
+			return NULL;
+		}
+		name[len] = toupper((int)at_cmd[len]);
+	}
+	name[len] = '\0';
+
+	/* The commands are sorted by name at link time. */
+	while (first < last) {
+		const struct slm_at_cmd *cmd = first + (last - first) / 2;
+		int cmp = strcmp(name, cmd->name);
+
+		if (cmp == 0) {
+			return cmd;
+		} else if (cmp < 0) {
+			last = cmd;
+		} else {
+			first = cmd + 1;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Handle an SLM AT command and send its final response
+ */
+int slm_at_cmd_handle(const struct slm_at_cmd *cmd, const char *at_cmd)
+{
+	int err;
+
+	err = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
+	if (err) {
+		LOG_ERR("Failed to parse AT command %d", err);
+		err = -EINVAL;
+	} else {
+		err = cmd->handler(at_parser_cmd_type_get(at_cmd));
+	}
+
+	if (err == 0) {
+		rsp_send(OK_STR, sizeof(OK_STR) - 1);
+	} else if (err < 0) {
+		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+	}
+
+	return err;
+}
+
+/**
+ * @brief Check that no SLM AT command is registered twice
+ */
+int slm_at_cmd_check(void)
+{
+	const struct slm_at_cmd *cmd;
+
+	/* Commands of the same name are next to each other in the table. */
+	for (cmd = _slm_at_cmd_list_start + 1; cmd < _slm_at_cmd_list_end;
+	     cmd++) {
+		if (strcmp(cmd[-1].name, cmd->name) == 0) {
+			LOG_ERR("%s registered twice", cmd->name);
+			return -EEXIST;
+		}
+	}
+
+	return 0;
+}
@@ -33,16 +33,10 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 #define SLM_UART_0_NAME	"UART_0"
 #define SLM_UART_2_NAME	"UART_2"
 
-#define OK_STR		"OK\r\n"
-#define ERROR_STR	"ERROR\r\n"
 #define FATAL_STR	"FATAL ERROR\r\n"
 #define SLM_SYNC_STR	"Ready\r\n"
 
 #define SLM_VERSION	"#XSLMVER: 1.4\r\n"
-#define AT_CMD_SLMVER	"AT#XSLMVER"
-#define AT_CMD_SLEEP	"AT#XSLEEP"
-#define AT_CMD_CLAC	"AT#XCLAC"
-#define AT_CMD_SLMUART	"AT#XSLMUART"
 
 #define SLM_UART_BAUDRATE                                           \
 	"#XSLMUART: (1200, 2400, 4800, 9600, 14400, 19200, 38400, " \
@@ -75,6 +69,7 @@ static uint8_t at_buf[AT_MAX_CMD_LEN];
 static size_t at_buf_len;
 static struct k_work cmd_send_work;
 static const char termination[3] = { '\0', '\r', '\n' };
+static bool uart_off;
 
 static uint8_t uart_rx_buf[UART_RX_BUF_NUM][UART_RX_LEN];
 static uint8_t *next_buf = uart_rx_buf[1];
@@ -88,6 +83,7 @@ void enter_sleep(void);
 
 /* global variable defined in different files */
 extern struct at_param_list at_param_list;
+extern char rsp_buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
 
 /* forward declaration */
 void slm_at_host_uninit(void);
@@ -163,42 +159,44 @@ static void response_handler(void *context, const char *response)
 	}
 }
 
-static void handle_at_clac(void)
+/**@brief handle AT#XSLMVER commands
+ *  AT#XSLMVER
+ */
+static int handle_at_slmver(enum at_cmd_type type)
 {
-	rsp_send(AT_CMD_SLMVER, sizeof(AT_CMD_SLMVER) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_SLMUART, sizeof(AT_CMD_SLMUART) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_SLEEP, sizeof(AT_CMD_SLEEP) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_CLAC, sizeof(AT_CMD_CLAC) - 1);
-	rsp_send("\r\n", 2);
-#if defined(CONFIG_SLM_TCP_PROXY)
-	slm_at_tcp_proxy_clac();
-#endif
-#if defined(CONFIG_SLM_UDP_PROXY)
-	slm_at_udp_proxy_clac();
-#endif
-	slm_at_tcpip_clac();
-	slm_at_icmp_clac();
-	slm_at_gps_clac();
-	slm_at_mqtt_clac();
-	slm_at_ftp_clac();
+	ARG_UNUSED(type);
+
+	rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
+
+	return 0;
 }
 
-static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
+/**@brief handle AT#XCLAC commands
+ *  AT#XCLAC
+ */
+static int handle_at_clac(enum at_cmd_type type)
 {
-	int ret = -EINVAL;
-	enum at_cmd_type type;
-	uint16_t shutdown_mode;
+	const struct slm_at_cmd *cmd;
 
-	ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
-	if (ret < 0) {
-		LOG_ERR("Failed to parse AT command %d", ret);
-		return -EINVAL;
+	ARG_UNUSED(type);
+
+	for (cmd = _slm_at_cmd_list_start; cmd < _slm_at_cmd_list_end; cmd++) {
+		sprintf(rsp_buf, "%s\r\n", cmd->name);
+		rsp_send(rsp_buf, strlen(rsp_buf));
 	}
 
-	type = at_parser_cmd_type_get(at_cmd);
+	return 0;
+}
+
+/**@brief handle AT#XSLEEP commands
+ *  AT#XSLEEP[=<shutdown_mode>]
+ *  AT#XSLEEP=?
+ */
+static int handle_at_sleep(enum at_cmd_type type)
+{
+	int ret = -EINVAL;
+	uint16_t shutdown_mode;
+
 	if (type == AT_CMD_TYPE_SET_COMMAND) {
 		shutdown_mode = SHUTDOWN_MODE_IDLE;
 		if (at_params_valid_count_get(&at_param_list) > 1) {
@@ -212,12 +210,11 @@ static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
 		if (shutdown_mode == SHUTDOWN_MODE_IDLE) {
 			slm_at_host_uninit();
 			enter_idle();
-			*mode = SHUTDOWN_MODE_IDLE;
-			ret = 0; /*Will send no "OK"*/
+			ret = SLM_AT_RSP_SENT; /*Will send no "OK"*/
 		} else if (shutdown_mode == SHUTDOWN_MODE_SLEEP) {
 			slm_at_host_uninit();
 			enter_sleep();
-			ret = 0; /* Cannot reach here */
+			ret = SLM_AT_RSP_SENT; /* Cannot reach here */
 		} else {
 			LOG_ERR("AT parameter error");
 			ret = -EINVAL;
@@ -236,28 +233,26 @@ static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
 	return ret;
 }
 
-static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
+/**@brief handle AT#XSLMUART commands
+ *  AT#XSLMUART[=<baud_rate>]
+ *  AT#XSLMUART?
+ *  AT#XSLMUART=?
+ */
+static int handle_at_slmuart(enum at_cmd_type type)
 {
 	int ret = -EINVAL;
-	enum at_cmd_type type;
+	uint32_t baudrate = 0;
 
-	ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
-	if (ret < 0) {
-		LOG_ERR("Failed to parse AT command %d", ret);
-		return -EINVAL;
-	}
-
-	type = at_parser_cmd_type_get(at_cmd);
 	if (type == AT_CMD_TYPE_SET_COMMAND) {
 		if (at_params_valid_count_get(&at_param_list) > 1) {
 			ret = at_params_int_get(&at_param_list, 1,
-					baudrate);
+					&baudrate);
 			if (ret < 0) {
 				LOG_ERR("AT parameter error");
 				return -EINVAL;
 			}
 		}
-		switch (*baudrate) {
+		switch (baudrate) {
 		case 1200:
 		case 2400:
 		case 4800:
@@ -271,12 +266,16 @@ static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
 		case 460800:
 		case 921600:
 		case 1000000:
-			ret = 0;
 			break;
 		default:
 			LOG_ERR("Invalid uart baud rate provided.");
 			return -EINVAL;
 		}
+		/* Send "OK" at the current baud rate */
+		rsp_send(OK_STR, sizeof(OK_STR) - 1);
+		k_sleep(K_MSEC(50));
+		set_uart_baudrate(baudrate);
+		ret = SLM_AT_RSP_SENT;
 	}
 
 	if (type == AT_CMD_TYPE_READ_COMMAND) {
@@ -297,11 +296,61 @@ static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
 	return ret;
 }
 
+/**@brief Supported AT commands. */
+SLM_AT_CMD_DEFINE(XSLMVER, handle_at_slmver);
+SLM_AT_CMD_DEFINE(XCLAC, handle_at_clac);
+SLM_AT_CMD_DEFINE(XSLEEP, handle_at_sleep);
+SLM_AT_CMD_DEFINE(XSLMUART, handle_at_slmuart);
+
+/**@brief Send data to the proxy that is in data mode
+ *
+ * @retval -ENOENT If no proxy is in data mode.
+ */
+static int proxy_data_send(void)
+{
+	int err = -ENOENT;
+
+#if defined(CONFIG_SLM_TCP_PROXY)
+	err = slm_at_tcp_proxy_data_send(at_buf, at_buf_len);
+	if (err != -ENOENT) {
+		return err;
+	}
+#endif
+#if defined(CONFIG_SLM_UDP_PROXY)
+	err = slm_at_udp_proxy_data_send(at_buf, at_buf_len);
+#endif
+
+	return err;
+}
+
+/**@brief Check that the command is not data for a proxy in data mode
+ *
+ * In data mode, only the commands of the proxy are handled, anything else
+ * received from the host is sent as data.
+ */
+static bool proxy_cmd_allowed(const struct slm_at_cmd *cmd)
+{
+#if defined(CONFIG_SLM_TCP_PROXY)
+	if (!slm_at_tcp_proxy_cmd_allowed(cmd)) {
+		return false;
+	}
+#endif
+#if defined(CONFIG_SLM_UDP_PROXY)
+	if (!slm_at_udp_proxy_cmd_allowed(cmd)) {
+		return false;
+	}
+#endif
+	ARG_UNUSED(cmd);
+
+	return true;
+}
+
 static void cmd_send(struct k_work *work)
 {
 	size_t chars;
 	char str[24];
 	static char buf[AT_MAX_CMD_LEN];
+	const struct slm_at_cmd *cmd;
 	enum at_cmd_state state;
 	int err;
 
@@ -312,67 +361,13 @@ static void cmd_send(struct k_work *work)
 
 	LOG_HEXDUMP_DBG(at_buf, at_buf_len, "RX");
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMVER)) {
-		rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	}
-
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMUART)) {
-		uint32_t baudrate;
-
-		err = handle_at_slmuart(at_buf, &baudrate);
-		if (err != 0) {
-			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
-		} else {
-			rsp_send(OK_STR, sizeof(OK_STR) - 1);
-			k_sleep(K_MSEC(50));
-			set_uart_baudrate(baudrate);
-			goto done;
-		}
-	}
-
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_CLAC)) {
-		handle_at_clac();
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	}
-
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLEEP)) {
-		enum shutdown_modes mode = SHUTDOWN_MODE_INVALID;
-
-		err = handle_at_sleep(at_buf, &mode);
-		if (err) {
-			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
-		} else {
-			if (mode == SHUTDOWN_MODE_INVALID) {
-				/*Test command*/
-				rsp_send(OK_STR, sizeof(OK_STR) - 1);
-				goto done;
-			} else {
-				/*Entered IDLE*/
-				return;
-			}
-		}
-	}
-
-#if defined(CONFIG_SLM_TCP_PROXY)
-	err = slm_at_tcp_proxy_parse(at_buf, at_buf_len);
-	if (err > 0) {
-		goto done;
-	} else if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+	cmd = slm_at_cmd_find(at_buf);
+	if (cmd != NULL && proxy_cmd_allowed(cmd)) {
+		slm_at_cmd_handle(cmd, at_buf);
 		goto done;
 	}
-#endif
 
-#if defined(CONFIG_SLM_UDP_PROXY)
-	err = slm_at_udp_proxy_parse(at_buf, at_buf_len);
+	err = proxy_data_send();
 	if (err > 0) {
 		goto done;
 	} else if (err == 0) {
@@ -382,51 +377,6 @@ static void cmd_send(struct k_work *work)
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
 		goto done;
 	}
-#endif
-
-	err = slm_at_tcpip_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-
-	err = slm_at_icmp_parse(at_buf);
-	if (err == 0) {
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-
-	err = slm_at_gps_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-
-	err = slm_at_mqtt_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-
-	err = slm_at_ftp_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
 
 	/* Send to modem */
 	err = at_cmd_write(at_buf, buf, AT_MAX_CMD_LEN, &state);
@@ -456,6 +406,10 @@ static void cmd_send(struct k_work *work)
 	}
 
 done:
+	if (uart_off) {
+		/* Entered IDLE */
+		return;
+	}
 	err = uart_rx_enable(uart_dev, uart_rx_buf[0],
 				sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
 	if (err) {
@@ -596,6 +550,11 @@ int slm_at_host_init(void)
 	enum term_modes mode = CONFIG_SLM_AT_HOST_TERMINATION;
 	uint32_t start_time;
 
+	err = slm_at_cmd_check();
+	if (err) {
+		return err;
+	}
+
 	/* Choosing the termination mode */
 	if (mode < MODE_COUNT) {
 		term_mode = mode;
@@ -693,6 +652,7 @@ int slm_at_host_init(void)
 		return -EFAULT;
 	}
 
+	uart_off = false;
 	k_work_init(&cmd_send_work, cmd_send);
 	k_sem_give(&tx_done);
 	rsp_send(SLM_SYNC_STR, sizeof(SLM_SYNC_STR)-1);
@@ -743,6 +703,7 @@ void slm_at_host_uninit(void)
 	}
 
 	/* Power off UART module */
+	uart_off = true;
 	uart_rx_disable(uart_dev);
 	k_sleep(K_MSEC(100));
 	err = device_set_power_state(uart_dev, DEVICE_PM_OFF_STATE,
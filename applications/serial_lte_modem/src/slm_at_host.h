@@ -18,15 +18,85 @@
 #include <modem/at_cmd_parser.h>
 #include <modem/at_cmd.h>
 
-/**@brief AT command handler type. */
+/**@brief AT command handler type.
+ *
+ * The parameters of the command are parsed into at_param_list before the
+ * handler is called.
+ *
+ * @retval 0 If successful, "OK" is sent to the host.
+ * @retval SLM_AT_RSP_SENT If the handler sends the final response itself.
+ * @retval -errno If the command failed, "ERROR" is sent to the host.
+ */
 typedef int (*slm_at_handler_t) (enum at_cmd_type);
 
-/**@brief AT command list item type. */
-typedef struct slm_at_cmd_list {
-	uint8_t type;
-	char *string;
+/**@brief Returned by a handler that sends the final response itself. */
+#define SLM_AT_RSP_SENT 1
+
+/**@brief Final responses sent to the host. */
+#define OK_STR		"OK\r\n"
+#define ERROR_STR	"ERROR\r\n"
+
+/**@brief SLM AT command. */
+struct slm_at_cmd {
+	/** Name of the command in upper case, such as "AT#XSOCKET". */
+	const char *name;
+	/** Handler of the command. */
 	slm_at_handler_t handler;
-} slm_at_cmd_list_t;
+};
+
+/**@brief Register an SLM AT command.
+ *
+ * The commands are placed in a linker section, sorted by name, so that
+ * they are found with a binary search however many modules are enabled.
+ *
+ * @param _name Name of the command without the "AT#" prefix, in upper
+ *              case, such as XSOCKET.
+ * @param _handler Handler of the command, see @ref slm_at_handler_t.
+ */
+#define SLM_AT_CMD_DEFINE(_name, _handler)				\
+	static const struct slm_at_cmd _slm_at_cmd_##_name __used	\
+	__attribute__((__section__("._slm_at_cmd.static." #_name))) = {	\
+		.name = "AT#" #_name,					\
+		.handler = _handler,					\
+	}
+
+/**@brief Start and end of the registered commands, sorted by name. */
+extern const struct slm_at_cmd _slm_at_cmd_list_start[];
+extern const struct slm_at_cmd _slm_at_cmd_list_end[];
+
+/**
+ * @brief Find the SLM AT command of a command string.
+ *
+ * @param at_cmd Command string received from the host.
+ *
+ * @return The command, or NULL if the string is not an SLM AT command.
+ */
+const struct slm_at_cmd *slm_at_cmd_find(const char *at_cmd);
+
+/**
+ * @brief Handle an SLM AT command and send its final response.
+ *
+ * The parameters are parsed into at_param_list before the handler is
+ * called. "OK" or "ERROR" is sent to the host, unless the handler returns
+ * @ref SLM_AT_RSP_SENT.
+ *
+ * @param cmd Command found by @ref slm_at_cmd_find.
+ * @param at_cmd Command string received from the host.
+ *
+ * @return Return value of the handler, or -EINVAL if the parameters could
+ *         not be parsed.
+ */
+int slm_at_cmd_handle(const struct slm_at_cmd *cmd, const char *at_cmd);
+
+/**
+ * @brief Check that no SLM AT command is registered twice.
+ *
+ * Only one of the commands of the same name would ever be found.
+ *
+ * @retval 0 If the names of the commands are unique.
+ * @retval -EEXIST If a name is registered by several modules.
+ */
+int slm_at_cmd_check(void);
 
 /**@brief Arbitrary data type over AT channel. */
 enum slm_data_type_t {
@@ -30,12 +30,6 @@ LOG_MODULE_REGISTER(icmp, CONFIG_SLM_LOG_LEVEL);
  * - IPv6 support
  */
 
-/**@brief List of supported AT commands. */
-enum slm_icmp_at_cmd_type {
-	AT_ICMP_PING,
-	AT_ICMP_MAX
-};
-
 /**@ ICMP Ping command arguments */
 static struct ping_argv_t {
 	struct addrinfo *src;
@@ -55,10 +49,8 @@ extern struct k_work_q slm_work_q;
 /** forward declaration of cmd handlers **/
 static int handle_at_icmp_ping(enum at_cmd_type cmd_type);
 
-/**@brief SLM AT Command list type. */
-static slm_at_cmd_list_t m_icmp_at_list[AT_ICMP_MAX] = {
-	{AT_ICMP_PING, "AT#XPING", handle_at_icmp_ping},
-};
+/**@brief Supported AT commands. */
+SLM_AT_CMD_DEFINE(XPING, handle_at_icmp_ping);
 
 static struct k_work my_work;
 
@@ -416,6 +408,10 @@ static int handle_at_icmp_ping(enum at_cmd_type cmd_type)
 			interval = 0;
 		}
 		err = ping_test_handler(url, length, timeout, count, interval);
+		if (err == 0) {
+			/* "OK" is sent when the ping is completed */
+			err = SLM_AT_RSP_SENT;
+		}
 		break;
 
 	default:
@@ -425,40 +421,6 @@ static int handle_at_icmp_ping(enum at_cmd_type cmd_type)
 	return err;
 }
 
-/**@brief API to handle TCP/IP AT commands
- */
-int slm_at_icmp_parse(const char *at_cmd)
-{
-	int ret = -ENOENT;
-	enum at_cmd_type type;
-
-	for (int i = 0; i < AT_ICMP_MAX; i++) {
-		if (slm_util_cmd_casecmp(at_cmd, m_icmp_at_list[i].string)) {
-			ret = at_parser_params_from_str(at_cmd, NULL,
-						&at_param_list);
-			if (ret < 0) {
-				LOG_ERR("Failed to parse AT command %d", ret);
-				return -EINVAL;
-			}
-			type = at_parser_cmd_type_get(at_cmd);
-			ret = m_icmp_at_list[i].handler(type);
-			break;
-		}
-	}
-
-	return ret;
-}
-
-/**@brief API to list ICMP AT commands
- */
-void slm_at_icmp_clac(void)
-{
-	for (int i = 0; i < AT_ICMP_MAX; i++) {
-		sprintf(rsp_buf, "%s\r\n", m_icmp_at_list[i].string);
-		rsp_send(rsp_buf, strlen(rsp_buf));
-	}
-}
-
 /**@brief API to initialize ICMP AT commands handler
  */
 int slm_at_icmp_init(void)
@@ -45,22 +45,6 @@ enum slm_socket_role {
 	AT_SOCKET_ROLE_SERVER
 };
 
-/**@brief List of supported AT commands. */
-enum slm_tcpip_at_cmd_type {
-	AT_SOCKET,
-	AT_SOCKETOPT,
-	AT_BIND,
-	AT_CONNECT,
-	AT_LISTEN,
-	AT_ACCEPT,
-	AT_SEND,
-	AT_RECV,
-	AT_SENDTO,
-	AT_RECVFROM,
-	AT_GETADDRINFO,
-	AT_TCPIP_MAX
-};
-
 /** forward declaration of cmd handlers **/
 static int handle_at_socket(enum at_cmd_type cmd_type);
 static int handle_at_socketopt(enum at_cmd_type cmd_type);
@@ -74,20 +58,18 @@ static int handle_at_sendto(enum at_cmd_type cmd_type);
 static int handle_at_recvfrom(enum at_cmd_type cmd_type);
 static int handle_at_getaddrinfo(enum at_cmd_type cmd_type);
 
-/**@brief SLM AT Command list type. */
-static slm_at_cmd_list_t m_tcpip_at_list[AT_TCPIP_MAX] = {
-	{AT_SOCKET, "AT#XSOCKET", handle_at_socket},
-	{AT_SOCKETOPT, "AT#XSOCKETOPT", handle_at_socketopt},
-	{AT_BIND, "AT#XBIND", handle_at_bind},
-	{AT_CONNECT, "AT#XCONNECT", handle_at_connect},
-	{AT_LISTEN, "AT#XLISTEN", handle_at_listen},
-	{AT_ACCEPT, "AT#XACCEPT", handle_at_accept},
-	{AT_SEND, "AT#XSEND", handle_at_send},
-	{AT_RECV, "AT#XRECV", handle_at_recv},
-	{AT_SENDTO, "AT#XSENDTO", handle_at_sendto},
-	{AT_RECVFROM, "AT#XRECVFROM", handle_at_recvfrom},
-	{AT_GETADDRINFO, "AT#XGETADDRINFO", handle_at_getaddrinfo},
-};
+/**@brief Supported AT commands. */
+SLM_AT_CMD_DEFINE(XSOCKET, handle_at_socket);
+SLM_AT_CMD_DEFINE(XSOCKETOPT, handle_at_socketopt);
+SLM_AT_CMD_DEFINE(XBIND, handle_at_bind);
+SLM_AT_CMD_DEFINE(XCONNECT, handle_at_connect);
+SLM_AT_CMD_DEFINE(XLISTEN, handle_at_listen);
+SLM_AT_CMD_DEFINE(XACCEPT, handle_at_accept);
+SLM_AT_CMD_DEFINE(XSEND, handle_at_send);
+SLM_AT_CMD_DEFINE(XRECV, handle_at_recv);
+SLM_AT_CMD_DEFINE(XSENDTO, handle_at_sendto);
+SLM_AT_CMD_DEFINE(XRECVFROM, handle_at_recvfrom);
+SLM_AT_CMD_DEFINE(XGETADDRINFO, handle_at_getaddrinfo);
 
 static struct sockaddr_in remote;
 
@@ -1221,40 +1203,6 @@ static int handle_at_getaddrinfo(enum at_cmd_type cmd_type)
 	return err;
 }
 
-/**@brief API to handle TCP/IP AT commands
- */
-int slm_at_tcpip_parse(const char *at_cmd)
-{
-	int ret = -ENOENT;
-	enum at_cmd_type type;
-
-	for (int i = 0; i < AT_TCPIP_MAX; i++) {
-		if (slm_util_cmd_casecmp(at_cmd, m_tcpip_at_list[i].string)) {
-			ret = at_parser_params_from_str(at_cmd, NULL,
-						&at_param_list);
-			if (ret) {
-				LOG_ERR("Failed to parse AT command %d", ret);
-				return -EINVAL;
-			}
-			type = at_parser_cmd_type_get(at_cmd);
-			ret = m_tcpip_at_list[i].handler(type);
-			break;
-		}
-	}
-
-	return ret;
-}
-
-/**@brief API to list TCP/IP AT commands
- */
-void slm_at_tcpip_clac(void)
-{
-	for (int i = 0; i < AT_TCPIP_MAX; i++) {
-		sprintf(rsp_buf, "%s\r\n", m_tcpip_at_list[i].string);
-		rsp_send(rsp_buf, strlen(rsp_buf));
-	}
-}
-
 /**@brief API to initialize TCP/IP AT commands handler
  */
 int slm_at_tcpip_init(void)
@@ -16,23 +16,33 @@
 #include <zephyr/types.h>
 #include <modem/at_cmd.h>
 
+struct slm_at_cmd;
+
 /**
- * @brief TCP proxy AT command parser.
+ * @brief Send TCP proxy data in data mode.
  *
- * @param at_cmd AT command or data string.
- * @param length AT command or data string length.
+ * @param data   Data received from the host.
+ * @param length Length of the data.
  *
- * @retval 0 If the operation was successful.
- *           Otherwise, negative code means error.
- *           Otherwise, positive code means data is sent in data mode.
+ * @return Number of bytes sent if the operation was successful.
+ *         -ENOENT if not in data mode.
+ *         Otherwise, a (negative) error code is returned.
  */
-int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length);
+int slm_at_tcp_proxy_data_send(const uint8_t *data, uint16_t length);
 
 /**
- * @brief List TCP proxy AT commands.
+ * @brief Check if a command is handled while the proxy is in data mode.
+ *
+ * In data mode, only the TCP proxy commands are handled, other commands
+ * are data to send.
+ *
+ * @param cmd Command received from the host.
  *
+ * @retval true If the proxy is not in data mode, or the command is a TCP
+ *              proxy command.
+ * @retval false If the command is data to send.
  */
-void slm_at_tcp_proxy_clac(void);
+bool slm_at_tcp_proxy_cmd_allowed(const struct slm_at_cmd *cmd);
 
 /**
  * @brief Initialize TCP proxy AT command parser.
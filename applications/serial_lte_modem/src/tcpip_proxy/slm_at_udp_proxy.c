@@ -38,25 +38,15 @@ enum slm_udp_proxy_operation {
 	AT_CLIENT_CONNECT_WITH_DATAMODE = AT_SERVER_START_WITH_DATAMODE
 };
 
-/**@brief List of supported AT commands. */
-enum slm_udp_proxy_at_cmd_type {
-	AT_UDP_SERVER,
-	AT_UDP_CLIENT,
-	AT_UDP_SEND,
-	AT_UDP_PROXY_MAX
-};
-
 /** forward declaration of cmd handlers **/
 static int handle_at_udp_server(enum at_cmd_type cmd_type);
 static int handle_at_udp_client(enum at_cmd_type cmd_type);
 static int handle_at_udp_send(enum at_cmd_type cmd_type);
 
-/**@brief SLM AT Command list type. */
-static slm_at_cmd_list_t m_udp_proxy_at_list[AT_UDP_PROXY_MAX] = {
-	{AT_UDP_SERVER, "AT#XUDPSVR", handle_at_udp_server},
-	{AT_UDP_CLIENT, "AT#XUDPCLI", handle_at_udp_client},
-	{AT_UDP_SEND, "AT#XUDPSEND", handle_at_udp_send},
-};
+/**@brief Supported AT commands. */
+SLM_AT_CMD_DEFINE(XUDPSVR, handle_at_udp_server);
+SLM_AT_CMD_DEFINE(XUDPCLI, handle_at_udp_client);
+SLM_AT_CMD_DEFINE(XUDPSEND, handle_at_udp_send);
 
 static uint8_t data_hex[DATA_HEX_MAX_SIZE];
 static struct k_thread udp_thread;
@@ -578,44 +568,28 @@ static int handle_at_udp_send(enum at_cmd_type cmd_type)
 	return err;
 }
 
-/**@brief API to handle UDP Proxy AT commands
+/**@brief API to send UDP proxy data in data mode
  */
-int slm_at_udp_proxy_parse(const char *at_cmd, uint16_t length)
+int slm_at_udp_proxy_data_send(const uint8_t *data, uint16_t length)
 {
-	int ret = -ENOENT;
-	enum at_cmd_type type;
-
-	for (int i = 0; i < AT_UDP_PROXY_MAX; i++) {
-		if (slm_util_cmd_casecmp(at_cmd,
-					m_udp_proxy_at_list[i].string)) {
-			ret = at_parser_params_from_str(at_cmd, NULL,
-						&at_param_list);
-			if (ret) {
-				LOG_ERR("Failed to parse AT command %d", ret);
-				return -EINVAL;
-			}
-			type = at_parser_cmd_type_get(at_cmd);
-			ret = m_udp_proxy_at_list[i].handler(type);
-			break;
-		}
-	}
-
-	/* handle sending in data mode */
-	if (ret == -ENOENT && udp_datamode) {
-		ret = do_udp_send_datamode(at_cmd, length);
+	if (!udp_datamode) {
+		return -ENOENT;
 	}
 
-	return ret;
+	return do_udp_send_datamode(data, length);
 }
 
-/**@brief API to list UDP Proxy AT commands
+/**@brief API to check the commands handled in data mode
  */
-void slm_at_udp_proxy_clac(void)
+bool slm_at_udp_proxy_cmd_allowed(const struct slm_at_cmd *cmd)
 {
-	for (int i = 0; i < AT_UDP_PROXY_MAX; i++) {
-		sprintf(rsp_buf, "%s\r\n", m_udp_proxy_at_list[i].string);
-		rsp_send(rsp_buf, strlen(rsp_buf));
+	if (!udp_datamode) {
+		return true;
 	}
+
+	return cmd->handler == handle_at_udp_server ||
+	       cmd->handler == handle_at_udp_client ||
+	       cmd->handler == handle_at_udp_send;
 }
 
 /**@brief API to initialize UDP Proxy AT commands handler
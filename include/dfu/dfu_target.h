@@ -22,6 +22,11 @@ extern "C" {
 
 #define DFU_TARGET_IMAGE_TYPE_MCUBOOT 1
 #define DFU_TARGET_IMAGE_TYPE_MODEM_DELTA 2
+#define DFU_TARGET_IMAGE_TYPE_DELTA 3
+#define DFU_TARGET_IMAGE_TYPE_COMPRESSED 4
+
+/** Length of the image digest, see @ref dfu_target_hash_set. */
+#define DFU_TARGET_HASH_LEN 32
 
 enum dfu_target_evt_id {
 	DFU_TARGET_EVT_TIMEOUT,
@@ -95,6 +100,24 @@ int dfu_target_offset_get(size_t *offset);
  **/
 int dfu_target_write(const void *const buf, size_t len);
 
+#if defined(CONFIG_DFU_TARGET_STREAM_HASH)
+/**
+ * @brief Set the expected SHA-256 digest of the image.
+ *
+ *	  The image is hashed as it is written, and the digest is compared
+ *	  when calling 'dfu_target_done' with 'successful' set. The expected
+ *	  digest is cleared when the DFU procedure is completed or reset.
+ *
+ *	  If the DFU procedure was resumed after a reboot, the beginning of
+ *	  the image has not been hashed and the comparison is skipped.
+ *
+ * @param[in] hash Expected digest, @ref DFU_TARGET_HASH_LEN bytes.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ **/
+int dfu_target_hash_set(const uint8_t *hash);
+#endif
+
 /**
  * @brief Deinitialize the resources that were needed for the current DFU
  *	  target.
@@ -104,6 +127,8 @@ int dfu_target_write(const void *const buf, size_t len);
  *
  * @return 0 for an successful deinitialization or a negative error
  *	   code identicating reason of failure.
+ * @retval -EBADMSG if a digest was set with 'dfu_target_hash_set' and the
+ *	   image does not match it. The DFU procedure is then aborted.
  **/
 int dfu_target_done(bool successful);
 
@@ -54,6 +54,31 @@ extern "C" {
 #define SUBS_PRIO_COUNT (SUBS_PRIO_MAX - SUBS_PRIO_MIN + 1)
 
 
+/** @brief Event lanes.
+ *
+ * Every lane is processed by a separate thread. Lanes are used only if
+ * CONFIG_DESKTOP_EVENT_MANAGER_LANES is enabled.
+ *
+ * The lane threads preempt each other. Handlers of a listener are not
+ * serialized, so all event types a listener subscribes to must be processed
+ * in the same lane. @ref event_manager_init fails otherwise. Data shared
+ * between listeners in different lanes must be protected by the listeners.
+ */
+enum event_lane {
+	/** Lane for latency-critical events. */
+	EVENT_LANE_REALTIME,
+
+	/** Default lane. */
+	EVENT_LANE_NORMAL,
+
+	/** Lane for events that are not time-critical. */
+	EVENT_LANE_BACKGROUND,
+
+	/** Number of lanes. */
+	EVENT_LANE_COUNT
+};
+
+
 /** @brief Event header.
  *
  * When defining an event structure, the event header
@@ -65,6 +90,11 @@ struct event_header {
 
 	/** Pointer to the event type object. */
 	const struct event_type *type_id;
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_TIMESTAMP
+	/** Submission time in cycles. */
+	uint32_t timestamp;
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_EVENT_TIMESTAMP */
 };
 
 
@@ -82,6 +112,34 @@ struct event_dyndata {
 };
 
 
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+/** @brief Histogram of times, in microseconds.
+ */
+struct event_histogram {
+	/** Number of samples in buckets. Bucket N holds samples from 2^N
+	 *  to 2^(N+1) - 1. The last bucket holds all larger samples. */
+	uint32_t buckets[CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAM_BUCKET_CNT];
+
+	/** Number of samples. */
+	uint32_t cnt;
+
+	/** Minimum sample. */
+	uint32_t min;
+
+	/** Maximum sample. */
+	uint32_t max;
+
+	/** Sum of samples. */
+	uint64_t total;
+
+	/** Lock protecting the histogram. Histograms of different event
+	 *  types and listeners are updated from different lanes without
+	 *  contention. */
+	struct k_spinlock lock;
+};
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
+
+
 /** @brief Event listener.
  *
  * All event listeners must be defined using @ref EVENT_LISTENER.
@@ -93,6 +151,11 @@ struct event_listener {
 	/** Pointer to the function that is called when an event
 	 *  is handled. */
 	bool (*notification)(const struct event_header *eh);
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+	/** Histogram of event handling times. */
+	struct event_histogram *exec_hist;
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
 };
 
 
@@ -101,6 +164,11 @@ struct event_listener {
 struct event_subscriber {
 	/** Pointer to the listener. */
 	const struct event_listener *listener;
+
+	/** Pointer to the function that is called when an event of the
+	 *  subscribed type is handled. If NULL, the notification function
+	 *  of the listener is called. */
+	bool (*notification)(const struct event_header *eh);
 };
 
 
@@ -122,6 +190,70 @@ struct event_info {
 };
 
 
+/** @brief Memory pool usage statistics.
+ */
+struct event_mem_stats {
+	/** Maximum number of blocks that were allocated at the same time. */
+	uint32_t max_used;
+
+	/** Number of allocations that were taken from another pool because
+	 *  the pool was exhausted. */
+	atomic_t fallback_cnt;
+
+	/** Number of allocations that failed because the pool and all pools
+	 *  tried after it were exhausted. */
+	atomic_t failed_cnt;
+};
+
+
+/** @brief Memory pool used to allocate events.
+ */
+struct event_mem_pool {
+	/** Memory slab holding the events. */
+	struct k_mem_slab *slab;
+
+	/** Usage statistics. */
+	struct event_mem_stats stats;
+};
+
+
+/** @brief Event lane statistics.
+ */
+struct event_lane_stats {
+	/** Number of events waiting in the queue. */
+	uint32_t queue_depth;
+
+	/** Maximum number of events waiting in the queue. */
+	uint32_t max_queue_depth;
+
+	/** Number of processed events. */
+	uint32_t event_cnt;
+
+	/** Minimum time from submission to processing, in cycles. */
+	uint32_t min_latency;
+
+	/** Maximum time from submission to processing, in cycles. */
+	uint32_t max_latency;
+
+	/** Sum of times from submission to processing, in cycles. */
+	uint64_t total_latency;
+};
+
+
+/** @brief Coalescing state of an event type.
+ */
+struct event_coalesce {
+	/** Event that is waiting in the queue and can be merged with. */
+	struct event_header *pending;
+
+	/** Sequence number of the queue batch the pending event belongs to. */
+	uint32_t seq;
+
+	/** Number of submitted events merged into pending events. */
+	atomic_t merged_cnt;
+};
+
+
 /** @brief Event type.
  */
 struct event_type {
@@ -144,6 +276,26 @@ struct event_type {
 
 	/** Logging and formatting information. */
 	const struct event_info *ev_info;
+
+	/** Lane in which events of this type are processed. */
+	uint8_t lane;
+
+	/** Coalescing state, NULL if events of this type are not merged. */
+	struct event_coalesce *coalesce;
+
+	/** Function merging a submitted event into the pending event. */
+	bool (*merge)(struct event_header *pending,
+		      const struct event_header *eh);
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+	/** Memory pool from which events of this type are allocated. */
+	struct event_mem_pool *mem_pool;
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+	/** Histogram of times from submission to processing. */
+	struct event_histogram *wait_hist;
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
 };
 
 
@@ -157,7 +309,9 @@ extern const struct event_type __stop_event_types[];
 /** Create an event listener object.
  *
  * @param lname   Module name.
- * @param cb_fn  Pointer to the event handler function.
+ * @param cb_fn  Pointer to the event handler function. Can be NULL if
+ *               the listener subscribes to all event types with
+ *               a dedicated handler (see @ref EVENT_SUBSCRIBE_HANDLER).
  */
 #define EVENT_LISTENER(lname, cb_fn) _EVENT_LISTENER(lname, cb_fn)
 
@@ -193,6 +347,51 @@ extern const struct event_type __stop_event_types[];
 	const struct {} _CONCAT(_CONCAT(__event_subscriber_, ename), final_sub_redefined) = {}
 
 
+/** Subscribe a listener to the early notification list for an
+ *  event type using a handler dedicated to this event type.
+ *
+ * @param lname    Name of the listener.
+ * @param ename    Name of the event.
+ * @param handler  Function called with the pointer to the event structure
+ *                 of the @p ename type (bool handler(const struct ename *)).
+ *                 The function returns true to consume the event.
+ */
+#define EVENT_SUBSCRIBE_EARLY_HANDLER(lname, ename, handler) \
+	_EVENT_SUBSCRIBE_HANDLER(lname, ename, _SUBS_PRIO_ID(_SUBS_PRIO_FIRST), \
+				 handler)
+
+
+/** Subscribe a listener to the normal notification list for an event
+ *  type using a handler dedicated to this event type.
+ *
+ * The handler is called directly for the subscribed event type, so it does
+ * not need to check the event type.
+ *
+ * @param lname    Name of the listener.
+ * @param ename    Name of the event.
+ * @param handler  Function called with the pointer to the event structure
+ *                 of the @p ename type (bool handler(const struct ename *)).
+ *                 The function returns true to consume the event.
+ */
+#define EVENT_SUBSCRIBE_HANDLER(lname, ename, handler) \
+	_EVENT_SUBSCRIBE_HANDLER(lname, ename, \
+				 _SUBS_PRIO_ID(_SUBS_PRIO_NORMAL), handler)
+
+
+/** Subscribe a listener to an event type as final module that is
+ *  being notified using a handler dedicated to this event type.
+ *
+ * @param lname    Name of the listener.
+ * @param ename    Name of the event.
+ * @param handler  Function called with the pointer to the event structure
+ *                 of the @p ename type (bool handler(const struct ename *)).
+ *                 The function returns true to consume the event.
+ */
+#define EVENT_SUBSCRIBE_FINAL_HANDLER(lname, ename, handler)					\
+	_EVENT_SUBSCRIBE_HANDLER(lname, ename, _SUBS_PRIO_ID(_SUBS_PRIO_FINAL), handler);	\
+	const struct {} _CONCAT(_CONCAT(__event_subscriber_, ename), final_sub_redefined) = {}
+
+
 /** Encode event data types or labels.
  *
  * @param ... Data types or labels to be encoded.
@@ -237,6 +436,49 @@ extern const struct event_type __stop_event_types[];
 #define EVENT_TYPE_DYNDATA_DECLARE(ename) _EVENT_TYPE_DYNDATA_DECLARE(ename)
 
 
+/** Process events of the event type in the given lane.
+ *
+ * Attribute of @ref EVENT_TYPE_DEFINE. The lane is used only if
+ * CONFIG_DESKTOP_EVENT_MANAGER_LANES is enabled. By default, events are
+ * processed in @ref EVENT_LANE_NORMAL.
+ *
+ * @param lane_id  Lane (@ref event_lane).
+ */
+#define EVENT_ATTR_LANE(lane_id) (_LANE, lane_id)
+
+
+/** Set the number of events in the memory slab of the event type.
+ *
+ * Attribute of @ref EVENT_TYPE_DEFINE. The value is used only if
+ * CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB is enabled. By default, the memory
+ * slab holds CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_BLOCK_CNT events.
+ *
+ * @param block_cnt  Number of events in the memory slab.
+ */
+#define EVENT_ATTR_MEM_SLAB(block_cnt) (_MEM_SLAB, block_cnt)
+
+
+/** Make the event type coalescing.
+ *
+ * Attribute of @ref EVENT_TYPE_DEFINE. A submitted event of this type can
+ * be merged into an event of the same type that is still waiting at the
+ * end of the queue. Events are never merged across events of other types,
+ * so merging does not change the order in which events are delivered.
+ * The merge function is called with the pending event and the submitted
+ * event. If it returns true, the submitted event is freed and is not
+ * delivered to listeners. If it returns false, the submitted event is
+ * queued and becomes the pending event.
+ *
+ * The merge function is called with interrupts locked and must be short.
+ * Events with dynamic data cannot be coalescing.
+ *
+ * @param merge_fn  Function merging a submitted event into the pending
+ *                  event (bool merge_fn(struct event_header *pending,
+ *                  const struct event_header *eh)).
+ */
+#define EVENT_ATTR_COALESCE(merge_fn) (_COALESCE, merge_fn)
+
+
 /** Define an event type.
  *
  * This macro defines an event type. In addition, it defines functions
@@ -251,14 +493,20 @@ extern const struct event_type __stop_event_types[];
  * - cast_<i>%event_type</i> - Casts the event header that is provided
  *                            as argument to an event of the given type.
  *
+ * The optional attributes @ref EVENT_ATTR_LANE, @ref EVENT_ATTR_MEM_SLAB,
+ * and @ref EVENT_ATTR_COALESCE can be combined in any order. Each of them
+ * can be given once.
+ *
  * @param ename     	   Name of the event.
  * @param init_log_en	   Bool indicating if the event is logged
  *                         by default.
  * @param log_fn  	   Function to stringify an event of this type.
  * @param ev_info_struct   Data structure describing the event type.
+ * @param ...              Optional attributes of the event type.
  */
-#define EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct) \
-	_EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)
+#define EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct, ...) \
+	_EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct, \
+			   ##__VA_ARGS__)
 
 
 /** Verify if an event ID is valid.
@@ -292,10 +540,81 @@ void _event_submit(struct event_header *eh);
 /** Initialize the Event Manager.
  *
  * @retval 0 If the operation was successful.
+ * @retval -EALREADY If the Event Manager is already initialized.
+ * @retval -EINVAL If a listener subscribes to event types processed in
+ *                 different lanes.
  */
 int event_manager_init(void);
 
 
+/** Get statistics of an event lane.
+ *
+ * If CONFIG_DESKTOP_EVENT_MANAGER_LANES is disabled, all events are
+ * processed in @ref EVENT_LANE_NORMAL.
+ *
+ * @param lane   Lane.
+ * @param stats  Pointer to the structure that is filled with statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If the lane is not used.
+ */
+int event_manager_lane_stats_get(enum event_lane lane,
+				 struct event_lane_stats *stats);
+
+
+/** Reset statistics of all event lanes.
+ */
+void event_manager_lane_stats_reset(void);
+
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+/** Get a consistent copy of a histogram.
+ *
+ * @param hist  Histogram of an event type or an event listener.
+ * @param copy  Pointer to the structure that is filled with the histogram.
+ */
+void event_manager_histogram_get(struct event_histogram *hist,
+				 struct event_histogram *copy);
+
+
+/** Reset histograms of all event types and event listeners.
+ */
+void event_manager_histograms_reset(void);
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
+
+
+/** Allocate memory for an event from the memory slabs.
+ *
+ * @param et    Pointer to the event type.
+ * @param size  Size of the event, including dynamic data.
+ *
+ * @return Pointer to the allocated memory or NULL if all memory slabs
+ *         that could hold the event are exhausted.
+ */
+void *_event_mem_alloc(const struct event_type *et, size_t size);
+
+
+/** Free an event that was allocated, but not submitted.
+ *
+ * Submitted events are freed by the Event Manager after they are processed.
+ *
+ * @param addr  Pointer to the event object.
+ */
+void event_manager_free(void *addr);
+
+
+/** Get a size-class memory pool.
+ *
+ * Size-class memory pools are used for events that do not fit into
+ * the memory pool of their event type.
+ *
+ * @param idx  Index of the memory pool.
+ *
+ * @return Pointer to the memory pool or NULL if the index is out of range.
+ */
+const struct event_mem_pool *event_manager_mem_pool_get(size_t idx);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef JSON_TOK_H__
+#define JSON_TOK_H__
+
+/**
+ * @file json_tok.h
+ *
+ * @defgroup json_tok JSON tokenizer
+ * @{
+ * @brief In-place JSON tokenizer with path queries.
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Type of a JSON value. */
+enum json_tok_type {
+	JSON_TOK_OBJECT,
+	JSON_TOK_ARRAY,
+	JSON_TOK_STRING,
+	JSON_TOK_NUMBER,
+	JSON_TOK_TRUE,
+	JSON_TOK_FALSE,
+	JSON_TOK_NULL,
+};
+
+/** @brief Location of a value in a JSON document.
+ *
+ *  The members of an object are stored as a string token for the key,
+ *  followed by the tokens of the value.
+ */
+struct json_tok {
+	/** Offset of the value in the document, strings start after the
+	 *  opening quote.
+	 */
+	uint16_t start;
+	/** Length of the value, strings are stored without their quotes. */
+	uint16_t len;
+	/** Index of the token following the value and all its children. */
+	uint16_t next;
+	/** Type of the value, see @ref json_tok_type. */
+	uint8_t type;
+};
+
+/** @brief Tokenized JSON document. */
+struct json_tok_doc {
+	/** Document, referenced and not copied. */
+	const char *json;
+	/** Token storage. */
+	struct json_tok *toks;
+	/** Number of tokens in the storage. */
+	uint16_t size;
+	/** Number of tokens used by the document. */
+	uint16_t count;
+};
+
+/** @brief Initialize a document.
+ *
+ *  @param[out] doc Document to initialize.
+ *  @param[in] toks Storage for the tokens.
+ *  @param[in] size Number of tokens, one is used per value and per key.
+ */
+void json_tok_init(struct json_tok_doc *doc, struct json_tok *toks,
+		   size_t size);
+
+/** @brief Tokenize a JSON document in a single pass.
+ *
+ *  The document is not modified or copied, and must be kept while the
+ *  tokens are used. The first token is the root value.
+ *
+ *  @param[in,out] doc Document initialized with @ref json_tok_init.
+ *  @param[in] json JSON document, does not need to be NULL terminated.
+ *  @param[in] len Length of the document.
+ *
+ *  @retval 0 If successful.
+ *  @retval -EINVAL If the document is not valid JSON.
+ *  @retval -ENOMEM If the document has more values than tokens.
+ *  @retval -E2BIG If the document is longer than 65535 bytes, or nested
+ *                 deeper than CONFIG_JSON_TOK_MAX_DEPTH.
+ */
+int json_tok_parse(struct json_tok_doc *doc, const char *json, size_t len);
+
+/** @brief Find a value by its path.
+ *
+ *  The path is a list of object keys and array indexes separated by dots,
+ *  for example "state.desired.config.GPS" or "topics.0". Keys containing
+ *  escape sequences or dots cannot be found.
+ *
+ *  @param[in] doc Tokenized document.
+ *  @param[in] tok Token the path starts from, 0 for the root value, or a
+ *                 negative error code.
+ *  @param[in] path Path of the value.
+ *
+ *  @return Index of the token of the value, or -ENOENT if not found.
+ */
+int json_tok_find(const struct json_tok_doc *doc, int tok, const char *path);
+
+/** @brief Get the type of a value.
+ *
+ *  @param[in] doc Tokenized document.
+ *  @param[in] tok Token of the value.
+ *
+ *  @return Type of the value, see @ref json_tok_type.
+ */
+static inline enum json_tok_type json_tok_type_get(
+	const struct json_tok_doc *doc, int tok)
+{
+	return (enum json_tok_type)doc->toks[tok].type;
+}
+
+/** @brief Compare a string value, without unescaping it.
+ *
+ *  @param[in] doc Tokenized document.
+ *  @param[in] tok Token of the value, or a negative error code.
+ *  @param[in] str NULL terminated string to compare with.
+ *
+ *  @return true If the value is a string equal to @p str.
+ */
+bool json_tok_str_eq(const struct json_tok_doc *doc, int tok, const char *str);
+
+/** @brief Copy a string value, with escape sequences decoded.
+ *
+ *  Like snprintf, the copy is truncated to fit the buffer and is always
+ *  NULL terminated, unless @p size is 0.
+ *
+ *  @param[in] doc Tokenized document.
+ *  @param[in] tok Token of the value, or a negative error code.
+ *  @param[out] buf Buffer for the string, can be NULL if @p size is 0.
+ *  @param[in] size Size of the buffer.
+ *
+ *  @return Length of the decoded string, without the NULL terminator. If it
+ *          is @p size or more, the copy was truncated.
+ *  @retval -EINVAL If the value is not a string.
+ */
+int json_tok_str_copy(const struct json_tok_doc *doc, int tok, char *buf,
+		      size_t size);
+
+/** @brief Get an integer value.
+ *
+ *  @param[in] doc Tokenized document.
+ *  @param[in] tok Token of the value, or a negative error code.
+ *  @param[out] value Value.
+ *
+ *  @retval 0 If successful.
+ *  @retval -EINVAL If the value is not an integer number.
+ *  @retval -ERANGE If the value does not fit an int.
+ */
+int json_tok_int_get(const struct json_tok_doc *doc, int tok, int *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* JSON_TOK_H__ */
@@ -23,6 +23,7 @@ extern "C" {
 
 #include <zephyr/types.h>
 #include <stddef.h>
+#include <kernel.h>
 
 /**
  * @brief AT command return codes
@@ -54,6 +55,89 @@ enum at_cmd_state {
  */
 typedef void (*at_cmd_handler_t)(const char *response);
 
+struct at_cmd_req;
+
+/**
+ * @typedef at_cmd_req_handler_t
+ *
+ * Completion callback of an asynchronous AT command request. It is called
+ * once the request has completed, with @ref at_cmd_req.state and
+ * @ref at_cmd_req.code set. The callback owns the request from this point on,
+ * it may for example free or resubmit it.
+ *
+ * @param req Completed request.
+ */
+typedef void (*at_cmd_req_handler_t)(struct at_cmd_req *req);
+
+/**
+ * @brief Asynchronous AT command request.
+ *
+ * The request is owned by the driver from @ref at_cmd_req_submit until it
+ * completes, and must stay valid during that time. Initialize it with
+ * @ref at_cmd_req_init before filling in the optional fields.
+ */
+struct at_cmd_req {
+	/** Null terminated AT command string. */
+	const char *cmd;
+	/** Buffer for the response payload, can be NULL. */
+	char *resp;
+	/** Size of the response buffer. */
+	size_t resp_size;
+	/** Handler called with the response payload, can be NULL.
+	 *  Runs from at_cmd's thread.
+	 */
+	at_cmd_handler_t handler;
+	/** Completion callback, can be NULL. Runs from at_cmd's thread when
+	 *  the modem responds, from the system workqueue when the request
+	 *  times out, and from the thread that submitted a request when
+	 *  writing the command fails. It must not block. Requests with a
+	 *  completion callback cannot be waited for with @ref at_cmd_req_wait.
+	 */
+	at_cmd_req_handler_t done;
+	/** Time to wait for the modem response after the command is written,
+	 *  in milliseconds, or SYS_FOREVER_MS. After a timeout, the next
+	 *  command is written once the modem has answered a sync command.
+	 *  If the sync command is not answered either, the queued requests
+	 *  complete with -ETIMEDOUT.
+	 */
+	int32_t timeout_ms;
+	/** State of the completed command. */
+	enum at_cmd_state state;
+	/** Return code of the completed command, as returned by
+	 *  @ref at_cmd_write. -ETIMEDOUT if the modem did not respond in time.
+	 */
+	int code;
+
+	/* Private members, used by the driver. */
+	sys_snode_t node;
+	struct k_sem sem;
+	uint32_t enqueue_time;
+	uint32_t write_time;
+};
+
+/**
+ * @brief AT command driver metrics.
+ *
+ * Queue time is measured from submission until the command is written to the
+ * modem, modem time from the write until the response is received.
+ */
+struct at_cmd_metrics {
+	/** Number of completed commands. */
+	uint32_t cmd_cnt;
+	/** Number of commands that timed out. */
+	uint32_t timeout_cnt;
+	/** Number of commands sent as part of a batch. */
+	uint32_t batched_cnt;
+	/** Longest queue time in microseconds. */
+	uint32_t queue_time_max_us;
+	/** Sum of queue times in microseconds. */
+	uint64_t queue_time_total_us;
+	/** Longest modem time in microseconds. */
+	uint32_t modem_time_max_us;
+	/** Sum of modem times in microseconds. */
+	uint64_t modem_time_total_us;
+};
+
 /**@brief Initialize or recover the AT command driver.
  *
  * @return Zero on success, non-zero otherwise.
@@ -132,6 +216,65 @@ int at_cmd_write(const char *const cmd,
 		 size_t buf_len,
 		 enum at_cmd_state *state);
 
+/**
+ * @brief Initialize an asynchronous AT command request.
+ *
+ * Clears the request, sets the command and the default response timeout
+ * (CONFIG_AT_CMD_RESPONSE_TIMEOUT).
+ *
+ * @param req Request to initialize.
+ * @param cmd Pointer to null terminated AT command string. Must stay valid
+ *            until the request completes.
+ */
+void at_cmd_req_init(struct at_cmd_req *req, const char *cmd);
+
+/**
+ * @brief Queue an AT command request without waiting for the response.
+ *
+ * Requests are written to the modem in submission order, one command line
+ * at a time. If CONFIG_AT_CMD_BATCH is enabled, consecutive read
+ * commands (AT+<name>? or AT%<name>?) may be sent together in one line and
+ * their responses are split among the requests.
+ *
+ * The function blocks if CONFIG_AT_CMD_QUEUE_LEN requests are
+ * already pending.
+ *
+ * @param req Initialized request.
+ *
+ * @retval 0 If the request was queued.
+ * @retval -EINVAL If the request or its command is NULL.
+ * @retval -EHOSTDOWN If bsdlib is shutdown.
+ */
+int at_cmd_req_submit(struct at_cmd_req *req);
+
+/**
+ * @brief Wait for a submitted request to complete.
+ *
+ * @note Must not be called from at_cmd's thread, as that would lead to a
+ *       deadlock, or for requests with a completion callback.
+ *
+ * @param req Submitted request.
+ * @param timeout Time to wait.
+ *
+ * @retval -EAGAIN If the request did not complete in time.
+ * @return The request return code otherwise, see @ref at_cmd_write.
+ */
+int at_cmd_req_wait(struct at_cmd_req *req, k_timeout_t timeout);
+
+#if defined(CONFIG_AT_CMD_METRICS)
+/**
+ * @brief Get a snapshot of the AT command driver metrics.
+ *
+ * @param metrics Structure to copy the metrics to.
+ */
+void at_cmd_metrics_get(struct at_cmd_metrics *metrics);
+
+/**
+ * @brief Reset the AT command driver metrics.
+ */
+void at_cmd_metrics_reset(void);
+#endif
+
 /**
  * @brief Function to set AT command global notification handler
  *
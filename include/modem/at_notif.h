@@ -78,6 +78,56 @@ int at_notif_register_handler(void *context, at_notif_handler_t handler);
  */
 int at_notif_deregister_handler(void *context, at_notif_handler_t handler);
 
+/**
+ * @brief Function to register a handler for notifications with a prefix
+ *
+ * The handler is called only for notifications whose name, which is the text
+ * before the first ':', equals @p prefix. For example, a handler registered
+ * for "+CEREG" receives "+CEREG: 1" but not "+CEREGX: 1" or "%CESQ: 1".
+ * Notifications are routed through a hash table, so handlers of other
+ * notifications are not called.
+ *
+ * Handlers registered for a prefix are called before the handlers registered
+ * with @ref at_notif_register_handler.
+ *
+ * @note  If the same combination of prefix, context and handler exists in
+ *        the memory, then the request will be ignored and command execution
+ *        will be regarded as finished successfully.
+ *
+ * @param prefix  Notification name, for example "+CEREG". A trailing ':' is
+ *                ignored.
+ * @param context Pointer to context provided by the module which has
+ *                registered the handler.
+ * @param handler Pointer to a received notification handler function of type
+ *                @ref at_notif_handler_t.
+ *
+ * @retval 0            If command execution was successful.
+ * @retval -ENOBUFS     If memory cannot be allocated.
+ * @retval -EINVAL      If handler is a NULL pointer or the prefix is invalid
+ *                      or longer than CONFIG_AT_NOTIF_PREFIX_MAX_LEN.
+ */
+int at_notif_register_prefix(const char *prefix, void *context,
+			     at_notif_handler_t handler);
+
+/**
+ * @brief Function to de-register a notification handler registered for a
+ *        prefix
+ *
+ * Once the function returns, the handler is no longer called, unless the
+ * function is called from a notification handler.
+ *
+ * @param prefix  Notification name used in registration.
+ * @param context Pointer to context provided by the module which has
+ *                registered the handler.
+ * @param handler Pointer to a received notification handler function of type
+ *                @ref at_notif_handler_t.
+ *
+ * @retval 0            If command execution was successful.
+ * @retval -EINVAL      If handler is a NULL pointer or the prefix is invalid.
+ */
+int at_notif_deregister_prefix(const char *prefix, void *context,
+			       at_notif_handler_t handler);
+
 /** @} */
 
 #ifdef __cplusplus
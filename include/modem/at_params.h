@@ -22,11 +22,17 @@
  * All parameters values are copied in the list. Parameters should be
  * cleared to free that memory. Getter and setter methods are available
  * to read and write parameter values.
+ *
+ * A list can also be created in caller-provided storage and in zero-copy
+ * mode. In this mode, string and array parameters reference the parsed
+ * string instead of being copied, so no memory is allocated.
  */
 #ifndef AT_PARAMS_H__
 #define AT_PARAMS_H__
 
 #include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,6 +69,8 @@ struct at_param {
 	enum at_param_type type;
 	size_t size;
 	union at_param_value value;
+	/** Value references external memory and is not freed. */
+	bool is_ref;
 };
 
 /**
@@ -74,6 +82,10 @@ struct at_param {
 struct at_param_list {
 	size_t param_count;
 	struct at_param *params;
+	/** Parameter array is provided by the caller. */
+	bool static_storage;
+	/** Parser stores references to the parsed string. */
+	bool zero_copy;
 };
 
 /**
@@ -92,6 +104,26 @@ struct at_param_list {
  */
 int at_params_list_init(struct at_param_list *list, size_t max_params_count);
 
+/**
+ * @brief Create a list of parameters in caller-provided storage.
+ *
+ * No memory is allocated. Each parameter is initialized to its default value.
+ * If @p zero_copy is set, the AT command parser stores string and array
+ * parameters as references to the parsed string. The parsed string must
+ * then stay unchanged as long as the parameters are used.
+ *
+ * @param[in] list Parameter list to initialize.
+ * @param[in] params Array of parameters used to store the list.
+ * @param[in] max_params_count Number of elements in @p params.
+ * @param[in] zero_copy Store references instead of copies of parameters.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_params_list_init_static(struct at_param_list *list,
+			       struct at_param *params,
+			       size_t max_params_count, bool zero_copy);
+
 /**
  * @brief Clear/reset all parameter types and values.
  *
@@ -182,6 +214,45 @@ int at_params_string_put(const struct at_param_list *list, size_t index,
 int at_params_array_put(const struct at_param_list *list, size_t index,
 			const uint32_t *array, size_t array_len);
 
+/**
+ * @brief Add a parameter in the list at the specified index and assign it a
+ * string value by reference.
+ *
+ * The string is not copied. It must stay unchanged as long as the parameter
+ * is used. If a parameter exists at this index, it is replaced.
+ *
+ * @param[in] list    Parameter list.
+ * @param[in] index   Index in the list where to put the parameter.
+ * @param[in] str     Pointer to the string value.
+ * @param[in] str_len Number of characters of the string value @p str.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_params_string_ref_put(const struct at_param_list *list, size_t index,
+			     const char *str, size_t str_len);
+
+/**
+ * @brief Add a parameter in the list at the specified index and assign it an
+ * array type value by reference.
+ *
+ * The array is stored as a reference to its textual representation, for
+ * example "1,2,3)". Values are converted when the array is read with
+ * @ref at_params_array_get. The string must stay unchanged as long as the
+ * parameter is used. If a parameter exists at this index, it is replaced.
+ *
+ * @param[in] list      Parameter list.
+ * @param[in] index     Index in the list where to put the parameter.
+ * @param[in] str       Pointer to the first array value in the string.
+ * @param[in] array_len Size of the converted array in bytes (must be
+ *                      divisible by 4).
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_params_array_ref_put(const struct at_param_list *list, size_t index,
+			    const char *str, size_t array_len);
+
 /**
  * @brief Add a parameter in the list at the specified index and assign it a
  * empty status.
@@ -264,6 +335,25 @@ int at_params_int_get(const struct at_param_list *list, size_t index,
 int at_params_string_get(const struct at_param_list *list, size_t index,
 			 char *value, size_t *len);
 
+/**
+ * @brief Get a pointer to a string parameter value.
+ *
+ * The parameter type must be a string, or an error is returned.
+ * The string is not copied and is not null-terminated. The pointer is valid
+ * until the parameter is changed or the list is cleared and, for lists in
+ * zero-copy mode, as long as the parsed string is unchanged.
+ *
+ * @param[in]  list    Parameter list.
+ * @param[in]  index   Parameter index in the list.
+ * @param[out] str     Pointer to the string value.
+ * @param[out] len     Length of the string value in bytes.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_params_string_ptr_get(const struct at_param_list *list, size_t index,
+			     const char **str, size_t *len);
+
 /**
  * @brief Get a parameter value as a array.
  *
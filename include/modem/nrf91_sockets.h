@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NRF91_SOCKETS_H__
+#define NRF91_SOCKETS_H__
+
+/**
+ * @file nrf91_sockets.h
+ *
+ * @defgroup nrf91_sockets nrf91 socket offload extensions
+ * @{
+ * @brief Extensions to the socket API for offloaded nrf91 sockets.
+ */
+
+#include <zephyr/types.h>
+#include <bsd_limits.h>
+#include <nrf_socket.h>
+#include <net/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Persistent set of sockets to poll.
+ *
+ *  The sockets are resolved to modem sockets and their events are
+ *  translated once, when they are added to the set, instead of on every
+ *  call to poll(). The members are internal to the library.
+ */
+struct nrf91_pollset {
+	/** Modem sockets and events, passed as is to the modem. */
+	struct nrf_pollfd nrf_fds[BSD_MAX_SOCKET_COUNT];
+	/** File descriptors of the sockets. */
+	int fds[BSD_MAX_SOCKET_COUNT];
+	/** Number of sockets in the set. */
+	uint8_t count;
+	/** Socket that is reported first by the next wait. */
+	uint8_t next;
+};
+
+/** @brief Event reported for a socket of a set. */
+struct nrf91_poll_event {
+	/** File descriptor of the socket. */
+	int fd;
+	/** Events that occurred, POLLIN, POLLOUT, POLLERR, POLLHUP or
+	 *  POLLNVAL, like the revents field of struct pollfd.
+	 */
+	short revents;
+};
+
+/** @brief Initialize an empty set.
+ *
+ *  @param[out] set Set to initialize.
+ */
+void nrf91_pollset_init(struct nrf91_pollset *set);
+
+/** @brief Add a socket to a set.
+ *
+ *  A socket must be removed from all sets before it is closed.
+ *
+ *  @param[in,out] set Set.
+ *  @param[in] fd File descriptor of an nrf91 socket.
+ *  @param[in] events Events to wait for, POLLIN, POLLOUT or both.
+ *
+ *  @retval 0 If successful.
+ *  @retval -EINVAL If a parameter is invalid.
+ *  @retval -EBADF If @p fd is not an nrf91 socket.
+ *  @retval -EEXIST If @p fd is already in the set.
+ *  @retval -ENOMEM If the set is full.
+ */
+int nrf91_pollset_add(struct nrf91_pollset *set, int fd, short events);
+
+/** @brief Change the events to wait for on a socket of a set.
+ *
+ *  @param[in,out] set Set.
+ *  @param[in] fd File descriptor of the socket.
+ *  @param[in] events Events to wait for, POLLIN, POLLOUT or both.
+ *
+ *  @retval 0 If successful.
+ *  @retval -EINVAL If a parameter is invalid.
+ *  @retval -ENOENT If @p fd is not in the set.
+ */
+int nrf91_pollset_modify(struct nrf91_pollset *set, int fd, short events);
+
+/** @brief Remove a socket from a set.
+ *
+ *  @param[in,out] set Set.
+ *  @param[in] fd File descriptor of the socket.
+ *
+ *  @retval 0 If successful.
+ *  @retval -EINVAL If a parameter is invalid.
+ *  @retval -ENOENT If @p fd is not in the set.
+ */
+int nrf91_pollset_remove(struct nrf91_pollset *set, int fd);
+
+/** @brief Wait for events on the sockets of a set.
+ *
+ *  Only the sockets with events are reported. If more sockets than
+ *  @p max_events have events, the next wait starts with the first socket
+ *  that was not reported, so that all sockets are served in turn.
+ *
+ *  A set must not be used by several threads at the same time.
+ *
+ *  @param[in,out] set Set.
+ *  @param[out] events Events of the sockets.
+ *  @param[in] max_events Size of @p events.
+ *  @param[in] timeout Timeout in milliseconds, -1 to wait forever.
+ *
+ *  @return Number of events, 0 on timeout, or a negative error code. The
+ *          error code is the native errno value set by the modem library,
+ *          or -EIO if it could not be translated.
+ */
+int nrf91_pollset_wait(struct nrf91_pollset *set,
+		       struct nrf91_poll_event *events, int max_events,
+		       int timeout);
+
+/** @brief Receive a message into several buffers.
+ *
+ *  Like recvmsg(), which is not supported by the socket offload API. A
+ *  message received into a single buffer is passed to the modem as is.
+ *  Otherwise it is received in one call to the modem and then scattered
+ *  into the buffers, so that a datagram is not split.
+ *
+ *  A datagram longer than the buffers is truncated, and MSG_TRUNC is set
+ *  in msg_flags. Its real length is returned if @p flags has MSG_TRUNC.
+ *
+ *  @param[in] fd File descriptor of an nrf91 socket.
+ *  @param[in,out] msg Buffers to receive into, and the address of the
+ *                     sender if msg_name is not NULL.
+ *  @param[in] flags Flags, as for recv().
+ *
+ *  @return Number of bytes received, or -1 with errno set on error.
+ */
+ssize_t nrf91_socket_recvmsg(int fd, struct msghdr *msg, int flags);
+
+/** @brief Statistics of the DNS cache. */
+struct nrf91_dns_cache_stats {
+	/** Lookups answered with cached addresses. */
+	uint32_t hits;
+	/** Lookups answered with a cached failure to resolve the name. */
+	uint32_t negative_hits;
+	/** Lookups that were not cached and were passed to the modem. */
+	uint32_t misses;
+	/** Entries that were replaced before they expired. */
+	uint32_t evictions;
+};
+
+/** @brief Resolve a host name and store the result in the DNS cache.
+ *
+ *  The name is resolved even if it is cached, so that the entry is
+ *  refreshed. Later calls to getaddrinfo() with the same parameters are
+ *  answered from the cache.
+ *
+ *  @param[in] node Host name.
+ *  @param[in] service Service name or port, can be NULL.
+ *  @param[in] hints Hints, can be NULL.
+ *
+ *  @return 0 if successful, or a DNS_EAI error code from getaddrinfo().
+ */
+int nrf91_dns_cache_prefetch(const char *node, const char *service,
+			     const struct zsock_addrinfo *hints);
+
+/** @brief Remove the entries of a host name from the DNS cache.
+ *
+ *  The cache does not know whether the addresses it returns can be
+ *  reached. Call this when connecting to an address of @p node fails, so
+ *  that the next call to getaddrinfo() resolves the name again instead of
+ *  returning the same addresses until the entry expires.
+ *
+ *  @param[in] node Host name.
+ */
+void nrf91_dns_cache_invalidate(const char *node);
+
+/** @brief Remove all entries from the DNS cache. */
+void nrf91_dns_cache_flush(void);
+
+/** @brief Get the statistics of the DNS cache.
+ *
+ *  @param[out] stats Statistics since boot.
+ */
+void nrf91_dns_cache_stats_get(struct nrf91_dns_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* NRF91_SOCKETS_H__ */
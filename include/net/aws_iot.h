@@ -85,13 +85,21 @@ enum aws_iot_evt_type {
 	AWS_IOT_EVT_FOTA_ERASE_DONE,
 	/** FOTA progress notification. */
 	AWS_IOT_EVT_FOTA_DL_PROGRESS,
+	/** Chunk of data received from AWS message broker. Messages larger
+	 *  than CONFIG_AWS_IOT_MQTT_PAYLOAD_BUFFER_LEN are received in chunks
+	 *  if CONFIG_AWS_IOT_MQTT_PAYLOAD_STREAM is enabled.
+	 */
+	AWS_IOT_EVT_DATA_RECEIVED_CHUNK,
 	/** AWS IoT library error. */
 	AWS_IOT_EVT_ERROR
 };
 
 /** @brief AWS IoT topic data. */
 struct aws_iot_topic_data {
-	/** Type of shadow topic that will be published to. */
+	/** Type of shadow topic that will be published to. For received
+	 *  messages, the shadow of the topic the message was received on, or
+	 *  AWS_IOT_SHADOW_TOPIC_UNKNOWN for application topics.
+	 */
 	enum aws_iot_topic_type type;
 	/** Pointer to string of application specific topic. */
 	const char *str;
@@ -121,12 +129,29 @@ struct aws_iot_data {
 	enum mqtt_qos qos;
 };
 
+/** @brief Chunk of a message received from the AWS IoT broker. */
+struct aws_iot_data_chunk {
+	/** Chunk data, and topic the message was received on. */
+	struct aws_iot_data msg;
+	/** Offset of the chunk in the message. */
+	size_t offset;
+	/** Length of the message. */
+	size_t total_len;
+	/** 0, or a negative error code if the rest of the message could not
+	 *  be received. The event then holds no data, and is the last one for
+	 *  the message.
+	 */
+	int err;
+};
+
 /** @brief Struct with data received from AWS IoT broker. */
 struct aws_iot_evt {
 	/** Type of event. */
 	enum aws_iot_evt_type type;
 	union {
 		struct aws_iot_data msg;
+		/** Received data, for AWS_IOT_EVT_DATA_RECEIVED_CHUNK. */
+		struct aws_iot_data_chunk chunk;
 		int err;
 		/** FOTA progress in percentage. */
 		int fota_progress;
@@ -42,6 +42,7 @@ enum cloud_event_type {
 	CLOUD_EVT_FOTA_ERASE_PENDING,
 	CLOUD_EVT_FOTA_ERASE_DONE,
 	CLOUD_EVT_FOTA_DL_PROGRESS,
+	CLOUD_EVT_DATA_RECEIVED_CHUNK,
 	CLOUD_EVT_COUNT
 };
 
@@ -122,11 +123,28 @@ struct cloud_msg {
 	struct cloud_endpoint endpoint;
 };
 
+/**@brief Chunk of a received cloud message. */
+struct cloud_msg_chunk {
+	/** Chunk data, and endpoint the message was received on. */
+	struct cloud_msg msg;
+	/** Offset of the chunk in the message. */
+	size_t offset;
+	/** Length of the message. */
+	size_t total_len;
+	/** 0, or a negative error code if the rest of the message could not
+	 *  be received. The event then holds no data, and is the last one for
+	 *  the message.
+	 */
+	int err;
+};
+
 /**@brief Cloud event type. */
 struct cloud_event {
 	enum cloud_event_type type;
 	union {
 		struct cloud_msg msg;
+		/** Received data, for CLOUD_EVT_DATA_RECEIVED_CHUNK. */
+		struct cloud_msg_chunk chunk;
 		int err;
 		/** FOTA progress in percentage. */
 		int fota_progress;
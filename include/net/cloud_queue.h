@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef CLOUD_QUEUE_H__
+#define CLOUD_QUEUE_H__
+
+/**
+ * @brief Store and forward queue for cloud messages
+ * @defgroup cloud_queue Cloud message queue
+ * @{
+ */
+
+#include <zephyr.h>
+#include <net/cloud.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief Priority of a queued message. */
+enum cloud_queue_priority {
+	/** Sent together with the next messages of higher priority. */
+	CLOUD_QUEUE_PRIORITY_LOW,
+	/** Sent after CONFIG_CLOUD_QUEUE_FLUSH_DELAY seconds at the latest,
+	 *  together with the messages queued in the meantime.
+	 */
+	CLOUD_QUEUE_PRIORITY_NORMAL,
+	/** Sent as soon as possible. */
+	CLOUD_QUEUE_PRIORITY_HIGH,
+	CLOUD_QUEUE_PRIORITY_COUNT
+};
+
+/**@brief Initialize the queue.
+ *
+ * Messages stored in flash before a reset are restored. Their time to live
+ * continues from the time the queue last wrote to flash before the reset, as
+ * the time spent in reset is unknown.
+ *
+ * @param backend Cloud backend the messages are sent to.
+ *
+ * @retval 0 If successful.
+ * @return A negative error code if the flash partition could not be used.
+ */
+int cloud_queue_init(const struct cloud_backend *const backend);
+
+/**@brief Store a message in the queue.
+ *
+ * The message is copied to flash, and is sent when sending is enabled
+ * (see @ref cloud_queue_send_enable). When the queue is full, the oldest
+ * messages are dropped to make room for the new one.
+ *
+ * Only messages sent to the default topic of an endpoint type can be queued,
+ * the endpoint string must be empty.
+ *
+ * @param msg Message to store.
+ * @param priority Priority of the message.
+ * @param ttl Time in seconds after which the message is dropped if it has
+ *            not been sent, or 0 to never drop it.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If a parameter is invalid.
+ * @retval -ENOTSUP If the message has an endpoint string.
+ * @retval -EMSGSIZE If the message is larger than the batch buffer.
+ * @return Another negative error code if the message could not be stored.
+ */
+int cloud_queue_add(const struct cloud_msg *const msg,
+		    enum cloud_queue_priority priority, uint32_t ttl);
+
+/**@brief Enable or disable sending of queued messages.
+ *
+ * Sending should be enabled when the cloud backend is ready, and disabled
+ * when it disconnects, or when the application does not want the radio to be
+ * used. When enabled, the messages of normal and high priority are sent.
+ *
+ * Sending is disabled after @ref cloud_queue_init.
+ *
+ * @param enable True to enable sending.
+ */
+void cloud_queue_send_enable(bool enable);
+
+/**@brief Send all queued messages.
+ *
+ * Messages are sent by priority, oldest first. Messages with the same
+ * endpoint and QoS are batched, see CONFIG_CLOUD_QUEUE_BATCH_MAX_COUNT.
+ * Messages that could not be sent stay in the queue.
+ *
+ * @retval 0 If all messages were sent.
+ * @retval -EAGAIN If sending is disabled.
+ * @return Another negative error code returned by @ref cloud_send.
+ */
+int cloud_queue_flush(void);
+
+/**@brief Get the number of messages in the queue.
+ *
+ * @return Number of messages that have not been sent.
+ */
+size_t cloud_queue_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ *@}
+ */
+
+#endif /* CLOUD_QUEUE_H__ */
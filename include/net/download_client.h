@@ -28,6 +28,18 @@
 extern "C" {
 #endif
 
+#if defined(CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE)
+#define DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH \
+	CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH
+#else
+#define DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH 1
+#endif
+
+/* Room for the GET request line, header fields, and range offsets */
+#define DOWNLOAD_CLIENT_HTTP_REQ_BUF_SIZE \
+	(CONFIG_DOWNLOAD_CLIENT_MAX_HOSTNAME_SIZE + \
+	 CONFIG_DOWNLOAD_CLIENT_MAX_FILENAME_SIZE + 128)
+
 /**
  * @brief Download client event IDs.
  */
@@ -60,6 +72,13 @@ enum download_client_evt_id {
 	DOWNLOAD_CLIENT_EVT_ERROR,
 	/** Download complete. */
 	DOWNLOAD_CLIENT_EVT_DONE,
+	/**
+	 * Download statistics.
+	 * Sent periodically and before @ref DOWNLOAD_CLIENT_EVT_DONE
+	 * if @c CONFIG_DOWNLOAD_CLIENT_STATS is enabled.
+	 * The return value is ignored.
+	 */
+	DOWNLOAD_CLIENT_EVT_STATS,
 };
 
 struct download_fragment {
@@ -67,6 +86,26 @@ struct download_fragment {
 	size_t len;
 };
 
+/**
+ * @brief Download statistics.
+ */
+struct download_client_stats {
+	/** Bytes downloaded since the download was started. */
+	size_t bytes;
+	/** Time since the download was started, in milliseconds. */
+	uint32_t elapsed_ms;
+	/** Average throughput, in bytes per second. */
+	uint32_t throughput;
+	/** Number of round-trip time samples. */
+	uint32_t rtt_cnt;
+	/** Shortest time from request to response header, in milliseconds. */
+	uint32_t rtt_min_ms;
+	/** Longest time from request to response header, in milliseconds. */
+	uint32_t rtt_max_ms;
+	/** Average time from request to response header, in milliseconds. */
+	uint32_t rtt_avg_ms;
+};
+
 /**
  * @brief Download client event.
  */
@@ -79,6 +118,8 @@ struct download_client_evt {
 		int error;
 		/** Fragment data. */
 		struct download_fragment fragment;
+		/** Download statistics. */
+		struct download_client_stats stats;
 	};
 };
 
@@ -132,6 +173,8 @@ struct download_client {
 	size_t file_size;
 	/** Download progress, number of bytes downloaded. */
 	size_t progress;
+	/** End of the requested range (exclusive), or zero for end of file. */
+	size_t range_end;
 
 	/** Server hosting the file, null-terminated. */
 	const char *host;
@@ -150,6 +193,24 @@ struct download_client {
 		bool has_header;
 		/** The server has closed the connection. */
 		bool connection_close;
+		/** File offset of the next range to request. */
+		size_t req_off;
+		/** File offset where the current response ends. */
+		size_t frag_end;
+		/** Bytes of the next response received with the current one. */
+		size_t carry;
+		/** Number of requests sent. */
+		uint32_t req_cnt;
+		/** Number of responses received. */
+		uint32_t resp_cnt;
+#if defined(CONFIG_DOWNLOAD_CLIENT_STATS)
+		/** Send time of the requests in flight. */
+		uint32_t req_time[DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH];
+#endif
+#if defined(CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE)
+		/** Request buffer, the response buffer may be in use. */
+		char req_buf[DOWNLOAD_CLIENT_HTTP_REQ_BUF_SIZE];
+#endif
 	} http;
 
 	struct {
@@ -159,6 +220,8 @@ struct download_client {
 
 	/** Internal thread ID. */
 	k_tid_t tid;
+	/** Given to let the internal thread start a download. */
+	struct k_sem start_sem;
 	/** Internal download thread. */
 	struct k_thread thread;
 	/** Internal thread stack. */
@@ -167,6 +230,44 @@ struct download_client {
 
 	/** Event handler. */
 	download_client_callback_t callback;
+
+#if defined(CONFIG_DOWNLOAD_CLIENT_DOUBLE_BUFFER)
+	struct {
+		/** Fragment being processed by the application. */
+		char buf[CONFIG_DOWNLOAD_CLIENT_BUF_SIZE];
+		/** Fragment length. */
+		size_t len;
+		/** Return value of the last fragment event. */
+		int rc;
+		/** Given when a fragment is ready. */
+		struct k_sem ready;
+		/** Given when the application is done with the fragment. */
+		struct k_sem free;
+		/** Internal thread ID. */
+		k_tid_t tid;
+		/** Internal fragment thread. */
+		struct k_thread thread;
+		/** Internal thread stack. */
+		K_THREAD_STACK_MEMBER(thread_stack,
+				      CONFIG_DOWNLOAD_CLIENT_CALLBACK_STACK_SIZE);
+	} dbuf;
+#endif
+
+#if defined(CONFIG_DOWNLOAD_CLIENT_STATS)
+	struct {
+		/** Uptime when the download was started. */
+		uint32_t start_time;
+		/** Progress when the download was started. */
+		size_t start_progress;
+		/** Uptime of the last statistics event. */
+		uint32_t evt_time;
+		/** Round-trip time samples, in milliseconds. */
+		uint32_t rtt_cnt;
+		uint32_t rtt_min;
+		uint32_t rtt_max;
+		uint32_t rtt_total;
+	} stats;
+#endif
 };
 
 /**
@@ -203,6 +304,11 @@ int download_client_connect(struct download_client *client, const char *host,
  * which are delivered to the application
  * via @ref DOWNLOAD_CLIENT_EVT_FRAGMENT events.
  *
+ * If @c CONFIG_DOWNLOAD_CLIENT_DOUBLE_BUFFER is enabled, fragment events are
+ * sent from a separate thread while the next fragment is being received.
+ * A fragment refused by the application then stops the download after the
+ * fragment that is being received at that time.
+ *
  * @param[in] client	Client instance.
  * @param[in] file	File to download, null-terminated.
  * @param[in] from	Offset from where to resume the download,
@@ -213,6 +319,25 @@ int download_client_connect(struct download_client *client, const char *host,
 int download_client_start(struct download_client *client, const char *file,
 			  size_t from);
 
+/**
+ * @brief Download a byte range of the given file.
+ *
+ * Same as @ref download_client_start, but the download completes with a
+ * @ref DOWNLOAD_CLIENT_EVT_DONE event once the byte before @p to has been
+ * received. Range downloads are only supported over HTTP and HTTPS.
+ *
+ * @param[in] client	Client instance.
+ * @param[in] file	File to download, null-terminated.
+ * @param[in] from	Offset of the first byte to download.
+ * @param[in] to	Offset after the last byte to download,
+ *			or zero to download until the end of the file.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ * @retval -ENOTSUP if @p to is set and the protocol is not HTTP(S).
+ */
+int download_client_range_start(struct download_client *client,
+				const char *file, size_t from, size_t to);
+
 /**
  * @brief Pause the download.
  *
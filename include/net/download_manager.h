@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file download_manager.h
+ *
+ * @defgroup download_manager Download manager
+ * @{
+ * @brief Parallel, resumable download of a file over several connections.
+ *
+ * @details The file is split into byte ranges which are downloaded over
+ * several @ref download_client instances, possibly from different hosts
+ * (mirrors) serving the same file. Failed ranges are retried independently
+ * and, if @c CONFIG_DOWNLOAD_MANAGER_SAVE_PROGRESS is enabled, the progress
+ * of each range is stored using the settings subsystem, so that a download
+ * interrupted by a reboot only fetches the missing ranges.
+ */
+
+#ifndef DOWNLOAD_MANAGER_H_
+#define DOWNLOAD_MANAGER_H_
+
+#include <zephyr.h>
+#include <zephyr/types.h>
+#include <net/download_client.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Download manager event IDs.
+ */
+enum download_manager_evt_id {
+	/** Download progress report. */
+	DOWNLOAD_MANAGER_EVT_PROGRESS,
+	/** The whole file has been written to the sink. */
+	DOWNLOAD_MANAGER_EVT_DONE,
+	/** The download failed and has been stopped.
+	 *
+	 * The progress is kept; starting the same download again
+	 * resumes it.
+	 */
+	DOWNLOAD_MANAGER_EVT_ERROR,
+};
+
+/**
+ * @brief Download manager event.
+ */
+struct download_manager_evt {
+	/** Event ID. */
+	enum download_manager_evt_id id;
+	union {
+		/** Download progress, for @c DOWNLOAD_MANAGER_EVT_PROGRESS. */
+		struct {
+			/** Bytes written to the sink. */
+			size_t written;
+			/** Size of the file. */
+			size_t file_size;
+		} progress;
+		/** Error cause, for @c DOWNLOAD_MANAGER_EVT_ERROR. */
+		int error;
+	};
+};
+
+/**
+ * @brief Download manager event handler.
+ *
+ * Events are sent from the download manager's thread.
+ *
+ * @param[in] evt The event.
+ */
+typedef void (*download_manager_callback_t)(
+	const struct download_manager_evt *evt);
+
+/**
+ * @brief Data sink.
+ *
+ * In order mode, data is written sequentially and @p offset is always the
+ * end of the previous write. Otherwise, ranges are written as they arrive
+ * and @p offset can be anywhere in the file. Writes are never concurrent.
+ *
+ * @param[in] offset Offset of the data in the file.
+ * @param[in] buf    Data.
+ * @param[in] len    Length of the data.
+ *
+ * @return Zero on success, a negative error code to stop the download.
+ */
+typedef int (*download_manager_write_t)(size_t offset, const void *buf,
+					size_t len);
+
+/**
+ * @brief Download configuration.
+ */
+struct download_manager_cfg {
+	/** Hosts serving the file, null-terminated. Each slot connects to
+	 *  a different host, and moves on to the next host if a range
+	 *  cannot be downloaded.
+	 */
+	const char *const *hosts;
+	/** Number of hosts. */
+	size_t host_cnt;
+	/** File to download, null-terminated. */
+	const char *file;
+	/** Size of the file, or zero to have it reported by the server. */
+	size_t file_size;
+	/** Connection options, shared by all hosts. */
+	struct download_client_cfg client;
+	/** Write the file sequentially. Ranges received ahead of the sink
+	 *  are buffered, up to @c CONFIG_DOWNLOAD_MANAGER_REORDER_BUF_SIZE
+	 *  bytes per connection.
+	 */
+	bool in_order;
+	/** Data sink. */
+	download_manager_write_t write;
+};
+
+/**
+ * @brief Initialize the download manager.
+ *
+ * @param[in] callback Event handler.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_manager_init(download_manager_callback_t callback);
+
+/**
+ * @brief Start or resume downloading a file.
+ *
+ * If progress was stored for the same file, only the missing ranges are
+ * downloaded.
+ *
+ * @param[in] cfg Download configuration. Must stay valid until the download
+ *		  completes or is stopped.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ * @retval -EALREADY if a download is ongoing.
+ */
+int download_manager_start(const struct download_manager_cfg *cfg);
+
+/**
+ * @brief Stop the ongoing download.
+ *
+ * The progress is kept, see @ref download_manager_start.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_manager_stop(void);
+
+/**
+ * @brief Discard the stored progress.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_manager_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DOWNLOAD_MANAGER_H_ */
+
+/**@} */
@@ -88,6 +88,21 @@ int fota_download_init(fota_download_callback_t client_callback);
 int fota_download_start(const char *host, const char *file, int sec_tag,
 			const char *apn, size_t fragment_size);
 
+#if defined(CONFIG_DFU_TARGET_STREAM_HASH)
+/**@brief Set the expected SHA-256 digest of the file to download next.
+ *
+ * The digest, for example taken from the update manifest, is verified as
+ * the file is written to the DFU target. If it does not match, the upgrade
+ * is not scheduled and an error event is sent instead of the finished event.
+ *
+ * @param hash Expected digest, DFU_TARGET_HASH_LEN bytes.
+ *
+ * @retval 0 If the digest was set.
+ *           Otherwise, a negative value is returned.
+ */
+int fota_download_hash_set(const uint8_t *hash);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
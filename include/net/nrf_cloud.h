@@ -41,6 +41,11 @@ enum nrf_cloud_evt_type {
 	NRF_CLOUD_EVT_TRANSPORT_DISCONNECTED,
 	/** The device should be restarted to apply a firmware upgrade */
 	NRF_CLOUD_EVT_FOTA_DONE,
+	/** The device received a chunk of data from the cloud. Messages on the
+	 * data channel larger than CONFIG_NRF_CLOUD_MQTT_PAYLOAD_BUFFER_LEN are
+	 * received in chunks if CONFIG_NRF_CLOUD_MQTT_PAYLOAD_STREAM is enabled.
+	 */
+	NRF_CLOUD_EVT_RX_DATA_CHUNK,
 	/** There was an error communicating with the cloud. */
 	NRF_CLOUD_EVT_ERROR = 0xFF
 };
@@ -83,6 +88,19 @@ struct nrf_cloud_topic {
 	const void *ptr;
 };
 
+/**@brief Position of a chunk of received data in its message. */
+struct nrf_cloud_rx_chunk {
+	/** Offset of the chunk in the message. */
+	uint32_t offset;
+	/** Length of the message. */
+	uint32_t total_len;
+	/** 0, or a negative error code if the rest of the message could not
+	 * be received. The event then holds no data, and is the last one for
+	 * the message.
+	 */
+	int32_t err;
+};
+
 /**@brief Sensors that are supported by the device. */
 struct nrf_cloud_sensor_list {
 	/** Size of the list. */
@@ -125,6 +143,8 @@ struct nrf_cloud_evt {
 	struct nrf_cloud_data data;
 	/** Topic on which data was received. */
 	struct nrf_cloud_topic topic;
+	/** Position of the received data, for NRF_CLOUD_EVT_RX_DATA_CHUNK. */
+	struct nrf_cloud_rx_chunk chunk;
 };
 
 /**
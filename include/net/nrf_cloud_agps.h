@@ -49,6 +49,50 @@ int nrf_cloud_agps_request_all(void);
  */
 int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket);
 
+/**@brief Processes a chunk of binary A-GPS data received from nRF Cloud.
+ *
+ * A-GPS data received in chunks, for example with the
+ * NRF_CLOUD_EVT_RX_DATA_CHUNK event, is parsed and passed on to the modem
+ * as it is received, without being stored in a contiguous buffer. The chunks
+ * must be processed in order, starting with the chunk at offset 0.
+ *
+ * @param buf Pointer to the chunk.
+ * @param buf_len Length of the chunk.
+ * @param offset Offset of the chunk in the A-GPS data.
+ * @param total_len Length of the A-GPS data.
+ * @param socket Pointer to GNSS socket to which A-GPS data will be injected.
+ *		 If NULL, the nRF9160 GPS driver is used to inject the data.
+ *		 Only used for the chunk at offset 0.
+ *
+ * @retval 0 If successful.
+ * @retval -ECANCELED If processing failed on an earlier chunk of the data.
+ * @return Otherwise, a (negative) error code.
+ */
+int nrf_cloud_agps_process_chunk(const char *buf, size_t buf_len,
+				 size_t offset, size_t total_len,
+				 const int *socket);
+
+/**@brief Ends the processing of A-GPS data received in chunks, when the rest
+ *	  of the data cannot be received.
+ *
+ * The data already passed on to the modem is kept, the GPS system time is
+ * not sent.
+ */
+void nrf_cloud_agps_process_abort(void);
+
+/**@brief Checks whether data received from nRF Cloud is A-GPS data.
+ *
+ * Only the schema version at the start of the data is checked, so the
+ * function can be used on the first chunk of a message received in chunks.
+ *
+ * @param buf Pointer to the data, or to its first chunk.
+ * @param buf_len Length of the data or the chunk.
+ *
+ * @return true if the data starts with the A-GPS schema version, otherwise
+ *	   false.
+ */
+bool nrf_cloud_agps_is_agps_data(const char *buf, size_t buf_len);
+
 /** @} */
 
 #ifdef __cplusplus
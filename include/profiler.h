@@ -17,6 +17,7 @@
 
 #include <zephyr/types.h>
 #include <sys/util.h>
+#include <sys/atomic.h>
 #include <sys/__assert.h>
 
 #ifndef CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS
@@ -25,8 +26,11 @@
 #endif
 
 /** @brief Set of flags for enabling/disabling profiling for given event types.
+ *
+ * The bitmap holds one bit for each of CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS
+ * event types.
  */
-extern uint32_t profiler_enabled_events;
+extern atomic_t profiler_enabled_events[];
 
 
 /** @brief Number of event types registered in the Profiler.
@@ -104,7 +108,8 @@ static inline bool is_profiling_enabled(size_t profiler_event_id)
 {
 	if (IS_ENABLED(CONFIG_PROFILER)) {
 		__ASSERT_NO_MSG(profiler_event_id < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
-		return (profiler_enabled_events & BIT(profiler_event_id)) != 0;
+		return atomic_test_bit(profiler_enabled_events,
+				       profiler_event_id);
 	}
 	return false;
 }
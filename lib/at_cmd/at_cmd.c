@@ -7,6 +7,7 @@
 #include <logging/log.h>
 #include <zephyr.h>
 #include <stdio.h>
+#include <ctype.h>
 #include <net/socket.h>
 #include <init.h>
 #include <bsd_limits.h>
@@ -23,19 +24,24 @@ LOG_MODULE_REGISTER(at_cmd, CONFIG_AT_CMD_LOG_LEVEL);
 #define AT_CMD_CMS_STR   "+CMS ERROR:"
 #define AT_CMD_CME_STR   "+CME ERROR:"
 
-/* Flags describing an AT command request */
-enum at_cmd_flags {
-	AT_CMD_BUF_CMD = 1 << 0,	/* Command is buffered by at_cmd */
-	AT_CMD_SYNC = 1 << 1,		/* Command is synchronous */
-};
+/* Command written after a timeout to find the end of the stale responses.
+ * Its response is recognized by the two response lines in this order.
+ */
+#define AT_CMD_SYNC_STR       "AT+CMEE?;+CNEC?"
+#define AT_CMD_SYNC_RESP_STR  "+CMEE:"
+#define AT_CMD_SYNC_RESP2_STR "+CNEC:"
+
+#ifdef CONFIG_AT_CMD_BATCH
+#define BATCH_MAX        CONFIG_AT_CMD_BATCH_MAX
+#define BATCH_BUF_LEN    CONFIG_AT_CMD_BATCH_BUF_LEN
+#else
+#define BATCH_MAX        1
+#endif
 
-/* Metadata for a queued AT command */
-struct cmd_item  {
-	char *cmd;			/* Pointer to 0-terminated command */
-	char *resp;			/* Pointer to response buffer */
-	at_cmd_handler_t callback;	/* Callback to execute on result */
-	size_t resp_size;		/* Size of response buffer */
-	enum at_cmd_flags flags;	/* Flags describing the request */
+/* Request buffered by at_cmd_write_with_callback, command copied behind it */
+struct cmd_buffered {
+	struct at_cmd_req req;
+	char cmd[];
 };
 
 /* Metadata for an AT response */
@@ -53,17 +59,47 @@ static struct k_thread socket_thread;
 static at_cmd_handler_t notification_handler;
 static atomic_t shutdown_mode;
 
-
-/* Structure holding current command. current_cmd.cmd=NULL signifies no cmd. */
-static struct cmd_item current_cmd;
+/* Requests written to the modem and awaiting the response. More than one
+ * request is in flight only when read commands were batched into one line.
+ */
+static struct at_cmd_req *current_cmd[BATCH_MAX];
+static size_t current_cmd_cnt;
+static uint32_t current_deadline;
 K_MUTEX_DEFINE(current_cmd_mutex);
 
-/* Queue for queued command metadata */
-K_MSGQ_DEFINE(commands, sizeof(struct cmd_item), CONFIG_AT_CMD_QUEUE_LEN, 4);
+/* Queued requests, protected by current_cmd_mutex */
+static sys_slist_t commands = SYS_SLIST_STATIC_INIT(&commands);
+
+/* Free request slots. A slot is held from submission until completion. */
+K_SEM_DEFINE(commands_free, CONFIG_AT_CMD_QUEUE_LEN, CONFIG_AT_CMD_QUEUE_LEN);
+
+/* Resynchronization after a timed out request. The modem may still respond
+ * to the request, or may not respond at all, so responses are dropped until
+ * the response to a known command is received.
+ */
+static enum {
+	SYNC_NONE,	/* Responses belong to the requests in flight */
+	SYNC_NEEDED,	/* Sync command must be written */
+	SYNC_WRITTEN,	/* Dropping responses until the sync response */
+	SYNC_LOST,	/* Sync command not answered, written again once a
+			 * command is queued
+			 */
+} sync_state;
+
+/* Number of times the sync command was written again without a response */
+static int sync_retry_cnt;
+
+static struct k_delayed_work timeout_work;
+
+#ifdef CONFIG_AT_CMD_BATCH
+static bool batch_disabled;
+static char batch_buf[BATCH_BUF_LEN];
+#endif
 
-/* Message queue to return the result in the case of a synchronous call */
-K_MSGQ_DEFINE(response_sync, sizeof(struct resp_item), 1, 4);
-K_MUTEX_DEFINE(response_sync_get);
+#ifdef CONFIG_AT_CMD_METRICS
+static struct at_cmd_metrics metrics;
+static struct k_spinlock metrics_lock;
+#endif
 
 static int open_socket(void)
 {
@@ -152,52 +188,517 @@ static inline int at_write(const char *const cmd)
 	return 0;
 }
 
-/* Clear the current command safely */
-static void complete_cmd(void)
+#ifdef CONFIG_AT_CMD_METRICS
+static void metrics_update(uint32_t *max, uint64_t *total,
+			   uint32_t from, uint32_t to)
 {
-	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
-	current_cmd.cmd = NULL;
-	k_mutex_unlock(&current_cmd_mutex);
+	uint32_t us = k_cyc_to_us_floor32(to - from);
+
+	*total += us;
+	if (us > *max) {
+		*max = us;
+	}
+}
+
+static void metrics_queue_update(struct at_cmd_req *req)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	metrics_update(&metrics.queue_time_max_us,
+		       &metrics.queue_time_total_us,
+		       req->enqueue_time, req->write_time);
+	k_spin_unlock(&metrics_lock, key);
+}
+
+static void metrics_complete_update(struct at_cmd_req *req, bool batched)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	metrics.cmd_cnt++;
+	if (req->code == -ETIMEDOUT) {
+		metrics.timeout_cnt++;
+	}
+	if (batched) {
+		metrics.batched_cnt++;
+	}
+	metrics_update(&metrics.modem_time_max_us,
+		       &metrics.modem_time_total_us,
+		       req->write_time, k_cycle_get_32());
+	k_spin_unlock(&metrics_lock, key);
+}
+
+void at_cmd_metrics_get(struct at_cmd_metrics *dst)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	*dst = metrics;
+	k_spin_unlock(&metrics_lock, key);
+}
+
+void at_cmd_metrics_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	memset(&metrics, 0, sizeof(metrics));
+	k_spin_unlock(&metrics_lock, key);
+}
+#else
+static inline void metrics_queue_update(struct at_cmd_req *req) {}
+static inline void metrics_complete_update(struct at_cmd_req *req,
+					   bool batched) {}
+#endif /* CONFIG_AT_CMD_METRICS */
+
+/*
+ * Finish a request and hand it back to its owner. The request must not be
+ * accessed after this call, as the owner may release it immediately.
+ */
+static void complete_req(struct at_cmd_req *req, enum at_cmd_state state,
+			 int code, bool batched)
+{
+	at_cmd_req_handler_t done = req->done;
+
+	req->state = state;
+	req->code = code;
+
+	metrics_complete_update(req, batched);
+	k_sem_give(&commands_free);
+
+	if (done != NULL) {
+		done(req);
+	} else {
+		k_sem_give(&req->sem);
+	}
+}
+
+/*
+ * Pass response payload to the request, copying it into the response buffer
+ * and calling the response handler, if any, then complete the request.
+ */
+static void deliver_resp(struct at_cmd_req *req, const char *payload,
+			 size_t payload_len, const struct resp_item *ret,
+			 bool batched)
+{
+	if (req->resp != NULL) {
+		if (req->resp_size < payload_len) {
+			LOG_ERR("Response buffer not large enough");
+			complete_req(req, ret->state, -EMSGSIZE, batched);
+			return;
+		}
+		memcpy(req->resp, payload, payload_len);
+	}
+
+	if (req->handler != NULL) {
+		req->handler(payload);
+	}
+
+	complete_req(req, ret->state, ret->code, batched);
+}
+
+#ifdef CONFIG_AT_CMD_BATCH
+/*
+ * Length of the command name if the command is a plain read command
+ * (AT+<name>? or AT%<name>?) that can share a line with other read commands,
+ * zero otherwise.
+ */
+static size_t batch_name_len(const char *cmd)
+{
+	size_t len;
+
+	if (toupper((int)cmd[0]) != 'A' || toupper((int)cmd[1]) != 'T' ||
+	    (cmd[2] != '+' && cmd[2] != '%')) {
+		return 0;
+	}
+
+	for (len = 1; isalnum((int)cmd[2 + len]); len++) {
+	}
+
+	if (len == 1 || cmd[2 + len] != '?' || cmd[3 + len] != '\0') {
+		return 0;
+	}
+
+	/* Includes the leading '+' or '%' */
+	return len;
+}
+
+/*
+ * Pop the head of the queue and any directly following read commands that can
+ * be combined with it. Returns the line to write to the modem.
+ * Must be called with current_cmd_mutex held.
+ */
+static const char *dequeue_cmd(void)
+{
+	struct at_cmd_req *req;
+	size_t name_len;
+	size_t len;
+
+	req = CONTAINER_OF(sys_slist_get_not_empty(&commands),
+			   struct at_cmd_req, node);
+	current_cmd[0] = req;
+	current_cmd_cnt = 1;
+
+	name_len = batch_name_len(req->cmd);
+	if (batch_disabled || name_len == 0) {
+		return req->cmd;
+	}
+
+	/* "AT" + first name + '?' */
+	len = 2 + name_len + 1;
+	if (len >= sizeof(batch_buf)) {
+		return req->cmd;
+	}
+	memcpy(batch_buf, req->cmd, len);
+
+	while (current_cmd_cnt < BATCH_MAX && !sys_slist_is_empty(&commands)) {
+		req = CONTAINER_OF(sys_slist_peek_head(&commands),
+				   struct at_cmd_req, node);
+		name_len = batch_name_len(req->cmd);
+
+		/* ';' + name + '?' */
+		if (name_len == 0 || len + name_len + 2 >= sizeof(batch_buf)) {
+			break;
+		}
+
+		batch_buf[len++] = ';';
+		memcpy(&batch_buf[len], &req->cmd[2], name_len + 1);
+		len += name_len + 1;
+
+		current_cmd[current_cmd_cnt++] = req;
+		sys_slist_get_not_empty(&commands);
+	}
+
+	if (current_cmd_cnt == 1) {
+		return current_cmd[0]->cmd;
+	}
+
+	batch_buf[len] = '\0';
+
+	return batch_buf;
+}
+
+/*
+ * Split a combined response among the batched requests. Each request gets the
+ * consecutive lines starting with its own command name.
+ */
+static void deliver_batch_resp(struct at_cmd_req **reqs, size_t cnt,
+			       char *buf, const struct resp_item *ret)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		const char *name = &reqs[i]->cmd[2];
+		size_t name_len = batch_name_len(reqs[i]->cmd);
+		char *start = NULL;
+		char *end = buf;
+		char *line = buf;
+		char saved;
+
+		while (*line != '\0') {
+			char *next = strstr(line, "\r\n");
+
+			next = (next != NULL) ? next + 2 : line + strlen(line);
+
+			if (!strncmp(line, name, name_len) &&
+			    line[name_len] == ':') {
+				if (start == NULL) {
+					start = line;
+				}
+				end = next;
+			} else if (start != NULL) {
+				break;
+			}
+
+			line = next;
+		}
+
+		if (start == NULL) {
+			start = end;
+		}
+
+		/* Terminate this request's lines in place while delivering */
+		saved = *end;
+		*end = '\0';
+		deliver_resp(reqs[i], start, end - start + 1, ret, true);
+		*end = saved;
+	}
+}
+
+/*
+ * Put batched requests back to the queue head in the original order and stop
+ * batching, as the modem did not accept the combined command line.
+ * Must be called with current_cmd_mutex held.
+ */
+static void batch_fallback(struct at_cmd_req **reqs, size_t cnt)
+{
+	LOG_WRN("Modem rejected batched command, batching disabled");
+	batch_disabled = true;
+
+	for (size_t i = cnt; i > 0; i--) {
+		sys_slist_prepend(&commands, &reqs[i - 1]->node);
+	}
+}
+#else
+static const char *dequeue_cmd(void)
+{
+	current_cmd[0] = CONTAINER_OF(sys_slist_get_not_empty(&commands),
+				      struct at_cmd_req, node);
+	current_cmd_cnt = 1;
+
+	return current_cmd[0]->cmd;
+}
+#endif /* CONFIG_AT_CMD_BATCH */
+
+static void timeout_arm(int32_t timeout_ms)
+{
+	current_deadline = k_uptime_get_32() + timeout_ms;
+	k_delayed_work_submit(&timeout_work, K_MSEC(timeout_ms));
+}
+
+/* Arm the response timeout for the requests just written to the modem */
+static void timeout_start(void)
+{
+	int32_t timeout_ms = 0;
+
+	for (size_t i = 0; i < current_cmd_cnt; i++) {
+		if (current_cmd[i]->timeout_ms == SYS_FOREVER_MS) {
+			return;
+		}
+		timeout_ms = MAX(timeout_ms, current_cmd[i]->timeout_ms);
+	}
+
+	timeout_arm(timeout_ms);
 }
 
 /*
  * Atomically load a new command if appropriate, then write it to the socket.
  * The operations are repeated until the queue is empty or a command is pending
- * a response. This function is called both from the socket thread and calling
- * context.
+ * a response. This function is called from the socket thread, the system
+ * workqueue and calling context.
  */
 static void load_cmd_and_write(void)
 {
+	struct at_cmd_req *failed[BATCH_MAX];
+	size_t failed_cnt;
+	const char *line;
+	uint32_t now;
 	int ret;
-	struct resp_item resp;
 
-	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
 	do {
-		ret = 0;
+		failed_cnt = 0;
+
+		k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+
+		if (sync_state == SYNC_LOST && !sys_slist_is_empty(&commands)) {
+			sync_state = SYNC_NEEDED;
+		}
+
+		if ((sync_state == SYNC_NEEDED) &&
+		    (at_write(AT_CMD_SYNC_STR) == 0)) {
+			sync_state = SYNC_WRITTEN;
+			timeout_arm(CONFIG_AT_CMD_SYNC_TIMEOUT);
+		}
 
-		/* Do not load a new command if already loaded or none queued */
-		if (current_cmd.cmd != NULL ||
-		    k_msgq_get(&commands, &current_cmd, K_NO_WAIT) != 0) {
+		/* Do not load a new command if already loaded, none queued or
+		 * responses are not synchronized with the commands.
+		 */
+		if (current_cmd_cnt != 0 || sys_slist_is_empty(&commands) ||
+		    sync_state != SYNC_NONE) {
+			k_mutex_unlock(&current_cmd_mutex);
 			break;
 		}
 
-		ret = at_write(current_cmd.cmd);
+		line = dequeue_cmd();
+		now = k_cycle_get_32();
 
-		if (current_cmd.flags & AT_CMD_BUF_CMD) {
-			k_free(current_cmd.cmd);
+		for (size_t i = 0; i < current_cmd_cnt; i++) {
+			current_cmd[i]->write_time = now;
+			metrics_queue_update(current_cmd[i]);
 		}
 
-		/* If write failed, make an error response and complete cmd */
-		if (ret != 0) {
-			resp.state = AT_CMD_ERROR_WRITE;
-			resp.code = ret;
-			if (current_cmd.flags & AT_CMD_SYNC) {
-				k_msgq_put(&response_sync, &resp, K_FOREVER);
-			}
-			complete_cmd();
+		ret = at_write(line);
+		if (ret == 0) {
+			timeout_start();
+		} else {
+			/* If write failed, complete the commands with error */
+			memcpy(failed, current_cmd,
+			       current_cmd_cnt * sizeof(current_cmd[0]));
+			failed_cnt = current_cmd_cnt;
+			current_cmd_cnt = 0;
 		}
-	} while (ret != 0);
+
+		k_mutex_unlock(&current_cmd_mutex);
+
+		for (size_t i = 0; i < failed_cnt; i++) {
+			complete_req(failed[i], AT_CMD_ERROR_WRITE, ret,
+				     failed_cnt > 1);
+		}
+	} while (failed_cnt != 0);
+}
+
+/*
+ * Write the sync command again if the modem did not answer it. After
+ * CONFIG_AT_CMD_SYNC_RETRIES attempts the modem is considered unresponsive
+ * and the queued requests are completed with -ETIMEDOUT.
+ * Must be called with current_cmd_mutex held, which is released.
+ */
+static void sync_timeout(void)
+{
+	sys_slist_t expired;
+	sys_snode_t *node;
+
+	if (sync_retry_cnt < CONFIG_AT_CMD_SYNC_RETRIES) {
+		LOG_WRN("Sync command timed out, writing it again");
+		sync_retry_cnt++;
+		sync_state = SYNC_NEEDED;
+		k_mutex_unlock(&current_cmd_mutex);
+
+		load_cmd_and_write();
+		return;
+	}
+
+	LOG_ERR("Modem does not respond, failing queued AT commands");
+	sync_retry_cnt = 0;
+	sync_state = SYNC_LOST;
+
+	expired = commands;
+	sys_slist_init(&commands);
+
+	k_mutex_unlock(&current_cmd_mutex);
+
+	while ((node = sys_slist_get(&expired)) != NULL) {
+		struct at_cmd_req *req = CONTAINER_OF(node, struct at_cmd_req,
+						      node);
+
+		/* Never written, no time is spent in the modem */
+		req->write_time = k_cycle_get_32();
+		complete_req(req, AT_CMD_ERROR_READ, -ETIMEDOUT, false);
+	}
+}
+
+static void timeout_work_fn(struct k_work *work)
+{
+	struct at_cmd_req *expired[BATCH_MAX];
+	size_t expired_cnt;
+
+	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+
+	/* The response may have arrived, or a new command may have been
+	 * written, while this work was waiting for the mutex.
+	 */
+	if ((int32_t)(k_uptime_get_32() - current_deadline) < 0) {
+		k_mutex_unlock(&current_cmd_mutex);
+		return;
+	}
+
+	if (sync_state == SYNC_WRITTEN) {
+		sync_timeout();
+		return;
+	}
+
+	if (current_cmd_cnt == 0) {
+		k_mutex_unlock(&current_cmd_mutex);
+		return;
+	}
+
+	LOG_WRN("AT command %s timed out", log_strdup(current_cmd[0]->cmd));
+
+	memcpy(expired, current_cmd, current_cmd_cnt * sizeof(current_cmd[0]));
+	expired_cnt = current_cmd_cnt;
+	current_cmd_cnt = 0;
+
+	/* The modem may still respond to the command. Drop responses until
+	 * the sync command is answered.
+	 */
+	sync_state = SYNC_NEEDED;
+
 	k_mutex_unlock(&current_cmd_mutex);
+
+	for (size_t i = 0; i < expired_cnt; i++) {
+		complete_req(expired[i], AT_CMD_ERROR_READ, -ETIMEDOUT,
+			     expired_cnt > 1);
+	}
+
+	load_cmd_and_write();
+}
+
+static bool is_sync_resp(const char *buf, const struct resp_item *ret)
+{
+	const char *line;
+
+	if (ret->state != AT_CMD_OK) {
+		return false;
+	}
+
+	line = strstr(buf, AT_CMD_SYNC_RESP_STR);
+
+	return (line != NULL) && (strstr(line, AT_CMD_SYNC_RESP2_STR) != NULL);
+}
+
+/* Complete the requests in flight with a command response */
+static void handle_resp(char *buf, size_t payload_len,
+			const struct resp_item *ret)
+{
+	struct at_cmd_req *reqs[BATCH_MAX];
+	size_t cnt;
+
+	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+
+	if (sync_state == SYNC_WRITTEN && ret->state == AT_CMD_ERROR_READ) {
+		/* The socket was reopened, the sync response may be lost */
+		sync_state = SYNC_NEEDED;
+	}
+
+	if (sync_state != SYNC_NONE) {
+		if (sync_state == SYNC_WRITTEN && is_sync_resp(buf, ret)) {
+			LOG_DBG("Responses synchronized");
+			k_delayed_work_cancel(&timeout_work);
+			sync_state = SYNC_NONE;
+			sync_retry_cnt = 0;
+		} else {
+			LOG_DBG("Dropping response to timed out command");
+		}
+		k_mutex_unlock(&current_cmd_mutex);
+		return;
+	}
+
+	if (current_cmd_cnt == 0) {
+		LOG_WRN("Response without pending command");
+		k_mutex_unlock(&current_cmd_mutex);
+		return;
+	}
+
+	k_delayed_work_cancel(&timeout_work);
+
+	memcpy(reqs, current_cmd, current_cmd_cnt * sizeof(current_cmd[0]));
+	cnt = current_cmd_cnt;
+	current_cmd_cnt = 0;
+
+#ifdef CONFIG_AT_CMD_BATCH
+	if (cnt > 1 && (ret->state == AT_CMD_ERROR ||
+			ret->state == AT_CMD_ERROR_READ)) {
+		batch_fallback(reqs, cnt);
+		k_mutex_unlock(&current_cmd_mutex);
+		return;
+	}
+#endif
+
+	k_mutex_unlock(&current_cmd_mutex);
+
+	if (cnt == 1) {
+		deliver_resp(reqs[0], buf, payload_len, ret, false);
+		return;
+	}
+
+#ifdef CONFIG_AT_CMD_BATCH
+	if (ret->state == AT_CMD_OK) {
+		deliver_batch_resp(reqs, cnt, buf, ret);
+		return;
+	}
+#endif
+
+	/* A +CME or +CMS error cannot be attributed to one of the batched
+	 * commands, so all of them get it.
+	 */
+	for (size_t i = 0; i < cnt; i++) {
+		complete_req(reqs[i], ret->state, ret->code, true);
+	}
 }
 
 static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
@@ -235,6 +736,14 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 				LOG_DBG("AT host available, "
 					"starting the thread again");
 				atomic_clear(&shutdown_mode);
+
+				/* The sync command is lost with the socket */
+				k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+				if (sync_state == SYNC_WRITTEN) {
+					sync_state = SYNC_NEEDED;
+				}
+				k_mutex_unlock(&current_cmd_mutex);
+
 				if (open_socket() != 0) {
 					LOG_ERR("Failed to open AT socket "
 						"after bsdlib init, "
@@ -253,7 +762,9 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 				LOG_INF("AT socket recovered");
 				ret.state = AT_CMD_ERROR_READ;
 				ret.code  = -errno;
-				goto next;
+				buf[0] = '\0';
+				handle_resp(buf, 1, &ret);
+				continue;
 			}
 
 			LOG_ERR("Unrecoverable reception error (err: %d), "
@@ -264,59 +775,91 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 			LOG_ERR("AT message empty");
 			ret.state = AT_CMD_ERROR_READ;
 			ret.code  = -EBADMSG;
-			goto next;
+			buf[0] = '\0';
+			handle_resp(buf, 1, &ret);
+			continue;
 		} else if (buf[bytes_read - 1] != '\0') {
 			LOG_ERR("AT message too large for reception buffer or "
 				"missing termination character");
 			ret.state = AT_CMD_ERROR_READ;
 			ret.code  = -ENOBUFS;
-			goto next;
+			buf[0] = '\0';
+			handle_resp(buf, 1, &ret);
+			continue;
 		}
 
 		LOG_DBG("at_cmd_rx %d bytes, %s", bytes_read, log_strdup(buf));
 
 		payload_len = get_return_code(buf, bytes_read, &ret);
 
-		/* Verify the buffer size if provided, and copy the message */
-		if (current_cmd.cmd != NULL &&
-		    current_cmd.resp != NULL &&
-		    ret.state != AT_CMD_NOTIFICATION) {
-			if (current_cmd.resp_size < payload_len) {
-				LOG_ERR("Response buffer not large enough");
-				ret.code  = -EMSGSIZE;
-				goto next;
+		if (ret.state == AT_CMD_NOTIFICATION) {
+			if (notification_handler != NULL) {
+				notification_handler(buf);
 			}
-			memcpy(current_cmd.resp, buf, payload_len);
+			continue;
 		}
 
-		/* Call the relevant callback, if any */
-		if (ret.state == AT_CMD_NOTIFICATION &&
-		    notification_handler != NULL) {
-			notification_handler(buf);
-		} else if (current_cmd.callback != NULL) {
-			current_cmd.callback(buf);
-		}
+		handle_resp(buf, payload_len, &ret);
+	}
+}
 
-next:
-		/* Dispatch response for sync call */
-		if (current_cmd.cmd != NULL &&
-		    current_cmd.flags & AT_CMD_SYNC &&
-		    ret.state != AT_CMD_NOTIFICATION) {
-			LOG_DBG("Enqueueing response for sync call");
-			k_msgq_put(&response_sync, &ret, K_FOREVER);
-		}
+void at_cmd_req_init(struct at_cmd_req *req, const char *cmd)
+{
+	memset(req, 0, sizeof(*req));
+	req->cmd = cmd;
+	req->timeout_ms = CONFIG_AT_CMD_RESPONSE_TIMEOUT > 0 ?
+			  CONFIG_AT_CMD_RESPONSE_TIMEOUT : SYS_FOREVER_MS;
+}
 
-		/* We have now handled a command if it was not a notification */
-		if (ret.state != AT_CMD_NOTIFICATION) {
-			complete_cmd();
-		}
+int at_cmd_req_submit(struct at_cmd_req *req)
+{
+	if (atomic_get(&shutdown_mode) == 1) {
+		return -EHOSTDOWN;
 	}
+
+	if (req == NULL || req->cmd == NULL) {
+		return -EINVAL;
+	}
+
+	k_sem_init(&req->sem, 0, 1);
+	req->state = AT_CMD_ERROR_QUEUE;
+	req->code = -EINPROGRESS;
+
+	k_sem_take(&commands_free, K_FOREVER);
+
+	req->enqueue_time = k_cycle_get_32();
+
+	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+	sys_slist_append(&commands, &req->node);
+	k_mutex_unlock(&current_cmd_mutex);
+
+	load_cmd_and_write();
+
+	return 0;
+}
+
+int at_cmd_req_wait(struct at_cmd_req *req, k_timeout_t timeout)
+{
+	__ASSERT(k_current_get() != socket_tid,
+		 "at_cmd deadlock: socket thread blocking self\n");
+	__ASSERT_NO_MSG(req->done == NULL);
+
+	if (k_sem_take(&req->sem, timeout) != 0) {
+		return -EAGAIN;
+	}
+
+	return req->code;
+}
+
+static void buffered_req_done(struct at_cmd_req *req)
+{
+	k_free(CONTAINER_OF(req, struct cmd_buffered, req));
 }
 
 int at_cmd_write_with_callback(const char *const cmd,
 			       at_cmd_handler_t  handler)
 {
-	struct cmd_item command;
+	struct cmd_buffered *command;
 	int ret;
 
 	if (atomic_get(&shutdown_mode) == 1) {
@@ -327,22 +870,22 @@ int at_cmd_write_with_callback(const char *const cmd,
 		return -EINVAL;
 	}
 
-	command.cmd = k_malloc(strlen(cmd) + 1);
-	if (command.cmd == NULL) {
+	command = k_malloc(sizeof(*command) + strlen(cmd) + 1);
+	if (command == NULL) {
 		return -ENOMEM;
 	}
-	strcpy(command.cmd, cmd);
+	strcpy(command->cmd, cmd);
 
-	command.resp = NULL;
-	command.callback = handler;
-	command.flags = AT_CMD_BUF_CMD;
+	at_cmd_req_init(&command->req, command->cmd);
+	command->req.handler = handler;
+	command->req.done = buffered_req_done;
 
-	ret = k_msgq_put(&commands, &command, K_FOREVER);
+	ret = at_cmd_req_submit(&command->req);
 	if (ret) {
+		k_free(command);
 		return ret;
 	}
 
-	load_cmd_and_write();
 	return 0;
 }
 
@@ -351,8 +894,8 @@ int at_cmd_write(const char *const cmd,
 		 size_t buf_len,
 		 enum at_cmd_state *state)
 {
-	struct cmd_item command;
-	struct resp_item ret;
+	struct at_cmd_req req;
+	int ret;
 
 	if (atomic_get(&shutdown_mode) == 1) {
 		return -EHOSTDOWN;
@@ -367,35 +910,27 @@ int at_cmd_write(const char *const cmd,
 		return -EINVAL;
 	}
 
-	/* This cast is safe; we do not free cmd without AT_CMD_BUF_CMD */
-	command.cmd = (char *)cmd;
-	command.resp = buf;
-	command.resp_size = buf_len;
-	command.callback = NULL;
-	command.flags = AT_CMD_SYNC;
-
-	/* Ensure we get our own AT response, not an old one */
-	k_mutex_lock(&response_sync_get, K_FOREVER);
+	at_cmd_req_init(&req, cmd);
+	req.resp = buf;
+	req.resp_size = buf_len;
 
-	/* We borrow the return code field from the currently unused response */
-	ret.code = k_msgq_put(&commands, &command, K_FOREVER);
-	if (ret.code) {
-		LOG_ERR("Could not enqueue cmd, error %d", ret.code);
-		*state = AT_CMD_ERROR_QUEUE;
-		return ret.code;
+	ret = at_cmd_req_submit(&req);
+	if (ret) {
+		LOG_ERR("Could not enqueue cmd, error %d", ret);
+		if (state) {
+			*state = AT_CMD_ERROR_QUEUE;
+		}
+		return ret;
 	}
 
-	load_cmd_and_write();
-
 	LOG_DBG("Awaiting response for %s", log_strdup(cmd));
-	k_msgq_get(&response_sync, &ret, K_FOREVER);
-	k_mutex_unlock(&response_sync_get);
+	ret = at_cmd_req_wait(&req, K_FOREVER);
 
 	if (state) {
-		*state = ret.state;
+		*state = req.state;
 	}
 
-	return ret.code;
+	return ret;
 }
 
 void at_cmd_set_notification_handler(at_cmd_handler_t handler)
@@ -428,6 +963,8 @@ static int at_cmd_driver_init(struct device *dev)
 
 	LOG_DBG("Common AT socket created");
 
+	k_delayed_work_init(&timeout_work, timeout_work_fn);
+
 	socket_tid = k_thread_create(&socket_thread, socket_thread_stack,
 				     K_THREAD_STACK_SIZEOF(socket_thread_stack),
 				     socket_thread_fn,
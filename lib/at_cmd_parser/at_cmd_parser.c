@@ -29,16 +29,32 @@ enum at_parser_state {
 	OPTIONAL,
 };
 
-static enum at_parser_state state;
+/* Parser context. Every parser call uses its own context, so that the
+ * parser can be used from multiple threads at the same time.
+ */
+struct at_parser {
+	enum at_parser_state state;
+};
 
-static inline void set_new_state(enum at_parser_state new_state)
+static inline void set_new_state(struct at_parser *parser,
+				 enum at_parser_state new_state)
 {
-	state = new_state;
+	parser->state = new_state;
 }
 
-static inline void reset_state(void)
+static inline void reset_state(struct at_parser *parser)
 {
-	state = IDLE;
+	parser->state = IDLE;
+}
+
+static inline void string_put(struct at_param_list *const list, int index,
+			      const char *str, size_t str_len)
+{
+	if (list->zero_copy) {
+		at_params_string_ref_put(list, index, str, str_len);
+	} else {
+		at_params_string_put(list, index, str, str_len);
+	}
 }
 
 static inline void skip_command_prefix(const char **cmd)
@@ -52,7 +68,8 @@ static inline void skip_command_prefix(const char **cmd)
 	(*cmd)++;
 }
 
-static int at_parse_detect_type(const char **str, int index)
+static int at_parse_detect_type(struct at_parser *parser, const char **str,
+				int index)
 {
 	const char *tmpstr = *str;
 
@@ -60,16 +77,16 @@ static int at_parse_detect_type(const char **str, int index)
 		/* Only first parameter in the string can be
 		 * notification ID, (eg +CEREG:)
 		 */
-		set_new_state(NOTIFICATION);
+		set_new_state(parser, NOTIFICATION);
 	} else if ((index == 0) && is_command(tmpstr)) {
 		/* Next, check if we deal with command (eg AT+CCLK) */
-		set_new_state(COMMAND);
+		set_new_state(parser, COMMAND);
 	} else if (index == 0) {
 		/* If the string start without an notification
 		 * ID, we treat the whole string as one string
 		 * parameter
 		 */
-		set_new_state(STRING);
+		set_new_state(parser, STRING);
 	} else if ((index > 0) && is_notification(*tmpstr)) {
 		/* If notifications is detected later in the
 		 * string we should stop parsing and return
@@ -78,15 +95,15 @@ static int at_parse_detect_type(const char **str, int index)
 		*str = tmpstr;
 		return -1;
 	} else if (is_number(*tmpstr)) {
-		set_new_state(NUMBER);
+		set_new_state(parser, NUMBER);
 
 	} else if (is_dblquote(*tmpstr)) {
-		set_new_state(QUOTED_STRING);
+		set_new_state(parser, QUOTED_STRING);
 		tmpstr++;
 	} else if (is_array_start(*tmpstr)) {
-		set_new_state(ARRAY);
+		set_new_state(parser, ARRAY);
 		tmpstr++;
-	} else if (is_lfcr(*tmpstr) && (state == NUMBER)) {
+	} else if (is_lfcr(*tmpstr) && (parser->state == NUMBER)) {
 		/* If \n or \r is detected in the string and the
 		 * previous param was a number we assume the
 		 * next parameter is PDU data
@@ -96,14 +113,14 @@ static int at_parse_detect_type(const char **str, int index)
 			tmpstr++;
 		}
 
-		set_new_state(SMS_PDU);
-	} else if (is_lfcr(*tmpstr) && (state == OPTIONAL)) {
-		set_new_state(OPTIONAL);
+		set_new_state(parser, SMS_PDU);
+	} else if (is_lfcr(*tmpstr) && (parser->state == OPTIONAL)) {
+		set_new_state(parser, OPTIONAL);
 	} else if (is_separator(*tmpstr)) {
 		/* If a separator is detected we have detected
 		 * and empty optional parameter
 		 */
-		set_new_state(OPTIONAL);
+		set_new_state(parser, OPTIONAL);
 	} else {
 		/* The rule set is exhausted, and cannot
 		 * continue. Break the loop and return an error
@@ -116,7 +133,8 @@ static int at_parse_detect_type(const char **str, int index)
 	return 0;
 }
 
-static int at_parse_process_element(const char **str, int index,
+static int at_parse_process_element(struct at_parser *parser,
+				    const char **str, int index,
 				    struct at_param_list *const list)
 {
 	const char *tmpstr = *str;
@@ -125,16 +143,15 @@ static int at_parse_process_element(const char **str, int index,
 		return -1;
 	}
 
-	if (state == NOTIFICATION) {
+	if (parser->state == NOTIFICATION) {
 		const char *start_ptr = tmpstr++;
 
 		while (is_valid_notification_char(*tmpstr)) {
 			tmpstr++;
 		}
 
-		at_params_string_put(list, index, start_ptr,
-				     tmpstr - start_ptr);
-	} else if (state == COMMAND) {
+		string_put(list, index, start_ptr, tmpstr - start_ptr);
+	} else if (parser->state == COMMAND) {
 		const char *start_ptr = tmpstr;
 
 		skip_command_prefix(&tmpstr);
@@ -143,8 +160,7 @@ static int at_parse_process_element(const char **str, int index,
 			tmpstr++;
 		}
 
-		at_params_string_put(list, index, start_ptr,
-				     tmpstr - start_ptr);
+		string_put(list, index, start_ptr, tmpstr - start_ptr);
 
 		/* Skip read/test special characters. */
 		if ((*tmpstr == AT_CMD_SEPARATOR) &&
@@ -154,63 +170,45 @@ static int at_parse_process_element(const char **str, int index,
 			tmpstr++;
 		}
 
-	} else if (state == OPTIONAL) {
+	} else if (parser->state == OPTIONAL) {
 		at_params_empty_put(list, index);
 
-	} else if (state == STRING) {
+	} else if (parser->state == STRING) {
 		const char *start_ptr = tmpstr;
 
 		while (!is_lfcr(*tmpstr) && !is_terminated(*tmpstr)) {
 			tmpstr++;
 		}
 
-		at_params_string_put(list, index, start_ptr,
-				     tmpstr - start_ptr);
+		string_put(list, index, start_ptr, tmpstr - start_ptr);
 
 		tmpstr++;
-	} else if (state == QUOTED_STRING) {
+	} else if (parser->state == QUOTED_STRING) {
 		const char *start_ptr = tmpstr;
 
 		while (!is_dblquote(*tmpstr) && !is_terminated(*tmpstr)) {
 			tmpstr++;
 		}
 
-		at_params_string_put(list, index, start_ptr,
-				     tmpstr - start_ptr);
+		string_put(list, index, start_ptr, tmpstr - start_ptr);
 
 		tmpstr++;
-	} else if (state == ARRAY) {
-		char *next;
-		size_t i = 0;
+	} else if (parser->state == ARRAY) {
+		const char *start_ptr = tmpstr;
 		uint32_t tmparray[AT_CMD_MAX_ARRAY_SIZE];
+		size_t i = at_parse_array_values(&tmpstr, tmparray,
+						 ARRAY_SIZE(tmparray));
 
-		tmparray[i++] = (uint32_t)strtoul(tmpstr, &next, 10);
-		tmpstr = next;
-
-		while (!is_array_stop(*tmpstr) && !is_terminated(*tmpstr)) {
-			if (is_separator(*tmpstr)) {
-				tmparray[i++] =
-					(uint32_t)strtoul(++tmpstr, &next, 10);
-
-				if (strlen(tmpstr) == strlen(next)) {
-					break;
-				} else {
-					tmpstr = next;
-				}
-
-			} else {
-				tmpstr++;
-			}
-
-			if (i == AT_CMD_MAX_ARRAY_SIZE) {
-				break;
-			}
+		if (list->zero_copy) {
+			at_params_array_ref_put(list, index, start_ptr,
+						i * sizeof(uint32_t));
+		} else {
+			at_params_array_put(list, index, tmparray,
+					    i * sizeof(uint32_t));
 		}
 
-		at_params_array_put(list, index, tmparray, i * sizeof(uint32_t));
-
 		tmpstr++;
-	} else if (state == NUMBER) {
+	} else if (parser->state == NUMBER) {
 		char *next;
 		int value = (uint32_t)strtoul(tmpstr, &next, 10);
 
@@ -222,15 +220,14 @@ static int at_parse_process_element(const char **str, int index,
 			at_params_int_put(list, index, value);
 		}
 
-	} else if (state == SMS_PDU) {
+	} else if (parser->state == SMS_PDU) {
 		const char *start_ptr = tmpstr;
 
 		while (isxdigit((int)*tmpstr)) {
 			tmpstr++;
 		}
 
-		at_params_string_put(list, index, start_ptr,
-				     tmpstr - start_ptr);
+		string_put(list, index, start_ptr, tmpstr - start_ptr);
 	}
 
 	*str = tmpstr;
@@ -248,19 +245,21 @@ static int at_parse_param(const char **at_params_str,
 	int index = 0;
 	const char *str = *at_params_str;
 	bool oversized = false;
+	struct at_parser parser;
 
-	reset_state();
+	reset_state(&parser);
 
 	while ((!is_terminated(*str)) && (index < max_params)) {
 		if (isspace((int)*str)) {
 			str++;
 		}
 
-		if (at_parse_detect_type(&str, index) == -1) {
+		if (at_parse_detect_type(&parser, &str, index) == -1) {
 			break;
 		}
 
-		if (at_parse_process_element(&str, index, list) == -1) {
+		if (at_parse_process_element(&parser, &str, index,
+					     list) == -1) {
 			break;
 		}
 
@@ -275,12 +274,13 @@ static int at_parse_param(const char **at_params_str,
 					break;
 				}
 
-				if (at_parse_detect_type(&str, index) == -1) {
+				if (at_parse_detect_type(&parser, &str,
+							 index) == -1) {
 					break;
 				}
 
-				if (at_parse_process_element(&str, index,
-							     list) == -1) {
+				if (at_parse_process_element(
+					&parser, &str, index, list) == -1) {
 					break;
 				}
 			}
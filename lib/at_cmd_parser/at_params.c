@@ -13,6 +13,7 @@
 #include <kernel.h>
 
 #include <modem/at_params.h>
+#include "at_utils.h"
 
 /* Internal function. Parameter cannot be null. */
 static void at_param_init(struct at_param *param)
@@ -28,12 +29,13 @@ static void at_param_clear(struct at_param *param)
 {
 	__ASSERT(param != NULL, "Parameter cannot be NULL.");
 
-	if ((param->type == AT_PARAM_TYPE_STRING) ||
-	    (param->type == AT_PARAM_TYPE_ARRAY)) {
+	if (((param->type == AT_PARAM_TYPE_STRING) ||
+	     (param->type == AT_PARAM_TYPE_ARRAY)) && !param->is_ref) {
 		k_free(param->value.str_val);
 	}
 
 	param->value.int_val = 0;
+	param->is_ref = false;
 }
 
 /* Internal function. Parameter cannot be null. */
@@ -81,6 +83,26 @@ int at_params_list_init(struct at_param_list *list, size_t max_params_count)
 	}
 
 	list->param_count = max_params_count;
+	list->static_storage = false;
+	list->zero_copy = false;
+	return 0;
+}
+
+int at_params_list_init_static(struct at_param_list *list,
+			       struct at_param *params,
+			       size_t max_params_count, bool zero_copy)
+{
+	if (list == NULL || params == NULL) {
+		return -EINVAL;
+	}
+
+	/* Array initialized with empty parameters. */
+	memset(params, 0, max_params_count * sizeof(struct at_param));
+
+	list->params = params;
+	list->param_count = max_params_count;
+	list->static_storage = true;
+	list->zero_copy = zero_copy;
 	return 0;
 }
 
@@ -107,7 +129,9 @@ void at_params_list_free(struct at_param_list *list)
 	at_params_list_clear(list);
 
 	list->param_count = 0;
-	k_free(list->params);
+	if (!list->static_storage) {
+		k_free(list->params);
+	}
 	list->params = NULL;
 }
 
@@ -229,6 +253,50 @@ int at_params_array_put(const struct at_param_list *list, size_t index,
 	return 0;
 }
 
+int at_params_string_ref_put(const struct at_param_list *list, size_t index,
+			     const char *str, size_t str_len)
+{
+	if (list == NULL || list->params == NULL || str == NULL) {
+		return -EINVAL;
+	}
+
+	struct at_param *param = at_params_get(list, index);
+
+	if (param == NULL) {
+		return -EINVAL;
+	}
+
+	at_param_clear(param);
+	param->size = str_len;
+	param->type = AT_PARAM_TYPE_STRING;
+	param->value.str_val = (char *)str;
+	param->is_ref = true;
+
+	return 0;
+}
+
+int at_params_array_ref_put(const struct at_param_list *list, size_t index,
+			    const char *str, size_t array_len)
+{
+	if (list == NULL || list->params == NULL || str == NULL) {
+		return -EINVAL;
+	}
+
+	struct at_param *param = at_params_get(list, index);
+
+	if (param == NULL) {
+		return -EINVAL;
+	}
+
+	at_param_clear(param);
+	param->size = array_len;
+	param->type = AT_PARAM_TYPE_ARRAY;
+	param->value.str_val = (char *)str;
+	param->is_ref = true;
+
+	return 0;
+}
+
 int at_params_size_get(const struct at_param_list *list, size_t index,
 		       size_t *len)
 {
@@ -319,6 +387,30 @@ int at_params_string_get(const struct at_param_list *list, size_t index,
 	return 0;
 }
 
+int at_params_string_ptr_get(const struct at_param_list *list, size_t index,
+			     const char **str, size_t *len)
+{
+	if (list == NULL || list->params == NULL || str == NULL ||
+	    len == NULL) {
+		return -EINVAL;
+	}
+
+	struct at_param *param = at_params_get(list, index);
+
+	if (param == NULL) {
+		return -EINVAL;
+	}
+
+	if (param->type != AT_PARAM_TYPE_STRING) {
+		return -EINVAL;
+	}
+
+	*str = param->value.str_val;
+	*len = at_param_size(param);
+
+	return 0;
+}
+
 int at_params_array_get(const struct at_param_list *list, size_t index,
 			uint32_t *array, size_t *len)
 {
@@ -343,7 +435,13 @@ int at_params_array_get(const struct at_param_list *list, size_t index,
 		return -ENOMEM;
 	}
 
-	memcpy(array, param->value.array_val, param_len);
+	if (param->is_ref) {
+		const char *str = param->value.str_val;
+
+		at_parse_array_values(&str, array, param_len / sizeof(uint32_t));
+	} else {
+		memcpy(array, param->value.array_val, param_len);
+	}
 	*len = param_len;
 
 	return 0;
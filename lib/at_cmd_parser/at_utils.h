@@ -18,6 +18,8 @@
 
 #include <zephyr/types.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 
 #define AT_PARAM_SEPARATOR ','
@@ -242,6 +244,50 @@ static inline bool is_command(const char *str)
 	return false;
 }
 
+/**
+ * @brief Parse numeric values of an array parameter
+ *
+ * Parsing stops at the array stop character, at the string terminator or
+ * when @p max_cnt values are parsed.
+ *
+ * @param[in,out] str     Pointer to the first character after the array
+ *                        start character. Updated to point to the character
+ *                        where parsing stopped.
+ * @param[out]    array   Array where parsed values are stored.
+ * @param[in]     max_cnt Maximum number of values stored in @p array.
+ *
+ * @return Number of parsed values.
+ */
+static inline size_t at_parse_array_values(const char **str, uint32_t *array,
+					   size_t max_cnt)
+{
+	const char *tmpstr = *str;
+	char *next;
+	size_t i = 0;
+
+	array[i++] = (uint32_t)strtoul(tmpstr, &next, 10);
+	tmpstr = next;
+
+	while (!is_array_stop(*tmpstr) && !is_terminated(*tmpstr) &&
+	       (i < max_cnt)) {
+		if (is_separator(*tmpstr)) {
+			array[i++] = (uint32_t)strtoul(++tmpstr, &next, 10);
+
+			if (next == tmpstr) {
+				break;
+			}
+
+			tmpstr = next;
+		} else {
+			tmpstr++;
+		}
+	}
+
+	*str = tmpstr;
+
+	return i;
+}
+
 /** @} */
 
 #endif /* AT_UTILS_H__ */
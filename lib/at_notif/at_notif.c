@@ -10,112 +10,271 @@
 #include <init.h>
 #include <modem/at_cmd.h>
 #include <modem/at_notif.h>
-#include <sys/slist.h>
 
 LOG_MODULE_REGISTER(at_notif, CONFIG_AT_NOTIF_LOG_LEVEL);
 
+BUILD_ASSERT((CONFIG_AT_NOTIF_BUCKET_CNT &
+	      (CONFIG_AT_NOTIF_BUCKET_CNT - 1)) == 0,
+	     "Bucket count must be a power of two");
+
+/* Serializes registration changes. Dispatch does not take it. */
 static K_MUTEX_DEFINE(list_mtx);
 
-/**@brief Link list element for notification handler. */
+/* Protects the dispatch state below */
+static struct k_spinlock dispatch_lock;
+
+/**@brief Link list element for notification handler.
+ *
+ * Elements are only ever appended to a list and are never freed, so the
+ * dispatcher can walk the lists without locking. A deregistered element has
+ * its handler cleared and is reused by a later registration in the same list,
+ * once the dispatch that may still be calling it has finished.
+ */
 struct notif_handler {
-	sys_snode_t        node;
+	struct notif_handler *next;
 	void               *ctx;
 	at_notif_handler_t handler;
+	bool               releasing;
+	uint8_t            prefix_len;
+	char               prefix[CONFIG_AT_NOTIF_PREFIX_MAX_LEN];
 };
 
-static sys_slist_t handler_list;
+/* Handlers of all notifications */
+static struct notif_handler *handler_list;
+
+/* Handlers of specific notifications, indexed by the prefix hash */
+static struct notif_handler *prefix_table[CONFIG_AT_NOTIF_BUCKET_CNT];
+
+/* Set while a notification is being dispatched */
+static bool dispatching;
+static k_tid_t dispatch_thread;
+
+/* Threads waiting for the ongoing dispatch to finish */
+static uint32_t sync_waiters;
+static K_SEM_DEFINE(dispatch_done, 0, K_SEM_MAX_LIMIT);
+
+/**@brief Length of the notification name, i.e. the text before ':'. */
+static size_t name_len_get(const char *notif)
+{
+	return strcspn(notif, ": \r\n");
+}
+
+static struct notif_handler **list_get(const char *prefix, size_t len)
+{
+	uint32_t hash = 5381;
+
+	if (len == 0) {
+		return &handler_list;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash * 33) ^ (uint8_t)prefix[i];
+	}
+
+	return &prefix_table[hash & (CONFIG_AT_NOTIF_BUCKET_CNT - 1)];
+}
+
+static inline at_notif_handler_t handler_get(struct notif_handler *curr)
+{
+	return __atomic_load_n(&curr->handler, __ATOMIC_ACQUIRE);
+}
+
+static inline void handler_set(struct notif_handler *curr,
+			       at_notif_handler_t handler)
+{
+	__atomic_store_n(&curr->handler, handler, __ATOMIC_RELEASE);
+}
 
+static inline bool prefix_match(const struct notif_handler *curr,
+				const char *prefix, size_t len)
+{
+	return curr->prefix_len == len && !memcmp(curr->prefix, prefix, len);
+}
 
 /**
- * @brief Find the handler from the notification list.
+ * @brief Wait until a dispatch in progress, if any, has finished.
  *
- * @return The node or NULL if not found and its previous node in @p prev_out.
+ * Not needed when called from a handler, as the dispatcher is then not
+ * touching the element being changed.
  */
-static struct notif_handler *find_node(struct notif_handler **prev_out,
-	void *ctx, at_notif_handler_t handler)
+static void dispatch_sync(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&dispatch_lock);
+
+	if (!dispatching || k_current_get() == dispatch_thread) {
+		k_spin_unlock(&dispatch_lock, key);
+		return;
+	}
+
+	sync_waiters++;
+	k_spin_unlock(&dispatch_lock, key);
+
+	k_sem_take(&dispatch_done, K_FOREVER);
+}
+
+static void dispatch_begin(void)
 {
-	struct notif_handler *prev = NULL, *curr, *tmp;
+	k_spinlock_key_t key = k_spin_lock(&dispatch_lock);
+
+	dispatching = true;
+	dispatch_thread = k_current_get();
+	k_spin_unlock(&dispatch_lock, key);
+}
+
+static void dispatch_end(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&dispatch_lock);
+	uint32_t waiters = sync_waiters;
+
+	dispatching = false;
+	sync_waiters = 0;
+	k_spin_unlock(&dispatch_lock, key);
+
+	while (waiters--) {
+		k_sem_give(&dispatch_done);
+	}
+}
+
+/**@brief Find the handler in the notification list. */
+static struct notif_handler *find_node(struct notif_handler *list,
+	const char *prefix, size_t len, void *ctx, at_notif_handler_t handler)
+{
+	for (struct notif_handler *curr = list; curr; curr = curr->next) {
+		if (curr->ctx == ctx && handler_get(curr) == handler &&
+		    prefix_match(curr, prefix, len)) {
+			return curr;
+		}
+	}
+	return NULL;
+}
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&handler_list, curr, tmp, node) {
-		if (curr->ctx == ctx && curr->handler == handler) {
-			*prev_out = prev;
+/**@brief Find a deregistered element in the notification list. */
+static struct notif_handler *find_free_node(struct notif_handler *list)
+{
+	for (struct notif_handler *curr = list; curr; curr = curr->next) {
+		if (handler_get(curr) == NULL && !curr->releasing) {
 			return curr;
 		}
-		prev = curr;
 	}
 	return NULL;
 }
 
 /**@brief Add the handler in the notification list if not already present. */
-static int append_notif_handler(void *ctx, at_notif_handler_t handler)
+static int append_notif_handler(const char *prefix, size_t len, void *ctx,
+				at_notif_handler_t handler)
 {
+	struct notif_handler **list = list_get(prefix, len);
 	struct notif_handler *to_ins;
 
 	k_mutex_lock(&list_mtx, K_FOREVER);
 
 	/* Check if handler is already registered. */
-	if (find_node(&to_ins, ctx, handler) != NULL) {
+	if (find_node(*list, prefix, len, ctx, handler) != NULL) {
 		LOG_DBG("Handler already registered. Nothing to do");
 		k_mutex_unlock(&list_mtx);
 		return 0;
 	}
 
-	/* Allocate memory and fill. */
-	to_ins = (struct notif_handler *)k_malloc(sizeof(struct notif_handler));
+	to_ins = find_free_node(*list);
 	if (to_ins == NULL) {
-		k_mutex_unlock(&list_mtx);
-		return -ENOBUFS;
+		/* Allocate memory and fill. */
+		to_ins = (struct notif_handler *)k_malloc(
+			sizeof(struct notif_handler));
+		if (to_ins == NULL) {
+			k_mutex_unlock(&list_mtx);
+			return -ENOBUFS;
+		}
+		memset(to_ins, 0, sizeof(struct notif_handler));
+
+		/* Insert the element at the list head. The element is
+		 * complete before it becomes visible to the dispatcher.
+		 */
+		to_ins->next = *list;
+		__atomic_store_n(list, to_ins, __ATOMIC_RELEASE);
 	}
-	memset(to_ins, 0, sizeof(struct notif_handler));
-	to_ins->ctx     = ctx;
-	to_ins->handler = handler;
 
-	/* Insert handler in the list. */
-	sys_slist_append(&handler_list, &to_ins->node);
+	/* The handler is set last, which publishes the element. */
+	to_ins->ctx = ctx;
+	to_ins->prefix_len = len;
+	memcpy(to_ins->prefix, prefix, len);
+	handler_set(to_ins, handler);
+
 	k_mutex_unlock(&list_mtx);
 	return 0;
 }
 
 /**@brief Remove the handler from the notification list if registered. */
-static int remove_notif_handler(void *ctx, at_notif_handler_t handler)
+static int remove_notif_handler(const char *prefix, size_t len, void *ctx,
+				at_notif_handler_t handler)
 {
-	struct notif_handler *curr, *prev = NULL;
+	struct notif_handler *curr;
 
 	k_mutex_lock(&list_mtx, K_FOREVER);
 
 	/* Check if the handler is registered before removing it. */
-	curr = find_node(&prev, ctx, handler);
+	curr = find_node(*list_get(prefix, len), prefix, len, ctx, handler);
 	if (curr == NULL) {
 		LOG_WRN("Handler not registered. Nothing to do");
 		k_mutex_unlock(&list_mtx);
 		return 0;
 	}
 
-	/* Remove the handler from the list. */
-	sys_slist_remove(&handler_list, &prev->node, &curr->node);
-	k_free(curr);
+	/* Disable the element. It is not called once the ongoing dispatch, if
+	 * any, has finished, and can be reused after that. The lock is not held
+	 * while waiting, as the handlers being called may register or
+	 * deregister handlers themselves.
+	 */
+	handler_set(curr, NULL);
+	curr->releasing = true;
+	k_mutex_unlock(&list_mtx);
+
+	dispatch_sync();
 
+	k_mutex_lock(&list_mtx, K_FOREVER);
+	curr->releasing = false;
 	k_mutex_unlock(&list_mtx);
 	return 0;
 }
 
+static void dispatch_list(struct notif_handler *list, const char *name,
+			  size_t len, const char *response)
+{
+	for (struct notif_handler *curr = list; curr; curr = curr->next) {
+		at_notif_handler_t handler = handler_get(curr);
+
+		if (handler == NULL || !prefix_match(curr, name, len)) {
+			continue;
+		}
+
+		LOG_DBG(" - ctx=0x%08X, handler=0x%08X", (uint32_t)curr->ctx,
+			(uint32_t)handler);
+		handler(curr->ctx, response);
+	}
+}
+
 /**@brief AT command notifications handler. */
 static void notif_dispatch(const char *response)
 {
-	struct notif_handler *curr, *tmp;
+	size_t len = name_len_get(response);
 
-	k_mutex_lock(&list_mtx, K_FOREVER);
+	dispatch_begin();
 
-	/* Dispatch notifications to all registered handlers */
 	LOG_DBG("Dispatching events:");
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&handler_list, curr, tmp, node) {
-		LOG_DBG(" - ctx=0x%08X, handler=0x%08X", (uint32_t)curr->ctx,
-			(uint32_t)curr->handler);
-		curr->handler(curr->ctx, response);
+
+	/* Handlers registered for this notification only */
+	if (len > 0 && len <= CONFIG_AT_NOTIF_PREFIX_MAX_LEN) {
+		dispatch_list(__atomic_load_n(list_get(response, len),
+					      __ATOMIC_ACQUIRE),
+			      response, len, response);
 	}
+
+	/* Handlers of all notifications */
+	dispatch_list(__atomic_load_n(&handler_list, __ATOMIC_ACQUIRE),
+		      "", 0, response);
+
 	LOG_DBG("Done");
 
-	k_mutex_unlock(&list_mtx);
+	dispatch_end();
 }
 
 static int module_init(struct device *dev)
@@ -132,7 +291,6 @@ static int module_init(struct device *dev)
 	initialized = true;
 
 	LOG_DBG("Initialization");
-	sys_slist_init(&handler_list);
 	at_cmd_set_notification_handler(notif_dispatch);
 	return 0;
 }
@@ -149,7 +307,7 @@ int at_notif_register_handler(void *context, at_notif_handler_t handler)
 			(uint32_t)context, (uint32_t)handler);
 		return -EINVAL;
 	}
-	return append_notif_handler(context, handler);
+	return append_notif_handler(NULL, 0, context, handler);
 }
 
 int at_notif_deregister_handler(void *context, at_notif_handler_t handler)
@@ -159,7 +317,51 @@ int at_notif_deregister_handler(void *context, at_notif_handler_t handler)
 			(uint32_t)context, (uint32_t)handler);
 		return -EINVAL;
 	}
-	return remove_notif_handler(context, handler);
+	return remove_notif_handler(NULL, 0, context, handler);
+}
+
+/**@brief Get the prefix length without a trailing ':', or 0 if invalid. */
+static size_t prefix_len_get(const char *prefix)
+{
+	size_t len;
+
+	if (prefix == NULL) {
+		return 0;
+	}
+
+	len = name_len_get(prefix);
+	if (len > CONFIG_AT_NOTIF_PREFIX_MAX_LEN ||
+	    (prefix[len] != '\0' && strcmp(&prefix[len], ":") != 0)) {
+		return 0;
+	}
+
+	return len;
+}
+
+int at_notif_register_prefix(const char *prefix, void *context,
+			     at_notif_handler_t handler)
+{
+	size_t len = prefix_len_get(prefix);
+
+	if (handler == NULL || len == 0) {
+		LOG_ERR("Invalid prefix or handler (handler=0x%08X)",
+			(uint32_t)handler);
+		return -EINVAL;
+	}
+	return append_notif_handler(prefix, len, context, handler);
+}
+
+int at_notif_deregister_prefix(const char *prefix, void *context,
+			       at_notif_handler_t handler)
+{
+	size_t len = prefix_len_get(prefix);
+
+	if (handler == NULL || len == 0) {
+		LOG_ERR("Invalid prefix or handler (handler=0x%08X)",
+			(uint32_t)handler);
+		return -EINVAL;
+	}
+	return remove_notif_handler(prefix, len, context, handler);
 }
 
 #ifdef CONFIG_AT_NOTIF_SYS_INIT
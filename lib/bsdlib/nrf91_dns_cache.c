@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file
+ * @brief Cache of the results of getaddrinfo() on nrf91 sockets
+ */
+
+#include <string.h>
+#include <zephyr.h>
+#include <net/socket.h>
+#include <net/dns_resolve.h>
+#include <modem/nrf91_sockets.h>
+
+#include "nrf91_dns_cache.h"
+
+/* Long enough for any port number. */
+#define SERVICE_MAX_LEN 7
+
+struct cache_addr {
+	int flags;
+	int family;
+	int socktype;
+	int protocol;
+	socklen_t addrlen;
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in in;
+		struct sockaddr_in6 in6;
+	} addr;
+};
+
+struct cache_entry {
+	char node[CONFIG_NRF91_SOCKET_DNS_CACHE_NAME_MAX_LEN + 1];
+	char service[SERVICE_MAX_LEN + 1];
+	/* Hints of the lookup. */
+	int family;
+	int socktype;
+	int protocol;
+	int flags;
+	/* 0, or the cached DNS_EAI error. */
+	int error;
+	/* Uptime in milliseconds. */
+	int64_t expires;
+	int64_t used;
+	/* Canonical name returned with the first address, or empty. */
+	char canonname[CONFIG_NRF91_SOCKET_DNS_CACHE_NAME_MAX_LEN + 1];
+	size_t count;
+	struct cache_addr addrs[CONFIG_NRF91_SOCKET_DNS_CACHE_ADDR_COUNT];
+};
+
+static struct cache_entry cache[CONFIG_NRF91_SOCKET_DNS_CACHE_SIZE];
+static struct nrf91_dns_cache_stats stats;
+static K_MUTEX_DEFINE(cache_lock);
+
+/* Lookups that cannot be stored are not cached, nor looked up. */
+static bool is_cacheable(const char *node, const char *service,
+			 const struct zsock_addrinfo *hints)
+{
+	return node != NULL &&
+	       strlen(node) <= CONFIG_NRF91_SOCKET_DNS_CACHE_NAME_MAX_LEN &&
+	       (service == NULL || strlen(service) <= SERVICE_MAX_LEN) &&
+	       /* Lookups on a specific PDN */
+	       (hints == NULL || hints->ai_next == NULL);
+}
+
+static bool entry_matches(const struct cache_entry *entry, const char *node,
+			  const char *service,
+			  const struct zsock_addrinfo *hints)
+{
+	const struct zsock_addrinfo none = { 0 };
+
+	if (hints == NULL) {
+		hints = &none;
+	}
+
+	return entry->expires != 0 &&
+	       strcmp(entry->node, node) == 0 &&
+	       strcmp(entry->service, service ? service : "") == 0 &&
+	       entry->family == hints->ai_family &&
+	       entry->socktype == hints->ai_socktype &&
+	       entry->protocol == hints->ai_protocol &&
+	       entry->flags == hints->ai_flags;
+}
+
+static struct cache_entry *entry_find(const char *node, const char *service,
+				      const struct zsock_addrinfo *hints)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (entry_matches(&cache[i], node, service, hints)) {
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Returns a free or expired entry, or the least recently used one. */
+static struct cache_entry *entry_alloc(int64_t now)
+{
+	struct cache_entry *lru = &cache[0];
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].expires <= now) {
+			return &cache[i];
+		}
+
+		if (cache[i].used < lru->used) {
+			lru = &cache[i];
+		}
+	}
+
+	stats.evictions++;
+
+	return lru;
+}
+
+static void addrinfo_free(struct zsock_addrinfo *res)
+{
+	while (res != NULL) {
+		struct zsock_addrinfo *next = res->ai_next;
+
+		k_free(res->ai_canonname);
+		k_free(res->ai_addr);
+		k_free(res);
+		res = next;
+	}
+}
+
+/* Copies the addresses into a list that is released with freeaddrinfo(). */
+static int entry_copy(const struct cache_entry *entry,
+		      struct zsock_addrinfo **res)
+{
+	struct zsock_addrinfo **last = res;
+
+	*res = NULL;
+
+	for (size_t i = 0; i < entry->count; i++) {
+		const struct cache_addr *addr = &entry->addrs[i];
+		struct zsock_addrinfo *ai = k_calloc(1, sizeof(*ai));
+
+		if (ai == NULL) {
+			addrinfo_free(*res);
+			*res = NULL;
+			return DNS_EAI_MEMORY;
+		}
+
+		*last = ai;
+		last = &ai->ai_next;
+
+		ai->ai_addr = k_malloc(addr->addrlen);
+		if (ai->ai_addr == NULL) {
+			addrinfo_free(*res);
+			*res = NULL;
+			return DNS_EAI_MEMORY;
+		}
+
+		memcpy(ai->ai_addr, &addr->addr, addr->addrlen);
+		ai->ai_addrlen = addr->addrlen;
+		ai->ai_flags = addr->flags;
+		ai->ai_family = addr->family;
+		ai->ai_socktype = addr->socktype;
+		ai->ai_protocol = addr->protocol;
+
+		if (i == 0 && entry->canonname[0] != '\0') {
+			size_t len = strlen(entry->canonname) + 1;
+
+			ai->ai_canonname = k_malloc(len);
+			if (ai->ai_canonname == NULL) {
+				addrinfo_free(*res);
+				*res = NULL;
+				return DNS_EAI_MEMORY;
+			}
+
+			memcpy(ai->ai_canonname, entry->canonname, len);
+		}
+	}
+
+	return 0;
+}
+
+bool nrf91_dns_cache_lookup(const char *node, const char *service,
+			    const struct zsock_addrinfo *hints,
+			    struct zsock_addrinfo **res, int *error)
+{
+	struct cache_entry *entry;
+	int64_t now;
+
+	if (!is_cacheable(node, service, hints)) {
+		return false;
+	}
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+	entry = entry_find(node, service, hints);
+
+	if (entry == NULL || entry->expires <= now) {
+		stats.misses++;
+		k_mutex_unlock(&cache_lock);
+		return false;
+	}
+
+	entry->used = now;
+
+	if (entry->error) {
+		stats.negative_hits++;
+		*error = entry->error;
+	} else {
+		stats.hits++;
+		*error = entry_copy(entry, res);
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return true;
+}
+
+void nrf91_dns_cache_store(const char *node, const char *service,
+			   const struct zsock_addrinfo *hints, int error,
+			   const struct zsock_addrinfo *res)
+{
+	struct cache_entry *entry;
+	int64_t now;
+
+	/* Temporary failures, such as the network not being available,
+	 * are not cached.
+	 */
+	if (!is_cacheable(node, service, hints) ||
+	    (error != 0 && error != DNS_EAI_NONAME) ||
+	    (error != 0 && CONFIG_NRF91_SOCKET_DNS_CACHE_NEGATIVE_TTL == 0) ||
+	    (error == 0 && res == NULL) ||
+	    (error == 0 && res->ai_canonname != NULL &&
+	     strlen(res->ai_canonname) >
+		CONFIG_NRF91_SOCKET_DNS_CACHE_NAME_MAX_LEN)) {
+		return;
+	}
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+	entry = entry_find(node, service, hints);
+	if (entry == NULL) {
+		entry = entry_alloc(now);
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	strcpy(entry->node, node);
+	strcpy(entry->service, service ? service : "");
+
+	if (hints != NULL) {
+		entry->family = hints->ai_family;
+		entry->socktype = hints->ai_socktype;
+		entry->protocol = hints->ai_protocol;
+		entry->flags = hints->ai_flags;
+	}
+
+	entry->error = error;
+	entry->used = now;
+	entry->expires = now + MSEC_PER_SEC * (error ?
+		CONFIG_NRF91_SOCKET_DNS_CACHE_NEGATIVE_TTL :
+		CONFIG_NRF91_SOCKET_DNS_CACHE_TTL);
+
+	if (res != NULL && res->ai_canonname != NULL) {
+		strcpy(entry->canonname, res->ai_canonname);
+	}
+
+	for (; res != NULL && entry->count < ARRAY_SIZE(entry->addrs);
+	     res = res->ai_next) {
+		struct cache_addr *addr = &entry->addrs[entry->count];
+
+		if (res->ai_addrlen > sizeof(addr->addr)) {
+			continue;
+		}
+
+		addr->flags = res->ai_flags;
+		addr->family = res->ai_family;
+		addr->socktype = res->ai_socktype;
+		addr->protocol = res->ai_protocol;
+		addr->addrlen = res->ai_addrlen;
+		memcpy(&addr->addr, res->ai_addr, res->ai_addrlen);
+		entry->count++;
+	}
+
+	k_mutex_unlock(&cache_lock);
+}
+
+int nrf91_dns_cache_prefetch(const char *node, const char *service,
+			     const struct zsock_addrinfo *hints)
+{
+	struct zsock_addrinfo *res;
+	struct cache_entry *entry;
+	int err;
+
+	if (!is_cacheable(node, service, hints)) {
+		return DNS_EAI_FAIL;
+	}
+
+	/* Drop the entry so that the name is resolved again. */
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	entry = entry_find(node, service, hints);
+	if (entry != NULL) {
+		entry->expires = 0;
+	}
+	k_mutex_unlock(&cache_lock);
+
+	err = zsock_getaddrinfo(node, service, hints, &res);
+	if (err == 0) {
+		zsock_freeaddrinfo(res);
+	}
+
+	return err;
+}
+
+void nrf91_dns_cache_invalidate(const char *node)
+{
+	if (node == NULL) {
+		return;
+	}
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (strcmp(cache[i].node, node) == 0) {
+			cache[i].expires = 0;
+		}
+	}
+
+	k_mutex_unlock(&cache_lock);
+}
+
+void nrf91_dns_cache_flush(void)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	memset(cache, 0, sizeof(cache));
+	k_mutex_unlock(&cache_lock);
+}
+
+void nrf91_dns_cache_stats_get(struct nrf91_dns_cache_stats *out)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	*out = stats;
+	k_mutex_unlock(&cache_lock);
+}
+
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE_SHELL)
+
+#include <shell/shell.h>
+
+static int cmd_dns_cache_list(const struct shell *shell, size_t argc,
+			      char **argv)
+{
+	int64_t now;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		const struct cache_entry *entry = &cache[i];
+
+		if (entry->expires <= now) {
+			continue;
+		}
+
+		shell_print(shell, "%s%s%s: %s, expires in %d s", entry->node,
+			    entry->service[0] ? ":" : "", entry->service,
+			    entry->error ? "not found" : "found",
+			    (int)((entry->expires - now) / MSEC_PER_SEC));
+
+		for (size_t j = 0; j < entry->count; j++) {
+			char str[NET_IPV6_ADDR_LEN];
+			const void *addr;
+
+			if (entry->addrs[j].family == AF_INET) {
+				addr = &entry->addrs[j].addr.in.sin_addr;
+			} else {
+				addr = &entry->addrs[j].addr.in6.sin6_addr;
+			}
+
+			shell_print(shell, "  %s",
+				    zsock_inet_ntop(entry->addrs[j].family,
+						    addr, str, sizeof(str)) ?
+				    str : "?");
+		}
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return 0;
+}
+
+static int cmd_dns_cache_stats(const struct shell *shell, size_t argc,
+			       char **argv)
+{
+	struct nrf91_dns_cache_stats s;
+
+	nrf91_dns_cache_stats_get(&s);
+
+	shell_print(shell, "hits: %u", s.hits);
+	shell_print(shell, "negative hits: %u", s.negative_hits);
+	shell_print(shell, "misses: %u", s.misses);
+	shell_print(shell, "evictions: %u", s.evictions);
+
+	return 0;
+}
+
+static int cmd_dns_cache_flush(const struct shell *shell, size_t argc,
+			       char **argv)
+{
+	nrf91_dns_cache_flush();
+	shell_print(shell, "Flushed");
+
+	return 0;
+}
+
+static int cmd_dns_cache_prefetch(const struct shell *shell, size_t argc,
+				  char **argv)
+{
+	int err;
+
+	if (argc < 2 || argc > 3) {
+		shell_warn(shell, "usage: dns_cache prefetch <host> [<port>]");
+		return 0;
+	}
+
+	err = nrf91_dns_cache_prefetch(argv[1], (argc == 3) ? argv[2] : NULL,
+				       NULL);
+	if (err) {
+		shell_warn(shell, "Resolving %s failed, err %d", argv[1], err);
+	} else {
+		shell_print(shell, "Resolved %s", argv[1]);
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_dns_cache,
+	SHELL_CMD(flush, NULL, "Remove all entries", cmd_dns_cache_flush),
+	SHELL_CMD(list, NULL, "List the entries", cmd_dns_cache_list),
+	SHELL_CMD(prefetch, NULL, "Resolve a host and cache the result",
+		  cmd_dns_cache_prefetch),
+	SHELL_CMD(stats, NULL, "Show hit and miss statistics",
+		  cmd_dns_cache_stats),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(dns_cache, &sub_dns_cache, "nrf91 DNS cache", NULL);
+
+#endif /* CONFIG_NRF91_SOCKET_DNS_CACHE_SHELL */
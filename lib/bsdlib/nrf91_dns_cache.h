@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NRF91_DNS_CACHE_H__
+#define NRF91_DNS_CACHE_H__
+
+#include <stdbool.h>
+#include <net/socket.h>
+
+/**
+ * @brief Look up the result of getaddrinfo() in the cache.
+ *
+ * @param[in] node Host name.
+ * @param[in] service Service name or port, can be NULL.
+ * @param[in] hints Hints, can be NULL.
+ * @param[out] res Copy of the cached addresses, to be released with
+ *                 freeaddrinfo().
+ * @param[out] error 0 if the addresses were copied, or a DNS_EAI error code.
+ *
+ * @return true If the result was cached, false if the name must be resolved.
+ */
+bool nrf91_dns_cache_lookup(const char *node, const char *service,
+			    const struct zsock_addrinfo *hints,
+			    struct zsock_addrinfo **res, int *error);
+
+/**
+ * @brief Store the result of getaddrinfo() in the cache.
+ *
+ * Only successful results and failures to resolve the name are stored.
+ *
+ * @param[in] node Host name.
+ * @param[in] service Service name or port, can be NULL.
+ * @param[in] hints Hints, can be NULL.
+ * @param[in] error Return value of getaddrinfo().
+ * @param[in] res Addresses, if @p error is 0.
+ */
+void nrf91_dns_cache_store(const char *node, const char *service,
+			   const struct zsock_addrinfo *hints, int error,
+			   const struct zsock_addrinfo *res);
+
+#endif /* NRF91_DNS_CACHE_H__ */
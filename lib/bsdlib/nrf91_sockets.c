@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <init.h>
+#include <modem/nrf91_sockets.h>
 #include <net/socket_offload.h>
 #include <nrf_socket.h>
 #include <nrf_errno.h>
@@ -22,6 +23,8 @@
 #include <sys/fdtable.h>
 #include <zephyr.h>
 
+#include "nrf91_dns_cache.h"
+
 #if defined(CONFIG_NET_SOCKETS_OFFLOAD)
 
 #if defined(CONFIG_NRF91_SOCKET_ENABLE_DEBUG_LOGS)
@@ -36,8 +39,22 @@
 #define SD_TO_OBJ(sd) ((void *)(sd + 1))
 #define OBJ_TO_SD(obj) (((int)obj) - 1)
 
+/* When the poll event flags of bsdlib have the native values, the events
+ * are passed through without being translated flag by flag.
+ */
+#if (NRF_POLLIN == POLLIN) && (NRF_POLLOUT == POLLOUT) && \
+	(NRF_POLLERR == POLLERR) && (NRF_POLLHUP == POLLHUP) && \
+	(NRF_POLLNVAL == POLLNVAL)
+#define POLL_EVENTS_NATIVE 1
+#endif
+
 static const struct socket_op_vtable nrf91_socket_fd_op_vtable;
 
+/* Modem sockets that are datagram sockets, for recvmsg() to report
+ * truncated datagrams.
+ */
+static ATOMIC_DEFINE(dgram_sockets, BSD_MAX_SOCKET_COUNT);
+
 static void z_to_nrf_ipv4(const struct sockaddr *z_in,
 			  struct nrf_sockaddr_in *nrf_out)
 {
@@ -499,6 +516,7 @@ static int nrf_to_z_addrinfo(struct zsock_addrinfo *z_out,
 
 static int nrf91_socket_offload_socket(int family, int type, int proto)
 {
+	bool dgram = (type == SOCK_DGRAM);
 	int retval;
 
 	family = z_to_nrf_family(family);
@@ -517,6 +535,14 @@ static int nrf91_socket_offload_socket(int family, int type, int proto)
 
 	retval = nrf_socket(family, type, proto);
 
+	if (retval >= 0 && retval < BSD_MAX_SOCKET_COUNT) {
+		if (dgram) {
+			atomic_set_bit(dgram_sockets, retval);
+		} else {
+			atomic_clear_bit(dgram_sockets, retval);
+		}
+	}
+
 	return retval;
 }
 
@@ -557,6 +583,10 @@ static int nrf91_socket_offload_accept(void *obj, struct sockaddr *addr,
 		return -1;
 	}
 
+	if (new_sd < BSD_MAX_SOCKET_COUNT) {
+		atomic_clear_bit(dgram_sockets, new_sd);
+	}
+
 	if ((addr != NULL) && (addrlen != NULL)) {
 		if (nrf_addr_ptr->sa_family == NRF_AF_INET) {
 			*addrlen = sizeof(struct sockaddr_in);
@@ -817,34 +847,96 @@ error:
 	return retval;
 }
 
+/* Intermediate buffer of messages of several parts. */
+static K_MUTEX_DEFINE(msg_buf_lock);
+static uint8_t msg_buf[CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE];
+
+/* Returns a buffer to repack a message into. The static buffer is used if
+ * the message fits and no other socket is using it, otherwise a buffer is
+ * allocated, so that sockets do not wait for each other's send or receive
+ * to complete. Only waits for the static buffer if the allocation fails.
+ */
+static uint8_t *msg_buf_get(size_t len)
+{
+	uint8_t *buf;
+
+	if (len <= sizeof(msg_buf) &&
+	    k_mutex_lock(&msg_buf_lock, K_NO_WAIT) == 0) {
+		return msg_buf;
+	}
+
+	buf = k_malloc(len);
+	if (buf == NULL && len <= sizeof(msg_buf)) {
+		k_mutex_lock(&msg_buf_lock, K_FOREVER);
+		buf = msg_buf;
+	}
+
+	return buf;
+}
+
+static void msg_buf_put(uint8_t *buf)
+{
+	if (buf == msg_buf) {
+		k_mutex_unlock(&msg_buf_lock);
+	} else {
+		k_free(buf);
+	}
+}
+
+/* Returns the total length of a message, and the number of its parts
+ * that are not empty. The last one is returned in @p part.
+ */
+static size_t msg_len(const struct msghdr *msg, int *parts, int *part)
+{
+	size_t len = 0;
+
+	*parts = 0;
+	*part = 0;
+
+	for (int i = 0; i < msg->msg_iovlen; i++) {
+		if (msg->msg_iov[i].iov_len == 0) {
+			continue;
+		}
+
+		len += msg->msg_iov[i].iov_len;
+		*parts += 1;
+		*part = i;
+	}
+
+	return len;
+}
+
 static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 					    int flags)
 {
-	ssize_t len = 0;
+	ssize_t len;
 	ssize_t ret;
-	int i;
-	static K_MUTEX_DEFINE(sendmsg_lock);
-	static uint8_t buf[CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE];
+	uint8_t *buf;
+	int parts;
+	int part;
 
 	if (msg == NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Try to reduce number of `sendto` calls - copy data if they fit into
-	 * a single buffer
-	 */
+	len = msg_len(msg, &parts, &part);
 
-	for (i = 0; i < msg->msg_iovlen; i++) {
-		len += msg->msg_iov[i].iov_len;
+	/* A message of a single part is passed to the modem as is. */
+	if (parts <= 1) {
+		return nrf91_socket_offload_sendto(obj,
+			(parts == 1) ? msg->msg_iov[part].iov_base : msg_buf,
+			len, flags, msg->msg_name, msg->msg_namelen);
 	}
 
-	if (len <= sizeof(buf)) {
-		/* Protect `buf` access with a mutex. */
-		k_mutex_lock(&sendmsg_lock, K_FOREVER);
+	/* Each call to `nrf_sendto` is a request to the modem, so repack the
+	 * parts and send them in one call if they fit into the buffer.
+	 */
+	if (len <= sizeof(msg_buf)) {
+		buf = msg_buf_get(len);
 		len = 0;
 
-		for (i = 0; i < msg->msg_iovlen; i++) {
+		for (int i = 0; i < msg->msg_iovlen; i++) {
 			memcpy(buf + len, msg->msg_iov[i].iov_base,
 			       msg->msg_iov[i].iov_len);
 			len += msg->msg_iov[i].iov_len;
@@ -854,7 +946,7 @@ static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 						  flags, msg->msg_name,
 						  msg->msg_namelen);
 
-		k_mutex_unlock(&sendmsg_lock);
+		msg_buf_put(buf);
 		return ret;
 	}
 
@@ -864,7 +956,7 @@ static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 
 	len = 0;
 
-	for (i = 0; i < msg->msg_iovlen; i++) {
+	for (int i = 0; i < msg->msg_iovlen; i++) {
 		if (msg->msg_iov[i].iov_len == 0) {
 			continue;
 		}
@@ -883,76 +975,339 @@ static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 	return len;
 }
 
+/* Receives a message into one buffer. The modem is asked for the real
+ * length of a datagram, so that a datagram longer than the buffer is
+ * reported with MSG_TRUNC in msg_flags.
+ */
+static ssize_t msg_recv(void *obj, struct msghdr *msg, void *buf, size_t len,
+			int flags)
+{
+	int sd = OBJ_TO_SD(obj);
+	ssize_t ret;
+
+	if (sd < 0 || sd >= BSD_MAX_SOCKET_COUNT ||
+	    !atomic_test_bit(dgram_sockets, sd)) {
+		return nrf91_socket_offload_recvfrom(obj, buf, len, flags,
+			msg->msg_name, &msg->msg_namelen);
+	}
+
+	ret = nrf91_socket_offload_recvfrom(obj, buf, len, flags | MSG_TRUNC,
+					    msg->msg_name, &msg->msg_namelen);
+	if (ret > (ssize_t)len) {
+		msg->msg_flags |= MSG_TRUNC;
+
+		/* As recvmsg(), the real length is only returned when
+		 * requested.
+		 */
+		if (!(flags & MSG_TRUNC)) {
+			ret = len;
+		}
+	}
+
+	return ret;
+}
+
+ssize_t nrf91_socket_recvmsg(int fd, struct msghdr *msg, int flags)
+{
+	void *obj;
+	ssize_t len;
+	ssize_t ret;
+	uint8_t *buf;
+	int parts;
+	int part;
+
+	if (msg == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	obj = z_get_fd_obj(fd, (const struct fd_op_vtable *)
+			       &nrf91_socket_fd_op_vtable, ENOTSOCK);
+	if (obj == NULL) {
+		return -1;
+	}
+
+	len = msg_len(msg, &parts, &part);
+	msg->msg_flags = 0;
+
+	/* A message of a single part is received from the modem as is. */
+	if (parts <= 1) {
+		return msg_recv(obj, msg,
+			(parts == 1) ? msg->msg_iov[part].iov_base : msg_buf,
+			len, flags);
+	}
+
+	/* A datagram must be received in one call, so it is received into
+	 * an intermediate buffer and then scattered into the parts.
+	 */
+	buf = msg_buf_get(len);
+	if (buf == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	ret = msg_recv(obj, msg, buf, len, flags);
+
+	len = 0;
+
+	for (int i = 0; i < msg->msg_iovlen && len < ret; i++) {
+		size_t copy = MIN(msg->msg_iov[i].iov_len,
+				  (size_t)(ret - len));
+
+		memcpy(msg->msg_iov[i].iov_base, buf + len, copy);
+		len += copy;
+	}
+
+	msg_buf_put(buf);
+
+	return ret;
+}
+
+static short z_to_nrf_poll_events(short z_events)
+{
+#if defined(POLL_EVENTS_NATIVE)
+	return z_events & (POLLIN | POLLOUT);
+#else
+	short nrf_events = 0;
+
+	if (z_events & POLLIN) {
+		nrf_events |= NRF_POLLIN;
+	}
+	if (z_events & POLLOUT) {
+		nrf_events |= NRF_POLLOUT;
+	}
+
+	return nrf_events;
+#endif
+}
+
+static short nrf_to_z_poll_events(short nrf_events)
+{
+#if defined(POLL_EVENTS_NATIVE)
+	return nrf_events & (POLLIN | POLLOUT | POLLERR | POLLHUP | POLLNVAL);
+#else
+	short z_events = 0;
+
+	if (nrf_events & NRF_POLLIN) {
+		z_events |= POLLIN;
+	}
+	if (nrf_events & NRF_POLLOUT) {
+		z_events |= POLLOUT;
+	}
+	if (nrf_events & NRF_POLLERR) {
+		z_events |= POLLERR;
+	}
+	if (nrf_events & NRF_POLLNVAL) {
+		z_events |= POLLNVAL;
+	}
+	if (nrf_events & NRF_POLLHUP) {
+		z_events |= POLLHUP;
+	}
+
+	return z_events;
+#endif
+}
+
+/* Returns the modem socket of an offloaded socket, or -1. */
+static int z_to_nrf_sd(int fd)
+{
+	void *obj = z_get_fd_obj(fd, (const struct fd_op_vtable *)
+				     &nrf91_socket_fd_op_vtable, ENOTSUP);
+
+	return (obj != NULL) ? OBJ_TO_SD(obj) : -1;
+}
+
 static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
 					    int timeout)
 {
 	int retval = 0;
-	struct nrf_pollfd tmp[BSD_MAX_SOCKET_COUNT] = { 0 };
-	void *obj;
+	struct nrf_pollfd tmp[BSD_MAX_SOCKET_COUNT];
+
+	if (nfds < 0 || nfds > BSD_MAX_SOCKET_COUNT) {
+		errno = EINVAL;
+		return -1;
+	}
 
 	for (int i = 0; i < nfds; i++) {
-		tmp[i].events = 0;
 		fds[i].revents = 0;
+		tmp[i].revents = 0;
 
 		if (fds[i].fd < 0) {
 			/* Per POSIX, negative fd's are just ignored */
 			tmp[i].fd = fds[i].fd;
+			tmp[i].events = 0;
 			continue;
-		} else {
-			obj = z_get_fd_obj(fds[i].fd,
-					   (const struct fd_op_vtable *)
-						     &nrf91_socket_fd_op_vtable,
-					   ENOTSUP);
-			if (obj != NULL) {
-				/* Offloaded socket found. */
-				tmp[i].fd = OBJ_TO_SD(obj);
-			} else {
-				/* Non-offloaded socket, return an error. */
-				fds[i].revents = POLLNVAL;
-				retval++;
-			}
 		}
 
-		/* Translate the API from native to nRF */
-		if (fds[i].events & POLLIN) {
-			tmp[i].events |= NRF_POLLIN;
-		}
-		if (fds[i].events & POLLOUT) {
-			tmp[i].events |= NRF_POLLOUT;
+		tmp[i].fd = z_to_nrf_sd(fds[i].fd);
+		if (tmp[i].fd < 0) {
+			/* Non-offloaded socket, return an error. */
+			fds[i].revents = POLLNVAL;
+			retval++;
 		}
+
+		/* Translate the API from native to nRF */
+		tmp[i].events = z_to_nrf_poll_events(fds[i].events);
 	}
 
 	if (retval > 0) {
 		return retval;
 	}
 
-	retval = nrf_poll((struct nrf_pollfd *)&tmp, nfds, timeout);
+	retval = nrf_poll(tmp, nfds, timeout);
 
 	/* Translate the API from nRF to native. */
 	/* No need to translate .events, shall be untouched by poll() */
 	for (int i = 0; i < nfds; i++) {
-		if (fds[i].fd < 0) {
-			continue;
+		if (fds[i].fd >= 0) {
+			fds[i].revents = nrf_to_z_poll_events(tmp[i].revents);
 		}
+	}
 
-		if (tmp[i].revents & NRF_POLLIN) {
-			fds[i].revents |= POLLIN;
-		}
-		if (tmp[i].revents & NRF_POLLOUT) {
-			fds[i].revents |= POLLOUT;
-		}
-		if (tmp[i].revents & NRF_POLLERR) {
-			fds[i].revents |= POLLERR;
+	return retval;
+}
+
+/* Negative error code of a failed bsdlib call. bsdlib sets errno through
+ * bsd_os_errno_set(), which translates it to a native value like for the
+ * offloaded calls, or sets a negative magic value if it cannot. That value
+ * must not be negated into a number of events.
+ */
+static int nrf_call_err(void)
+{
+	return (errno > 0) ? -errno : -EIO;
+}
+
+void nrf91_pollset_init(struct nrf91_pollset *set)
+{
+	set->count = 0;
+	set->next = 0;
+}
+
+static int pollset_index(const struct nrf91_pollset *set, int fd)
+{
+	for (int i = 0; i < set->count; i++) {
+		if (set->fds[i] == fd) {
+			return i;
 		}
-		if (tmp[i].revents & NRF_POLLNVAL) {
-			fds[i].revents |= POLLNVAL;
+	}
+
+	return -ENOENT;
+}
+
+int nrf91_pollset_add(struct nrf91_pollset *set, int fd, short events)
+{
+	int sd;
+
+	if (set == NULL || fd < 0) {
+		return -EINVAL;
+	}
+
+	if (pollset_index(set, fd) >= 0) {
+		return -EEXIST;
+	}
+
+	if (set->count == ARRAY_SIZE(set->fds)) {
+		return -ENOMEM;
+	}
+
+	sd = z_to_nrf_sd(fd);
+	if (sd < 0) {
+		return -EBADF;
+	}
+
+	set->fds[set->count] = fd;
+	set->nrf_fds[set->count].fd = sd;
+	set->nrf_fds[set->count].events = z_to_nrf_poll_events(events);
+	set->nrf_fds[set->count].revents = 0;
+	set->count++;
+
+	return 0;
+}
+
+int nrf91_pollset_modify(struct nrf91_pollset *set, int fd, short events)
+{
+	int i;
+
+	if (set == NULL) {
+		return -EINVAL;
+	}
+
+	i = pollset_index(set, fd);
+	if (i < 0) {
+		return i;
+	}
+
+	set->nrf_fds[i].events = z_to_nrf_poll_events(events);
+
+	return 0;
+}
+
+int nrf91_pollset_remove(struct nrf91_pollset *set, int fd)
+{
+	int i;
+
+	if (set == NULL) {
+		return -EINVAL;
+	}
+
+	i = pollset_index(set, fd);
+	if (i < 0) {
+		return i;
+	}
+
+	/* The order of the sockets does not matter, move the last one. */
+	set->count--;
+	set->fds[i] = set->fds[set->count];
+	set->nrf_fds[i] = set->nrf_fds[set->count];
+
+	if (set->next >= set->count) {
+		set->next = 0;
+	}
+
+	return 0;
+}
+
+int nrf91_pollset_wait(struct nrf91_pollset *set,
+		       struct nrf91_poll_event *events, int max_events,
+		       int timeout)
+{
+	int ready;
+	int n = 0;
+
+	if (set == NULL || events == NULL || max_events <= 0 ||
+	    set->count == 0) {
+		return -EINVAL;
+	}
+
+	ready = nrf_poll(set->nrf_fds, set->count, timeout);
+	if (ready < 0) {
+		return nrf_call_err();
+	}
+
+	/* Report the sockets with events in one pass, starting after the
+	 * last one reported by the previous wait.
+	 */
+	for (int j = 0; j < set->count && n < ready; j++) {
+		int i = (set->next + j) % set->count;
+
+		if (set->nrf_fds[i].revents == 0) {
+			continue;
 		}
-		if (tmp[i].revents & NRF_POLLHUP) {
-			fds[i].revents |= POLLHUP;
+
+		if (n == max_events) {
+			set->next = i;
+			return n;
 		}
+
+		events[n].fd = set->fds[i];
+		events[n].revents =
+			nrf_to_z_poll_events(set->nrf_fds[i].revents);
+		n++;
 	}
 
-	return retval;
+	set->next = 0;
+
+	return n;
 }
 
 static void nrf91_socket_offload_freeaddrinfo(struct zsock_addrinfo *root)
@@ -963,15 +1318,15 @@ static void nrf91_socket_offload_freeaddrinfo(struct zsock_addrinfo *root)
 		struct zsock_addrinfo *this = next;
 
 		next = next->ai_next;
+		k_free(this->ai_canonname);
 		k_free(this->ai_addr);
 		k_free(this);
 	}
 }
 
-static int nrf91_socket_offload_getaddrinfo(const char *node,
-					    const char *service,
-					    const struct zsock_addrinfo *hints,
-					    struct zsock_addrinfo **res)
+static int nrf91_socket_resolve(const char *node, const char *service,
+				const struct zsock_addrinfo *hints,
+				struct zsock_addrinfo **res)
 {
 	int error;
 	struct nrf_addrinfo nrf_hints;
@@ -1055,6 +1410,28 @@ static int nrf91_socket_offload_getaddrinfo(const char *node,
 	return retval;
 }
 
+static int nrf91_socket_offload_getaddrinfo(const char *node,
+					    const char *service,
+					    const struct zsock_addrinfo *hints,
+					    struct zsock_addrinfo **res)
+{
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+	int retval;
+
+	if (nrf91_dns_cache_lookup(node, service, hints, res, &retval)) {
+		return retval;
+	}
+
+	retval = nrf91_socket_resolve(node, service, hints, res);
+	nrf91_dns_cache_store(node, service, hints, retval,
+			      (retval == 0) ? *res : NULL);
+
+	return retval;
+#else
+	return nrf91_socket_resolve(node, service, hints, res);
+#endif
+}
+
 static int nrf91_socket_offload_fcntl(int fd, int cmd, va_list args)
 {
 	int retval;
@@ -0,0 +1,566 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/util.h>
+#include <json_tok.h>
+
+/* What the tokenizer expects next, whitespace aside. */
+enum expect {
+	EXPECT_VALUE,
+	/* First element of an array, or an empty array. */
+	EXPECT_VALUE_OR_CLOSE,
+	EXPECT_KEY,
+	/* First member of an object, or an empty object. */
+	EXPECT_KEY_OR_CLOSE,
+	EXPECT_COLON,
+	EXPECT_COMMA_OR_CLOSE,
+	EXPECT_END,
+};
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_delim(char c)
+{
+	return is_space(c) || c == ',' || c == ']' || c == '}';
+}
+
+static int hex_get(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+
+	return -1;
+}
+
+static int tok_new(struct json_tok_doc *doc, enum json_tok_type type,
+		   size_t start, size_t len)
+{
+	struct json_tok *tok;
+
+	if (doc->count == doc->size) {
+		return -ENOMEM;
+	}
+
+	tok = &doc->toks[doc->count];
+	tok->type = type;
+	tok->start = start;
+	tok->len = len;
+	tok->next = doc->count + 1;
+
+	return doc->count++;
+}
+
+/* Returns the length of the string starting after the opening quote. */
+static int string_scan(const char *json, size_t pos, size_t len)
+{
+	size_t start = pos;
+
+	while (pos < len) {
+		char c = json[pos];
+
+		if (c == '"') {
+			return pos - start;
+		} else if ((unsigned char)c < 0x20) {
+			return -EINVAL;
+		} else if (c != '\\') {
+			pos++;
+			continue;
+		}
+
+		if (++pos == len) {
+			return -EINVAL;
+		}
+
+		if (json[pos] == 'u') {
+			if (len - pos <= 4) {
+				return -EINVAL;
+			}
+
+			for (int i = 1; i <= 4; i++) {
+				if (hex_get(json[pos + i]) < 0) {
+					return -EINVAL;
+				}
+			}
+
+			pos += 4;
+		} else if (!strchr("\"\\/bfnrt", json[pos])) {
+			return -EINVAL;
+		}
+
+		pos++;
+	}
+
+	return -EINVAL;
+}
+
+/* Returns the type of the number or literal, or a negative error code. */
+static int primitive_check(const char *str, size_t len)
+{
+	if (len == 4 && memcmp(str, "true", 4) == 0) {
+		return JSON_TOK_TRUE;
+	} else if (len == 5 && memcmp(str, "false", 5) == 0) {
+		return JSON_TOK_FALSE;
+	} else if (len == 4 && memcmp(str, "null", 4) == 0) {
+		return JSON_TOK_NULL;
+	}
+
+	if (str[0] != '-' && (str[0] < '0' || str[0] > '9')) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 1; i < len; i++) {
+		if (!strchr("0123456789.eE+-", str[i])) {
+			return -EINVAL;
+		}
+	}
+
+	return JSON_TOK_NUMBER;
+}
+
+void json_tok_init(struct json_tok_doc *doc, struct json_tok *toks,
+		   size_t size)
+{
+	doc->json = NULL;
+	doc->toks = toks;
+	doc->size = MIN(size, UINT16_MAX);
+	doc->count = 0;
+}
+
+static int tokenize(struct json_tok_doc *doc, const char *json, size_t len)
+{
+	/* Tokens of the containers that are open. */
+	uint16_t stack[CONFIG_JSON_TOK_MAX_DEPTH];
+	enum expect expect = EXPECT_VALUE;
+	size_t depth = 0;
+	size_t pos = 0;
+	int tok;
+
+	while (pos < len) {
+		char c = json[pos];
+		bool done = false;
+
+		if (is_space(c)) {
+			pos++;
+			continue;
+		}
+
+		switch (expect) {
+		case EXPECT_KEY_OR_CLOSE:
+			if (c == '}') {
+				break;
+			}
+			/* Fall through */
+		case EXPECT_KEY:
+			if (c != '"') {
+				return -EINVAL;
+			}
+
+			tok = string_scan(json, pos + 1, len);
+			if (tok < 0) {
+				return tok;
+			}
+
+			tok = tok_new(doc, JSON_TOK_STRING, pos + 1, tok);
+			if (tok < 0) {
+				return tok;
+			}
+
+			pos += doc->toks[tok].len + 2;
+			expect = EXPECT_COLON;
+			continue;
+
+		case EXPECT_COLON:
+			if (c != ':') {
+				return -EINVAL;
+			}
+
+			pos++;
+			expect = EXPECT_VALUE;
+			continue;
+
+		case EXPECT_COMMA_OR_CLOSE:
+			if (c != ',') {
+				break;
+			}
+
+			pos++;
+			expect = (doc->toks[stack[depth - 1]].type ==
+				  JSON_TOK_OBJECT) ? EXPECT_KEY : EXPECT_VALUE;
+			continue;
+
+		case EXPECT_VALUE_OR_CLOSE:
+			if (c == ']') {
+				break;
+			}
+			/* Fall through */
+		case EXPECT_VALUE:
+			if (c == '{' || c == '[') {
+				if (depth == ARRAY_SIZE(stack)) {
+					return -E2BIG;
+				}
+
+				tok = tok_new(doc, (c == '{') ?
+					      JSON_TOK_OBJECT : JSON_TOK_ARRAY,
+					      pos, 0);
+				if (tok < 0) {
+					return tok;
+				}
+
+				stack[depth++] = tok;
+				pos++;
+				expect = (c == '{') ? EXPECT_KEY_OR_CLOSE :
+					 EXPECT_VALUE_OR_CLOSE;
+				continue;
+			} else if (c == '"') {
+				tok = string_scan(json, pos + 1, len);
+				if (tok < 0) {
+					return tok;
+				}
+
+				tok = tok_new(doc, JSON_TOK_STRING, pos + 1,
+					      tok);
+				if (tok < 0) {
+					return tok;
+				}
+
+				pos += doc->toks[tok].len + 2;
+			} else {
+				size_t end = pos;
+				int type;
+
+				while (end < len && !is_delim(json[end])) {
+					end++;
+				}
+
+				type = primitive_check(&json[pos], end - pos);
+				if (type < 0) {
+					return type;
+				}
+
+				tok = tok_new(doc, type, pos, end - pos);
+				if (tok < 0) {
+					return tok;
+				}
+
+				pos = end;
+			}
+
+			done = true;
+			break;
+
+		case EXPECT_END:
+		default:
+			return -EINVAL;
+		}
+
+		if (!done) {
+			/* Closing bracket of the innermost container. */
+			struct json_tok *container;
+			bool is_obj;
+
+			container = &doc->toks[stack[depth - 1]];
+			is_obj = (container->type == JSON_TOK_OBJECT);
+			if ((c != '}' && c != ']') || (c == '}') != is_obj) {
+				return -EINVAL;
+			}
+
+			container->len = pos + 1 - container->start;
+			container->next = doc->count;
+			depth--;
+			pos++;
+		}
+
+		expect = (depth > 0) ? EXPECT_COMMA_OR_CLOSE : EXPECT_END;
+	}
+
+	return (expect == EXPECT_END) ? 0 : -EINVAL;
+}
+
+int json_tok_parse(struct json_tok_doc *doc, const char *json, size_t len)
+{
+	int err;
+
+	if (doc == NULL || json == NULL) {
+		return -EINVAL;
+	}
+
+	if (len > UINT16_MAX) {
+		return -E2BIG;
+	}
+
+	doc->json = json;
+	doc->count = 0;
+
+	err = tokenize(doc, json, len);
+	if (err) {
+		doc->count = 0;
+	}
+
+	return err;
+}
+
+static int member_find(const struct json_tok_doc *doc, int tok,
+		       const char *key, size_t key_len)
+{
+	const struct json_tok *obj = &doc->toks[tok];
+	int i = tok + 1;
+
+	while (i < obj->next) {
+		const struct json_tok *k = &doc->toks[i];
+
+		if (k->len == key_len &&
+		    memcmp(&doc->json[k->start], key, key_len) == 0) {
+			return i + 1;
+		}
+
+		i = doc->toks[i + 1].next;
+	}
+
+	return -ENOENT;
+}
+
+static int element_find(const struct json_tok_doc *doc, int tok,
+			const char *index, size_t index_len)
+{
+	const struct json_tok *arr = &doc->toks[tok];
+	size_t n = 0;
+	int i = tok + 1;
+
+	if (index_len == 0 || index_len > 5) {
+		return -ENOENT;
+	}
+
+	for (size_t j = 0; j < index_len; j++) {
+		if (index[j] < '0' || index[j] > '9') {
+			return -ENOENT;
+		}
+
+		n = n * 10 + index[j] - '0';
+	}
+
+	while (i < arr->next) {
+		if (n-- == 0) {
+			return i;
+		}
+
+		i = doc->toks[i].next;
+	}
+
+	return -ENOENT;
+}
+
+int json_tok_find(const struct json_tok_doc *doc, int tok, const char *path)
+{
+	if (doc == NULL || path == NULL || tok < 0 || tok >= doc->count) {
+		return -ENOENT;
+	}
+
+	while (*path != '\0') {
+		const char *end = strchr(path, '.');
+		size_t len = end ? (size_t)(end - path) : strlen(path);
+
+		switch (doc->toks[tok].type) {
+		case JSON_TOK_OBJECT:
+			tok = member_find(doc, tok, path, len);
+			break;
+		case JSON_TOK_ARRAY:
+			tok = element_find(doc, tok, path, len);
+			break;
+		default:
+			tok = -ENOENT;
+			break;
+		}
+
+		if (tok < 0) {
+			return tok;
+		}
+
+		path += len + (end ? 1 : 0);
+	}
+
+	return tok;
+}
+
+bool json_tok_str_eq(const struct json_tok_doc *doc, int tok, const char *str)
+{
+	const struct json_tok *t;
+
+	if (doc == NULL || str == NULL || tok < 0 || tok >= doc->count) {
+		return false;
+	}
+
+	t = &doc->toks[tok];
+
+	return t->type == JSON_TOK_STRING && strlen(str) == t->len &&
+	       memcmp(&doc->json[t->start], str, t->len) == 0;
+}
+
+static size_t utf8_encode(uint32_t cp, char *out)
+{
+	if (cp < 0x80) {
+		out[0] = cp;
+		return 1;
+	} else if (cp < 0x800) {
+		out[0] = 0xc0 | (cp >> 6);
+		out[1] = 0x80 | (cp & 0x3f);
+		return 2;
+	} else if (cp < 0x10000) {
+		out[0] = 0xe0 | (cp >> 12);
+		out[1] = 0x80 | ((cp >> 6) & 0x3f);
+		out[2] = 0x80 | (cp & 0x3f);
+		return 3;
+	}
+
+	out[0] = 0xf0 | (cp >> 18);
+	out[1] = 0x80 | ((cp >> 12) & 0x3f);
+	out[2] = 0x80 | ((cp >> 6) & 0x3f);
+	out[3] = 0x80 | (cp & 0x3f);
+	return 4;
+}
+
+static uint32_t hex4_get(const char *str)
+{
+	return (hex_get(str[0]) << 12) | (hex_get(str[1]) << 8) |
+	       (hex_get(str[2]) << 4) | hex_get(str[3]);
+}
+
+/* Decodes the escape sequence after the backslash, returns its length. */
+static size_t escape_decode(const char *str, size_t len, char *out,
+			    size_t *out_len)
+{
+	static const char from[] = "\"\\/bfnrt";
+	static const char to[] = "\"\\/\b\f\n\r\t";
+	uint32_t cp;
+
+	if (str[0] != 'u') {
+		out[0] = to[strchr(from, str[0]) - from];
+		*out_len = 1;
+		return 1;
+	}
+
+	cp = hex4_get(&str[1]);
+
+	/* A high surrogate followed by a low surrogate is one code point. */
+	if (cp >= 0xd800 && cp < 0xdc00 && len >= 11 &&
+	    str[5] == '\\' && str[6] == 'u') {
+		uint32_t low = hex4_get(&str[7]);
+
+		if (low >= 0xdc00 && low < 0xe000) {
+			cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+			*out_len = utf8_encode(cp, out);
+			return 11;
+		}
+	}
+
+	if (cp >= 0xd800 && cp < 0xe000) {
+		/* Unpaired surrogate, replaced by U+FFFD. */
+		cp = 0xfffd;
+	}
+
+	*out_len = utf8_encode(cp, out);
+	return 5;
+}
+
+int json_tok_str_copy(const struct json_tok_doc *doc, int tok, char *buf,
+		      size_t size)
+{
+	const struct json_tok *t;
+	const char *str;
+	size_t out = 0;
+	size_t i = 0;
+
+	if (doc == NULL || tok < 0 || tok >= doc->count ||
+	    doc->toks[tok].type != JSON_TOK_STRING ||
+	    (buf == NULL && size != 0)) {
+		return -EINVAL;
+	}
+
+	t = &doc->toks[tok];
+	str = &doc->json[t->start];
+
+	while (i < t->len) {
+		char utf8[4];
+		const char *chunk = &str[i];
+		size_t chunk_len = 1;
+
+		if (str[i] == '\\') {
+			i += 1 + escape_decode(&str[i + 1], t->len - i - 1,
+					       utf8, &chunk_len);
+			chunk = utf8;
+		} else {
+			i++;
+		}
+
+		if (out + chunk_len < size) {
+			memcpy(&buf[out], chunk, chunk_len);
+		} else if (out < size) {
+			/* Do not split a character. */
+			size = out + 1;
+		}
+
+		out += chunk_len;
+	}
+
+	if (size > 0) {
+		buf[MIN(out, size - 1)] = '\0';
+	}
+
+	return out;
+}
+
+int json_tok_int_get(const struct json_tok_doc *doc, int tok, int *value)
+{
+	const struct json_tok *t;
+	const char *str;
+	bool negative;
+	int64_t n = 0;
+	size_t i;
+
+	if (doc == NULL || value == NULL || tok < 0 || tok >= doc->count ||
+	    doc->toks[tok].type != JSON_TOK_NUMBER) {
+		return -EINVAL;
+	}
+
+	t = &doc->toks[tok];
+	str = &doc->json[t->start];
+	negative = (str[0] == '-');
+	i = negative ? 1 : 0;
+
+	if (i == t->len) {
+		return -EINVAL;
+	}
+
+	for (; i < t->len; i++) {
+		if (str[i] < '0' || str[i] > '9') {
+			return -EINVAL;
+		}
+
+		n = n * 10 + (str[i] - '0');
+		if (n > (int64_t)INT_MAX + 1) {
+			return -ERANGE;
+		}
+	}
+
+	n = negative ? -n : n;
+	if (n > INT_MAX) {
+		return -ERANGE;
+	}
+
+	*value = (int)n;
+
+	return 0;
+}
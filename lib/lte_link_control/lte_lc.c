@@ -540,10 +540,12 @@ static int w_lte_lc_init(void)
 		return err;
 	}
 
-	err = at_notif_register_handler(NULL, at_handler);
-	if (err) {
-		LOG_ERR("Can't register AT handler, error: %d", err);
-		return err;
+	for (size_t i = 0; i < ARRAY_SIZE(at_notifs); i++) {
+		err = at_notif_register_prefix(at_notifs[i], NULL, at_handler);
+		if (err) {
+			LOG_ERR("Can't register AT handler, error: %d", err);
+			return err;
+		}
 	}
 
 	if (sys_mode_current != sys_mode_target) {
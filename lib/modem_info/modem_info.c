@@ -343,11 +343,6 @@ static const struct modem_info_data *const modem_data[] = {
 static rsrp_cb_t modem_info_rsrp_cb;
 static struct at_param_list m_param_list;
 
-static bool is_cesq_notification(const char *buf, size_t len)
-{
-	return strstr(buf, AT_CMD_CESQ_RESP) ? true : false;
-}
-
 static void flip_iccid_string(char *buf)
 {
 	uint8_t current_char;
@@ -602,10 +597,6 @@ static void modem_info_rsrp_subscribe_handler(void *context, const char *respons
 	uint16_t param_value;
 	int err;
 
-	if (!is_cesq_notification(response, strlen(response))) {
-		return;
-	}
-
 	const struct modem_info_data rsrp_notify_data = {
 		.cmd		= AT_CMD_CESQ,
 		.data_name	= RSRP_DATA_NAME,
@@ -636,7 +627,7 @@ int modem_info_rsrp_register(rsrp_cb_t cb)
 {
 	modem_info_rsrp_cb = cb;
 
-	int rc = at_notif_register_handler(NULL,
+	int rc = at_notif_register_prefix(AT_CMD_CESQ_RESP, NULL,
 		modem_info_rsrp_subscribe_handler);
 	if (rc != 0) {
 		LOG_ERR("Can't register handler rc=%d", rc);
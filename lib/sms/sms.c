@@ -218,7 +218,8 @@ int sms_init(void)
 	}
 
 	/* Register for AT commands notifications before creating the client. */
-	ret = at_notif_register_handler(NULL, sms_at_handler);
+	ret = at_notif_register_prefix(AT_SMS_NOTIFICATION, NULL,
+				       sms_at_handler);
 	if (ret) {
 		LOG_ERR("Cannot register AT notification handler, err: %d",
 			ret);
@@ -228,7 +229,8 @@ int sms_init(void)
 	/* Register this module as an SMS client. */
 	ret = at_cmd_write(AT_SMS_SUBSCRIBER_REGISTER, NULL, 0, NULL);
 	if (ret) {
-		(void)at_notif_deregister_handler(NULL, sms_at_handler);
+		(void)at_notif_deregister_prefix(AT_SMS_NOTIFICATION, NULL,
+						 sms_at_handler);
 		LOG_ERR("Unable to register a new SMS client, err: %d", ret);
 		return ret;
 	}
@@ -302,7 +304,8 @@ void sms_uninit(void)
 	}
 
 	/* Unregister from AT commands notifications. */
-	(void)at_notif_deregister_handler(NULL, sms_at_handler);
+	(void)at_notif_deregister_prefix(AT_SMS_NOTIFICATION, NULL,
+					 sms_at_handler);
 
 	sms_client_registered = false;
 }
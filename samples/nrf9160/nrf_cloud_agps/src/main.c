@@ -72,11 +72,8 @@ static void gps_start_work_fn(struct k_work *work)
 	start_search_timestamp = k_uptime_get();
 }
 
-static void process_agps_data(char *buf, size_t len)
+static void agps_processed(int err)
 {
-	int err;
-
-	err = nrf_cloud_agps_process(buf, len, NULL);
 	if (err) {
 		LOG_ERR("A-GPS failed, error: %d", err);
 		LOG_WRN("GPS starts without new assistance data in 3 seconds");
@@ -88,6 +85,39 @@ static void process_agps_data(char *buf, size_t len)
 	k_delayed_work_submit(&gps_start_work, K_SECONDS(3));
 }
 
+static void process_agps_data(char *buf, size_t len)
+{
+	agps_processed(nrf_cloud_agps_process(buf, len, NULL));
+}
+
+static void process_agps_chunk(const struct cloud_msg_chunk *chunk)
+{
+	int err;
+
+	if (chunk->err) {
+		/* The rest of the data could not be received */
+		nrf_cloud_agps_process_abort();
+		agps_processed(chunk->err);
+		return;
+	}
+
+	err = nrf_cloud_agps_process_chunk(chunk->msg.buf, chunk->msg.len,
+					   chunk->offset, chunk->total_len,
+					   NULL);
+	if (err == -ECANCELED) {
+		/* Failure already reported for an earlier chunk */
+		return;
+	}
+
+	if ((err == 0) &&
+	    (chunk->offset + chunk->msg.len < chunk->total_len)) {
+		/* Wait for the rest of the data */
+		return;
+	}
+
+	agps_processed(err);
+}
+
 static void on_ready_evt(void)
 {
 	int err;
@@ -146,6 +176,12 @@ static void cloud_event_handler(const struct cloud_backend *const backend,
 
 		process_agps_data(evt->data.msg.buf, evt->data.msg.len);
 		break;
+	case CLOUD_EVT_DATA_RECEIVED_CHUNK:
+		LOG_DBG("CLOUD_EVT_DATA_RECEIVED_CHUNK");
+
+		/* Only A-GPS data is large enough to be received in chunks */
+		process_agps_chunk(&evt->data.chunk);
+		break;
 	case CLOUD_EVT_PAIR_REQUEST:
 		LOG_INF("CLOUD_EVT_PAIR_REQUEST");
 		break;
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+"""Compress and decompress images for the compressed DFU target.
+
+The image is compressed as a single LZ4 block, with the match distance
+limited to a window small enough to be kept in RAM by the device while it
+decompresses the image as it is downloaded. A sequence is:
+
+    token        u8   literal length (high nibble), match length - 4 (low)
+    [lengths]         255 bytes extend a nibble of 15, as in LZ4
+    literals
+    distance     u16  little endian, 1 to the window size
+    [lengths]
+
+The image ends after the literals or the match that completes it, the
+last sequence then has no distance if it ends with literals.
+
+Format (integers are little endian):
+
+    magic        u32  COMPRESSED_MAGIC
+    window_bits  u8   log2 of the window size
+    reserved     3 bytes, zero
+    image_size   u32
+    sequences
+"""
+
+import argparse
+import struct
+import sys
+
+COMPRESSED_MAGIC = 0x5a4c4644  # "DFLZ"
+HEADER = struct.Struct('<IB3xI')
+
+MIN_MATCH = 4
+WINDOW_BITS_DEFAULT = 12
+WINDOW_BITS_MAX = 16
+# Candidates tried per position, to bound compression time
+CHAIN_DEPTH = 32
+
+
+def lengths(value):
+    out = bytearray()
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+    return bytes(out)
+
+
+def sequence(literals, match_len=None, distance=None):
+    lit_nibble = min(len(literals), 15)
+    if match_len is None:
+        match_nibble = 0
+    else:
+        match_nibble = min(match_len - MIN_MATCH, 15)
+
+    out = bytearray([lit_nibble << 4 | match_nibble])
+    if lit_nibble == 15:
+        out += lengths(len(literals) - 15)
+    out += literals
+    if match_len is not None:
+        out += struct.pack('<H', distance)
+        if match_nibble == 15:
+            out += lengths(match_len - MIN_MATCH - 15)
+    return bytes(out)
+
+
+def compress(image, window_bits=WINDOW_BITS_DEFAULT):
+    window = 1 << window_bits
+    max_distance = min(window, 0xffff)
+    head = {}
+    prev = [0] * len(image)
+    out = bytearray(HEADER.pack(COMPRESSED_MAGIC, window_bits, len(image)))
+
+    def insert(pos):
+        key = bytes(image[pos:pos + MIN_MATCH])
+        prev[pos] = head.get(key, -1)
+        head[key] = pos
+
+    pos = 0
+    literal_start = 0
+    while pos + MIN_MATCH <= len(image):
+        best_len, best_dist = 0, 0
+        candidate = head.get(bytes(image[pos:pos + MIN_MATCH]), -1)
+        depth = CHAIN_DEPTH
+        limit = len(image) - pos
+        while candidate >= 0 and pos - candidate <= max_distance and depth:
+            n = 0
+            while n < limit and image[candidate + n] == image[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_dist = n, pos - candidate
+            candidate = prev[candidate]
+            depth -= 1
+
+        if best_len >= MIN_MATCH:
+            out += sequence(image[literal_start:pos], best_len, best_dist)
+            for p in range(pos, min(pos + best_len, len(image) - MIN_MATCH + 1)):
+                insert(p)
+            pos += best_len
+            literal_start = pos
+        else:
+            insert(pos)
+            pos += 1
+
+    if literal_start < len(image):
+        out += sequence(image[literal_start:])
+    return bytes(out)
+
+
+def decompress(data):
+    magic, window_bits, image_size = HEADER.unpack_from(data)
+    if magic != COMPRESSED_MAGIC:
+        raise ValueError('Not a compressed image')
+
+    window = 1 << window_bits
+    pos = HEADER.size
+    out = bytearray()
+
+    def read_lengths(nibble):
+        nonlocal pos
+        value = nibble
+        if nibble == 15:
+            while True:
+                byte = data[pos]
+                pos += 1
+                value += byte
+                if byte != 255:
+                    break
+        return value
+
+    while len(out) < image_size:
+        token = data[pos]
+        pos += 1
+        n = read_lengths(token >> 4)
+        out += data[pos:pos + n]
+        pos += n
+        if len(out) >= image_size:
+            break
+        distance = struct.unpack_from('<H', data, pos)[0]
+        pos += 2
+        if distance == 0 or distance > window or distance > len(out):
+            raise ValueError('Invalid match distance {}'.format(distance))
+        n = read_lengths(token & 0xf) + MIN_MATCH
+        for _ in range(n):
+            out.append(out[-distance])
+
+    if len(out) != image_size or pos != len(data):
+        raise ValueError('Corrupt compressed image')
+    return bytes(out)
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description="Compress or decompress images for the compressed DFU "
+                    "target.",
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    compress_parser = sub.add_parser('compress', help='Compress an image.')
+    compress_parser.add_argument('input', help='Image (signed binary).')
+    compress_parser.add_argument('output', help='Output compressed image.')
+    compress_parser.add_argument(
+        '--window-bits', type=int, default=WINDOW_BITS_DEFAULT,
+        help='log2 of the decompression window, must not exceed '
+             'CONFIG_DFU_TARGET_COMPRESSED_WINDOW_SIZE on the device. '
+             'Default: {}.'.format(WINDOW_BITS_DEFAULT))
+
+    decompress_parser = sub.add_parser(
+        'decompress', help='Decompress an image, for verification.')
+    decompress_parser.add_argument('input', help='Compressed image.')
+    decompress_parser.add_argument('output', help='Output image.')
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    with open(args.input, 'rb') as f:
+        data = f.read()
+
+    if args.command == 'compress':
+        if not 8 <= args.window_bits <= WINDOW_BITS_MAX:
+            sys.exit('Window bits must be 8 to {}'.format(WINDOW_BITS_MAX))
+        out = compress(data, args.window_bits)
+        if decompress(out) != data:
+            sys.exit('Internal error: image does not decompress')
+        print('{}: {} bytes, {:.1f}% of the image'.format(
+            args.output, len(out), 100 * len(out) / max(len(data), 1)))
+    else:
+        try:
+            out = decompress(data)
+        except ValueError as e:
+            sys.exit(str(e))
+
+    with open(args.output, 'wb') as f:
+        f.write(out)
+
+
+if __name__ == "__main__":
+    main()
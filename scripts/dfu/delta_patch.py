@@ -0,0 +1,322 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+"""Create and apply patches for the delta DFU target (dfu_target_delta).
+
+A patch rebuilds the target image from the source image (the image that is
+running on the device) with a sequence of operations, each of which can be
+applied in one pass with a bounded amount of memory:
+
+    COPY n      copy n bytes from the source, advancing the source position
+    INSERT n    n literal bytes follow
+    REPLACE n   n literal bytes follow, the source position also advances by
+                n (bytes changed in place, for example relocated addresses)
+    SEEK d      move the source position by d bytes
+    ADD n       add differences to the next n source bytes, the source
+                position advances by n (bsdiff style, for areas where many
+                scattered bytes changed, for example relocated addresses)
+
+The differences of an ADD are bytes added modulo 256 to the source bytes.
+As the patch is not compressed, a run of unchanged bytes is encoded as a 0
+difference followed by the LEB128 length of the run.
+
+Format (integers are little endian):
+
+    magic        u32  DELTA_MAGIC
+    source_size  u32
+    source_crc   u32  CRC-32 (IEEE) of the source image
+    target_size  u32
+    operations   op:u8, then a LEB128 length (zig-zag encoded for SEEK)
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+DELTA_MAGIC = 0x544c4544  # "DELT"
+HEADER = struct.Struct('<IIII')
+
+OP_COPY = 0
+OP_INSERT = 1
+OP_REPLACE = 2
+OP_SEEK = 3
+OP_ADD = 4
+
+# Shortest match worth a COPY (and a SEEK) instead of literal bytes
+MIN_MATCH = 8
+# Shortest match that ends a REPLACE, the source position is already right
+MIN_LOCKSTEP_MATCH = 4
+# Source offsets kept per indexed block, to bound memory use
+INDEX_DEPTH = 8
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def unzigzag(value):
+    return (value >> 1) if not value & 1 else -((value + 1) >> 1)
+
+
+def match_len(source, s, target, t):
+    n = 0
+    limit = min(len(source) - s, len(target) - t)
+    while n < limit and source[s + n] == target[t + n]:
+        n += 1
+    return n
+
+
+def add_data(source, s, target, t, n):
+    out = bytearray()
+    end = t + n
+    while t < end:
+        diff = (target[t] - source[s]) & 0xff
+        if diff:
+            out.append(diff)
+            s += 1
+            t += 1
+            continue
+        run = min(match_len(source, s, target, t), end - t)
+        out.append(0)
+        out += varint(run)
+        s += run
+        t += run
+    return bytes(out)
+
+
+class Encoder:
+    """Encodes operations. A sequence of COPY and REPLACE operations keeps
+    the source and the target in lockstep, and is encoded as one ADD when
+    this is shorter.
+    """
+
+    def __init__(self, source, target):
+        self.source = source
+        self.target = target
+        self.out = bytearray()
+        self.src = 0
+        self.dst = 0
+        self.lockstep = bytearray()
+        self.lockstep_start = (0, 0)
+
+    def flush(self):
+        if not self.lockstep:
+            return
+        s, t = self.lockstep_start
+        n = self.dst - t
+        add = bytes([OP_ADD]) + varint(n) + \
+            add_data(self.source, s, self.target, t, n)
+        self.out += add if len(add) < len(self.lockstep) else self.lockstep
+        self.lockstep = bytearray()
+
+    def op(self, op, length, data=b''):
+        encoded = bytes([op]) + varint(length) + data
+        if op in (OP_COPY, OP_REPLACE):
+            if not self.lockstep:
+                self.lockstep_start = (self.src, self.dst)
+            self.lockstep += encoded
+            self.src += length
+            self.dst += length
+            return
+
+        self.flush()
+        self.out += encoded
+        if op == OP_INSERT:
+            self.dst += length
+        elif op == OP_SEEK:
+            self.src += unzigzag(length)
+
+    def finish(self):
+        self.flush()
+        return bytes(self.out)
+
+
+def create(source, target):
+    index = {}
+    for s in range(len(source) - MIN_MATCH + 1):
+        offsets = index.setdefault(bytes(source[s:s + MIN_MATCH]), [])
+        if len(offsets) < INDEX_DEPTH:
+            offsets.append(s)
+
+    enc = Encoder(source, target)
+    src = 0        # Source position of the decoder
+    t = 0
+    literal_start = 0
+
+    def flush_literal(lockstep):
+        nonlocal src
+        literal = target[literal_start:t]
+        if not literal:
+            return
+        if lockstep:
+            enc.op(OP_REPLACE, len(literal), literal)
+            src += len(literal)
+        else:
+            enc.op(OP_INSERT, len(literal), literal)
+
+    while t < len(target):
+        literal_len = t - literal_start
+
+        # Continuing in lockstep with the source is the cheapest option
+        lockstep = src + literal_len
+        n = 0
+        if lockstep < len(source):
+            n = match_len(source, lockstep, target, t)
+        if n >= (MIN_LOCKSTEP_MATCH if literal_len else MIN_MATCH):
+            flush_literal(lockstep=True)
+            enc.op(OP_COPY, n)
+            src += n
+            t += n
+            literal_start = t
+            continue
+
+        best, best_len = None, 0
+        for s in index.get(bytes(target[t:t + MIN_MATCH]), ()):
+            n = match_len(source, s, target, t)
+            if n > best_len:
+                best, best_len = s, n
+
+        if best_len >= MIN_MATCH:
+            flush_literal(lockstep=False)
+            if best != src:
+                enc.op(OP_SEEK, zigzag(best - src))
+            enc.op(OP_COPY, best_len)
+            src = best + best_len
+            t += best_len
+            literal_start = t
+            continue
+
+        t += 1
+
+    flush_literal(lockstep=False)
+
+    header = HEADER.pack(DELTA_MAGIC, len(source),
+                         zlib.crc32(source) & 0xffffffff, len(target))
+    return header + enc.finish()
+
+
+def apply(source, patch):
+    magic, source_size, source_crc, target_size = HEADER.unpack_from(patch)
+    if magic != DELTA_MAGIC:
+        raise ValueError('Not a delta patch')
+    if len(source) < source_size or \
+            zlib.crc32(source[:source_size]) & 0xffffffff != source_crc:
+        raise ValueError('Patch does not apply to this source image')
+
+    def read_varint():
+        nonlocal pos
+        value, shift = 0, 0
+        while True:
+            byte = patch[pos]
+            pos += 1
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    out = bytearray()
+    pos = HEADER.size
+    src = 0
+    while pos < len(patch):
+        op = patch[pos]
+        pos += 1
+        n = read_varint()
+        if op == OP_COPY:
+            out += source[src:src + n]
+            src += n
+        elif op in (OP_INSERT, OP_REPLACE):
+            out += patch[pos:pos + n]
+            pos += n
+            if op == OP_REPLACE:
+                src += n
+        elif op == OP_SEEK:
+            src += unzigzag(n)
+        elif op == OP_ADD:
+            end = src + n
+            while src < end:
+                diff = patch[pos]
+                pos += 1
+                if diff:
+                    out.append((source[src] + diff) & 0xff)
+                    src += 1
+                else:
+                    run = read_varint()
+                    if src + run > end:
+                        raise ValueError('Run outside of ADD at {}'.format(
+                            pos))
+                    out += source[src:src + run]
+                    src += run
+        else:
+            raise ValueError('Unknown operation {} at {}'.format(op, pos - 1))
+
+    if len(out) != target_size:
+        raise ValueError('Patch produced {} bytes, expected {}'.format(
+            len(out), target_size))
+    return bytes(out)
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description="Create or apply patches for the delta DFU target.",
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    create_parser = sub.add_parser('create', help='Create a patch.')
+    create_parser.add_argument('source', help='Image running on the device (signed binary).')
+    create_parser.add_argument('target', help='New image (signed binary).')
+    create_parser.add_argument('patch', help='Output patch file.')
+
+    apply_parser = sub.add_parser('apply', help='Apply a patch, for verification.')
+    apply_parser.add_argument('source', help='Source image.')
+    apply_parser.add_argument('patch', help='Patch file.')
+    apply_parser.add_argument('target', help='Output image.')
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    with open(args.source, 'rb') as f:
+        source = f.read()
+
+    if args.command == 'create':
+        with open(args.target, 'rb') as f:
+            target = f.read()
+        patch = create(source, target)
+        if apply(source, patch) != target:
+            sys.exit('Internal error: patch does not rebuild the target')
+        with open(args.patch, 'wb') as f:
+            f.write(patch)
+        print('{}: {} bytes, {:.1f}% of the target image'.format(
+            args.patch, len(patch), 100 * len(patch) / max(len(target), 1)))
+    else:
+        with open(args.patch, 'rb') as f:
+            patch = f.read()
+        try:
+            target = apply(source, patch)
+        except ValueError as e:
+            sys.exit(str(e))
+        with open(args.target, 'wb') as f:
+            f.write(target)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from events import Event, EventType, EventsData
+import argparse
+import logging
+import sys
+
+# Binary stream format (CONFIG_PROFILER_NORDIC_RING_BUFFER):
+# Every record starts with a length byte (number of bytes that follow)
+# and a record ID. Record IDs below RECORD_ID_HEADER are event type IDs.
+#
+# Event:      timestamp (u32, little-endian), arguments (varint each)
+# Header:     stream version (u8), timestamp frequency in Hz (u32)
+# Descriptor: event type description "name,id,types...,labels..."
+# Overflow:   number of dropped records (varint)
+RECORD_ID_HEADER = 0xFD
+RECORD_ID_DESCR = 0xFE
+RECORD_ID_OVERFLOW = 0xFF
+
+STREAM_VERSION = 1
+TIMESTAMP_RAW_MAX = 2**32
+
+
+class BinaryStreamDecoder:
+
+    def __init__(self, log_lvl=logging.WARNING):
+        self.received_events = EventsData([], {})
+        self.frequency = None
+        self.timestamp_overflows = 0
+        self.last_timestamp_raw = 0
+        self.dropped_cnt = 0
+
+        self.logger = logging.getLogger('Binary Stream Decoder')
+        self.logger_console = logging.StreamHandler()
+        self.logger.setLevel(log_lvl)
+        self.log_format = logging.Formatter('[%(levelname)s] %(name)s: %(message)s')
+        self.logger_console.setFormatter(self.log_format)
+        self.logger.addHandler(self.logger_console)
+
+    @staticmethod
+    def _decode_varint(buf, pos):
+        val = 0
+        shift = 0
+        while True:
+            byte = buf[pos]
+            pos += 1
+            val |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return val, pos
+
+    @staticmethod
+    def _parse_description(desc):
+        desc_fields = desc.split(',')
+
+        name = desc_fields[0]
+        id = int(desc_fields[1])
+        data_type = []
+        for i in range(2, len(desc_fields) // 2 + 1):
+            data_type.append(desc_fields[i])
+        data = []
+        for i in range(len(desc_fields) // 2 + 1, len(desc_fields)):
+            data.append(desc_fields[i])
+        return id, EventType(name, data_type, data)
+
+    def _decode_header(self, payload):
+        version = payload[0]
+        if version != STREAM_VERSION:
+            self.logger.error("Unsupported stream version: {}".format(version))
+            sys.exit()
+        self.frequency = int.from_bytes(payload[1:5], byteorder='little')
+        # Logging was restarted, timestamps start over
+        self.timestamp_overflows = 0
+        self.last_timestamp_raw = 0
+        self.logger.info("Timestamp frequency: {} Hz".format(self.frequency))
+
+    def _decode_event(self, id, payload):
+        if id not in self.received_events.registered_events_types:
+            self.logger.warning("Event of unknown type: {}".format(id))
+            return
+        if self.frequency is None:
+            self.logger.warning("Event received before stream header")
+            return
+
+        et = self.received_events.registered_events_types[id]
+        timestamp_raw = int.from_bytes(payload[0:4], byteorder='little')
+
+        # Records are stored in order of reservation in the ring buffer,
+        # so timestamps can go back slightly. Only a large step back is
+        # treated as a timer overflow.
+        if self.last_timestamp_raw - timestamp_raw > TIMESTAMP_RAW_MAX // 2:
+            self.timestamp_overflows += 1
+        self.last_timestamp_raw = timestamp_raw
+
+        timestamp = (timestamp_raw + self.timestamp_overflows *
+                     TIMESTAMP_RAW_MAX) / self.frequency
+
+        data = []
+        pos = 4
+        for i in et.data_types:
+            val, pos = BinaryStreamDecoder._decode_varint(payload, pos)
+            if i[0] == 's' and val >= 2**31:
+                val -= 2**32
+            data.append(val)
+
+        self.received_events.events.append(Event(id, timestamp, data))
+
+    def decode(self, buf):
+        pos = 0
+        while pos < len(buf):
+            length = buf[pos]
+            if pos + 1 + length > len(buf):
+                self.logger.warning("Stream ends with incomplete record")
+                break
+            id = buf[pos + 1]
+            payload = buf[pos + 2:pos + 1 + length]
+            pos += 1 + length
+
+            if id == RECORD_ID_HEADER:
+                self._decode_header(payload)
+            elif id == RECORD_ID_DESCR:
+                type_id, et = BinaryStreamDecoder._parse_description(
+                                  payload.decode('utf-8'))
+                self.received_events.registered_events_types[type_id] = et
+            elif id == RECORD_ID_OVERFLOW:
+                dropped, _ = BinaryStreamDecoder._decode_varint(payload, 0)
+                self.dropped_cnt += dropped
+                self.logger.warning("{} events dropped on device".format(dropped))
+            else:
+                self._decode_event(id, payload)
+
+        return self.received_events
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decoding binary data stream of Nordic profiler and saving to files.')
+    parser.add_argument('input_file', help='File with binary data stream')
+    parser.add_argument('dataset_name', help='Name of dataset')
+    parser.add_argument('--log', help='Log level')
+    args = parser.parse_args()
+
+    if args.log is not None:
+        log_lvl_number = int(getattr(logging, args.log.upper(), None))
+    else:
+        log_lvl_number = logging.WARNING
+
+    try:
+        with open(args.input_file, 'rb') as f:
+            buf = f.read()
+    except IOError:
+        print("Problem with accessing file: " + args.input_file)
+        sys.exit()
+
+    decoder = BinaryStreamDecoder(log_lvl=log_lvl_number)
+    received_events = decoder.decode(buf)
+    if decoder.dropped_cnt > 0:
+        print("Events dropped on device: {}".format(decoder.dropped_cnt))
+
+    received_events.write_data_to_files(args.dataset_name + ".csv",
+                                        args.dataset_name + ".json")
+
+
+if __name__ == "__main__":
+    main()
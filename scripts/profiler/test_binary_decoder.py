@@ -0,0 +1,134 @@
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from binary_decoder import BinaryStreamDecoder, RECORD_ID_HEADER, \
+                           RECORD_ID_DESCR, RECORD_ID_OVERFLOW, \
+                           STREAM_VERSION, TIMESTAMP_RAW_MAX
+import unittest
+
+# Run with: python3 -m unittest test_binary_decoder
+
+FREQUENCY = 32768
+
+
+def encode_varint(val):
+    # Same encoding as encode_varint() in profiler_nordic.c
+    out = bytearray()
+    while val > 0x7F:
+        out.append((val & 0x7F) | 0x80)
+        val >>= 7
+    out.append(val)
+    return out
+
+
+def encode_record(id, payload):
+    return bytes([len(payload) + 1, id]) + payload
+
+
+def encode_header():
+    return encode_record(RECORD_ID_HEADER,
+                         bytes([STREAM_VERSION]) +
+                         FREQUENCY.to_bytes(4, byteorder='little'))
+
+
+def encode_descr(descr):
+    return encode_record(RECORD_ID_DESCR, descr.encode('utf-8'))
+
+
+def encode_event(id, timestamp_raw, args):
+    payload = bytearray(timestamp_raw.to_bytes(4, byteorder='little'))
+    for arg in args:
+        # Signed arguments are sign-extended to 32 bits on the device.
+        payload += encode_varint(arg & (TIMESTAMP_RAW_MAX - 1))
+    return encode_record(id, bytes(payload))
+
+
+def encode_overflow(dropped):
+    return encode_record(RECORD_ID_OVERFLOW, bytes(encode_varint(dropped)))
+
+
+class TestBinaryDecoder(unittest.TestCase):
+
+    def decode(self, stream):
+        decoder = BinaryStreamDecoder()
+        return decoder, decoder.decode(stream)
+
+    def test_round_trip(self):
+        args = [0, 0x7F, 0x80, 0x3FFF, 0x4000, 2**32 - 1]
+        stream = (encode_header() +
+                  encode_descr("event_a,0,u32,u32,u32,u32,u32,u32,"
+                               "a,b,c,d,e,f") +
+                  encode_descr("event_b,1,s8,s32,x,y") +
+                  encode_event(0, 100, args) +
+                  encode_event(1, 200, [-1, -2**31]) +
+                  encode_event(1, 300, [127, 2**31 - 1]))
+
+        decoder, data = self.decode(stream)
+
+        self.assertEqual(decoder.dropped_cnt, 0)
+        self.assertEqual(data.registered_events_types[0].name, "event_a")
+        self.assertEqual(data.registered_events_types[1].data_types,
+                         ["s8", "s32"])
+        self.assertEqual(data.registered_events_types[1].data_descriptions,
+                         ["x", "y"])
+
+        self.assertEqual([ev.type_id for ev in data.events], [0, 1, 1])
+        self.assertEqual(data.events[0].data, args)
+        self.assertEqual(data.events[1].data, [-1, -2**31])
+        self.assertEqual(data.events[2].data, [127, 2**31 - 1])
+        self.assertAlmostEqual(data.events[0].timestamp, 100 / FREQUENCY)
+        self.assertAlmostEqual(data.events[2].timestamp, 300 / FREQUENCY)
+
+    def test_timestamp_overflow(self):
+        stream = (encode_header() +
+                  encode_descr("event_a,0,") +
+                  encode_event(0, TIMESTAMP_RAW_MAX - 10, []) +
+                  # Records can be stored slightly out of order.
+                  encode_event(0, TIMESTAMP_RAW_MAX - 20, []) +
+                  encode_event(0, 5, []))
+
+        _, data = self.decode(stream)
+
+        timestamps = [ev.timestamp * FREQUENCY for ev in data.events]
+        self.assertAlmostEqual(timestamps[0], TIMESTAMP_RAW_MAX - 10)
+        self.assertAlmostEqual(timestamps[1], TIMESTAMP_RAW_MAX - 20)
+        self.assertAlmostEqual(timestamps[2], TIMESTAMP_RAW_MAX + 5)
+
+    def test_overflow_record(self):
+        stream = (encode_header() +
+                  encode_descr("event_a,0,u32,a") +
+                  encode_event(0, 1, [1]) +
+                  encode_overflow(300) +
+                  encode_overflow(2) +
+                  encode_event(0, 2, [2]))
+
+        decoder, data = self.decode(stream)
+
+        self.assertEqual(decoder.dropped_cnt, 302)
+        self.assertEqual([ev.data for ev in data.events], [[1], [2]])
+
+    def test_incomplete_record(self):
+        stream = (encode_header() +
+                  encode_descr("event_a,0,u32,a") +
+                  encode_event(0, 1, [1]))
+        partial = encode_event(0, 2, [2])
+
+        _, data = self.decode(stream + partial[:-1])
+
+        self.assertEqual(len(data.events), 1)
+
+    def test_unknown_event(self):
+        stream = (encode_header() +
+                  encode_event(3, 1, [1]) +
+                  encode_descr("event_a,3,u32,a") +
+                  encode_event(3, 2, [2]))
+
+        _, data = self.decode(stream)
+
+        self.assertEqual([ev.data for ev in data.events], [[2]])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file dfu_target_compressed.h
+ *
+ * @defgroup dfu_target_compressed Compressed DFU Target
+ * @{
+ * @brief DFU Target for compressed application upgrades
+ *
+ * The image is decompressed as it is received, and written to the MCUBoot
+ * secondary slot through the MCUBoot DFU target. Images are compressed with
+ * scripts/dfu/compress_image.py.
+ */
+
+#ifndef DFU_TARGET_COMPRESSED_H__
+#define DFU_TARGET_COMPRESSED_H__
+
+#include <stddef.h>
+#include <dfu/dfu_target.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief See if data in buf indicates a compressed upgrade.
+ *
+ * @retval true if data matches, false otherwise.
+ */
+bool dfu_target_compressed_identify(const void *const buf);
+
+/**
+ * @brief Initialize dfu target, perform steps necessary to receive an image.
+ *
+ * @param[in] file_size Size of the compressed image.
+ * @param[in] cb Callback for signaling events(unused).
+ *
+ * @retval 0 If successful, negative errno otherwise.
+ */
+int dfu_target_compressed_init(size_t file_size, dfu_target_callback_t cb);
+
+/**
+ * @brief Get offset of the compressed image.
+ *
+ * Compressed images cannot be resumed, the offset is reset to zero when the
+ * target is initialized.
+ *
+ * @param[out] offset Returns the number of compressed bytes processed.
+ *
+ * @return 0 if success, otherwise negative value if unable to get the offset
+ */
+int dfu_target_compressed_offset_get(size_t *offset);
+
+/**
+ * @brief Write compressed image data.
+ *
+ * @param[in] buf Pointer to data that should be written.
+ * @param[in] len Length of data to write.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_compressed_write(const void *const buf, size_t len);
+
+/**
+ * @brief Deinitialize resources and finalize firmware upgrade if successful.
+ *
+ * @param[in] successful Indicate whether the image was successfully
+ *			 received.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_compressed_done(bool successful);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DFU_TARGET_COMPRESSED_H__ */
+
+/**@} */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file dfu_target_delta.h
+ *
+ * @defgroup dfu_target_delta Delta DFU Target
+ * @{
+ * @brief DFU Target for application upgrades distributed as patches
+ *
+ * The patch is applied to the image in the MCUBoot primary slot, and the
+ * resulting image is written to the secondary slot through the MCUBoot DFU
+ * target. Patches are created with scripts/dfu/delta_patch.py.
+ */
+
+#ifndef DFU_TARGET_DELTA_H__
+#define DFU_TARGET_DELTA_H__
+
+#include <stddef.h>
+#include <dfu/dfu_target.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief See if data in buf indicates a delta upgrade.
+ *
+ * @retval true if data matches, false otherwise.
+ */
+bool dfu_target_delta_identify(const void *const buf);
+
+/**
+ * @brief Initialize dfu target, perform steps necessary to receive a patch.
+ *
+ * @param[in] file_size Size of the patch being downloaded.
+ * @param[in] cb Callback for signaling events(unused).
+ *
+ * @retval 0 If successful, negative errno otherwise.
+ */
+int dfu_target_delta_init(size_t file_size, dfu_target_callback_t cb);
+
+/**
+ * @brief Get offset of the patch.
+ *
+ * Patches cannot be resumed, the offset is reset to zero when the target
+ * is initialized.
+ *
+ * @param[out] offset Returns the number of patch bytes processed.
+ *
+ * @return 0 if success, otherwise negative value if unable to get the offset
+ */
+int dfu_target_delta_offset_get(size_t *offset);
+
+/**
+ * @brief Write patch data.
+ *
+ * @param[in] buf Pointer to data that should be written.
+ * @param[in] len Length of data to write.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_delta_write(const void *const buf, size_t len);
+
+/**
+ * @brief Deinitialize resources and finalize firmware upgrade if successful.
+ *
+ * @param[in] successful Indicate whether the patch was successfully received.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_delta_done(bool successful);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DFU_TARGET_DELTA_H__ */
+
+/**@} */
@@ -8,6 +8,11 @@
 #include <dfu/mcuboot.h>
 #include <dfu/dfu_target.h>
 
+#ifdef CONFIG_DFU_TARGET_STREAM_HASH
+#include <string.h>
+#include <mbedtls/sha256.h>
+#endif
+
 #define DEF_DFU_TARGET(name) \
 static const struct dfu_target dfu_target_ ## name  = { \
 	.init = dfu_target_ ## name ## _init, \
@@ -24,6 +29,14 @@ DEF_DFU_TARGET(modem);
 #include "dfu_target_mcuboot.h"
 DEF_DFU_TARGET(mcuboot);
 #endif
+#ifdef CONFIG_DFU_TARGET_DELTA
+#include "dfu_target_delta.h"
+DEF_DFU_TARGET(delta);
+#endif
+#ifdef CONFIG_DFU_TARGET_COMPRESSED
+#include "dfu_target_compressed.h"
+DEF_DFU_TARGET(compressed);
+#endif
 
 #define MIN_SIZE_IDENTIFY_BUF 32
 
@@ -31,6 +44,126 @@ LOG_MODULE_REGISTER(dfu_target, CONFIG_DFU_TARGET_LOG_LEVEL);
 
 static const struct dfu_target *current_target;
 
+#ifdef CONFIG_DFU_TARGET_STREAM_HASH
+static mbedtls_sha256_context hash_ctx;
+static uint8_t expected_hash[DFU_TARGET_HASH_LEN];
+static bool hash_expected;
+/* Whether hash_ctx is initialized and the hash has not failed */
+static bool hash_started;
+/* The image was partly written before hashing started */
+static bool hash_resumed;
+static size_t hashed;
+
+static void hash_start(void)
+{
+	size_t offset;
+	int err = current_target->offset_get(&offset);
+
+	if (err) {
+		hash_resumed = true;
+		return;
+	}
+
+	if (offset != 0) {
+		/* Resuming. The hash still covers the whole image if the
+		 * previous writes were all hashed in this session.
+		 */
+		if (!hash_started || hashed != offset) {
+			hash_resumed = true;
+		}
+		return;
+	}
+
+	if (hash_started) {
+		mbedtls_sha256_free(&hash_ctx);
+	}
+
+	mbedtls_sha256_init(&hash_ctx);
+	err = mbedtls_sha256_starts_ret(&hash_ctx, 0);
+	if (err) {
+		mbedtls_sha256_free(&hash_ctx);
+	}
+	hash_started = (err == 0);
+	hash_resumed = false;
+	hashed = 0;
+}
+
+static void hash_update(const void *const buf, size_t len)
+{
+	if (hash_started &&
+	    mbedtls_sha256_update_ret(&hash_ctx, buf, len) != 0) {
+		mbedtls_sha256_free(&hash_ctx);
+		hash_started = false;
+	}
+
+	hashed += len;
+}
+
+static int hash_verify(void)
+{
+	uint8_t digest[DFU_TARGET_HASH_LEN];
+	int err;
+
+	if (!hash_expected) {
+		return 0;
+	}
+
+	if (hash_resumed) {
+		LOG_WRN("Download was resumed, digest not verified");
+		return 0;
+	}
+
+	if (!hash_started) {
+		LOG_ERR("Unable to compute digest");
+		return -EIO;
+	}
+
+	err = mbedtls_sha256_finish_ret(&hash_ctx, digest);
+	if (err) {
+		LOG_ERR("Unable to compute digest (err %d)", err);
+		return -EIO;
+	}
+
+	if (memcmp(digest, expected_hash, sizeof(digest))) {
+		LOG_ERR("Image digest mismatch");
+		return -EBADMSG;
+	}
+
+	LOG_INF("Image digest verified");
+
+	return 0;
+}
+
+static void hash_reset(void)
+{
+	if (hash_started) {
+		mbedtls_sha256_free(&hash_ctx);
+	}
+
+	hash_started = false;
+	hash_expected = false;
+	hash_resumed = false;
+	hashed = 0;
+}
+
+int dfu_target_hash_set(const uint8_t *hash)
+{
+	if (hash == NULL) {
+		return -EINVAL;
+	}
+
+	memcpy(expected_hash, hash, sizeof(expected_hash));
+	hash_expected = true;
+
+	return 0;
+}
+#else
+static inline void hash_start(void) {}
+static inline void hash_update(const void *const buf, size_t len) {}
+static inline int hash_verify(void) { return 0; }
+static inline void hash_reset(void) {}
+#endif /* CONFIG_DFU_TARGET_STREAM_HASH */
+
 int dfu_target_img_type(const void *const buf, size_t len)
 {
 #ifdef CONFIG_DFU_TARGET_MCUBOOT
@@ -38,6 +171,16 @@ int dfu_target_img_type(const void *const buf, size_t len)
 		return DFU_TARGET_IMAGE_TYPE_MCUBOOT;
 	}
 #endif
+#ifdef CONFIG_DFU_TARGET_DELTA
+	if (dfu_target_delta_identify(buf)) {
+		return DFU_TARGET_IMAGE_TYPE_DELTA;
+	}
+#endif
+#ifdef CONFIG_DFU_TARGET_COMPRESSED
+	if (dfu_target_compressed_identify(buf)) {
+		return DFU_TARGET_IMAGE_TYPE_COMPRESSED;
+	}
+#endif
 #ifdef CONFIG_DFU_TARGET_MODEM
 	if (dfu_target_modem_identify(buf)) {
 		return DFU_TARGET_IMAGE_TYPE_MODEM_DELTA;
@@ -60,6 +203,16 @@ int dfu_target_init(int img_type, size_t file_size, dfu_target_callback_t cb)
 		new_target = &dfu_target_mcuboot;
 	}
 #endif
+#ifdef CONFIG_DFU_TARGET_DELTA
+	if (img_type == DFU_TARGET_IMAGE_TYPE_DELTA) {
+		new_target = &dfu_target_delta;
+	}
+#endif
+#ifdef CONFIG_DFU_TARGET_COMPRESSED
+	if (img_type == DFU_TARGET_IMAGE_TYPE_COMPRESSED) {
+		new_target = &dfu_target_compressed;
+	}
+#endif
 #ifdef CONFIG_DFU_TARGET_MODEM
 	if (img_type == DFU_TARGET_IMAGE_TYPE_MODEM_DELTA) {
 		new_target = &dfu_target_modem;
@@ -77,12 +230,19 @@ int dfu_target_init(int img_type, size_t file_size, dfu_target_callback_t cb)
 	 */
 	if (new_target == current_target
 	   && img_type != DFU_TARGET_IMAGE_TYPE_MODEM_DELTA) {
+		hash_start();
 		return 0;
 	}
 
 	current_target = new_target;
 
-	return current_target->init(file_size, cb);
+	int err = current_target->init(file_size, cb);
+
+	if (err == 0) {
+		hash_start();
+	}
+
+	return err;
 }
 
 int dfu_target_offset_get(size_t *offset)
@@ -100,7 +260,13 @@ int dfu_target_write(const void *const buf, size_t len)
 		return -EACCES;
 	}
 
-	return current_target->write(buf, len);
+	int err = current_target->write(buf, len);
+
+	if (err == 0) {
+		hash_update(buf, len);
+	}
+
+	return err;
 }
 
 int dfu_target_done(bool successful)
@@ -111,6 +277,18 @@ int dfu_target_done(bool successful)
 		return -EACCES;
 	}
 
+	if (successful) {
+		/* Do not schedule a corrupted image for upgrade */
+		int verify_err = hash_verify();
+
+		if (verify_err != 0) {
+			(void)current_target->done(false);
+			hash_reset();
+			current_target = NULL;
+			return verify_err;
+		}
+	}
+
 	err = current_target->done(successful);
 	if (err != 0) {
 		LOG_ERR("Unable to clean up dfu_target");
@@ -118,6 +296,7 @@ int dfu_target_done(bool successful)
 	}
 
 	if (successful) {
+		hash_reset();
 		current_target = NULL;
 	}
 
@@ -134,6 +313,7 @@ int dfu_target_reset(void)
 			return err;
 		}
 	}
+	hash_reset();
 	current_target = NULL;
 	return 0;
 }
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <logging/log.h>
+#include <sys/byteorder.h>
+#include <dfu/dfu_target.h>
+#include "dfu_target_mcuboot.h"
+#include "dfu_target_compressed.h"
+
+LOG_MODULE_REGISTER(dfu_target_compressed, CONFIG_DFU_TARGET_LOG_LEVEL);
+
+/* Image format, see scripts/dfu/compress_image.py */
+#define COMPRESSED_MAGIC 0x5a4c4644
+#define HEADER_SIZE 12
+#define WINDOW_BITS_MAX 16
+
+#define MIN_MATCH 4
+#define LENGTH_EXTENDED 15
+
+#define WINDOW_SIZE CONFIG_DFU_TARGET_COMPRESSED_WINDOW_SIZE
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+
+BUILD_ASSERT((WINDOW_SIZE & WINDOW_MASK) == 0,
+	     "CONFIG_DFU_TARGET_COMPRESSED_WINDOW_SIZE must be a power of two");
+
+enum stream_state {
+	STATE_HEADER,
+	STATE_TOKEN,
+	STATE_LITERAL_LENGTH,
+	STATE_LITERALS,
+	STATE_DISTANCE,
+	STATE_MATCH_LENGTH,
+};
+
+static struct {
+	enum stream_state state;
+	uint8_t header[HEADER_SIZE];
+	size_t header_len;
+	uint32_t image_size;
+	/* Largest match distance allowed by the image header */
+	uint32_t max_distance;
+	/* Sequence being decoded */
+	uint8_t token;
+	uint32_t length;
+	uint32_t distance;
+	uint8_t distance_len;
+	/* Bytes of the image written */
+	size_t produced;
+	/* Bytes of the compressed image processed */
+	size_t offset;
+} stream;
+
+/* The last WINDOW_SIZE bytes of the image, indexed by image offset */
+static uint8_t window[WINDOW_SIZE];
+
+static int header_parse(void)
+{
+	uint8_t window_bits = stream.header[4];
+	size_t offset;
+	int err;
+
+	if (sys_get_le32(&stream.header[0]) != COMPRESSED_MAGIC) {
+		LOG_ERR("Not a compressed image");
+		return -EBADMSG;
+	}
+
+	if (window_bits > WINDOW_BITS_MAX ||
+	    (1UL << window_bits) > WINDOW_SIZE) {
+		LOG_ERR("Window of %lu bytes does not fit in %d bytes",
+			1UL << window_bits, WINDOW_SIZE);
+		return -ENOMEM;
+	}
+
+	stream.max_distance = 1UL << window_bits;
+	stream.image_size = sys_get_le32(&stream.header[8]);
+
+	err = dfu_target_mcuboot_init(stream.image_size, NULL);
+	if (err) {
+		return err;
+	}
+
+	/* The window is lost on reset, discard any stored MCUBoot progress */
+	err = dfu_target_mcuboot_offset_get(&offset);
+	if (err == 0 && offset != 0) {
+		err = dfu_target_mcuboot_done(false);
+	}
+
+	return err;
+}
+
+static int image_left_check(uint32_t len)
+{
+	if (len > stream.image_size - stream.produced) {
+		LOG_ERR("Data beyond the end of the image");
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+static int literals_write(const uint8_t *data, size_t len)
+{
+	int err = dfu_target_mcuboot_write(data, len);
+
+	if (err) {
+		return err;
+	}
+
+	/* Only the last WINDOW_SIZE bytes can be referenced */
+	if (len > WINDOW_SIZE) {
+		stream.produced += len - WINDOW_SIZE;
+		data += len - WINDOW_SIZE;
+		len = WINDOW_SIZE;
+	}
+
+	while (len > 0) {
+		size_t start = stream.produced & WINDOW_MASK;
+		size_t chunk = MIN(len, WINDOW_SIZE - start);
+
+		memcpy(&window[start], data, chunk);
+		stream.produced += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+static int match_copy(uint32_t distance, uint32_t len)
+{
+	int err = image_left_check(len);
+
+	if (err) {
+		return err;
+	}
+
+	if (distance == 0 || distance > stream.max_distance ||
+	    distance > stream.produced) {
+		LOG_ERR("Invalid match distance %u", distance);
+		return -EBADMSG;
+	}
+
+	/* Copied byte by byte, the match may overlap itself. The window is
+	 * written to flash up to its end, so that unwritten data is never
+	 * overwritten.
+	 */
+	while (len > 0) {
+		size_t start = stream.produced & WINDOW_MASK;
+		size_t chunk = MIN(len, WINDOW_SIZE - start);
+
+		for (size_t i = 0; i < chunk; i++) {
+			window[start + i] =
+				window[(stream.produced + i - distance) &
+				       WINDOW_MASK];
+		}
+
+		err = dfu_target_mcuboot_write(&window[start], chunk);
+		if (err) {
+			return err;
+		}
+
+		stream.produced += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Add a byte to a length that was extended past the token nibble.
+ *
+ * @return true if more length bytes follow.
+ */
+static bool length_extend(uint8_t byte)
+{
+	stream.length += byte;
+	return byte == UINT8_MAX;
+}
+
+static void literals_start(void)
+{
+	stream.state = stream.length ? STATE_LITERALS : STATE_DISTANCE;
+	stream.distance = 0;
+	stream.distance_len = 0;
+}
+
+static int match_start(void)
+{
+	int err = match_copy(stream.distance, stream.length + MIN_MATCH);
+
+	stream.state = STATE_TOKEN;
+	return err;
+}
+
+/**
+ * @brief Process compressed data.
+ *
+ * @return Number of bytes consumed, or a negative error code.
+ */
+static int stream_process(const uint8_t *data, size_t len)
+{
+	size_t used;
+	bool more;
+	int err;
+
+	switch (stream.state) {
+	case STATE_HEADER:
+		used = MIN(len, HEADER_SIZE - stream.header_len);
+		memcpy(&stream.header[stream.header_len], data, used);
+		stream.header_len += used;
+		if (stream.header_len == HEADER_SIZE) {
+			err = header_parse();
+			if (err) {
+				return err;
+			}
+			stream.state = STATE_TOKEN;
+		}
+		return used;
+	case STATE_TOKEN:
+		if (stream.produced == stream.image_size) {
+			LOG_ERR("Data after the end of the image");
+			return -EBADMSG;
+		}
+		stream.token = data[0];
+		stream.length = stream.token >> 4;
+		if (stream.length == LENGTH_EXTENDED) {
+			stream.state = STATE_LITERAL_LENGTH;
+		} else {
+			literals_start();
+		}
+		return 1;
+	case STATE_LITERAL_LENGTH:
+		more = length_extend(data[0]);
+		err = image_left_check(stream.length);
+		if (err) {
+			return err;
+		}
+		if (!more) {
+			literals_start();
+		}
+		return 1;
+	case STATE_LITERALS:
+		used = MIN(len, stream.length);
+		err = image_left_check(used);
+		if (err) {
+			return err;
+		}
+		err = literals_write(data, used);
+		if (err) {
+			return err;
+		}
+		stream.length -= used;
+		if (stream.length == 0) {
+			/* The image may end with literals */
+			stream.state = (stream.produced == stream.image_size) ?
+				       STATE_TOKEN : STATE_DISTANCE;
+		}
+		return used;
+	case STATE_DISTANCE:
+		stream.distance |= data[0] << (8 * stream.distance_len);
+		if (++stream.distance_len == sizeof(uint16_t)) {
+			stream.length = stream.token & 0xf;
+			if (stream.length == LENGTH_EXTENDED) {
+				stream.state = STATE_MATCH_LENGTH;
+			} else {
+				err = match_start();
+				if (err) {
+					return err;
+				}
+			}
+		}
+		return 1;
+	case STATE_MATCH_LENGTH:
+		more = length_extend(data[0]);
+		err = image_left_check(stream.length);
+		if (err) {
+			return err;
+		}
+		if (!more) {
+			err = match_start();
+			if (err) {
+				return err;
+			}
+		}
+		return 1;
+	default:
+		return -EINVAL;
+	}
+}
+
+bool dfu_target_compressed_identify(const void *const buf)
+{
+	return sys_get_le32(buf) == COMPRESSED_MAGIC;
+}
+
+int dfu_target_compressed_init(size_t file_size, dfu_target_callback_t cb)
+{
+	ARG_UNUSED(cb);
+
+	if (file_size < HEADER_SIZE) {
+		LOG_ERR("Compressed image too small");
+		return -EINVAL;
+	}
+
+	memset(&stream, 0, sizeof(stream));
+
+	return 0;
+}
+
+int dfu_target_compressed_offset_get(size_t *offset)
+{
+	*offset = stream.offset;
+	return 0;
+}
+
+int dfu_target_compressed_write(const void *const buf, size_t len)
+{
+	const uint8_t *data = buf;
+
+	while (len > 0) {
+		int used = stream_process(data, len);
+
+		if (used < 0) {
+			return used;
+		}
+
+		data += used;
+		len -= used;
+		stream.offset += used;
+	}
+
+	return 0;
+}
+
+int dfu_target_compressed_done(bool successful)
+{
+	bool started = stream.state != STATE_HEADER;
+	int err = 0;
+
+	if (successful && (stream.state != STATE_TOKEN ||
+			   stream.produced != stream.image_size)) {
+		LOG_ERR("Image incomplete, %zu of %u bytes decompressed",
+			stream.produced, stream.image_size);
+		successful = false;
+		err = -EBADMSG;
+	}
+
+	if (started) {
+		int done_err = dfu_target_mcuboot_done(successful);
+
+		if (err == 0) {
+			err = done_err;
+		}
+	}
+
+	memset(&stream, 0, sizeof(stream));
+
+	return err;
+}
@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <pm_config.h>
+#include <logging/log.h>
+#include <storage/flash_map.h>
+#include <sys/byteorder.h>
+#include <sys/crc.h>
+#include <dfu/dfu_target.h>
+#include "dfu_target_mcuboot.h"
+#include "dfu_target_delta.h"
+
+LOG_MODULE_REGISTER(dfu_target_delta, CONFIG_DFU_TARGET_LOG_LEVEL);
+
+/* Patch format, see scripts/dfu/delta_patch.py */
+#define DELTA_MAGIC 0x544c4544
+#define HEADER_SIZE 16
+
+#define OP_COPY 0
+#define OP_INSERT 1
+#define OP_REPLACE 2
+#define OP_SEEK 3
+#define OP_ADD 4
+
+/* Longest LEB128 encoding of a 32-bit value */
+#define LENGTH_MAX_SHIFT 28
+
+enum patch_state {
+	STATE_HEADER,
+	STATE_OP,
+	STATE_LENGTH,
+	STATE_LITERAL,
+	STATE_ADD,
+	STATE_ADD_RUN,
+};
+
+static struct {
+	enum patch_state state;
+	uint8_t header[HEADER_SIZE];
+	size_t header_len;
+	uint32_t source_size;
+	uint32_t target_size;
+	/* Operation being decoded */
+	uint8_t op;
+	uint32_t length;
+	uint8_t shift;
+	/* Literal bytes, or source bytes to add to, of the current operation
+	 * not yet processed
+	 */
+	uint32_t literal_left;
+	/* Read position in the source image */
+	int64_t source_pos;
+	/* Bytes of the target image written */
+	size_t produced;
+	/* Bytes of the patch processed */
+	size_t offset;
+} patch;
+
+/* Window used to move data from the source to the target image */
+static uint8_t window[CONFIG_DFU_TARGET_DELTA_BUF_SIZE];
+static const struct flash_area *source;
+
+static int source_check(uint32_t size, uint32_t crc)
+{
+	uint32_t actual = 0;
+	int err;
+
+	if (size > source->fa_size) {
+		return -EINVAL;
+	}
+
+	for (uint32_t pos = 0; pos < size; pos += sizeof(window)) {
+		size_t len = MIN(sizeof(window), size - pos);
+
+		err = flash_area_read(source, pos, window, len);
+		if (err) {
+			LOG_ERR("flash_area_read error %d", err);
+			return err;
+		}
+
+		actual = crc32_ieee_update(actual, window, len);
+	}
+
+	return actual == crc ? 0 : -EINVAL;
+}
+
+static int header_parse(void)
+{
+	size_t offset;
+	int err;
+
+	if (sys_get_le32(&patch.header[0]) != DELTA_MAGIC) {
+		LOG_ERR("Not a delta patch");
+		return -EBADMSG;
+	}
+
+	/* Opened here, and not in init, as dfu_target skips init when an
+	 * aborted procedure is restarted.
+	 */
+	if (source == NULL) {
+		err = flash_area_open(PM_MCUBOOT_PRIMARY_ID, &source);
+		if (err) {
+			LOG_ERR("flash_area_open error %d", err);
+			return err;
+		}
+	}
+
+	patch.source_size = sys_get_le32(&patch.header[4]);
+	patch.target_size = sys_get_le32(&patch.header[12]);
+
+	err = source_check(patch.source_size, sys_get_le32(&patch.header[8]));
+	if (err) {
+		LOG_ERR("Patch does not apply to the running image (err %d)",
+			err);
+		return err;
+	}
+
+	err = dfu_target_mcuboot_init(patch.target_size, NULL);
+	if (err) {
+		return err;
+	}
+
+	/* A patch cannot be resumed, discard any stored MCUBoot progress */
+	err = dfu_target_mcuboot_offset_get(&offset);
+	if (err == 0 && offset != 0) {
+		err = dfu_target_mcuboot_done(false);
+	}
+
+	return err;
+}
+
+static int target_write(const void *buf, size_t len)
+{
+	if (len > patch.target_size - patch.produced) {
+		LOG_ERR("Patch produces a too large image");
+		return -EBADMSG;
+	}
+
+	patch.produced += len;
+
+	return dfu_target_mcuboot_write(buf, len);
+}
+
+static int source_copy(uint32_t len)
+{
+	int err;
+
+	if (patch.source_pos + len > patch.source_size) {
+		LOG_ERR("Copy outside of the source image");
+		return -EBADMSG;
+	}
+
+	while (len > 0) {
+		size_t chunk = MIN(sizeof(window), len);
+
+		err = flash_area_read(source, (off_t)patch.source_pos, window,
+				      chunk);
+		if (err) {
+			LOG_ERR("flash_area_read error %d", err);
+			return err;
+		}
+
+		err = target_write(window, chunk);
+		if (err) {
+			return err;
+		}
+
+		patch.source_pos += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Add differences to the source bytes, up to the next unchanged byte.
+ *
+ * @return Number of differences consumed, or a negative error code.
+ */
+static int source_add(const uint8_t *diff, size_t len)
+{
+	size_t cnt = 0;
+	int err;
+
+	len = MIN(len, MIN(patch.literal_left, sizeof(window)));
+	while (cnt < len && diff[cnt] != 0) {
+		cnt++;
+	}
+
+	err = flash_area_read(source, (off_t)patch.source_pos, window, cnt);
+	if (err) {
+		LOG_ERR("flash_area_read error %d", err);
+		return err;
+	}
+
+	for (size_t i = 0; i < cnt; i++) {
+		window[i] += diff[i];
+	}
+
+	err = target_write(window, cnt);
+	if (err) {
+		return err;
+	}
+
+	patch.source_pos += cnt;
+	patch.literal_left -= cnt;
+	if (patch.literal_left == 0) {
+		patch.state = STATE_OP;
+	}
+
+	return cnt;
+}
+
+/* Copy a run of unchanged bytes within an ADD operation */
+static int add_run(void)
+{
+	int err;
+
+	if (patch.length > patch.literal_left) {
+		LOG_ERR("Run outside of the add operation");
+		return -EBADMSG;
+	}
+
+	err = source_copy(patch.length);
+	if (err) {
+		return err;
+	}
+
+	patch.literal_left -= patch.length;
+	patch.state = patch.literal_left ? STATE_ADD : STATE_OP;
+
+	return 0;
+}
+
+/**
+ * @brief Decode a byte of a LEB128 length.
+ *
+ * @return 1 if the length is complete, 0 if more bytes follow, or a negative
+ *         error code.
+ */
+static int length_decode(uint8_t byte)
+{
+	if (patch.shift > LENGTH_MAX_SHIFT) {
+		LOG_ERR("Operation length overflow");
+		return -EBADMSG;
+	}
+
+	patch.length |= (uint32_t)(byte & 0x7f) << patch.shift;
+	patch.shift += 7;
+
+	return (byte & 0x80) ? 0 : 1;
+}
+
+static int op_execute(void)
+{
+	int64_t distance;
+
+	patch.state = STATE_OP;
+
+	switch (patch.op) {
+	case OP_COPY:
+		return source_copy(patch.length);
+	case OP_REPLACE:
+		patch.source_pos += patch.length;
+		/* Fall through */
+	case OP_INSERT:
+		if (patch.length > 0) {
+			patch.literal_left = patch.length;
+			patch.state = STATE_LITERAL;
+		}
+		return 0;
+	case OP_SEEK:
+		/* Zig-zag encoded */
+		distance = (patch.length & 1) ?
+			-(((int64_t)patch.length + 1) >> 1) :
+			(int64_t)(patch.length >> 1);
+		if (patch.source_pos + distance < 0) {
+			LOG_ERR("Seek outside of the source image");
+			return -EBADMSG;
+		}
+		patch.source_pos += distance;
+		return 0;
+	case OP_ADD:
+		if (patch.source_pos + patch.length > patch.source_size) {
+			LOG_ERR("Add outside of the source image");
+			return -EBADMSG;
+		}
+		if (patch.length > 0) {
+			patch.literal_left = patch.length;
+			patch.state = STATE_ADD;
+		}
+		return 0;
+	default:
+		LOG_ERR("Unknown operation %d", patch.op);
+		return -EBADMSG;
+	}
+}
+
+/**
+ * @brief Process patch data.
+ *
+ * @return Number of bytes consumed, or a negative error code.
+ */
+static int patch_process(const uint8_t *data, size_t len)
+{
+	size_t used;
+	int err;
+
+	switch (patch.state) {
+	case STATE_HEADER:
+		used = MIN(len, HEADER_SIZE - patch.header_len);
+		memcpy(&patch.header[patch.header_len], data, used);
+		patch.header_len += used;
+		if (patch.header_len == HEADER_SIZE) {
+			err = header_parse();
+			if (err) {
+				return err;
+			}
+			patch.state = STATE_OP;
+		}
+		return used;
+	case STATE_OP:
+		patch.op = data[0];
+		patch.length = 0;
+		patch.shift = 0;
+		patch.state = STATE_LENGTH;
+		return 1;
+	case STATE_LENGTH:
+		err = length_decode(data[0]);
+		if (err > 0) {
+			err = op_execute();
+		}
+		return err ? err : 1;
+	case STATE_LITERAL:
+		used = MIN(len, patch.literal_left);
+		err = target_write(data, used);
+		if (err) {
+			return err;
+		}
+		patch.literal_left -= used;
+		if (patch.literal_left == 0) {
+			patch.state = STATE_OP;
+		}
+		return used;
+	case STATE_ADD:
+		if (data[0] == 0) {
+			/* A run of unchanged bytes, its length follows */
+			patch.length = 0;
+			patch.shift = 0;
+			patch.state = STATE_ADD_RUN;
+			return 1;
+		}
+		return source_add(data, len);
+	case STATE_ADD_RUN:
+		err = length_decode(data[0]);
+		if (err > 0) {
+			err = add_run();
+		}
+		return err ? err : 1;
+	default:
+		return -EINVAL;
+	}
+}
+
+bool dfu_target_delta_identify(const void *const buf)
+{
+	return sys_get_le32(buf) == DELTA_MAGIC;
+}
+
+int dfu_target_delta_init(size_t file_size, dfu_target_callback_t cb)
+{
+	ARG_UNUSED(cb);
+
+	if (file_size < HEADER_SIZE) {
+		LOG_ERR("Patch too small");
+		return -EINVAL;
+	}
+
+	memset(&patch, 0, sizeof(patch));
+
+	return 0;
+}
+
+int dfu_target_delta_offset_get(size_t *offset)
+{
+	*offset = patch.offset;
+	return 0;
+}
+
+int dfu_target_delta_write(const void *const buf, size_t len)
+{
+	const uint8_t *data = buf;
+
+	while (len > 0) {
+		int used = patch_process(data, len);
+
+		if (used < 0) {
+			return used;
+		}
+
+		data += used;
+		len -= used;
+		patch.offset += used;
+	}
+
+	return 0;
+}
+
+int dfu_target_delta_done(bool successful)
+{
+	bool started = patch.state != STATE_HEADER;
+	int err = 0;
+
+	if (successful && (patch.state != STATE_OP ||
+			   patch.produced != patch.target_size)) {
+		LOG_ERR("Patch incomplete, %zu of %u bytes produced",
+			patch.produced, patch.target_size);
+		successful = false;
+		err = -EBADMSG;
+	}
+
+	if (started) {
+		int done_err = dfu_target_mcuboot_done(successful);
+
+		if (err == 0) {
+			err = done_err;
+		}
+	}
+
+	if (source != NULL) {
+		flash_area_close(source);
+		source = NULL;
+	}
+
+	memset(&patch, 0, sizeof(patch));
+
+	return err;
+}
@@ -69,6 +69,11 @@ int dfu_ctx_mcuboot_set_b1_file(const char *file, bool s0_active,
 
 #define MODULE "dfu"
 #define FILE_FLASH_IMG "mcuboot/flash_img"
+
+/* Last stored progress, and when it was stored */
+static size_t stored_bytes;
+static uint32_t stored_time;
+
 /**
  * @brief Store the information stored in the flash_img instance so that it can
  *	  be restored from flash in case of a power failure, reboot etc.
@@ -85,11 +90,47 @@ static int store_flash_img_context(void)
 			LOG_ERR("Problem storing offset (err %d)", err);
 			return err;
 		}
+
+		stored_bytes = bytes_written;
+		stored_time = k_uptime_get_32();
 	}
 
 	return 0;
 }
 
+#ifdef CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS
+/**
+ * @brief Store the progress if enough data has reached flash since it was
+ *	  last stored, see CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS_INTERVAL.
+ *
+ *	  Data buffered by flash_img is not counted, so the progress is only
+ *	  stored when a block has been written to flash.
+ */
+static int checkpoint_flash_img_context(void)
+{
+	size_t progress = flash_img_bytes_written(&flash_img) - stored_bytes;
+
+	if (progress == 0) {
+		return 0;
+	}
+
+	if (progress < CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS_INTERVAL &&
+	    (CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS_PERIOD == 0 ||
+	     k_uptime_get_32() - stored_time <
+	     CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS_PERIOD * MSEC_PER_SEC)) {
+		return 0;
+	}
+
+	return store_flash_img_context();
+}
+#else
+/* The interval and period options only exist with progress saving */
+static inline int checkpoint_flash_img_context(void)
+{
+	return 0;
+}
+#endif /* CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS */
+
 /**
  * @brief Function used by settings_load() to restore the flash_img variable.
  *	  See the Zephyr documentation of the settings subsystem for more
@@ -158,6 +199,9 @@ int dfu_target_mcuboot_init(size_t file_size, dfu_target_callback_t cb)
 			LOG_ERR("Cannot load settings (err %d)", err);
 			return err;
 		}
+
+		stored_bytes = flash_img_bytes_written(&flash_img);
+		stored_time = k_uptime_get_32();
 	}
 
 	return 0;
@@ -178,7 +222,7 @@ int dfu_target_mcuboot_write(const void *const buf, size_t len)
 		return err;
 	}
 
-	err = store_flash_img_context();
+	err = checkpoint_flash_img_context();
 	if (err != 0) {
 		/* Failing to store progress is not a critical error you'll just
 		 * be left to download a bit more if you fail and resume.
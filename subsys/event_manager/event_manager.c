@@ -5,7 +5,9 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <zephyr.h>
+#include <init.h>
 #include <spinlock.h>
 #include <sys/slist.h>
 #include <event_manager.h>
@@ -17,28 +19,117 @@ LOG_MODULE_REGISTER(event_manager, CONFIG_DESKTOP_EVENT_MANAGER_LOG_LEVEL);
 static void event_processor_fn(struct k_work *work);
 
 
+/* Two additional profiler events are used to trace event execution. */
 #if CONFIG_DESKTOP_EVENT_MANAGER_PROFILER_ENABLED
-#define IDS_COUNT CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT
+#define IDS_COUNT (CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT + 2)
 #else
 #define IDS_COUNT 0
 #endif
 
 #ifdef CONFIG_SHELL
-extern uint32_t event_manager_displayed_events;
+extern atomic_t event_manager_displayed_events[];
 #else
-static uint32_t event_manager_displayed_events;
+static ATOMIC_DEFINE(event_manager_displayed_events,
+		     CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT);
 #endif
 
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANES
+#define LANE_COUNT EVENT_LANE_COUNT
+#else
+#define LANE_COUNT 1
+#endif
+
+struct lane_ctx {
+	sys_slist_t eventq;
+	struct k_spinlock lock;
+	struct k_work work;
+	struct k_work_q *work_q;
+	uint32_t seq;
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+	struct event_lane_stats stats;
+#endif
+};
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANES
+struct lane_thread_cfg {
+	const char *name;
+	k_thread_stack_t *stack;
+	size_t stack_size;
+	int priority;
+};
+
+static K_THREAD_STACK_DEFINE(lane_realtime_stack,
+		CONFIG_DESKTOP_EVENT_MANAGER_LANE_REALTIME_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(lane_normal_stack,
+		CONFIG_DESKTOP_EVENT_MANAGER_LANE_NORMAL_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(lane_background_stack,
+		CONFIG_DESKTOP_EVENT_MANAGER_LANE_BACKGROUND_STACK_SIZE);
+
+static const struct lane_thread_cfg lane_thread_cfgs[LANE_COUNT] = {
+	[EVENT_LANE_REALTIME] = {
+		.name = "em_realtime",
+		.stack = lane_realtime_stack,
+		.stack_size = K_THREAD_STACK_SIZEOF(lane_realtime_stack),
+		.priority = CONFIG_DESKTOP_EVENT_MANAGER_LANE_REALTIME_PRIORITY,
+	},
+	[EVENT_LANE_NORMAL] = {
+		.name = "em_normal",
+		.stack = lane_normal_stack,
+		.stack_size = K_THREAD_STACK_SIZEOF(lane_normal_stack),
+		.priority = CONFIG_DESKTOP_EVENT_MANAGER_LANE_NORMAL_PRIORITY,
+	},
+	[EVENT_LANE_BACKGROUND] = {
+		.name = "em_background",
+		.stack = lane_background_stack,
+		.stack_size = K_THREAD_STACK_SIZEOF(lane_background_stack),
+		.priority = CONFIG_DESKTOP_EVENT_MANAGER_LANE_BACKGROUND_PRIORITY,
+	},
+};
+
+static struct k_work_q lane_work_qs[LANE_COUNT];
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_LANES */
+
 static uint16_t profiler_event_ids[IDS_COUNT];
-static K_WORK_DEFINE(event_processor, event_processor_fn);
-static sys_slist_t eventq = SYS_SLIST_STATIC_INIT(&eventq);
-static struct k_spinlock lock;
+static struct lane_ctx lanes[LANE_COUNT];
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+K_MEM_SLAB_DEFINE(event_mem_slab_small,
+		  ROUND_UP(CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_SMALL_SIZE,
+			   sizeof(void *)),
+		  CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_SMALL_CNT,
+		  sizeof(void *));
+K_MEM_SLAB_DEFINE(event_mem_slab_medium,
+		  ROUND_UP(CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_MEDIUM_SIZE,
+			   sizeof(void *)),
+		  CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_MEDIUM_CNT,
+		  sizeof(void *));
+K_MEM_SLAB_DEFINE(event_mem_slab_large,
+		  ROUND_UP(CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_LARGE_SIZE,
+			   sizeof(void *)),
+		  CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_LARGE_CNT,
+		  sizeof(void *));
+
+BUILD_ASSERT((CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_SMALL_SIZE <=
+	      CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_MEDIUM_SIZE) &&
+	     (CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_MEDIUM_SIZE <=
+	      CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_LARGE_SIZE),
+	     "Size-class memory slabs must be sorted by block size");
+
+/* Size-class memory pools sorted by block size. */
+static struct event_mem_pool size_class_pools[] = {
+	{ .slab = &event_mem_slab_small },
+	{ .slab = &event_mem_slab_medium },
+	{ .slab = &event_mem_slab_large },
+};
+
+static struct k_spinlock mem_stats_lock;
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
 
 
 static bool log_is_event_displayed(const struct event_type *et)
 {
-	uint32_t event_mask = BIT(et - __start_event_types);
-	return event_manager_displayed_events & event_mask;
+	return atomic_test_bit(event_manager_displayed_events,
+			       et - __start_event_types);
 }
 
 static void log_event(const struct event_header *eh)
@@ -102,8 +193,8 @@ static void log_event_init(void)
 	     (et != NULL) && (et != __stop_event_types);
 	     et++) {
 		if (et->init_log_enable) {
-			uint32_t event_mask = BIT(et - __start_event_types);
-			event_manager_displayed_events |= event_mask;
+			atomic_set_bit(event_manager_displayed_events,
+				       et - __start_event_types);
 		}
 	}
 }
@@ -217,21 +308,266 @@ static int trace_event_init(void)
 	return 0;
 }
 
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+static void mem_pool_stats_update(struct event_mem_pool *pool)
+{
+	uint32_t used = k_mem_slab_num_used_get(pool->slab);
+
+	k_spinlock_key_t key = k_spin_lock(&mem_stats_lock);
+
+	if (used > pool->stats.max_used) {
+		pool->stats.max_used = used;
+	}
+
+	k_spin_unlock(&mem_stats_lock, key);
+}
+
+static int mem_pool_alloc(struct event_mem_pool *pool, size_t size,
+			  void **mem)
+{
+	struct k_mem_slab *slab = pool->slab;
+
+	if ((slab->num_blocks == 0) || (size > slab->block_size)) {
+		return -EINVAL;
+	}
+
+	if (k_mem_slab_alloc(slab, mem, K_NO_WAIT)) {
+		return -ENOMEM;
+	}
+
+	mem_pool_stats_update(pool);
+
+	return 0;
+}
+
+static bool mem_pool_owns(const struct event_mem_pool *pool, const void *addr)
+{
+	const struct k_mem_slab *slab = pool->slab;
+	const char *start = slab->buffer;
+	const char *end = start + slab->num_blocks * slab->block_size;
+
+	return ((const char *)addr >= start) && ((const char *)addr < end);
+}
+
+void *_event_mem_alloc(const struct event_type *et, size_t size)
+{
+	ASSERT_EVENT_ID(et);
+
+	struct event_mem_pool *exhausted[ARRAY_SIZE(size_class_pools) + 1];
+	size_t exhausted_cnt = 0;
+	void *mem = NULL;
+
+	for (size_t i = 0;
+	     (mem == NULL) && (i <= ARRAY_SIZE(size_class_pools));
+	     i++) {
+		struct event_mem_pool *pool = (i == 0) ? et->mem_pool :
+						&size_class_pools[i - 1];
+
+		if (mem_pool_alloc(pool, size, &mem) == -ENOMEM) {
+			exhausted[exhausted_cnt++] = pool;
+		}
+	}
+
+	/* Pools that were exhausted either fell back to a later pool or
+	 * failed together with all of them.
+	 */
+	for (size_t i = 0; i < exhausted_cnt; i++) {
+		atomic_inc((mem != NULL) ? &exhausted[i]->stats.fallback_cnt :
+					   &exhausted[i]->stats.failed_cnt);
+	}
+
+	return mem;
+}
+
+const struct event_mem_pool *event_manager_mem_pool_get(size_t idx)
+{
+	if (idx >= ARRAY_SIZE(size_class_pools)) {
+		return NULL;
+	}
+
+	return &size_class_pools[idx];
+}
+
+void event_manager_free(void *addr)
+{
+	const struct event_header *eh = addr;
+	struct event_mem_pool *pool = eh->type_id->mem_pool;
+
+	if (!mem_pool_owns(pool, addr)) {
+		pool = NULL;
+
+		for (size_t i = 0; i < ARRAY_SIZE(size_class_pools); i++) {
+			if (mem_pool_owns(&size_class_pools[i], addr)) {
+				pool = &size_class_pools[i];
+				break;
+			}
+		}
+	}
+
+	__ASSERT_NO_MSG(pool != NULL);
+	k_mem_slab_free(pool->slab, &addr);
+}
+
+#else
+void event_manager_free(void *addr)
+{
+	k_free(addr);
+}
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
+
+static struct lane_ctx *lane_get(const struct event_type *et)
+{
+	if (IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES)) {
+		__ASSERT_NO_MSG(et->lane < LANE_COUNT);
+		return &lanes[et->lane];
+	}
+
+	return &lanes[0];
+}
+
+static void lane_stats_submit(struct lane_ctx *lane, struct event_header *eh)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_TIMESTAMP
+	eh->timestamp = k_cycle_get_32();
+#endif
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+	lane->stats.queue_depth++;
+	if (lane->stats.queue_depth > lane->stats.max_queue_depth) {
+		lane->stats.max_queue_depth = lane->stats.queue_depth;
+	}
+#endif
+}
+
+static void lane_stats_process(struct lane_ctx *lane,
+			       const struct event_header *eh)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+	uint32_t latency = k_cycle_get_32() - eh->timestamp;
+
+	k_spinlock_key_t key = k_spin_lock(&lane->lock);
+
+	struct event_lane_stats *stats = &lane->stats;
+
+	__ASSERT_NO_MSG(stats->queue_depth > 0);
+	stats->queue_depth--;
+
+	if ((stats->event_cnt == 0) || (latency < stats->min_latency)) {
+		stats->min_latency = latency;
+	}
+	if (latency > stats->max_latency) {
+		stats->max_latency = latency;
+	}
+	stats->total_latency += latency;
+	stats->event_cnt++;
+
+	k_spin_unlock(&lane->lock, key);
+#endif
+}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+static void histogram_update(struct event_histogram *hist, uint32_t cycles)
+{
+	uint32_t time = k_cyc_to_us_floor32(cycles);
+	size_t bucket = (time > 0) ? (31 - __builtin_clz(time)) : 0;
+
+	bucket = MIN(bucket, ARRAY_SIZE(hist->buckets) - 1);
+
+	k_spinlock_key_t key = k_spin_lock(&hist->lock);
+
+	hist->buckets[bucket]++;
+
+	if ((hist->cnt == 0) || (time < hist->min)) {
+		hist->min = time;
+	}
+	if (time > hist->max) {
+		hist->max = time;
+	}
+	hist->total += time;
+	hist->cnt++;
+
+	k_spin_unlock(&hist->lock, key);
+}
+
+void event_manager_histogram_get(struct event_histogram *hist,
+				 struct event_histogram *copy)
+{
+	k_spinlock_key_t key = k_spin_lock(&hist->lock);
+
+	memcpy(copy->buckets, hist->buckets, sizeof(copy->buckets));
+	copy->cnt = hist->cnt;
+	copy->min = hist->min;
+	copy->max = hist->max;
+	copy->total = hist->total;
+
+	k_spin_unlock(&hist->lock, key);
+}
+
+static void histogram_reset(struct event_histogram *hist)
+{
+	k_spinlock_key_t key = k_spin_lock(&hist->lock);
+
+	memset(hist->buckets, 0, sizeof(hist->buckets));
+	hist->cnt = 0;
+	hist->min = 0;
+	hist->max = 0;
+	hist->total = 0;
+
+	k_spin_unlock(&hist->lock, key);
+}
+
+void event_manager_histograms_reset(void)
+{
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		histogram_reset(et->wait_hist);
+	}
+
+	for (const struct event_listener *el = __start_event_listeners;
+	     el != __stop_event_listeners;
+	     el++) {
+		histogram_reset(el->exec_hist);
+	}
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
+
+static void histogram_wait_update(const struct event_header *eh)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+	histogram_update(eh->type_id->wait_hist,
+			 k_cycle_get_32() - eh->timestamp);
+#endif
+}
+
+static void histogram_exec_update(const struct event_listener *el,
+				  uint32_t start)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+	histogram_update(el->exec_hist, k_cycle_get_32() - start);
+#endif
+}
+
 static void event_processor_fn(struct k_work *work)
 {
+	struct lane_ctx *lane = CONTAINER_OF(work, struct lane_ctx, work);
 	sys_slist_t events = SYS_SLIST_STATIC_INIT(&events);
 
 	/* Make current event list local. */
-	k_spinlock_key_t key = k_spin_lock(&lock);
+	k_spinlock_key_t key = k_spin_lock(&lane->lock);
 
-	if (sys_slist_is_empty(&eventq)) {
-		k_spin_unlock(&lock, key);
+	if (sys_slist_is_empty(&lane->eventq)) {
+		k_spin_unlock(&lane->lock, key);
 		return;
 	}
 
-	sys_slist_merge_slist(&events, &eventq);
+	sys_slist_merge_slist(&events, &lane->eventq);
+
+	/* Events taken for processing can no longer be merged with. */
+	lane->seq++;
 
-	k_spin_unlock(&lock, key);
+	k_spin_unlock(&lane->lock, key);
 
 
 	/* Traverse the list of events. */
@@ -245,6 +581,9 @@ static void event_processor_fn(struct k_work *work)
 
 		const struct event_type *et = eh->type_id;
 
+		lane_stats_process(lane, eh);
+		histogram_wait_update(eh);
+
 		trace_event_execution(eh, true);
 
 		log_event(eh);
@@ -264,11 +603,21 @@ static void event_processor_fn(struct k_work *work)
 				const struct event_listener *el = es->listener;
 
 				__ASSERT_NO_MSG(el != NULL);
-				__ASSERT_NO_MSG(el->notification != NULL);
 
 				log_event_progress(et, el);
 
-				consumed = el->notification(eh);
+				uint32_t start = IS_ENABLED(
+					CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS) ?
+					k_cycle_get_32() : 0;
+
+				if (es->notification) {
+					consumed = es->notification(eh);
+				} else {
+					__ASSERT_NO_MSG(el->notification != NULL);
+					consumed = el->notification(eh);
+				}
+
+				histogram_exec_update(el, start);
 
 				if (consumed) {
 					log_event_consumed(et);
@@ -278,26 +627,223 @@ static void event_processor_fn(struct k_work *work)
 
 		trace_event_execution(eh, false);
 
-		k_free(eh);
+		event_manager_free(eh);
 	}
 }
 
+/* Must be called with the lane lock held. */
+static bool event_merge(struct lane_ctx *lane, struct event_header *eh)
+{
+	const struct event_type *et = eh->type_id;
+	struct event_coalesce *ec = et->coalesce;
+
+	if (!ec) {
+		return false;
+	}
+
+	/* Only merge with the last event in the queue, so that merging does
+	 * not reorder the submitted event with events of other types.
+	 */
+	if (ec->pending && (ec->seq == lane->seq) &&
+	    (sys_slist_peek_tail(&lane->eventq) == &ec->pending->node) &&
+	    et->merge(ec->pending, eh)) {
+		atomic_inc(&ec->merged_cnt);
+		return true;
+	}
+
+	ec->pending = eh;
+	ec->seq = lane->seq;
+
+	return false;
+}
+
 void _event_submit(struct event_header *eh)
 {
 	__ASSERT_NO_MSG(eh);
 	ASSERT_EVENT_ID(eh->type_id);
 
+	struct lane_ctx *lane = lane_get(eh->type_id);
+
+	k_spinlock_key_t key = k_spin_lock(&lane->lock);
+
+	if (event_merge(lane, eh)) {
+		k_spin_unlock(&lane->lock, key);
+		event_manager_free(eh);
+		return;
+	}
+
+	/* Merged events are not traced, as they are never executed. Trace
+	 * before the event is queued, as it can be processed and freed as
+	 * soon as the lock is released.
+	 */
 	trace_event_submission(eh);
 
-	k_spinlock_key_t key = k_spin_lock(&lock);
-	sys_slist_append(&eventq, &eh->node);
-	k_spin_unlock(&lock, key);
+	sys_slist_append(&lane->eventq, &eh->node);
+	lane_stats_submit(lane, eh);
+
+	/* Work queue is not set until the lane thread is started. */
+	struct k_work_q *work_q = lane->work_q;
+
+	k_spin_unlock(&lane->lock, key);
+
+	if (work_q) {
+		k_work_submit_to_queue(work_q, &lane->work);
+	}
+}
+
+int event_manager_lane_stats_get(enum event_lane lane_id,
+				 struct event_lane_stats *stats)
+{
+	if (!IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS) ||
+	    (lane_id >= EVENT_LANE_COUNT) ||
+	    (!IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES) &&
+	     (lane_id != EVENT_LANE_NORMAL))) {
+		return -EINVAL;
+	}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+	struct lane_ctx *lane = IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES) ?
+				&lanes[lane_id] : &lanes[0];
+
+	k_spinlock_key_t key = k_spin_lock(&lane->lock);
+	*stats = lane->stats;
+	k_spin_unlock(&lane->lock, key);
+#endif
+
+	return 0;
+}
+
+void event_manager_lane_stats_reset(void)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+	for (size_t i = 0; i < ARRAY_SIZE(lanes); i++) {
+		struct lane_ctx *lane = &lanes[i];
+		k_spinlock_key_t key = k_spin_lock(&lane->lock);
+		uint32_t queue_depth = lane->stats.queue_depth;
 
-	k_work_submit(&event_processor);
+		memset(&lane->stats, 0, sizeof(lane->stats));
+		lane->stats.queue_depth = queue_depth;
+		lane->stats.max_queue_depth = queue_depth;
+
+		k_spin_unlock(&lane->lock, key);
+	}
+#endif
 }
 
+static void lanes_start(void)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANES
+	for (size_t i = 0; i < ARRAY_SIZE(lanes); i++) {
+		const struct lane_thread_cfg *cfg = &lane_thread_cfgs[i];
+		struct lane_ctx *lane = &lanes[i];
+
+		k_work_q_start(&lane_work_qs[i], cfg->stack, cfg->stack_size,
+			       cfg->priority);
+		k_thread_name_set(&lane_work_qs[i].thread, cfg->name);
+
+		k_spinlock_key_t key = k_spin_lock(&lane->lock);
+
+		lane->work_q = &lane_work_qs[i];
+		bool pending = !sys_slist_is_empty(&lane->eventq);
+
+		k_spin_unlock(&lane->lock, key);
+
+		/* Process events submitted before the thread was started. */
+		if (pending) {
+			k_work_submit_to_queue(lane->work_q, &lane->work);
+		}
+	}
+#endif
+}
+
+/* Handlers of a listener are not serialized. A listener subscribed to event
+ * types from different lanes would be called from several threads at the
+ * same time, so such subscriptions are rejected.
+ */
+static int lanes_subscriptions_check(void)
+{
+	if (!IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES)) {
+		return 0;
+	}
+
+	for (const struct event_listener *el = __start_event_listeners;
+	     el != __stop_event_listeners;
+	     el++) {
+		const struct event_type *first = NULL;
+
+		for (const struct event_type *et = __start_event_types;
+		     (et != NULL) && (et != __stop_event_types);
+		     et++) {
+			for (size_t prio = SUBS_PRIO_MIN;
+			     prio <= SUBS_PRIO_MAX;
+			     prio++) {
+				for (const struct event_subscriber *es =
+						et->subs_start[prio];
+				     es != et->subs_stop[prio];
+				     es++) {
+					if (es->listener != el) {
+						continue;
+					}
+
+					if (!first) {
+						first = et;
+					} else if (first->lane != et->lane) {
+						LOG_ERR("%s subscribes to %s "
+							"and %s in different "
+							"lanes", el->name,
+							first->name, et->name);
+						return -EINVAL;
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int lanes_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	for (size_t i = 0; i < ARRAY_SIZE(lanes); i++) {
+		sys_slist_init(&lanes[i].eventq);
+		k_work_init(&lanes[i].work, event_processor_fn);
+
+		if (!IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES)) {
+			lanes[i].work_q = &k_sys_work_q;
+		}
+	}
+
+	return 0;
+}
+
+SYS_INIT(lanes_init, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
 int event_manager_init(void)
 {
+	static bool initialized;
+	size_t event_cnt = __stop_event_types - __start_event_types;
+	int err;
+
+	if (initialized) {
+		return -EALREADY;
+	}
+
+	if (event_cnt > CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT) {
+		LOG_ERR("Too many event types (%zu), increase "
+			"CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT", event_cnt);
+		return -ENOMEM;
+	}
+
+	err = lanes_subscriptions_check();
+	if (err) {
+		return err;
+	}
+
+	lanes_start();
+	initialized = true;
+
 	log_event_init();
 
 	return trace_event_init();
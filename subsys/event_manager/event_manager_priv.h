@@ -75,6 +75,29 @@ extern "C" {
 	const struct event_subscriber _CONCAT(_CONCAT(__event_subscriber_, ename), lname) __used	\
 	__attribute__((__section__(_EVENT_SUBSCRIBERS_SECTION_NAME(ename, prio)))) = {			\
 		.listener = &_CONCAT(__event_listener_, lname),						\
+		.notification = NULL,									\
+	}
+
+
+/* Convenience macro generating the name of a typed handler trampoline. */
+#define _EVENT_HANDLER_TRAMPOLINE(lname, ename) \
+	_CONCAT(_CONCAT(__event_handler_, ename), lname)
+
+
+/* Subscribe a listener to an event with a handler that takes the event
+ * structure of the given type. The trampoline is generated in the same
+ * translation unit as the handler, so the handler can be inlined into it.
+ */
+#define _EVENT_SUBSCRIBE_HANDLER(lname, ename, prio, handler)						\
+	static bool _EVENT_HANDLER_TRAMPOLINE(lname, ename)(const struct event_header *eh)		\
+	{												\
+		bool (*fn)(const struct ename *event) = handler;					\
+		return fn(CONTAINER_OF(eh, struct ename, header));					\
+	}												\
+	const struct event_subscriber _CONCAT(_CONCAT(__event_subscriber_, ename), lname) __used	\
+	__attribute__((__section__(_EVENT_SUBSCRIBERS_SECTION_NAME(ename, prio)))) = {			\
+		.listener = &_CONCAT(__event_listener_, lname),						\
+		.notification = _EVENT_HANDLER_TRAMPOLINE(lname, ename),				\
 	}
 
 
@@ -82,6 +105,32 @@ extern "C" {
 #define _EVENT_ID(ename) (&_CONCAT(__event_type_, ename))
 
 
+/* Memory used by events is either taken from memory slabs or from the heap. */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+#define _EVENT_MEM_ALLOC(ename, size) _event_mem_alloc(_EVENT_ID(ename), (size))
+
+/* Define a memory slab for events of the given type. Memory slab blocks must
+ * be a multiple of the block alignment.
+ */
+#define _EVENT_MEM_POOL_DEFINE(ename, block_cnt)					\
+	K_MEM_SLAB_DEFINE(_CONCAT(__event_mem_slab_, ename),				\
+			  ROUND_UP(sizeof(struct ename), sizeof(void *)),		\
+			  (block_cnt), sizeof(void *));					\
+	static struct event_mem_pool _CONCAT(__event_mem_pool_, ename) = {		\
+		.slab = &_CONCAT(__event_mem_slab_, ename),				\
+	}
+
+#define _EVENT_MEM_POOL_INIT(ename) \
+	.mem_pool = &_CONCAT(__event_mem_pool_, ename),
+
+#else
+#define _EVENT_MEM_ALLOC(ename, size) k_malloc(size)
+#define _EVENT_MEM_POOL_DEFINE(ename, block_cnt)
+#define _EVENT_MEM_POOL_INIT(ename)
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
+
+
 /* Macro generates a function of name new_ename where ename is provided as
  * an argument. Allocator function is used to create an event of the given
  * ename type.
@@ -89,7 +138,8 @@ extern "C" {
 #define _EVENT_ALLOCATOR_FN(ename)					\
 	static inline struct ename *_CONCAT(new_, ename)(void)		\
 	{								\
-		struct ename *event = k_malloc(sizeof(*event));		\
+		struct ename *event =					\
+			_EVENT_MEM_ALLOC(ename, sizeof(*event));	\
 		BUILD_ASSERT(offsetof(struct ename, header) == 0,	\
 				 "");					\
 		if (unlikely(!event)) {					\
@@ -111,7 +161,8 @@ extern "C" {
 #define _EVENT_ALLOCATOR_DYNDATA_FN(ename)				\
 	static inline struct ename *_CONCAT(new_, ename)(size_t size)	\
 	{								\
-		struct ename *event = k_malloc(sizeof(*event) + size);	\
+		struct ename *event =					\
+			_EVENT_MEM_ALLOC(ename, sizeof(*event) + size);	\
 		BUILD_ASSERT((offsetof(struct ename, dyndata) +	\
 				  sizeof(event->dyndata.size)) ==	\
 				 sizeof(*event), "");			\
@@ -196,11 +247,28 @@ extern "C" {
 			}
 
 
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+/* Define histograms used to collect event handling times. */
+#define _EVENT_HISTOGRAM_DEFINE(name) \
+	static struct event_histogram _CONCAT(__event_histogram_, name)
+
+#define _EVENT_HISTOGRAM_INIT(field, name) \
+	.field = &_CONCAT(__event_histogram_, name),
+
+#else
+#define _EVENT_HISTOGRAM_DEFINE(name)
+#define _EVENT_HISTOGRAM_INIT(field, name)
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
+
+
 #define _EVENT_LISTENER(lname, notification_fn)					\
+	_EVENT_HISTOGRAM_DEFINE(_CONCAT(listener_, lname));			\
 	const struct event_listener _CONCAT(__event_listener_, lname) __used	\
 	__attribute__((__section__("event_listeners"))) = {			\
 		.name = STRINGIFY(lname),					\
 		.notification = (notification_fn),				\
+		_EVENT_HISTOGRAM_INIT(exec_hist, _CONCAT(listener_, lname))	\
 	}
 
 
@@ -221,8 +289,71 @@ extern "C" {
 	_EVENT_ALLOCATOR_DYNDATA_FN(ename)
 
 
-#define _EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)							\
+/* Event type attributes are (key, value) pairs. The attributes given to
+ * EVENT_TYPE_DEFINE are expanded once for every part of the event type
+ * definition that depends on them.
+ */
+#define _EVENT_ATTR_MATCH_LANE_LANE		1
+#define _EVENT_ATTR_MATCH_MEM_SLAB_MEM_SLAB	1
+#define _EVENT_ATTR_MATCH_COALESCE_COALESCE	1
+
+/* Expand code only for an attribute with the wanted key. */
+#define _EVENT_ATTR_IF(want, key, code) \
+	COND_CODE_1(_CONCAT(_CONCAT(_EVENT_ATTR_MATCH, want), key), code, ())
+
+#define _EVENT_ATTR_UNPACK(key, value) key, value
+#define _EVENT_ATTR_APPLY_(fn, ...) fn(__VA_ARGS__)
+#define _EVENT_ATTR_APPLY(fn, ename, attr) \
+	_EVENT_ATTR_APPLY_(fn, ename, _EVENT_ATTR_UNPACK attr)
+
+/* Apply fn(ename, key, value) to every attribute. Every kind of attribute
+ * can be given once, so there are at most three.
+ */
+#define _EVENT_ATTRS_0(fn, ename)
+#define _EVENT_ATTRS_1(fn, ename, attr) _EVENT_ATTR_APPLY(fn, ename, attr)
+#define _EVENT_ATTRS_2(fn, ename, attr, ...) \
+	_EVENT_ATTR_APPLY(fn, ename, attr) _EVENT_ATTRS_1(fn, ename, __VA_ARGS__)
+#define _EVENT_ATTRS_3(fn, ename, attr, ...) \
+	_EVENT_ATTR_APPLY(fn, ename, attr) _EVENT_ATTRS_2(fn, ename, __VA_ARGS__)
+
+#define _EVENT_ATTR_CNT_(_0, _1, _2, _3, cnt, ...) cnt
+#define _EVENT_ATTR_CNT(...) _EVENT_ATTR_CNT_(_, ##__VA_ARGS__, 3, 2, 1, 0)
+
+#define _EVENT_ATTRS(fn, ename, ...) \
+	_CONCAT(_EVENT_ATTRS_, _EVENT_ATTR_CNT(__VA_ARGS__))(fn, ename, ##__VA_ARGS__)
+
+/* Number of attributes with the given key, and their value. */
+#define _EVENT_ATTR_LANE_CNT(ename, key, value) _EVENT_ATTR_IF(_LANE, key, (+ 1))
+#define _EVENT_ATTR_LANE_VAL(ename, key, value) _EVENT_ATTR_IF(_LANE, key, (+ (value)))
+#define _EVENT_ATTR_MEM_SLAB_CNT(ename, key, value) _EVENT_ATTR_IF(_MEM_SLAB, key, (+ 1))
+#define _EVENT_ATTR_MEM_SLAB_VAL(ename, key, value) _EVENT_ATTR_IF(_MEM_SLAB, key, (+ (value)))
+
+/* Value of an attribute, or the default value if it is not given. */
+#define _EVENT_ATTR_GET(attr, ename, default_val, ...)					\
+	(((0 _EVENT_ATTRS(_CONCAT(attr, _CNT), ename, ##__VA_ARGS__)) > 0) ?		\
+	 (0 _EVENT_ATTRS(_CONCAT(attr, _VAL), ename, ##__VA_ARGS__)) : (default_val))
+
+/* Coalescing state of the event type. */
+#define _EVENT_ATTR_COALESCE_DEFINE(ename, key, value)					\
+	_EVENT_ATTR_IF(_COALESCE, key,							\
+		(static struct event_coalesce _CONCAT(__event_coalesce_, ename);))
+
+#define _EVENT_ATTR_COALESCE_INIT(ename, key, value)					\
+	_EVENT_ATTR_IF(_COALESCE, key,							\
+		(.coalesce = &_CONCAT(__event_coalesce_, ename), .merge = (value),))
+
+
+#define _EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct, ...)					\
+	BUILD_ASSERT((0 _EVENT_ATTRS(_EVENT_ATTR_LANE_CNT, ename, ##__VA_ARGS__)) <= 1,				\
+		     "Lane given more than once");								\
+	BUILD_ASSERT((0 _EVENT_ATTRS(_EVENT_ATTR_MEM_SLAB_CNT, ename, ##__VA_ARGS__)) <= 1,			\
+		     "Memory slab size given more than once");							\
+	_EVENT_ATTRS(_EVENT_ATTR_COALESCE_DEFINE, ename, ##__VA_ARGS__)						\
 	_EVENT_SUBSCRIBERS_DEFINE(ename);										\
+	_EVENT_MEM_POOL_DEFINE(ename,											\
+		_EVENT_ATTR_GET(_EVENT_ATTR_MEM_SLAB, ename,							\
+				CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_BLOCK_CNT, ##__VA_ARGS__));			\
+	_EVENT_HISTOGRAM_DEFINE(_CONCAT(type_, ename));									\
 	const struct event_type _CONCAT(__event_type_, ename) __used							\
 	__attribute__((__section__("event_types"))) = {									\
 		.name				= STRINGIFY(ename),							\
@@ -239,6 +370,11 @@ extern "C" {
 		.init_log_enable		= init_log_en,								\
 		.log_event			= log_fn,								\
 		.ev_info			= ev_info_struct,							\
+		.lane				= _EVENT_ATTR_GET(_EVENT_ATTR_LANE, ename,				\
+								  EVENT_LANE_NORMAL, ##__VA_ARGS__),		\
+		_EVENT_ATTRS(_EVENT_ATTR_COALESCE_INIT, ename, ##__VA_ARGS__)						\
+		_EVENT_MEM_POOL_INIT(ename)										\
+		_EVENT_HISTOGRAM_INIT(wait_hist, _CONCAT(type_, ename))						\
 	}
 
 
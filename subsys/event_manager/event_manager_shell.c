@@ -8,7 +8,8 @@
 #include <shell/shell.h>
 #include <event_manager.h>
 
-uint32_t event_manager_displayed_events;
+ATOMIC_DEFINE(event_manager_displayed_events,
+	      CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT);
 
 static int show_events(const struct shell *shell, size_t argc,
 		char **argv)
@@ -23,11 +24,19 @@ static int show_events(const struct shell *shell, size_t argc,
 
 		shell_fprintf(shell,
 			      SHELL_NORMAL,
-			      "%c %d:\t%s\n",
-			      (event_manager_displayed_events & BIT(ev_id)) ?
-				'E' : 'D',
+			      "%c %d:\t%s",
+			      atomic_test_bit(event_manager_displayed_events,
+					      ev_id) ? 'E' : 'D',
 			      ev_id,
 			      et->name);
+
+		if (et->coalesce) {
+			shell_fprintf(shell, SHELL_NORMAL, "\t(merged: %u)",
+				      (uint32_t)atomic_get(
+					      &et->coalesce->merged_cnt));
+		}
+
+		shell_fprintf(shell, SHELL_NORMAL, "\n");
 	}
 
 	return 0;
@@ -89,11 +98,170 @@ static int show_subscribers(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+static void print_mem_pool(const struct shell *shell, const char *name,
+			   const struct event_mem_pool *pool)
+{
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "|\t%s:\tblock size:%zu used:%u/%u max used:%u "
+		      "fallback:%u failed:%u\n",
+		      name, pool->slab->block_size,
+		      k_mem_slab_num_used_get(pool->slab),
+		      pool->slab->num_blocks, pool->stats.max_used,
+		      (uint32_t)atomic_get(&pool->stats.fallback_cnt),
+		      (uint32_t)atomic_get(&pool->stats.failed_cnt));
+}
+
+static int show_mem_pools(const struct shell *shell, size_t argc,
+			  char **argv)
+{
+	static const char * const size_class_names[] = {
+		"small", "medium", "large"
+	};
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event type memory pools:\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		print_mem_pool(shell, et->name, et->mem_pool);
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL, "Size-class memory pools:\n");
+	for (size_t i = 0; i < ARRAY_SIZE(size_class_names); i++) {
+		const struct event_mem_pool *pool =
+			event_manager_mem_pool_get(i);
+
+		__ASSERT_NO_MSG(pool != NULL);
+		print_mem_pool(shell, size_class_names[i], pool);
+	}
+
+	return 0;
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+static int show_lanes(const struct shell *shell, size_t argc, char **argv)
+{
+	static const char * const lane_names[] = {
+		[EVENT_LANE_REALTIME] = "realtime",
+		[EVENT_LANE_NORMAL] = "normal",
+		[EVENT_LANE_BACKGROUND] = "background",
+	};
+
+	BUILD_ASSERT(ARRAY_SIZE(lane_names) == EVENT_LANE_COUNT, "");
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event lanes:\n");
+	for (size_t i = 0; i < EVENT_LANE_COUNT; i++) {
+		struct event_lane_stats stats;
+
+		if (event_manager_lane_stats_get(i, &stats)) {
+			continue;
+		}
+
+		uint32_t avg_latency = (stats.event_cnt > 0) ?
+			(uint32_t)(stats.total_latency / stats.event_cnt) : 0;
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "|\t%s:\tevents:%u queue:%u max queue:%u\n",
+			      lane_names[i], stats.event_cnt,
+			      stats.queue_depth, stats.max_queue_depth);
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "|\t\tlatency [us] min:%u max:%u avg:%u\n",
+			      k_cyc_to_us_floor32(stats.min_latency),
+			      k_cyc_to_us_floor32(stats.max_latency),
+			      k_cyc_to_us_floor32(avg_latency));
+	}
+
+	return 0;
+}
+
+static int reset_lanes(const struct shell *shell, size_t argc, char **argv)
+{
+	event_manager_lane_stats_reset();
+	shell_fprintf(shell, SHELL_NORMAL, "Lane statistics reset\n");
+
+	return 0;
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS */
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+static void print_histogram(const struct shell *shell, const char *name,
+			    struct event_histogram *hist)
+{
+	struct event_histogram h;
+
+	event_manager_histogram_get(hist, &h);
+
+	if (h.cnt == 0) {
+		return;
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "|\t%s:\tcnt:%u min:%u max:%u avg:%u\n",
+		      name, h.cnt, h.min, h.max, (uint32_t)(h.total / h.cnt));
+
+	for (size_t i = 0; i < ARRAY_SIZE(h.buckets); i++) {
+		if (h.buckets[i] == 0) {
+			continue;
+		}
+
+		uint32_t low = (i == 0) ? 0 : BIT(i);
+
+		if (i == ARRAY_SIZE(h.buckets) - 1) {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t\t[%u-...]:\t%u\n",
+				      low, h.buckets[i]);
+		} else {
+			shell_fprintf(shell, SHELL_NORMAL,
+				      "|\t\t[%u-%u]:\t%u\n",
+				      low, BIT(i + 1) - 1, h.buckets[i]);
+		}
+	}
+}
+
+static int show_histograms(const struct shell *shell, size_t argc,
+			   char **argv)
+{
+	shell_fprintf(shell, SHELL_NORMAL, "Event queue wait time [us]:\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		print_histogram(shell, et->name, et->wait_hist);
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "Listener execution time [us]:\n");
+	for (const struct event_listener *el = __start_event_listeners;
+	     el != __stop_event_listeners;
+	     el++) {
+		print_histogram(shell, el->name, el->exec_hist);
+	}
+
+	return 0;
+}
+
+static int reset_histograms(const struct shell *shell, size_t argc,
+			    char **argv)
+{
+	event_manager_histograms_reset();
+	shell_fprintf(shell, SHELL_NORMAL, "Histograms reset\n");
+
+	return 0;
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
+
+static void event_displaying_set(size_t ev_id, bool enable)
+{
+	if (enable) {
+		atomic_set_bit(event_manager_displayed_events, ev_id);
+	} else {
+		atomic_clear_bit(event_manager_displayed_events, ev_id);
+	}
+}
+
 static void set_event_displaying(const struct shell *shell, size_t argc,
 				 char **argv, bool enable)
 {
-	uint32_t evt_mask = 0;
-
 	/* If no IDs specified, all registered events are affected */
 	if (argc == 1) {
 		for (const struct event_type *et = __start_event_types;
@@ -102,7 +270,7 @@ static void set_event_displaying(const struct shell *shell, size_t argc,
 
 			size_t ev_id = et - __start_event_types;
 
-			evt_mask |= BIT(ev_id);
+			event_displaying_set(ev_id, enable);
 		}
 
 		shell_fprintf(shell,
@@ -128,7 +296,7 @@ static void set_event_displaying(const struct shell *shell, size_t argc,
 		}
 
 		for (size_t i = 0; i < ARRAY_SIZE(event_indexes); i++) {
-			evt_mask |= BIT(event_indexes[i]);
+			event_displaying_set(event_indexes[i], enable);
 			const struct event_type *et =
 				__start_event_types + event_indexes[i];
 			const char *event_name = et->name;
@@ -140,11 +308,6 @@ static void set_event_displaying(const struct shell *shell, size_t argc,
 				      enable ? "en":"dis");
 		}
 	}
-	if (enable) {
-		event_manager_displayed_events |= evt_mask;
-	} else {
-		event_manager_displayed_events &= ~evt_mask;
-	}
 }
 
 static int enable_event_displaying(const struct shell *shell, size_t argc,
@@ -168,12 +331,29 @@ SHELL_STATIC_SUBCMD_SET_CREATE(sub_event_manager,
 	SHELL_CMD_ARG(show_subscribers, NULL, "Show subscribers",
 		      show_subscribers, 0, 0),
 	SHELL_CMD_ARG(show_events, NULL, "Show events", show_events, 0, 0),
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+	SHELL_CMD_ARG(show_mem_pools, NULL, "Show memory pool statistics",
+		      show_mem_pools, 0, 0),
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS
+	SHELL_CMD_ARG(show_lanes, NULL, "Show event lane statistics",
+		      show_lanes, 0, 0),
+	SHELL_CMD_ARG(reset_lanes, NULL, "Reset event lane statistics",
+		      reset_lanes, 0, 0),
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_LANE_STATS */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+	SHELL_CMD_ARG(show_histograms, NULL,
+		      "Show event wait and listener execution time histograms",
+		      show_histograms, 0, 0),
+	SHELL_CMD_ARG(reset_histograms, NULL, "Reset histograms",
+		      reset_histograms, 0, 0),
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
 	SHELL_CMD_ARG(disable, NULL, "Disable displaying event with given ID",
 		      disable_event_displaying, 0,
-		      sizeof(event_manager_displayed_events) * 8 - 1),
+		      CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT),
 	SHELL_CMD_ARG(enable, NULL, "Enable displaying event with given ID",
 		      enable_event_displaying, 0,
-		      sizeof(event_manager_displayed_events) * 8 - 1),
+		      CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT),
 	SHELL_SUBCMD_SET_END
 );
 
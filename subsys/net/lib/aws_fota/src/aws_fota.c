@@ -73,6 +73,8 @@ static int get_published_payload(struct mqtt_client *client, uint8_t *write_buf,
 	uint8_t *end = buf + length;
 
 	if (length > sizeof(payload_buf)) {
+		LOG_ERR("Message of %zu bytes does not fit, increase "
+			"CONFIG_AWS_FOTA_PAYLOAD_SIZE", length);
 		return -EMSGSIZE;
 	}
 	while (buf < end) {
@@ -6,54 +6,38 @@
 
 #include <zephyr.h>
 #include <string.h>
-#include <cJSON.h>
+#include <json_tok.h>
 #include <sys/util.h>
 #include <net/aws_jobs.h>
 
 #include "aws_fota_json.h"
 
-/**@brief Copy max maxlen bytes from src to dst. Insert null-terminator.
+/* Documents are tokenized into a static array, they are parsed from the MQTT
+ * event handler only.
  */
-static void strncpy_nullterm(char *dst, const char *src, size_t maxlen)
-{
-	size_t len = strlen(src) + 1;
-
-	memcpy(dst, src, MIN(len, maxlen));
-	if (len > maxlen) {
-		dst[maxlen - 1] = '\0';
-	}
-}
+static struct json_tok toks[CONFIG_AWS_FOTA_JSON_TOKENS];
 
 int aws_fota_parse_UpdateJobExecution_rsp(const char *update_rsp_document,
 					  size_t payload_len, char *status_buf)
 {
+	struct json_tok_doc doc;
+	int tok;
+
 	if (update_rsp_document == NULL || status_buf == NULL) {
 		return -EINVAL;
 	}
 
-	int ret;
-
-	cJSON *update_response = cJSON_Parse(update_rsp_document);
-
-	if (update_response == NULL) {
-		ret = -ENODATA;
-		goto cleanup;
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
+	if (json_tok_parse(&doc, update_rsp_document, payload_len)) {
+		return -ENODATA;
 	}
 
-	cJSON *status = cJSON_GetObjectItemCaseSensitive(update_response,
-							  "status");
-	if (cJSON_IsString(status) && status->valuestring != NULL) {
-		strncpy_nullterm(status_buf, status->valuestring,
-				 STATUS_MAX_LEN);
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+	tok = json_tok_find(&doc, 0, "status");
+	if (json_tok_str_copy(&doc, tok, status_buf, STATUS_MAX_LEN) < 0) {
+		return -ENODATA;
 	}
 
-	ret = 0;
-cleanup:
-	cJSON_Delete(update_response);
-	return ret;
+	return 0;
 }
 
 int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
@@ -63,6 +47,11 @@ int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
 					   char *file_path_buf,
 					   int *execution_version_number)
 {
+	struct json_tok_doc doc;
+	int execution;
+	int location;
+	int err;
+
 	if (job_document == NULL
 	    || job_id_buf == NULL
 	    || hostname_buf == NULL
@@ -71,74 +60,47 @@ int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
 		return -EINVAL;
 	}
 
-	int ret;
-
-	cJSON *json_data = cJSON_Parse(job_document);
-
-	if (json_data == NULL) {
-		ret = -ENODATA;
-		goto cleanup;
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
+	if (json_tok_parse(&doc, job_document, payload_len)) {
+		return -ENODATA;
 	}
 
-	cJSON *execution = cJSON_GetObjectItemCaseSensitive(json_data,
-							    "execution");
-	if (execution == NULL) {
-		ret = 0;
-		goto cleanup;
+	execution = json_tok_find(&doc, 0, "execution");
+	if (execution < 0) {
+		return 0;
 	}
 
-	cJSON *job_id = cJSON_GetObjectItemCaseSensitive(execution, "jobId");
-
-	if (cJSON_GetStringValue(job_id) != NULL) {
-		strncpy_nullterm(job_id_buf, job_id->valuestring,
-				AWS_JOBS_JOB_ID_MAX_LEN);
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+	err = json_tok_str_copy(&doc, json_tok_find(&doc, execution, "jobId"),
+				job_id_buf, AWS_JOBS_JOB_ID_MAX_LEN);
+	if (err < 0) {
+		return -ENODATA;
 	}
 
-	cJSON *job_data = cJSON_GetObjectItemCaseSensitive(execution,
-							   "jobDocument");
-
-	if (!cJSON_IsObject(job_data)) {
-		ret = -ENODATA;
-		goto cleanup;
+	location = json_tok_find(&doc, execution, "jobDocument.location");
+	if (location < 0 ||
+	    json_tok_type_get(&doc, location) != JSON_TOK_OBJECT) {
+		return -ENODATA;
 	}
 
-	cJSON *location = cJSON_GetObjectItemCaseSensitive(job_data,
-							    "location");
-
-	if (!cJSON_IsObject(location)) {
-		ret = -ENODATA;
-		goto cleanup;
+	err = json_tok_str_copy(&doc, json_tok_find(&doc, location, "host"),
+				hostname_buf, CONFIG_AWS_FOTA_HOSTNAME_MAX_LEN);
+	if (err < 0) {
+		return -ENODATA;
 	}
 
-	cJSON *hostname = cJSON_GetObjectItemCaseSensitive(location, "host");
-	cJSON *path = cJSON_GetObjectItemCaseSensitive(location, "path");
-
-	if ((cJSON_GetStringValue(hostname) != NULL)
-	   && (cJSON_GetStringValue(path) != NULL)) {
-		strncpy_nullterm(hostname_buf, hostname->valuestring,
-				CONFIG_AWS_FOTA_HOSTNAME_MAX_LEN);
-		strncpy_nullterm(file_path_buf, path->valuestring,
+	err = json_tok_str_copy(&doc, json_tok_find(&doc, location, "path"),
+				file_path_buf,
 				CONFIG_AWS_FOTA_FILE_PATH_MAX_LEN);
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+	if (err < 0) {
+		return -ENODATA;
 	}
 
-	cJSON *version_number = cJSON_GetObjectItemCaseSensitive(
-					execution, "versionNumber");
-
-	if (cJSON_IsNumber(version_number)) {
-		*execution_version_number = version_number->valueint;
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+	err = json_tok_int_get(&doc,
+			       json_tok_find(&doc, execution, "versionNumber"),
+			       execution_version_number);
+	if (err) {
+		return -ENODATA;
 	}
 
-	ret = 1;
-cleanup:
-	cJSON_Delete(json_data);
-	return ret;
+	return 1;
 }
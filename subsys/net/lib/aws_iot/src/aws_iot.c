@@ -14,6 +14,11 @@
 #endif
 
 #include <logging/log.h>
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+#include <modem/nrf91_sockets.h>
+#endif
+
+#include "topic_trie.h"
 
 LOG_MODULE_REGISTER(aws_iot, CONFIG_AWS_IOT_LOG_LEVEL);
 
@@ -32,61 +37,111 @@ BUILD_ASSERT(sizeof(CONFIG_AWS_IOT_BROKER_HOST_NAME) > 1,
 #define AWS_CLIENT_ID_PREFIX "%s"
 #define AWS_CLIENT_ID_LEN_MAX CONFIG_AWS_IOT_CLIENT_ID_MAX_LEN
 
-#define GET_TOPIC AWS_TOPIC "%s/shadow/get"
-#define GET_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 11)
-
-#define UPDATE_TOPIC AWS_TOPIC "%s/shadow/update"
-#define UPDATE_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 14)
+#define SHADOW_TOPIC AWS_TOPIC "%s/shadow/%s"
+/* Longest shadow topic, $aws/things/<thing-name>/shadow/update/accepted */
+#define SHADOW_TOPIC_LEN_MAX (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 23)
 
-#define DELETE_TOPIC AWS_TOPIC "%s/shadow/delete"
-#define DELETE_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 14)
+#define JOBS_TOPIC AWS_TOPIC "%s/jobs/#"
+#define JOBS_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 7)
 
 static char client_id_buf[AWS_CLIENT_ID_LEN_MAX + 1];
-static char get_topic[GET_TOPIC_LEN + 1];
-static char update_topic[UPDATE_TOPIC_LEN + 1];
-static char delete_topic[DELETE_TOPIC_LEN + 1];
 
+/** @brief Shadow topic, populated once the client ID is known. */
+struct shadow_topic {
+	/** Topic after $aws/things/<thing-name>/shadow/ */
+	const char *suffix;
+	/** Shadow the topic belongs to, reported for received messages. */
+	enum aws_iot_topic_type type;
+	/** Subscribe to the topic when connecting. */
+	bool subscribe;
+	size_t len;
+	char str[SHADOW_TOPIC_LEN_MAX + 1];
+};
+
+/* Topics that are published to, indexed by the type in aws_iot_send() */
+#define SHADOW_GET 0
+#define SHADOW_UPDATE 1
+#define SHADOW_DELETE 2
+
+static struct shadow_topic shadow_topics[] = {
+	[SHADOW_GET] = {
+		.suffix = "get",
+		.type = AWS_IOT_SHADOW_TOPIC_GET
+	},
+	[SHADOW_UPDATE] = {
+		.suffix = "update",
+		.type = AWS_IOT_SHADOW_TOPIC_UPDATE
+	},
+	[SHADOW_DELETE] = {
+		.suffix = "delete",
+		.type = AWS_IOT_SHADOW_TOPIC_DELETE
+	},
+#if defined(CONFIG_AWS_IOT_TOPIC_GET_ACCEPTED_SUBSCRIBE)
+	{
+		.suffix = "get/accepted",
+		.type = AWS_IOT_SHADOW_TOPIC_GET,
+		.subscribe = true
+	},
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_GET_REJECTED_SUBSCRIBE)
+	{
+		.suffix = "get/rejected",
+		.type = AWS_IOT_SHADOW_TOPIC_GET,
+		.subscribe = true
+	},
+#endif
 #if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_ACCEPTED_SUBSCRIBE)
-#define UPDATE_ACCEPTED_TOPIC AWS_TOPIC "%s/shadow/update/accepted"
-#define UPDATE_ACCEPTED_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 23)
-static char update_accepted_topic[UPDATE_ACCEPTED_TOPIC_LEN + 1];
+	{
+		.suffix = "update/accepted",
+		.type = AWS_IOT_SHADOW_TOPIC_UPDATE,
+		.subscribe = true
+	},
 #endif
-
 #if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_REJECTED_SUBSCRIBE)
-#define UPDATE_REJECTED_TOPIC AWS_TOPIC "%s/shadow/update/rejected"
-#define UPDATE_REJECTED_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 23)
-static char update_rejected_topic[UPDATE_REJECTED_TOPIC_LEN + 1];
+	{
+		.suffix = "update/rejected",
+		.type = AWS_IOT_SHADOW_TOPIC_UPDATE,
+		.subscribe = true
+	},
 #endif
-
 #if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_DELTA_SUBSCRIBE)
-#define UPDATE_DELTA_TOPIC AWS_TOPIC "%s/shadow/update/delta"
-#define UPDATE_DELTA_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 20)
-static char update_delta_topic[UPDATE_DELTA_TOPIC_LEN + 1];
+	{
+		.suffix = "update/delta",
+		.type = AWS_IOT_SHADOW_TOPIC_UPDATE,
+		.subscribe = true
+	},
 #endif
-
-#if defined(CONFIG_AWS_IOT_TOPIC_GET_ACCEPTED_SUBSCRIBE)
-#define GET_ACCEPTED_TOPIC AWS_TOPIC "%s/shadow/get/accepted"
-#define GET_ACCEPTED_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 20)
-static char get_accepted_topic[GET_ACCEPTED_TOPIC_LEN + 1];
+#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_ACCEPTED_SUBSCRIBE)
+	{
+		.suffix = "delete/accepted",
+		.type = AWS_IOT_SHADOW_TOPIC_DELETE,
+		.subscribe = true
+	},
 #endif
-
-#if defined(CONFIG_AWS_IOT_TOPIC_GET_REJECTED_SUBSCRIBE)
-#define GET_REJECTED_TOPIC AWS_TOPIC "%s/shadow/get/rejected"
-#define GET_REJECTED_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 20)
-static char get_rejected_topic[GET_REJECTED_TOPIC_LEN + 1];
+#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_REJECTED_SUBSCRIBE)
+	{
+		.suffix = "delete/rejected",
+		.type = AWS_IOT_SHADOW_TOPIC_DELETE,
+		.subscribe = true
+	},
 #endif
+};
 
-#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_ACCEPTED_SUBSCRIBE)
-#define DELETE_ACCEPTED_TOPIC AWS_TOPIC "%s/shadow/delete/accepted"
-#define DELETE_ACCEPTED_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 23)
-static char delete_accepted_topic[DELETE_ACCEPTED_TOPIC_LEN + 1];
+#if defined(CONFIG_AWS_FOTA)
+/* All AWS IoT Jobs topics, handled by the FOTA library */
+static char jobs_topic[JOBS_TOPIC_LEN + 1];
+static size_t jobs_topic_len;
 #endif
 
-#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_REJECTED_SUBSCRIBE)
-#define DELETE_REJECTED_TOPIC AWS_TOPIC "%s/shadow/delete/rejected"
-#define DELETE_REJECTED_TOPIC_LEN (AWS_TOPIC_LEN + AWS_CLIENT_ID_LEN_MAX + 23)
-static char delete_rejected_topic[DELETE_REJECTED_TOPIC_LEN + 1];
-#endif
+/* Handlers of received messages, shadow topics are routed to
+ * ROUTE_SHADOW + their index in shadow_topics.
+ */
+#define ROUTE_APP 0
+#define ROUTE_FOTA 1
+#define ROUTE_SHADOW 2
+
+static struct topic_trie_node topic_nodes[CONFIG_AWS_IOT_TOPIC_TRIE_NODE_COUNT];
+static struct topic_trie topic_routes;
 
 #if defined(CONFIG_CLOUD_API)
 static struct cloud_backend *aws_iot_backend;
@@ -237,6 +292,20 @@ static void aws_iot_notify_event(const struct aws_iot_evt *aws_iot_evt)
 		cloud_evt.data.msg.endpoint.len =
 				aws_iot_evt->data.msg.topic.len;
 		break;
+	case AWS_IOT_EVT_DATA_RECEIVED_CHUNK:
+		cloud_evt.type = CLOUD_EVT_DATA_RECEIVED_CHUNK;
+		cloud_evt.data.chunk.msg.buf = aws_iot_evt->data.chunk.msg.ptr;
+		cloud_evt.data.chunk.msg.len = aws_iot_evt->data.chunk.msg.len;
+		cloud_evt.data.chunk.msg.endpoint.type = CLOUD_EP_TOPIC_MSG;
+		cloud_evt.data.chunk.msg.endpoint.str =
+				(char *)aws_iot_evt->data.chunk.msg.topic.str;
+		cloud_evt.data.chunk.msg.endpoint.len =
+				aws_iot_evt->data.chunk.msg.topic.len;
+		cloud_evt.data.chunk.offset = aws_iot_evt->data.chunk.offset;
+		cloud_evt.data.chunk.total_len =
+				aws_iot_evt->data.chunk.total_len;
+		cloud_evt.data.chunk.err = aws_iot_evt->data.chunk.err;
+		break;
 	case AWS_IOT_EVT_FOTA_START:
 		cloud_evt.type = CLOUD_EVT_FOTA_START;
 		break;
@@ -333,144 +402,95 @@ static int aws_iot_topics_populate(char *const id, size_t id_len)
 		return -ENOMEM;
 	}
 #endif
-	err = snprintf(get_topic, sizeof(get_topic),
-		       GET_TOPIC, client_id_buf);
-	if (err >= GET_TOPIC_LEN) {
-		return -ENOMEM;
-	}
+	for (size_t i = 0; i < ARRAY_SIZE(shadow_topics); i++) {
+		struct shadow_topic *topic = &shadow_topics[i];
 
-	err = snprintf(update_topic, sizeof(update_topic),
-		       UPDATE_TOPIC, client_id_buf);
-	if (err >= UPDATE_TOPIC_LEN) {
-		return -ENOMEM;
-	}
+		err = snprintf(topic->str, sizeof(topic->str), SHADOW_TOPIC,
+			       client_id_buf, topic->suffix);
+		if (err >= sizeof(topic->str)) {
+			return -ENOMEM;
+		}
 
-	err = snprintf(delete_topic, sizeof(delete_topic),
-		       DELETE_TOPIC, client_id_buf);
-	if (err >= DELETE_TOPIC_LEN) {
-		return -ENOMEM;
+		topic->len = err;
 	}
 
-#if defined(CONFIG_AWS_IOT_TOPIC_GET_ACCEPTED_SUBSCRIBE)
-	err = snprintf(get_accepted_topic, sizeof(get_accepted_topic),
-		       GET_ACCEPTED_TOPIC, client_id_buf);
-	if (err >= GET_ACCEPTED_TOPIC_LEN) {
-		return -ENOMEM;
-	}
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_GET_REJECTED_SUBSCRIBE)
-	err = snprintf(get_rejected_topic, sizeof(get_rejected_topic),
-		       GET_REJECTED_TOPIC, client_id_buf);
-	if (err >= GET_REJECTED_TOPIC_LEN) {
-		return -ENOMEM;
-	}
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_ACCEPTED_SUBSCRIBE)
-	err = snprintf(update_accepted_topic, sizeof(update_accepted_topic),
-		       UPDATE_ACCEPTED_TOPIC, client_id_buf);
-	if (err >= UPDATE_ACCEPTED_TOPIC_LEN) {
-		return -ENOMEM;
-	}
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_REJECTED_SUBSCRIBE)
-	err = snprintf(update_rejected_topic, sizeof(update_rejected_topic),
-		       UPDATE_REJECTED_TOPIC, client_id_buf);
-	if (err >= UPDATE_REJECTED_TOPIC_LEN) {
+#if defined(CONFIG_AWS_FOTA)
+	err = snprintf(jobs_topic, sizeof(jobs_topic), JOBS_TOPIC,
+		       client_id_buf);
+	if (err >= sizeof(jobs_topic)) {
 		return -ENOMEM;
 	}
+
+	jobs_topic_len = err;
 #endif
-#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_DELTA_SUBSCRIBE)
-	err = snprintf(update_delta_topic, sizeof(update_delta_topic),
-		       UPDATE_DELTA_TOPIC, client_id_buf);
-	if (err >= UPDATE_DELTA_TOPIC_LEN) {
-		return -ENOMEM;
+	return 0;
+}
+
+/**
+ * @brief Build the table used to route received messages to their handler.
+ *	  Built when connecting, as application topics can be added after
+ *	  the library is initialized.
+ */
+static int topic_routes_build(void)
+{
+	int err;
+
+	topic_trie_init(&topic_routes, topic_nodes, ARRAY_SIZE(topic_nodes));
+
+#if defined(CONFIG_AWS_FOTA)
+	err = topic_trie_add(&topic_routes, jobs_topic, jobs_topic_len,
+			     ROUTE_FOTA);
+	if (err) {
+		return err;
 	}
 #endif
-#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_ACCEPTED_SUBSCRIBE)
-	err = snprintf(delete_accepted_topic, sizeof(delete_accepted_topic),
-		       DELETE_ACCEPTED_TOPIC, client_id_buf);
-	if (err >= DELETE_ACCEPTED_TOPIC_LEN) {
-		return -ENOMEM;
+
+	for (size_t i = 0; i < ARRAY_SIZE(shadow_topics); i++) {
+		if (!shadow_topics[i].subscribe) {
+			continue;
+		}
+
+		err = topic_trie_add(&topic_routes, shadow_topics[i].str,
+				     shadow_topics[i].len, ROUTE_SHADOW + i);
+		if (err) {
+			return err;
+		}
 	}
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_REJECTED_SUBSCRIBE)
-	err = snprintf(delete_rejected_topic, sizeof(delete_rejected_topic),
-		       DELETE_REJECTED_TOPIC, client_id_buf);
-	if (err >= DELETE_REJECTED_TOPIC_LEN) {
-		return -ENOMEM;
+
+	for (size_t i = 0; i < app_topic_data.list_count; i++) {
+		err = topic_trie_add(&topic_routes,
+				     app_topic_data.list[i].topic.utf8,
+				     app_topic_data.list[i].topic.size,
+				     ROUTE_APP);
+		if (err == -EEXIST) {
+			LOG_WRN("Application topic overlaps a library topic");
+		} else if (err) {
+			return err;
+		}
 	}
-#endif
+
 	return 0;
 }
 
 static int topic_subscribe(void)
 {
-	int err;
-	const struct mqtt_topic aws_iot_rx_list[] = {
-#if defined(CONFIG_AWS_IOT_TOPIC_GET_ACCEPTED_SUBSCRIBE)
-		{
-			.topic = {
-				.utf8 = get_accepted_topic,
-				.size = strlen(get_accepted_topic)
-			},
-			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_GET_REJECTED_SUBSCRIBE)
-		{
-			.topic = {
-				.utf8 = get_rejected_topic,
-				.size = strlen(get_rejected_topic)
-			},
-			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_ACCEPTED_SUBSCRIBE)
-		{
-			.topic = {
-				.utf8 = update_accepted_topic,
-				.size = strlen(update_accepted_topic)
-			},
-			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_REJECTED_SUBSCRIBE)
-		{
-			.topic = {
-				.utf8 = update_rejected_topic,
-				.size = strlen(update_rejected_topic)
-			},
-			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_DELTA_SUBSCRIBE)
-		{
-			.topic = {
-				.utf8 = update_delta_topic,
-				.size = strlen(update_delta_topic)
-			},
-			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_ACCEPTED_SUBSCRIBE)
-		{
-			.topic = {
-				.utf8 = delete_accepted_topic,
-				.size = strlen(delete_accepted_topic)
-			},
-			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_REJECTED_SUBSCRIBE)
-		{
+	int err = 0;
+	struct mqtt_topic aws_iot_rx_list[ARRAY_SIZE(shadow_topics)];
+	size_t rx_list_count = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(shadow_topics); i++) {
+		if (!shadow_topics[i].subscribe) {
+			continue;
+		}
+
+		aws_iot_rx_list[rx_list_count++] = (struct mqtt_topic) {
 			.topic = {
-				.utf8 = delete_rejected_topic,
-				.size = strlen(delete_rejected_topic)
+				.utf8 = shadow_topics[i].str,
+				.size = shadow_topics[i].len
 			},
 			.qos = MQTT_QOS_1_AT_LEAST_ONCE
-		},
-#endif
-	};
+		};
+	}
 
 	if (app_topic_data.list_count > 0) {
 		const struct mqtt_subscription_list app_sub_list = {
@@ -490,10 +510,10 @@ static int topic_subscribe(void)
 		}
 	}
 
-	if (ARRAY_SIZE(aws_iot_rx_list) > 0) {
+	if (rx_list_count > 0) {
 		const struct mqtt_subscription_list aws_sub_list = {
-			.list = (struct mqtt_topic *)&aws_iot_rx_list,
-			.list_count = ARRAY_SIZE(aws_iot_rx_list),
+			.list = aws_iot_rx_list,
+			.list_count = rx_list_count,
 			.message_id = sys_rand32_get()
 		};
 
@@ -521,17 +541,65 @@ static int publish_get_payload(struct mqtt_client *const c, size_t length)
 	return mqtt_readall_publish_payload(c, payload_buf, length);
 }
 
-static void mqtt_evt_handler(struct mqtt_client *const c,
-			     const struct mqtt_evt *mqtt_evt)
+/**
+ * @brief Read a message larger than the payload buffer from the socket, and
+ *	  pass it to the application one buffer at a time.
+ */
+static int publish_stream_payload(struct mqtt_client *const c,
+				  const struct aws_iot_data *msg, size_t length)
 {
+	struct aws_iot_evt aws_iot_evt = {
+		.type = AWS_IOT_EVT_DATA_RECEIVED_CHUNK,
+		.data.chunk = {
+			.msg = *msg,
+			.total_len = length
+		}
+	};
+	size_t offset = 0;
 	int err;
-	struct aws_iot_evt aws_iot_evt = { 0 };
+
+	aws_iot_evt.data.chunk.msg.ptr = payload_buf;
+
+	while (offset < length) {
+		size_t chunk_len = MIN(length - offset, sizeof(payload_buf));
+
+		err = mqtt_readall_publish_payload(c, payload_buf, chunk_len);
+		if (err) {
+			/* Let the application drop the chunks already
+			 * received.
+			 */
+			aws_iot_evt.data.chunk.msg.len = 0;
+			aws_iot_evt.data.chunk.offset = offset;
+			aws_iot_evt.data.chunk.err = err;
+			aws_iot_notify_event(&aws_iot_evt);
+			return err;
+		}
+
+		aws_iot_evt.data.chunk.msg.len = chunk_len;
+		aws_iot_evt.data.chunk.offset = offset;
+		aws_iot_notify_event(&aws_iot_evt);
+
+		offset += chunk_len;
+	}
+
+	return 0;
+}
 
 #if defined(CONFIG_AWS_FOTA)
-	err = aws_fota_mqtt_evt_handler(c, mqtt_evt);
+/**
+ * @brief Pass an MQTT event to the FOTA library.
+ *
+ * @return true if the event was handled by the FOTA library and can be
+ *	   skipped.
+ */
+static bool fota_evt_handle(struct mqtt_client *const c,
+			    const struct mqtt_evt *mqtt_evt)
+{
+	struct aws_iot_evt aws_iot_evt = { 0 };
+	int err = aws_fota_mqtt_evt_handler(c, mqtt_evt);
+
 	if (err == 0) {
-		/* Event handled by FOTA library so it can be skipped. */
-		return;
+		return true;
 	} else if (err < 0) {
 		LOG_ERR("aws_fota_mqtt_evt_handler, error: %d", err);
 		LOG_DBG("Disconnecting MQTT client...");
@@ -545,6 +613,25 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 			aws_iot_notify_event(&aws_iot_evt);
 		}
 	}
+
+	return false;
+}
+#endif
+
+static void mqtt_evt_handler(struct mqtt_client *const c,
+			     const struct mqtt_evt *mqtt_evt)
+{
+	int err;
+	struct aws_iot_evt aws_iot_evt = { 0 };
+
+#if defined(CONFIG_AWS_FOTA)
+	/* Received messages are only passed to the FOTA library if they are
+	 * on an AWS IoT Jobs topic, see MQTT_EVT_PUBLISH.
+	 */
+	if (mqtt_evt->type != MQTT_EVT_PUBLISH &&
+	    fota_evt_handle(c, mqtt_evt)) {
+		return;
+	}
 #endif
 
 	switch (mqtt_evt->type) {
@@ -579,12 +666,42 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 		break;
 	case MQTT_EVT_PUBLISH: {
 		const struct mqtt_publish_param *p = &mqtt_evt->param.publish;
+		int route = topic_trie_match(&topic_routes,
+					     p->message.topic.topic.utf8,
+					     p->message.topic.topic.size);
+		bool stream = IS_ENABLED(CONFIG_AWS_IOT_MQTT_PAYLOAD_STREAM) &&
+			      (p->message.payload.len > sizeof(payload_buf));
+		struct aws_iot_data msg = {
+			.topic = {
+				.type = (route >= ROUTE_SHADOW) ?
+					shadow_topics[route - ROUTE_SHADOW].type :
+					AWS_IOT_SHADOW_TOPIC_UNKNOWN,
+				.str = p->message.topic.topic.utf8,
+				.len = p->message.topic.topic.size
+			}
+		};
+
+#if defined(CONFIG_AWS_FOTA)
+		/* Jobs messages are not streamed, as the FOTA library parses
+		 * and keeps the whole job document. It reads them into its
+		 * own buffer of CONFIG_AWS_FOTA_PAYLOAD_SIZE bytes.
+		 */
+		if (route == ROUTE_FOTA && fota_evt_handle(c, mqtt_evt)) {
+			break;
+		}
+#endif
 
 		LOG_DBG("MQTT_EVT_PUBLISH: id = %d len = %d ",
 			p->message_id,
 			p->message.payload.len);
 
-		err = publish_get_payload(c, p->message.payload.len);
+		if (stream) {
+			err = publish_stream_payload(c, &msg,
+						     p->message.payload.len);
+		} else {
+			err = publish_get_payload(c, p->message.payload.len);
+		}
+
 		if (err) {
 			LOG_ERR("publish_get_payload, error: %d", err);
 			break;
@@ -598,12 +715,16 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 			mqtt_publish_qos1_ack(c, &ack);
 		}
 
+		if (stream) {
+			/* Already passed to the application in chunks. */
+			break;
+		}
+
+		msg.ptr = payload_buf;
+		msg.len = p->message.payload.len;
+
 		aws_iot_evt.type = AWS_IOT_EVT_DATA_RECEIVED;
-		aws_iot_evt.data.msg.ptr = payload_buf;
-		aws_iot_evt.data.msg.len = p->message.payload.len;
-		aws_iot_evt.data.msg.topic.type = AWS_IOT_SHADOW_TOPIC_UNKNOWN;
-		aws_iot_evt.data.msg.topic.str = p->message.topic.topic.utf8;
-		aws_iot_evt.data.msg.topic.len = p->message.topic.topic.size;
+		aws_iot_evt.data.msg = msg;
 
 		aws_iot_notify_event(&aws_iot_evt);
 	} break;
@@ -752,6 +873,17 @@ static int broker_init(void)
 }
 #endif /* !defined(CONFIG_AWS_IOT_STATIC_IP) */
 
+/* Resolve the broker again on the next connection, in case the cached
+ * address is no longer reachable.
+ */
+static void broker_invalidate(void)
+{
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE) && \
+	!defined(CONFIG_AWS_IOT_STATIC_IPV4)
+	nrf91_dns_cache_invalidate(CONFIG_AWS_IOT_BROKER_HOST_NAME);
+#endif
+}
+
 static int client_broker_init(struct mqtt_client *const client)
 {
 	int err;
@@ -763,6 +895,12 @@ static int client_broker_init(struct mqtt_client *const client)
 		return err;
 	}
 
+	err = topic_routes_build();
+	if (err) {
+		LOG_ERR("Could not build topic table, error: %d", err);
+		return err;
+	}
+
 	client->broker			= &broker;
 	client->evt_cb			= mqtt_evt_handler;
 	client->client_id.utf8		= (char *)client_id_buf;
@@ -850,29 +988,29 @@ int aws_iot_send(const struct aws_iot_data *const tx_data)
 	switch (tx_data_pub.topic.type) {
 #if defined(CONFIG_CLOUD_API)
 	case CLOUD_EP_TOPIC_STATE:
-		tx_data_pub.topic.str = get_topic;
-		tx_data_pub.topic.len = strlen(get_topic);
+		tx_data_pub.topic.str = shadow_topics[SHADOW_GET].str;
+		tx_data_pub.topic.len = shadow_topics[SHADOW_GET].len;
 		break;
 	case CLOUD_EP_TOPIC_MSG:
-		tx_data_pub.topic.str = update_topic;
-		tx_data_pub.topic.len = strlen(update_topic);
+		tx_data_pub.topic.str = shadow_topics[SHADOW_UPDATE].str;
+		tx_data_pub.topic.len = shadow_topics[SHADOW_UPDATE].len;
 		break;
 	case CLOUD_EP_TOPIC_STATE_DELETE:
-		tx_data_pub.topic.str = delete_topic;
-		tx_data_pub.topic.len = strlen(delete_topic);
+		tx_data_pub.topic.str = shadow_topics[SHADOW_DELETE].str;
+		tx_data_pub.topic.len = shadow_topics[SHADOW_DELETE].len;
 		break;
 #else
 	case AWS_IOT_SHADOW_TOPIC_GET:
-		tx_data_pub.topic.str = get_topic;
-		tx_data_pub.topic.len = strlen(get_topic);
+		tx_data_pub.topic.str = shadow_topics[SHADOW_GET].str;
+		tx_data_pub.topic.len = shadow_topics[SHADOW_GET].len;
 		break;
 	case AWS_IOT_SHADOW_TOPIC_UPDATE:
-		tx_data_pub.topic.str = update_topic;
-		tx_data_pub.topic.len = strlen(update_topic);
+		tx_data_pub.topic.str = shadow_topics[SHADOW_UPDATE].str;
+		tx_data_pub.topic.len = shadow_topics[SHADOW_UPDATE].len;
 		break;
 	case AWS_IOT_SHADOW_TOPIC_DELETE:
-		tx_data_pub.topic.str = delete_topic;
-		tx_data_pub.topic.len = strlen(delete_topic);
+		tx_data_pub.topic.str = shadow_topics[SHADOW_DELETE].str;
+		tx_data_pub.topic.len = shadow_topics[SHADOW_DELETE].len;
 		break;
 #endif
 	default:
@@ -925,6 +1063,7 @@ int aws_iot_connect(struct aws_iot_config *const config)
 		err = mqtt_connect(&client);
 		if (err) {
 			LOG_ERR("mqtt_connect, error: %d", err);
+			broker_invalidate();
 		}
 
 		err = connect_error_translate(err);
@@ -1022,6 +1161,7 @@ start:
 	err = mqtt_connect(&client);
 	if (err) {
 		LOG_ERR("mqtt_connect, error: %d", err);
+		broker_invalidate();
 	}
 
 	err = connect_error_translate(err);
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include "topic_trie.h"
+
+#define NO_NODE -1
+#define ROOT 0
+
+/* FNV-1a */
+static uint32_t level_hash(const char *level, size_t len)
+{
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ (uint8_t)level[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+static size_t level_len_get(const char *topic, size_t len)
+{
+	const char *end = memchr(topic, '/', len);
+
+	return end ? (size_t)(end - topic) : len;
+}
+
+static int node_new(struct topic_trie *trie, const char *level, size_t len,
+		    uint32_t hash)
+{
+	struct topic_trie_node *node;
+
+	if (trie->count == trie->size) {
+		return -ENOMEM;
+	}
+
+	node = &trie->nodes[trie->count];
+	node->level = level;
+	node->level_len = len;
+	node->hash = hash;
+	node->child = NO_NODE;
+	node->sibling = NO_NODE;
+	node->plus = NO_NODE;
+	node->route = TOPIC_TRIE_NO_ROUTE;
+	node->multi_route = TOPIC_TRIE_NO_ROUTE;
+
+	return trie->count++;
+}
+
+static int child_find(const struct topic_trie *trie, int parent,
+		      const char *level, size_t len, uint32_t hash)
+{
+	int child = trie->nodes[parent].child;
+
+	while (child != NO_NODE) {
+		const struct topic_trie_node *node = &trie->nodes[child];
+
+		if (node->hash == hash && node->level_len == len &&
+		    memcmp(node->level, level, len) == 0) {
+			break;
+		}
+
+		child = node->sibling;
+	}
+
+	return child;
+}
+
+static int route_set(int16_t *slot, int route)
+{
+	if (*slot != TOPIC_TRIE_NO_ROUTE && *slot != route) {
+		return -EEXIST;
+	}
+
+	*slot = route;
+	return 0;
+}
+
+void topic_trie_init(struct topic_trie *trie, struct topic_trie_node *nodes,
+		     size_t size)
+{
+	trie->nodes = nodes;
+	trie->size = size;
+	trie->count = 0;
+
+	(void)node_new(trie, NULL, 0, 0);
+}
+
+int topic_trie_add(struct topic_trie *trie, const char *filter, size_t len,
+		   int route)
+{
+	int node = ROOT;
+
+	if (filter == NULL || len == 0 || route < 0 || route > INT16_MAX) {
+		return -EINVAL;
+	}
+
+	while (true) {
+		size_t level_len = level_len_get(filter, len);
+		bool last = (level_len == len);
+		uint32_t hash;
+		int next;
+
+		if (level_len == 1 && filter[0] == '#') {
+			if (!last) {
+				return -EINVAL;
+			}
+
+			return route_set(&trie->nodes[node].multi_route, route);
+		}
+
+		if (level_len == 1 && filter[0] == '+') {
+			next = trie->nodes[node].plus;
+			if (next == NO_NODE) {
+				next = node_new(trie, filter, 1, 0);
+				if (next < 0) {
+					return next;
+				}
+				trie->nodes[node].plus = next;
+			}
+		} else {
+			if (memchr(filter, '+', level_len) ||
+			    memchr(filter, '#', level_len)) {
+				return -EINVAL;
+			}
+
+			hash = level_hash(filter, level_len);
+			next = child_find(trie, node, filter, level_len, hash);
+			if (next == NO_NODE) {
+				next = node_new(trie, filter, level_len, hash);
+				if (next < 0) {
+					return next;
+				}
+				trie->nodes[next].sibling = trie->nodes[node].child;
+				trie->nodes[node].child = next;
+			}
+		}
+
+		node = next;
+
+		if (last) {
+			return route_set(&trie->nodes[node].route, route);
+		}
+
+		filter += level_len + 1;
+		len -= level_len + 1;
+	}
+}
+
+static int node_route(const struct topic_trie *trie, int node)
+{
+	const struct topic_trie_node *n = &trie->nodes[node];
+
+	/* "a/#" also matches "a" */
+	return (n->route != TOPIC_TRIE_NO_ROUTE) ? n->route : n->multi_route;
+}
+
+static int level_match(const struct topic_trie *trie, int node,
+		       const char *topic, size_t len)
+{
+	const struct topic_trie_node *parent = &trie->nodes[node];
+	size_t level_len = level_len_get(topic, len);
+	bool last = (level_len == len);
+	bool wildcards = !(node == ROOT && len > 0 && topic[0] == '$');
+	int route = TOPIC_TRIE_NO_ROUTE;
+	int child;
+
+	child = child_find(trie, node, topic, level_len,
+			   level_hash(topic, level_len));
+	if (child != NO_NODE) {
+		route = last ? node_route(trie, child) :
+			level_match(trie, child, topic + level_len + 1,
+				    len - level_len - 1);
+		if (route != TOPIC_TRIE_NO_ROUTE) {
+			return route;
+		}
+	}
+
+	if (!wildcards) {
+		return TOPIC_TRIE_NO_ROUTE;
+	}
+
+	if (parent->plus != NO_NODE) {
+		route = last ? node_route(trie, parent->plus) :
+			level_match(trie, parent->plus, topic + level_len + 1,
+				    len - level_len - 1);
+		if (route != TOPIC_TRIE_NO_ROUTE) {
+			return route;
+		}
+	}
+
+	return parent->multi_route;
+}
+
+int topic_trie_match(const struct topic_trie *trie, const char *topic,
+		     size_t len)
+{
+	if (topic == NULL || len == 0) {
+		return TOPIC_TRIE_NO_ROUTE;
+	}
+
+	return level_match(trie, ROOT, topic, len);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**@file
+ *@brief Matching of MQTT topics against a set of topic filters.
+ *
+ * Topic filters are stored in a trie with one node per topic level, so a
+ * topic is matched in a single pass over its levels. The '+' and '#'
+ * wildcards are supported. Filters are referenced, not copied, and must be
+ * kept while the trie is in use.
+ */
+
+#ifndef TOPIC_TRIE_H__
+#define TOPIC_TRIE_H__
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Returned by @ref topic_trie_match when no filter matches. */
+#define TOPIC_TRIE_NO_ROUTE -1
+
+struct topic_trie_node {
+	/** Topic level, not NULL terminated. */
+	const char *level;
+	uint32_t hash;
+	uint16_t level_len;
+	/** First child with a literal level, and the next sibling. */
+	int16_t child;
+	int16_t sibling;
+	/** Child for the '+' wildcard. */
+	int16_t plus;
+	/** Route of a filter ending at this node. */
+	int16_t route;
+	/** Route of a filter ending with '#' at this node. */
+	int16_t multi_route;
+};
+
+struct topic_trie {
+	struct topic_trie_node *nodes;
+	uint16_t size;
+	uint16_t count;
+};
+
+/** @brief Initialize an empty trie.
+ *
+ *  @param[out] trie Trie to initialize.
+ *  @param[in] nodes Storage for the trie nodes.
+ *  @param[in] size Number of nodes, one is used for the root.
+ */
+void topic_trie_init(struct topic_trie *trie, struct topic_trie_node *nodes,
+		     size_t size);
+
+/** @brief Add a topic filter.
+ *
+ *  @param[in] trie Trie to add the filter to.
+ *  @param[in] filter Topic filter, with optional '+' and '#' wildcards.
+ *  @param[in] len Length of the filter.
+ *  @param[in] route Non-negative value returned when a topic matches.
+ *
+ *  @retval 0 If successful.
+ *  @retval -EINVAL If the filter is invalid.
+ *  @retval -EEXIST If the filter was added with a different route.
+ *  @retval -ENOMEM If the trie has no free nodes left.
+ */
+int topic_trie_add(struct topic_trie *trie, const char *filter, size_t len,
+		   int route);
+
+/** @brief Find the route of the filter that matches a topic.
+ *
+ *  If several filters match, a literal level takes precedence over '+',
+ *  which takes precedence over '#'. Topics starting with '$' do not match
+ *  filters starting with a wildcard.
+ *
+ *  @param[in] trie Trie to search.
+ *  @param[in] topic Topic, not NULL terminated.
+ *  @param[in] len Length of the topic.
+ *
+ *  @return Route of the matching filter, or TOPIC_TRIE_NO_ROUTE.
+ */
+int topic_trie_match(const struct topic_trie *trie, const char *topic,
+		     size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPIC_TRIE_H__ */
@@ -0,0 +1,701 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <logging/log.h>
+#include <fs/fcb.h>
+#include <storage/flash_map.h>
+#include <pm_config.h>
+#include <net/cloud_queue.h>
+
+LOG_MODULE_REGISTER(cloud_queue, CONFIG_CLOUD_QUEUE_LOG_LEVEL);
+
+#define QUEUE_AREA_ID PM_CLOUD_QUEUE_STORAGE_ID
+#define QUEUE_FCB_MAGIC 0x43515545
+#define QUEUE_FCB_VERSION 2
+#define SECTOR_COUNT_MAX 16
+#define DONE_SEQ_MAX 8
+#define BATCHING (CONFIG_CLOUD_QUEUE_BATCH_MAX_COUNT > 1)
+
+/* Messages are appended to the flash circular buffer as they are queued.
+ * Records cannot be deleted one by one, so the sequence numbers of the
+ * messages that were sent are appended as well, and a sector is erased once
+ * all the messages it holds have been sent. A RAM index of the messages left
+ * to send is rebuilt from the records at boot.
+ *
+ * Each record holds the queue time it was written at, in seconds. The queue
+ * time continues after a reset from the time of the last record, so the time
+ * to live of the restored messages is not restarted.
+ */
+enum record_type {
+	RECORD_MSG = 1,
+	/* Messages that were sent or expired */
+	RECORD_DONE,
+};
+
+struct record_msg {
+	uint8_t type;
+	uint8_t priority;
+	uint8_t qos;
+	uint16_t endpoint;
+	uint32_t seq;
+	uint32_t time;
+	/* Time to live in seconds, or 0 */
+	uint32_t ttl;
+	/* Followed by the message */
+} __packed;
+
+struct record_done {
+	uint8_t type;
+	uint32_t time;
+	uint32_t seq[DONE_SEQ_MAX];
+} __packed;
+
+struct queue_entry {
+	struct fcb_entry loc;
+	/* Queue time at which the message expires, or 0 */
+	uint32_t expiry;
+	uint32_t seq;
+	uint16_t endpoint;
+	uint8_t priority;
+	uint8_t qos;
+};
+
+BUILD_ASSERT(CONFIG_CLOUD_QUEUE_BATCH_BUF_SIZE >=
+	     2 * sizeof(struct record_done),
+	     "CONFIG_CLOUD_QUEUE_BATCH_BUF_SIZE is too small");
+
+static const struct cloud_backend *cloud_backend;
+static struct flash_sector sectors[SECTOR_COUNT_MAX];
+static struct fcb fcb;
+static K_MUTEX_DEFINE(queue_lock);
+/* Held while a flush sends batches, so that each batch is sent once. The
+ * queue lock is released while a batch is sent.
+ */
+static K_MUTEX_DEFINE(send_lock);
+static struct k_delayed_work flush_work;
+static bool send_enabled;
+static uint32_t next_seq;
+/* Queue time at boot, in seconds */
+static int64_t time_base;
+
+/* Queued messages, oldest first */
+static struct queue_entry entries[CONFIG_CLOUD_QUEUE_MAX_MESSAGES];
+static size_t entry_count;
+
+/* Records are composed in record_buf before being written, and batches in
+ * batch_buf before being sent, so that messages can be queued while a batch
+ * is sent.
+ */
+static char record_buf[CONFIG_CLOUD_QUEUE_BATCH_BUF_SIZE];
+static char batch_buf[CONFIG_CLOUD_QUEUE_BATCH_BUF_SIZE];
+
+static uint32_t queue_time(void)
+{
+	return (uint32_t)(time_base + k_uptime_get() / MSEC_PER_SEC);
+}
+
+static size_t record_len_in_flash(size_t len)
+{
+	return ROUND_UP(len, MAX(fcb.f_align, 1));
+}
+
+static void entry_remove(size_t index)
+{
+	entry_count--;
+	memmove(&entries[index], &entries[index + 1],
+		(entry_count - index) * sizeof(entries[0]));
+}
+
+static void entry_remove_seq(uint32_t seq)
+{
+	for (size_t i = 0; i < entry_count; i++) {
+		if (entries[i].seq == seq) {
+			entry_remove(i);
+			return;
+		}
+	}
+}
+
+static bool sector_in_use(const struct flash_sector *sector)
+{
+	for (size_t i = 0; i < entry_count; i++) {
+		if (entries[i].loc.fe_sector == sector) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void oldest_sector_drop(void)
+{
+	size_t dropped = 0;
+
+	for (size_t i = 0; i < entry_count;) {
+		if (entries[i].loc.fe_sector == fcb.f_oldest) {
+			entry_remove(i);
+			dropped++;
+		} else {
+			i++;
+		}
+	}
+
+	if (dropped) {
+		LOG_WRN("Queue full, %zu messages dropped", dropped);
+	}
+
+	(void)fcb_rotate(&fcb);
+}
+
+/* Erase the oldest sectors once all their messages have been sent. The active
+ * sector is kept until it is full to limit flash wear.
+ */
+static void sectors_release(void)
+{
+	while (fcb.f_oldest != fcb.f_active.fe_sector &&
+	       !sector_in_use(fcb.f_oldest)) {
+		int err = fcb_rotate(&fcb);
+
+		if (err) {
+			LOG_ERR("fcb_rotate, error: %d", err);
+			return;
+		}
+	}
+}
+
+/* Append the record of len bytes composed in record_buf. */
+static int record_append(size_t len, struct fcb_entry *loc)
+{
+	int err;
+
+	memset(&record_buf[len], 0xff, record_len_in_flash(len) - len);
+
+	err = fcb_append(&fcb, len, loc);
+	while (err == -ENOSPC && !fcb_is_empty(&fcb)) {
+		oldest_sector_drop();
+		err = fcb_append(&fcb, len, loc);
+	}
+
+	if (err) {
+		LOG_ERR("fcb_append, error: %d", err);
+		return err;
+	}
+
+	err = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)),
+			       record_buf, record_len_in_flash(len));
+	if (err) {
+		LOG_ERR("flash_area_write, error: %d", err);
+		return err;
+	}
+
+	return fcb_append_finish(&fcb, loc);
+}
+
+static void done_write(const uint32_t *seq, size_t count)
+{
+	struct record_done *done = (struct record_done *)record_buf;
+	struct fcb_entry loc;
+
+	while (count > 0) {
+		size_t n = MIN(count, DONE_SEQ_MAX);
+		int err;
+
+		done->type = RECORD_DONE;
+		done->time = queue_time();
+		memcpy(done->seq, seq, n * sizeof(seq[0]));
+
+		err = record_append(offsetof(struct record_done, seq) +
+				    n * sizeof(seq[0]), &loc);
+		if (err) {
+			/* The messages are sent again after a reset */
+			LOG_WRN("Sent messages not recorded, error: %d", err);
+			return;
+		}
+
+		seq += n;
+		count -= n;
+	}
+}
+
+static void entry_set(struct queue_entry *entry, const struct fcb_entry *loc,
+		      const struct record_msg *record)
+{
+	entry->loc = *loc;
+	entry->seq = record->seq;
+	entry->endpoint = record->endpoint;
+	entry->priority = record->priority;
+	entry->qos = record->qos;
+	entry->expiry = record->ttl ? record->time + record->ttl : 0;
+}
+
+static int record_restore(struct fcb_entry_ctx *ctx, void *arg)
+{
+	uint32_t *last_time = arg;
+	union {
+		uint8_t type;
+		struct record_msg msg;
+		struct record_done done;
+	} record;
+	size_t len = MIN(ctx->loc.fe_data_len, sizeof(record));
+	int err;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	err = flash_area_read(ctx->fap, FCB_ENTRY_FA_DATA_OFF(ctx->loc),
+			      &record, len);
+	if (err) {
+		LOG_ERR("flash_area_read, error: %d", err);
+		return err;
+	}
+
+	if (record.type == RECORD_MSG && len >= sizeof(record.msg)) {
+		if (entry_count == ARRAY_SIZE(entries)) {
+			LOG_WRN("Too many stored messages, oldest dropped");
+			entry_remove(0);
+		}
+
+		entry_set(&entries[entry_count++], &ctx->loc, &record.msg);
+		next_seq = MAX(next_seq, record.msg.seq + 1);
+		*last_time = MAX(*last_time, record.msg.time);
+	} else if (record.type == RECORD_DONE &&
+		   len >= offsetof(struct record_done, seq)) {
+		size_t count = (len - offsetof(struct record_done, seq)) /
+			       sizeof(uint32_t);
+
+		for (size_t i = 0; i < count; i++) {
+			uint32_t seq = record.done.seq[i];
+
+			entry_remove_seq(seq);
+			next_seq = MAX(next_seq, seq + 1);
+		}
+
+		*last_time = MAX(*last_time, record.done.time);
+	} else {
+		LOG_WRN("Unknown record type %d", record.type);
+	}
+
+	return 0;
+}
+
+static int records_restore(void)
+{
+	uint32_t last_time = 0;
+	int err;
+
+	entry_count = 0;
+	next_seq = 0;
+
+	err = fcb_walk(&fcb, NULL, record_restore, &last_time);
+
+	/* The time spent in reset is unknown */
+	time_base = (int64_t)last_time - k_uptime_get() / MSEC_PER_SEC;
+
+	return err;
+}
+
+static int entry_read(const struct queue_entry *entry, char *buf,
+		      size_t len)
+{
+	return flash_area_read(fcb.fap,
+			       FCB_ENTRY_FA_DATA_OFF(entry->loc) +
+			       sizeof(struct record_msg),
+			       buf, len);
+}
+
+static size_t entry_len(const struct queue_entry *entry)
+{
+	return entry->loc.fe_data_len - sizeof(struct record_msg);
+}
+
+static void expired_drop(void)
+{
+	uint32_t now = queue_time();
+	uint32_t seq[DONE_SEQ_MAX];
+	size_t count;
+
+	do {
+		count = 0;
+
+		for (size_t i = 0; i < entry_count && count < DONE_SEQ_MAX;) {
+			if (entries[i].expiry && now > entries[i].expiry) {
+				seq[count++] = entries[i].seq;
+				entry_remove(i);
+			} else {
+				i++;
+			}
+		}
+
+		if (count) {
+			LOG_DBG("%zu messages expired", count);
+			done_write(seq, count);
+		}
+	} while (count == DONE_SEQ_MAX);
+}
+
+/* Index of the oldest message with the highest priority. */
+static size_t first_get(void)
+{
+	size_t first = 0;
+
+	for (size_t i = 1; i < entry_count; i++) {
+		if (entries[i].priority > entries[first].priority) {
+			first = i;
+		}
+	}
+
+	return first;
+}
+
+/* Compose the next message in batch_buf, batched with the following messages
+ * that have the same endpoint and QoS.
+ *
+ * @return Number of messages in the batch, or a negative error code.
+ */
+static int batch_compose(struct cloud_msg *msg, uint32_t *seq)
+{
+	const struct queue_entry *first = &entries[first_get()];
+	size_t count = 0;
+	size_t len = 0;
+	int err;
+
+	if (BATCHING) {
+		batch_buf[len++] = '[';
+	}
+
+	for (int prio = CLOUD_QUEUE_PRIORITY_COUNT - 1;
+	     prio >= 0 && count < CONFIG_CLOUD_QUEUE_BATCH_MAX_COUNT; prio--) {
+		for (size_t i = 0;
+		     i < entry_count && count < CONFIG_CLOUD_QUEUE_BATCH_MAX_COUNT;
+		     i++) {
+			const struct queue_entry *entry = &entries[i];
+			/* Separator and closing bracket */
+			size_t extra = BATCHING ? (count ? 2 : 1) : 0;
+
+			if (entry->priority != prio ||
+			    entry->endpoint != first->endpoint ||
+			    entry->qos != first->qos ||
+			    len + entry_len(entry) + extra > sizeof(batch_buf)) {
+				continue;
+			}
+
+			if (BATCHING && count) {
+				batch_buf[len++] = ',';
+			}
+
+			err = entry_read(entry, &batch_buf[len],
+					 entry_len(entry));
+			if (err) {
+				LOG_ERR("flash_area_read, error: %d", err);
+				return err;
+			}
+
+			len += entry_len(entry);
+			seq[count++] = entry->seq;
+		}
+	}
+
+	if (BATCHING) {
+		batch_buf[len++] = ']';
+	}
+
+	msg->buf = batch_buf;
+	msg->len = len;
+	msg->qos = first->qos;
+	msg->endpoint.type = first->endpoint;
+
+	return count;
+}
+
+/* Send the next batch. The queue lock is not held while the batch is sent,
+ * so that messages can be queued meanwhile.
+ *
+ * @return Number of messages sent, 0 if the queue is empty, or a negative
+ *	   error code.
+ */
+static int batch_send(void)
+{
+	uint32_t seq[CONFIG_CLOUD_QUEUE_BATCH_MAX_COUNT];
+	struct cloud_msg msg = { 0 };
+	int count;
+	int err;
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	if (!send_enabled) {
+		count = -EAGAIN;
+	} else if (entry_count == 0) {
+		count = 0;
+	} else {
+		count = batch_compose(&msg, seq);
+	}
+
+	k_mutex_unlock(&queue_lock);
+
+	if (count <= 0) {
+		return count;
+	}
+
+	err = cloud_send(cloud_backend, &msg);
+	if (err) {
+		LOG_WRN("cloud_send, error: %d", err);
+		return err;
+	}
+
+	LOG_DBG("%d messages sent, %zu bytes", count, msg.len);
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	/* Messages may have been dropped while the batch was sent */
+	for (int i = 0; i < count; i++) {
+		entry_remove_seq(seq[i]);
+	}
+
+	done_write(seq, count);
+
+	k_mutex_unlock(&queue_lock);
+
+	return count;
+}
+
+static int queue_flush(void)
+{
+	int err;
+
+	k_mutex_lock(&send_lock, K_FOREVER);
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	if (!send_enabled) {
+		k_mutex_unlock(&queue_lock);
+		k_mutex_unlock(&send_lock);
+		return -EAGAIN;
+	}
+
+	expired_drop();
+
+	k_mutex_unlock(&queue_lock);
+
+	do {
+		err = batch_send();
+	} while (err > 0);
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+	sectors_release();
+	k_mutex_unlock(&queue_lock);
+
+	k_mutex_unlock(&send_lock);
+
+	return err;
+}
+
+static void flush_work_fn(struct k_work *work)
+{
+	int err;
+
+	err = queue_flush();
+	if (err && err != -EAGAIN) {
+		LOG_WRN("Queued messages not sent, error: %d", err);
+	}
+}
+
+/* Schedule a flush for the priorities of the queued messages. */
+static void flush_schedule(void)
+{
+	bool normal = false;
+
+	if (!send_enabled) {
+		return;
+	}
+
+	for (size_t i = 0; i < entry_count; i++) {
+		if (entries[i].priority == CLOUD_QUEUE_PRIORITY_HIGH) {
+			k_delayed_work_submit(&flush_work, K_NO_WAIT);
+			return;
+		}
+
+		normal |= (entries[i].priority == CLOUD_QUEUE_PRIORITY_NORMAL);
+	}
+
+	if (entry_count >= CONFIG_CLOUD_QUEUE_FLUSH_THRESHOLD) {
+		k_delayed_work_submit(&flush_work, K_NO_WAIT);
+	} else if (normal && k_delayed_work_remaining_get(&flush_work) == 0) {
+		k_delayed_work_submit(&flush_work,
+				      K_SECONDS(CONFIG_CLOUD_QUEUE_FLUSH_DELAY));
+	}
+}
+
+static int fcb_open(void)
+{
+	uint32_t sector_count = ARRAY_SIZE(sectors);
+	int err;
+
+	err = flash_area_get_sectors(QUEUE_AREA_ID, &sector_count, sectors);
+	if (err) {
+		LOG_ERR("flash_area_get_sectors, error: %d", err);
+		return err;
+	}
+
+	memset(&fcb, 0, sizeof(fcb));
+	fcb.f_magic = QUEUE_FCB_MAGIC;
+	fcb.f_version = QUEUE_FCB_VERSION;
+	fcb.f_sectors = sectors;
+	fcb.f_sector_cnt = sector_count;
+
+	return fcb_init(QUEUE_AREA_ID, &fcb);
+}
+
+static int storage_erase(void)
+{
+	const struct flash_area *fap;
+	int err;
+
+	err = flash_area_open(QUEUE_AREA_ID, &fap);
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_erase(fap, 0, fap->fa_size);
+	flash_area_close(fap);
+
+	return err;
+}
+
+int cloud_queue_init(const struct cloud_backend *const backend)
+{
+	int err;
+
+	if (backend == NULL) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	cloud_backend = backend;
+	send_enabled = false;
+	k_delayed_work_init(&flush_work, flush_work_fn);
+
+	err = fcb_open();
+	if (err == 0) {
+		err = records_restore();
+	}
+
+	if (err) {
+		LOG_WRN("Stored messages could not be restored, error: %d",
+			err);
+
+		err = storage_erase();
+		if (err == 0) {
+			err = fcb_open();
+		}
+		if (err == 0) {
+			err = records_restore();
+		}
+	}
+
+	if (err) {
+		LOG_ERR("Flash storage could not be used, error: %d", err);
+		cloud_backend = NULL;
+	} else if (entry_count) {
+		LOG_INF("%zu stored messages restored", entry_count);
+	}
+
+	k_mutex_unlock(&queue_lock);
+
+	return err;
+}
+
+int cloud_queue_add(const struct cloud_msg *const msg,
+		    enum cloud_queue_priority priority, uint32_t ttl)
+{
+	struct record_msg record = {
+		.type = RECORD_MSG,
+		.priority = priority,
+	};
+	struct fcb_entry loc;
+	size_t len;
+	int err;
+
+	if (msg == NULL || msg->buf == NULL || msg->len == 0 ||
+	    priority >= CLOUD_QUEUE_PRIORITY_COUNT ||
+	    msg->qos >= CLOUD_QOS_COUNT) {
+		return -EINVAL;
+	}
+
+	if (msg->endpoint.len != 0) {
+		return -ENOTSUP;
+	}
+
+	if (cloud_backend == NULL) {
+		return -ENODEV;
+	}
+
+	len = sizeof(record) + msg->len;
+	if (record_len_in_flash(len) > sizeof(record_buf)) {
+		return -EMSGSIZE;
+	}
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	if (entry_count == ARRAY_SIZE(entries)) {
+		uint32_t seq = entries[0].seq;
+
+		LOG_WRN("Queue full, oldest message dropped");
+		entry_remove(0);
+		done_write(&seq, 1);
+	}
+
+	record.qos = msg->qos;
+	record.endpoint = msg->endpoint.type;
+	record.seq = next_seq++;
+	record.time = queue_time();
+	record.ttl = ttl;
+
+	memcpy(record_buf, &record, sizeof(record));
+	memcpy(&record_buf[sizeof(record)], msg->buf, msg->len);
+
+	err = record_append(len, &loc);
+	if (err == 0) {
+		entry_set(&entries[entry_count++], &loc, &record);
+		flush_schedule();
+	}
+
+	k_mutex_unlock(&queue_lock);
+
+	return err;
+}
+
+void cloud_queue_send_enable(bool enable)
+{
+	k_mutex_lock(&queue_lock, K_FOREVER);
+
+	send_enabled = enable;
+	if (enable) {
+		flush_schedule();
+	} else {
+		k_delayed_work_cancel(&flush_work);
+	}
+
+	k_mutex_unlock(&queue_lock);
+}
+
+int cloud_queue_flush(void)
+{
+	return queue_flush();
+}
+
+size_t cloud_queue_count(void)
+{
+	size_t count;
+
+	k_mutex_lock(&queue_lock, K_FOREVER);
+	count = entry_count;
+	k_mutex_unlock(&queue_lock);
+
+	return count;
+}
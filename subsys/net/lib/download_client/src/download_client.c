@@ -14,6 +14,9 @@
 #include <net/tls_credentials.h>
 #include <net/download_client.h>
 #include <logging/log.h>
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+#include <modem/nrf91_sockets.h>
+#endif
 
 LOG_MODULE_REGISTER(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
 
@@ -28,6 +31,7 @@ int url_parse_host(const char *url, char *host, size_t len);
 
 int http_parse(struct download_client *client, size_t len);
 int http_get_request_send(struct download_client *client);
+bool http_pipelined(const struct download_client *client);
 
 int coap_block_init(struct download_client *client, size_t from);
 int coap_parse(struct download_client *client, size_t len);
@@ -165,6 +169,20 @@ static int host_lookup(const char *host, int family, const char *apn,
 	return 0;
 }
 
+/* Resolve the host name again on the next connection, in case the cached
+ * address is no longer reachable.
+ */
+static void host_invalidate(const char *host)
+{
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+	char hostname[HOSTNAME_SIZE];
+
+	if (url_parse_host(host, hostname, sizeof(hostname)) == 0) {
+		nrf91_dns_cache_invalidate(hostname);
+	}
+#endif
+}
+
 static int client_connect(struct download_client *dl, const char *host,
 			  struct sockaddr *sa, int *fd)
 {
@@ -261,6 +279,7 @@ static int client_connect(struct download_client *dl, const char *host,
 	if (err) {
 		LOG_ERR("Unable to connect, errno %d", errno);
 		err = -errno;
+		host_invalidate(host);
 	}
 
 cleanup:
@@ -273,13 +292,14 @@ cleanup:
 	return err;
 }
 
-int socket_send(const struct download_client *client, size_t len)
+int socket_send(const struct download_client *client, const void *buf,
+		size_t len)
 {
 	int sent;
 	size_t off = 0;
 
 	while (len) {
-		sent = send(client->fd, client->buf + off, len, 0);
+		sent = send(client->fd, (const char *)buf + off, len, 0);
 		if (sent <= 0) {
 			return -errno;
 		}
@@ -291,6 +311,19 @@ int socket_send(const struct download_client *client, size_t len)
 	return 0;
 }
 
+size_t download_end_get(const struct download_client *client)
+{
+	if (client->range_end == 0) {
+		return client->file_size;
+	}
+
+	if (client->file_size != 0) {
+		return MIN(client->range_end, client->file_size);
+	}
+
+	return client->range_end;
+}
+
 static int request_send(struct download_client *dl)
 {
 	switch (dl->proto) {
@@ -307,7 +340,67 @@ static int request_send(struct download_client *dl)
 	return 0;
 }
 
-static int fragment_evt_send(const struct download_client *client)
+#if defined(CONFIG_DOWNLOAD_CLIENT_DOUBLE_BUFFER)
+static void fragment_thread(void *client, void *a, void *b)
+{
+	struct download_client *const dl = client;
+
+	while (true) {
+		k_sem_take(&dl->dbuf.ready, K_FOREVER);
+
+		const struct download_client_evt evt = {
+			.id = DOWNLOAD_CLIENT_EVT_FRAGMENT,
+			.fragment = {
+				.buf = dl->dbuf.buf,
+				.len = dl->dbuf.len,
+			}
+		};
+
+		dl->dbuf.rc = dl->callback(&evt);
+
+		k_sem_give(&dl->dbuf.free);
+	}
+}
+
+/* Wait until the application is done with the last fragment,
+ * and return what the application returned for it.
+ */
+static int fragment_sync(struct download_client *dl)
+{
+	k_sem_take(&dl->dbuf.free, K_FOREVER);
+	k_sem_give(&dl->dbuf.free);
+
+	return dl->dbuf.rc;
+}
+
+static int fragment_evt_send(struct download_client *client)
+{
+	__ASSERT(client->offset <= CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
+		 "Buffer overflow!");
+
+	k_sem_take(&client->dbuf.free, K_FOREVER);
+
+	/* The application refused the previous fragment */
+	if (client->dbuf.rc) {
+		k_sem_give(&client->dbuf.free);
+		return client->dbuf.rc;
+	}
+
+	/* Hand the fragment over, and receive the next one meanwhile */
+	memcpy(client->dbuf.buf, client->buf, client->offset);
+	client->dbuf.len = client->offset;
+
+	k_sem_give(&client->dbuf.ready);
+
+	return 0;
+}
+#else
+static int fragment_sync(struct download_client *dl)
+{
+	return 0;
+}
+
+static int fragment_evt_send(struct download_client *client)
 {
 	__ASSERT(client->offset <= CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
 		 "Buffer overflow!");
@@ -322,12 +415,83 @@ static int fragment_evt_send(const struct download_client *client)
 
 	return client->callback(&evt);
 }
+#endif /* CONFIG_DOWNLOAD_CLIENT_DOUBLE_BUFFER */
 
-static int error_evt_send(const struct download_client *dl, int error)
+#if defined(CONFIG_DOWNLOAD_CLIENT_STATS)
+void stats_rtt_update(struct download_client *dl, uint32_t sent)
 {
+	uint32_t rtt = k_uptime_get_32() - sent;
+
+	if (dl->stats.rtt_cnt == 0 || rtt < dl->stats.rtt_min) {
+		dl->stats.rtt_min = rtt;
+	}
+	if (rtt > dl->stats.rtt_max) {
+		dl->stats.rtt_max = rtt;
+	}
+	dl->stats.rtt_total += rtt;
+	dl->stats.rtt_cnt++;
+}
+
+static void stats_init(struct download_client *dl)
+{
+	memset(&dl->stats, 0, sizeof(dl->stats));
+	dl->stats.start_time = k_uptime_get_32();
+	dl->stats.evt_time = dl->stats.start_time;
+	dl->stats.start_progress = dl->progress;
+}
+
+static void stats_evt_send(struct download_client *dl, bool force)
+{
+	uint32_t now = k_uptime_get_32();
+	uint32_t elapsed = now - dl->stats.start_time;
+	size_t bytes = dl->progress - dl->stats.start_progress;
+
+	if (!force &&
+	    now - dl->stats.evt_time < CONFIG_DOWNLOAD_CLIENT_STATS_INTERVAL_MS) {
+		return;
+	}
+
+	dl->stats.evt_time = now;
+
+	const struct download_client_evt evt = {
+		.id = DOWNLOAD_CLIENT_EVT_STATS,
+		.stats = {
+			.bytes = bytes,
+			.elapsed_ms = elapsed,
+			.throughput = elapsed ?
+				((uint64_t)bytes * MSEC_PER_SEC) / elapsed : 0,
+			.rtt_cnt = dl->stats.rtt_cnt,
+			.rtt_min_ms = dl->stats.rtt_min,
+			.rtt_max_ms = dl->stats.rtt_max,
+			.rtt_avg_ms = dl->stats.rtt_cnt ?
+				dl->stats.rtt_total / dl->stats.rtt_cnt : 0,
+		}
+	};
+
+	LOG_DBG("%u bytes in %u ms, %u B/s, RTT avg %u ms",
+		bytes, elapsed, evt.stats.throughput, evt.stats.rtt_avg_ms);
+
+	(void)fragment_sync(dl);
+	(void)dl->callback(&evt);
+}
+#else
+static inline void stats_init(struct download_client *dl) {}
+static inline void stats_evt_send(struct download_client *dl, bool force) {}
+#endif /* CONFIG_DOWNLOAD_CLIENT_STATS */
+
+static int error_evt_send(struct download_client *dl, int error)
+{
+	int rc;
+
 	/* Error will be sent as negative. */
 	__ASSERT_NO_MSG(error > 0);
 
+	/* Stop if the application has refused the last fragment */
+	rc = fragment_sync(dl);
+	if (rc) {
+		return rc;
+	}
+
 	const struct download_client_evt evt = {
 		.id = DOWNLOAD_CLIENT_EVT_ERROR,
 		.error = -error
@@ -341,6 +505,11 @@ static int reconnect(struct download_client *dl)
 	int err;
 
 	LOG_INF("Reconnecting..");
+
+	/* Requests in flight are lost with the connection */
+	dl->http.carry = 0;
+	dl->http.req_cnt = dl->http.resp_cnt;
+
 	err = download_client_disconnect(dl);
 	if (err) {
 		return err;
@@ -361,7 +530,9 @@ void download_thread(void *client, void *a, void *b)
 	struct download_client *const dl = client;
 
 restart_and_suspend:
-	k_thread_suspend(dl->tid);
+	/* Let the application finish with the last fragment */
+	(void)fragment_sync(dl);
+	k_sem_take(&dl->start_sem, K_FOREVER);
 
 	while (true) {
 		__ASSERT(dl->offset < sizeof(dl->buf), "Buffer overflow");
@@ -373,6 +544,15 @@ restart_and_suspend:
 			break;
 		}
 
+		if (dl->http.carry) {
+			/* Part of the next pipelined response was received
+			 * with the previous one, parse it first.
+			 */
+			len = dl->http.carry;
+			dl->http.carry = 0;
+			goto parse;
+		}
+
 		LOG_DBG("Receiving up to %d bytes at %p...",
 			(sizeof(dl->buf) - dl->offset), (dl->buf + dl->offset));
 
@@ -396,6 +576,20 @@ restart_and_suspend:
 			}
 
 			if (len == -1) {
+				if (errno == ETIMEDOUT && http_pipelined(dl)) {
+					/* The responses to the requests in
+					 * flight may still arrive, and the
+					 * next range to request is past them.
+					 * Start over on a new connection.
+					 */
+					LOG_DBG("Socket timeout, reconnecting");
+					rc = reconnect(dl);
+					if (rc) {
+						error_evt_send(dl, EHOSTDOWN);
+						break;
+					}
+					goto send_again;
+				}
 				if (errno == ETIMEDOUT) {
 					LOG_DBG("Socket timeout, resending");
 					goto send_again;
@@ -428,6 +622,7 @@ restart_and_suspend:
 
 		LOG_DBG("Read %d bytes from socket", len);
 
+parse:
 		if (dl->proto == IPPROTO_TCP || dl->proto == IPPROTO_TLS_1_2) {
 			rc = http_parse(client, len);
 			if (rc > 0) {
@@ -464,8 +659,18 @@ restart_and_suspend:
 			break;
 		}
 
-		if (dl->progress == dl->file_size) {
+		stats_evt_send(dl, false);
+
+		if (dl->progress == download_end_get(dl)) {
+			rc = fragment_sync(dl);
+			if (rc) {
+				/* Restart and suspend */
+				LOG_INF("Fragment refused, download stopped.");
+				break;
+			}
+
 			LOG_INF("Download complete");
+			stats_evt_send(dl, true);
 			const struct download_client_evt evt = {
 				.id = DOWNLOAD_CLIENT_EVT_DONE,
 			};
@@ -481,6 +686,9 @@ restart_and_suspend:
 		}
 
 send_again:
+		if (dl->http.carry) {
+			memmove(dl->buf, dl->buf + dl->offset, dl->http.carry);
+		}
 		dl->offset = 0;
 		/* Request next fragment, if necessary (HTTPS/CoAP) */
 		if (dl->proto != IPPROTO_TCP || len == 0) {
@@ -519,8 +727,21 @@ int download_client_init(struct download_client *const client,
 	client->fd = -1;
 	client->callback = callback;
 
-	/* The thread is spawned now, but it will suspend itself;
-	 * it is resumed when the download is started via the API.
+	k_sem_init(&client->start_sem, 0, 1);
+
+#if defined(CONFIG_DOWNLOAD_CLIENT_DOUBLE_BUFFER)
+	k_sem_init(&client->dbuf.ready, 0, 1);
+	k_sem_init(&client->dbuf.free, 1, 1);
+
+	client->dbuf.tid =
+		k_thread_create(&client->dbuf.thread, client->dbuf.thread_stack,
+				K_THREAD_STACK_SIZEOF(client->dbuf.thread_stack),
+				fragment_thread, client, NULL, NULL,
+				K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
+#endif
+
+	/* The thread is spawned now, but it will block on start_sem;
+	 * it is released when the download is started via the API.
 	 */
 	client->tid =
 		k_thread_create(&client->thread, client->thread_stack,
@@ -601,10 +822,16 @@ int download_client_disconnect(struct download_client *const client)
 
 int download_client_start(struct download_client *client, const char *file,
 			  size_t from)
+{
+	return download_client_range_start(client, file, from, 0);
+}
+
+int download_client_range_start(struct download_client *client,
+				const char *file, size_t from, size_t to)
 {
 	int err;
 
-	if (client == NULL) {
+	if (client == NULL || (to != 0 && to <= from)) {
 		return -EINVAL;
 	}
 
@@ -612,12 +839,27 @@ int download_client_start(struct download_client *client, const char *file,
 		return -ENOTCONN;
 	}
 
+	if (to != 0 && client->proto != IPPROTO_TCP &&
+	    client->proto != IPPROTO_TLS_1_2) {
+		/* Ranges are only supported over HTTP(S) */
+		return -ENOTSUP;
+	}
+
 	client->file = file;
 	client->file_size = 0;
 	client->progress = from;
+	client->range_end = to;
 
 	client->offset = 0;
 	client->http.has_header = false;
+	client->http.carry = 0;
+	client->http.req_cnt = 0;
+	client->http.resp_cnt = 0;
+
+#if defined(CONFIG_DOWNLOAD_CLIENT_DOUBLE_BUFFER)
+	client->dbuf.rc = 0;
+#endif
+	stats_init(client);
 
 	if (IS_ENABLED(CONFIG_COAP)) {
 		coap_block_init(client, from);
@@ -628,11 +870,16 @@ int download_client_start(struct download_client *client, const char *file,
 		return err;
 	}
 
-	LOG_INF("Downloading: %s [%u]", log_strdup(client->file),
-		client->progress);
+	if (to != 0) {
+		LOG_INF("Downloading: %s [%u-%u]", log_strdup(client->file),
+			client->progress, to - 1);
+	} else {
+		LOG_INF("Downloading: %s [%u]", log_strdup(client->file),
+			client->progress);
+	}
 
 	/* Let the thread run */
-	k_thread_resume(client->tid);
+	k_sem_give(&client->start_sem);
 
 	return 0;
 }
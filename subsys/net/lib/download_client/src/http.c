@@ -33,13 +33,34 @@ LOG_MODULE_DECLARE(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
 
 int url_parse_host(const char *url, char *host, size_t len);
 int url_parse_file(const char *url, char *file, size_t len);
-int socket_send(const struct download_client *client, size_t len);
+int socket_send(const struct download_client *client, const void *buf,
+		size_t len);
+void stats_rtt_update(struct download_client *client, uint32_t sent);
+size_t download_end_get(const struct download_client *client);
 
-int http_get_request_send(struct download_client *client)
+static size_t frag_size_get(const struct download_client *client)
+{
+	if (client->config.frag_size_override) {
+		return client->config.frag_size_override;
+	}
+
+	return CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE;
+}
+
+/* Whether range requests are pipelined on the connection */
+bool http_pipelined(const struct download_client *client)
+{
+	return IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE) &&
+	       client->proto == IPPROTO_TLS_1_2;
+}
+
+static int request_send(struct download_client *client, size_t from)
 {
 	int err;
 	int len;
 	size_t off;
+	char *buf;
+	size_t buf_size;
 	char host[HOSTNAME_SIZE];
 	char file[FILENAME_SIZE];
 
@@ -56,51 +77,105 @@ int http_get_request_send(struct download_client *client)
 		return err;
 	}
 
-	/* Offset of last byte in range (Content-Range) */
-	if (client->config.frag_size_override) {
-		off = client->progress + client->config.frag_size_override - 1;
+	if (client->proto == IPPROTO_TLS_1_2) {
+		/* Offset of last byte in range (Content-Range) */
+		off = from + frag_size_get(client) - 1;
+
+		if (download_end_get(client) != 0) {
+			/* Don't request bytes past the end of file or range */
+			off = MIN(off, download_end_get(client) - 1);
+		}
 	} else {
-		off = client->progress +
-			CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE - 1;
+		/* Over HTTP, a single request is sent for the whole range.
+		 * The offset is only used when a range was asked for.
+		 */
+		off = download_end_get(client) - 1;
 	}
 
-	if (client->file_size != 0) {
-		/* Don't request bytes past the end of file */
-		off = MIN(off, client->file_size);
-	}
+#if defined(CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE)
+	/* The receive buffer may hold the start of a pending response */
+	buf = client->http.req_buf;
+	buf_size = sizeof(client->http.req_buf);
+#else
+	buf = client->buf;
+	buf_size = sizeof(client->buf);
+#endif
 
 	/* We use range requests only for HTTPS, due to memory limitations.
 	 * When using HTTP, we request the whole resource to minimize
-	 * network usage (only one request/response are sent).
+	 * network usage (only one request/response are sent). If the
+	 * application asked for a range, the whole range is requested.
 	 */
-	if (client->proto == IPPROTO_TLS_1_2) {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-			GET_HTTPS_TEMPLATE, file, host, client->progress, off);
+	if (client->proto == IPPROTO_TLS_1_2 || client->range_end != 0) {
+		len = snprintf(buf, buf_size,
+			GET_HTTPS_TEMPLATE, file, host, from, off);
 	} else {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-			GET_HTTP_TEMPLATE, file, host, client->progress);
+		len = snprintf(buf, buf_size,
+			GET_HTTP_TEMPLATE, file, host, from);
 	}
 
-	if (len < 0 || len > CONFIG_DOWNLOAD_CLIENT_BUF_SIZE) {
+	if (len < 0 || len > buf_size) {
 		LOG_ERR("Cannot create GET request, buffer too small");
 		return -ENOMEM;
 	}
 
 	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_LOG_HEADERS)) {
-		LOG_HEXDUMP_DBG(client->buf, len, "HTTP request");
+		LOG_HEXDUMP_DBG(buf, len, "HTTP request");
 	}
 
-	err = socket_send(client, len);
+	err = socket_send(client, buf, len);
 	if (err) {
 		LOG_ERR("Failed to send HTTP request, errno %d", errno);
 		return err;
 	}
 
+#if defined(CONFIG_DOWNLOAD_CLIENT_STATS)
+	client->http.req_time[client->http.req_cnt %
+			      ARRAY_SIZE(client->http.req_time)] =
+		k_uptime_get_32();
+#endif
+	client->http.req_cnt++;
+	client->http.req_off = off + 1;
+
 	return 0;
 }
 
+int http_get_request_send(struct download_client *client)
+{
+	int err;
+
+	if (!http_pipelined(client)) {
+		client->http.req_cnt = client->http.resp_cnt;
+		return request_send(client, client->progress);
+	}
+
+	/* Nothing in flight, e.g. after reconnecting, start from scratch */
+	if (client->http.req_cnt == client->http.resp_cnt) {
+		client->http.req_off = client->progress;
+	}
+
+	/* Keep up to the configured number of range requests in flight.
+	 * Until the file size is known, only one request is sent.
+	 */
+	do {
+		if (download_end_get(client) != 0 &&
+		    client->http.req_off >= download_end_get(client)) {
+			break;
+		}
+
+		err = request_send(client, client->http.req_off);
+		if (err) {
+			return err;
+		}
+	} while (client->file_size != 0 &&
+		 client->http.req_cnt - client->http.resp_cnt <
+		 DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH);
+
+	return 0;
+}
+
+static int http_header_fields_parse(struct download_client *client);
+
 /* Returns:
  *  1 while the header is being received
  *  0 if the header has been fully received
@@ -109,6 +184,15 @@ int http_get_request_send(struct download_client *client)
 static int http_header_parse(struct download_client *client, size_t *hdr_len)
 {
 	char *p;
+	char c;
+	int rc;
+
+	/* Only search the bytes received so far. With pipelined requests,
+	 * stale bytes of an earlier response may follow them.
+	 */
+	if (client->offset < sizeof(client->buf)) {
+		client->buf[client->offset] = '\0';
+	}
 
 	p = strstr(client->buf, "\r\n\r\n");
 	if (!p) {
@@ -129,6 +213,23 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 		client->buf[i] = tolower(client->buf[i]);
 	}
 
+	if (*hdr_len == sizeof(client->buf)) {
+		return http_header_fields_parse(client);
+	}
+
+	/* Parse the header fields only, not the payload that follows */
+	c = client->buf[*hdr_len];
+	client->buf[*hdr_len] = '\0';
+	rc = http_header_fields_parse(client);
+	client->buf[*hdr_len] = c;
+
+	return rc;
+}
+
+static int http_header_fields_parse(struct download_client *client)
+{
+	char *p;
+
 	p = strstr(client->buf, "http/1.1 206");
 	if (!p) {
 		if (client->proto == IPPROTO_TLS_1_2) {
@@ -142,18 +243,18 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 		}
 	}
 
-	/* The file size is returned via "Content-Length" in case of HTTP,
-	 * and via "Content-Range" in case of HTTPS with range requests.
+	/* The file size is returned via "Content-Range" in case of range
+	 * requests, and via "Content-Length" otherwise.
 	 */
 	if (client->file_size == 0) {
-		if (client->proto == IPPROTO_TLS_1_2) {
-			p = strstr(client->buf, "content-range");
-			if (!p) {
-				LOG_ERR("Server did not send "
-					"\"Content-Range\" in response");
-				return -1;
-			}
+		p = strstr(client->buf, "content-range");
+		if (p) {
 			p = strstr(p, "/");
+		} else if (client->proto == IPPROTO_TLS_1_2 ||
+			   client->range_end != 0) {
+			LOG_ERR("Server did not send "
+				"\"Content-Range\" in response");
+			return -1;
 		} else { /* proto == PROTO_HTTP */
 			p = strstr(client->buf, "content-length");
 			if (!p) {
@@ -208,6 +309,17 @@ int http_parse(struct download_client *client, size_t len)
 			return -1;
 		}
 
+		/* End of the range carried by this response */
+		client->http.frag_end = MIN(client->progress +
+					    frag_size_get(client),
+					    download_end_get(client));
+
+#if defined(CONFIG_DOWNLOAD_CLIENT_STATS)
+		stats_rtt_update(client,
+			client->http.req_time[client->http.resp_cnt %
+					      ARRAY_SIZE(client->http.req_time)]);
+#endif
+
 		if (client->offset != hdr_len) {
 			/* The buffer contains some payload bytes,
 			 * copy them at the beginning of the buffer
@@ -236,11 +348,31 @@ int http_parse(struct download_client *client, size_t len)
 	 */
 	client->progress += MIN(client->offset, len);
 
-	/* Have we received a whole fragment or the whole file? */
-	if ((client->offset < CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE) &&
-	    (client->progress != client->file_size)) {
+	if (client->proto != IPPROTO_TLS_1_2) {
+		/* Have we received a whole fragment or the whole file? */
+		if ((client->offset < CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE) &&
+		    (client->progress != download_end_get(client))) {
+			return 1;
+		}
+
+		return 0;
+	}
+
+	/* With pipelined range requests, the bytes past the end of this
+	 * response belong to the next one. Keep them for later.
+	 */
+	if (client->progress > client->http.frag_end) {
+		client->http.carry = client->progress - client->http.frag_end;
+		client->progress = client->http.frag_end;
+		client->offset -= client->http.carry;
+	}
+
+	/* Have we received the whole range? */
+	if (client->progress < client->http.frag_end) {
 		return 1;
 	}
 
+	client->http.resp_cnt++;
+
 	return 0;
 }
@@ -0,0 +1,833 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <logging/log.h>
+#include <settings/settings.h>
+#include <net/download_client.h>
+#include <net/download_manager.h>
+
+LOG_MODULE_REGISTER(download_manager, CONFIG_DOWNLOAD_MANAGER_LOG_LEVEL);
+
+#define CONN_CNT CONFIG_DOWNLOAD_MANAGER_CONN_CNT
+#define RANGE_MAX CONFIG_DOWNLOAD_MANAGER_RANGE_MAX
+
+#define MODULE "dl_mgr"
+#define FILE_STATE "state"
+
+enum range_state {
+	/** Not assigned to a connection. */
+	RANGE_PENDING,
+	/** Being downloaded. */
+	RANGE_ACTIVE,
+	/** Downloaded, but possibly not written to the sink yet. */
+	RANGE_RECEIVED,
+};
+
+struct range {
+	/** File offset of the first byte. */
+	size_t start;
+	/** File offset after the last byte. */
+	size_t end;
+	/** File offset of the next byte to receive. */
+	size_t received;
+	/** File offset of the next byte to write to the sink.
+	 *  Bytes in between written and received are buffered by the slot.
+	 */
+	size_t written;
+	enum range_state state;
+	/** Number of hosts which failed to serve the range. */
+	uint8_t failures;
+};
+
+struct slot {
+	struct download_client dlc;
+	/** Range being downloaded or flushed, NULL if idle. */
+	struct range *range;
+	/** Host the client is connected to, -1 if none. */
+	int host;
+	/** Host to use for the next range. */
+	int host_next;
+	/** Reconnection attempts left for the current range. */
+	uint8_t retries;
+	/** Data received ahead of the sink, in order mode. */
+	size_t buf_len;
+	uint8_t buf[CONFIG_DOWNLOAD_MANAGER_REORDER_BUF_SIZE];
+	/** Given when the sink has moved on. */
+	struct k_sem space;
+};
+
+/** Progress, as stored in settings. */
+struct stored_state {
+	/** Hash of the file name, zero if nothing is stored. */
+	uint32_t id;
+	uint32_t file_size;
+	uint32_t range_size;
+	/** Bytes of each range written to the sink. */
+	uint32_t written[RANGE_MAX];
+};
+
+static download_manager_callback_t callback;
+static const struct download_manager_cfg *cfg;
+
+static struct slot slots[CONN_CNT];
+static struct range ranges[RANGE_MAX];
+static size_t range_cnt;
+static size_t range_size;
+
+static size_t file_size;
+/** Offset of the next write, in order mode. */
+static size_t sink_off;
+/** Bytes written to the sink. */
+static size_t written_total;
+/** Bytes written since the last update. */
+static size_t unsent;
+static bool running;
+static int dl_error;
+
+static struct stored_state stored;
+
+/* Protects all of the above, the sink is called with it held. */
+static K_MUTEX_DEFINE(lock);
+
+static struct k_work_q work_q;
+static K_THREAD_STACK_DEFINE(work_q_stack, CONFIG_DOWNLOAD_MANAGER_STACK_SIZE);
+static struct k_delayed_work sched_work;
+
+static void sched(k_timeout_t delay)
+{
+	k_delayed_work_submit_to_queue(&work_q, &sched_work, delay);
+}
+
+static uint32_t file_id(const char *file)
+{
+	uint32_t hash = 5381;
+
+	while (*file) {
+		hash = ((hash << 5) + hash) ^ (uint8_t)*file++;
+	}
+
+	/* Zero means nothing is stored */
+	return hash ? hash : 1;
+}
+
+static void ranges_build(size_t size)
+{
+	struct range first = ranges[0];
+
+	range_size = MAX(CONFIG_DOWNLOAD_MANAGER_RANGE_SIZE,
+			 DIV_ROUND_UP(size, RANGE_MAX));
+	range_cnt = DIV_ROUND_UP(size, range_size);
+
+	for (size_t i = 0; i < range_cnt; i++) {
+		ranges[i] = (struct range){
+			.start = i * range_size,
+			.end = MIN((i + 1) * range_size, size),
+			.received = i * range_size,
+			.written = i * range_size,
+			.state = RANGE_PENDING,
+		};
+	}
+
+	/* The first range may be in use to retrieve the file size */
+	ranges[0].received = first.received;
+	ranges[0].written = first.written;
+	ranges[0].state = first.state;
+
+	file_size = size;
+
+	LOG_DBG("File size %u, %u ranges of %u bytes",
+		file_size, range_cnt, range_size);
+}
+
+static bool stored_state_apply(void)
+{
+	if (stored.id != file_id(cfg->file) ||
+	    (cfg->file_size != 0 && cfg->file_size != stored.file_size)) {
+		return false;
+	}
+
+	ranges_build(stored.file_size);
+
+	if (stored.range_size != range_size) {
+		return false;
+	}
+
+	for (size_t i = 0; i < range_cnt; i++) {
+		struct range *r = &ranges[i];
+
+		r->written = MIN(r->start + stored.written[i], r->end);
+		r->received = r->written;
+		r->state = (r->written == r->end) ? RANGE_RECEIVED
+						  : RANGE_PENDING;
+		written_total += r->written - r->start;
+	}
+
+	LOG_INF("Resuming download, %u/%u bytes written",
+		written_total, file_size);
+
+	return true;
+}
+
+static void stored_state_update(void)
+{
+	stored.id = file_id(cfg->file);
+	stored.file_size = file_size;
+	stored.range_size = range_size;
+
+	for (size_t i = 0; i < RANGE_MAX; i++) {
+		stored.written[i] = (i < range_cnt) ?
+			ranges[i].written - ranges[i].start : 0;
+	}
+}
+
+static void stored_state_save(void)
+{
+	if (IS_ENABLED(CONFIG_DOWNLOAD_MANAGER_SAVE_PROGRESS)) {
+		int err = settings_save_one(MODULE "/" FILE_STATE, &stored,
+					    sizeof(stored));
+
+		if (err) {
+			LOG_ERR("Problem storing progress (err %d)", err);
+		}
+	}
+}
+
+static void stored_state_clear(void)
+{
+	memset(&stored, 0, sizeof(stored));
+
+	if (IS_ENABLED(CONFIG_DOWNLOAD_MANAGER_SAVE_PROGRESS)) {
+		int err = settings_delete(MODULE "/" FILE_STATE);
+
+		if (err) {
+			LOG_ERR("Problem deleting progress (err %d)", err);
+		}
+	}
+}
+
+/**
+ * @brief Function used by settings_load() to restore the stored progress.
+ *	  See the Zephyr documentation of the settings subsystem for more
+ *	  information.
+ */
+static int settings_set(const char *key, size_t len_rd,
+			settings_read_cb read_cb, void *cb_arg)
+{
+	if (!strcmp(key, FILE_STATE)) {
+		ssize_t len = read_cb(cb_arg, &stored, sizeof(stored));
+
+		if (len != sizeof(stored)) {
+			LOG_ERR("Can't read progress from storage");
+			memset(&stored, 0, sizeof(stored));
+			return len;
+		}
+	}
+
+	return 0;
+}
+
+static void evt_send(enum download_manager_evt_id id, int error)
+{
+	struct download_manager_evt evt = {
+		.id = id,
+	};
+
+	if (id == DOWNLOAD_MANAGER_EVT_ERROR) {
+		evt.error = error;
+	} else {
+		evt.progress.written = written_total;
+		evt.progress.file_size = file_size;
+	}
+
+	callback(&evt);
+}
+
+/* Return the range to the pending state, dropping buffered data. */
+static void slot_release(struct slot *s)
+{
+	struct range *r = s->range;
+
+	if (r) {
+		r->received = r->written;
+		r->state = RANGE_PENDING;
+	}
+
+	s->buf_len = 0;
+	s->range = NULL;
+}
+
+/* The current host could not serve the range, try the next one. */
+static void slot_fail(struct slot *s, int err)
+{
+	struct range *r = s->range;
+
+	slot_release(s);
+
+	/* Reconnect before the next range */
+	s->host_next = (s->host_next + 1) % cfg->host_cnt;
+	s->host = -1;
+
+	if (r && ++r->failures >= cfg->host_cnt) {
+		LOG_ERR("Range %u-%u failed on all hosts",
+			r->start, r->end - 1);
+		dl_error = err;
+	}
+}
+
+static int sink_write(struct range *r, const void *buf, size_t len)
+{
+	int err = cfg->write(r->written, buf, len);
+
+	if (err) {
+		LOG_ERR("Sink refused data at %u (err %d)", r->written, err);
+		return err;
+	}
+
+	r->written += len;
+	written_total += len;
+
+	if (cfg->in_order) {
+		sink_off = r->written;
+	}
+
+	unsent += len;
+	if (unsent >= CONFIG_DOWNLOAD_MANAGER_UPDATE_INTERVAL ||
+	    r->written == r->end) {
+		unsent = 0;
+		sched(K_NO_WAIT);
+	}
+
+	return 0;
+}
+
+/* Write the buffered data that the sink has caught up with. */
+static int sink_flush(void)
+{
+	bool again;
+	int err;
+
+	do {
+		again = false;
+
+		for (size_t i = 0; i < CONN_CNT; i++) {
+			struct slot *s = &slots[i];
+
+			if (s->buf_len == 0 ||
+			    s->range->written != sink_off) {
+				continue;
+			}
+
+			err = sink_write(s->range, s->buf, s->buf_len);
+			if (err) {
+				return err;
+			}
+
+			s->buf_len = 0;
+			if (s->range->state == RANGE_RECEIVED) {
+				s->range = NULL;
+				sched(K_NO_WAIT);
+			}
+
+			again = true;
+		}
+	} while (again);
+
+	/* Let blocked slots check whether they are next */
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		k_sem_give(&slots[i].space);
+	}
+
+	return 0;
+}
+
+static int fragment_ordered(struct slot *s, const void *buf, size_t len)
+{
+	struct range *r = s->range;
+	int err;
+
+	while (r->received != sink_off) {
+		if (s->buf_len + len <= sizeof(s->buf)) {
+			memcpy(s->buf + s->buf_len, buf, len);
+			s->buf_len += len;
+			r->received += len;
+			return 0;
+		}
+
+		/* Buffer is full, wait for the sink to catch up.
+		 * The semaphore is only given with the lock held.
+		 */
+		k_sem_reset(&s->space);
+		k_mutex_unlock(&lock);
+		k_sem_take(&s->space, K_FOREVER);
+		k_mutex_lock(&lock, K_FOREVER);
+
+		if (!running || s->range != r) {
+			return -ECANCELED;
+		}
+	}
+
+	r->received += len;
+	err = sink_write(r, buf, len);
+	if (err) {
+		return err;
+	}
+
+	return sink_flush();
+}
+
+static int fragment_handle(struct slot *s, const void *buf, size_t len)
+{
+	struct range *r;
+	int err;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (!running || s->range == NULL) {
+		err = -ECANCELED;
+		goto out;
+	}
+
+	if (file_size == 0) {
+		size_t size;
+
+		err = download_client_file_size_get(&s->dlc, &size);
+		if (err || size == 0) {
+			LOG_ERR("File size unknown");
+			err = -EBADMSG;
+			goto out;
+		}
+
+		ranges_build(size);
+		sched(K_NO_WAIT);
+	}
+
+	r = s->range;
+	/* The first range is shortened if the file is smaller */
+	len = MIN(len, r->end - r->received);
+
+	if (cfg->in_order) {
+		err = fragment_ordered(s, buf, len);
+	} else {
+		r->received += len;
+		err = sink_write(r, buf, len);
+	}
+
+out:
+	if (err && err != -ECANCELED) {
+		dl_error = err;
+		sched(K_NO_WAIT);
+	}
+
+	k_mutex_unlock(&lock);
+
+	return err;
+}
+
+static int client_evt_handle(struct slot *s,
+			     const struct download_client_evt *evt)
+{
+	struct range *r;
+	int rc = 0;
+
+	switch (evt->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		return fragment_handle(s, evt->fragment.buf, evt->fragment.len);
+
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		k_mutex_lock(&lock, K_FOREVER);
+		r = s->range;
+		if (r && r->received == r->end) {
+			r->state = RANGE_RECEIVED;
+			if (s->buf_len == 0) {
+				s->range = NULL;
+			}
+		} else {
+			/* The file size was not known when the range was
+			 * requested, request the rest of it.
+			 */
+			slot_release(s);
+		}
+		k_mutex_unlock(&lock);
+		sched(K_NO_WAIT);
+		break;
+
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		k_mutex_lock(&lock, K_FOREVER);
+		if (!running) {
+			rc = -ECANCELED;
+		} else if (evt->error == -ECONNRESET && s->retries > 0) {
+			/* Let the client reconnect and resume */
+			LOG_WRN("Connection reset, %d retries left",
+				s->retries);
+			s->retries--;
+		} else {
+			LOG_WRN("Range failed on %s (err %d)",
+				log_strdup(cfg->hosts[s->host_next]),
+				evt->error);
+			slot_fail(s, evt->error);
+			sched(K_NO_WAIT);
+			rc = evt->error;
+		}
+		k_mutex_unlock(&lock);
+		break;
+
+	default:
+		break;
+	}
+
+	return rc;
+}
+
+/* download_client callbacks carry no context, so each slot has its own. */
+#define SLOT_CALLBACK(n)						\
+	static int slot_##n##_callback(					\
+		const struct download_client_evt *evt)			\
+	{								\
+		return client_evt_handle(&slots[n], evt);		\
+	}
+
+SLOT_CALLBACK(0)
+#if CONN_CNT > 1
+SLOT_CALLBACK(1)
+#endif
+#if CONN_CNT > 2
+SLOT_CALLBACK(2)
+#endif
+#if CONN_CNT > 3
+SLOT_CALLBACK(3)
+#endif
+
+static const download_client_callback_t slot_callbacks[CONN_CNT] = {
+	slot_0_callback,
+#if CONN_CNT > 1
+	slot_1_callback,
+#endif
+#if CONN_CNT > 2
+	slot_2_callback,
+#endif
+#if CONN_CNT > 3
+	slot_3_callback,
+#endif
+};
+
+static void slots_disconnect(void)
+{
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		if (slots[i].dlc.fd != -1) {
+			(void)download_client_disconnect(&slots[i].dlc);
+		}
+		slots[i].host = -1;
+	}
+}
+
+static int slot_start(struct slot *s, size_t from, size_t to)
+{
+	struct download_client *dlc = &s->dlc;
+	int err;
+
+	if (s->host != s->host_next && dlc->fd != -1) {
+		(void)download_client_disconnect(dlc);
+	}
+
+	err = download_client_connect(dlc, cfg->hosts[s->host_next],
+				      &cfg->client);
+	if (err) {
+		return err;
+	}
+
+	s->host = s->host_next;
+
+	err = download_client_range_start(dlc, cfg->file, from, to);
+	if (err) {
+		/* The server may have closed the connection
+		 * after the previous range, try once more.
+		 */
+		(void)download_client_disconnect(dlc);
+		err = download_client_connect(dlc, cfg->hosts[s->host],
+					      &cfg->client);
+		if (err) {
+			return err;
+		}
+		err = download_client_range_start(dlc, cfg->file, from, to);
+	}
+
+	return err;
+}
+
+static struct range *range_next(void)
+{
+	for (size_t i = 0; i < range_cnt; i++) {
+		if (ranges[i].state == RANGE_PENDING) {
+			return &ranges[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void slots_schedule(void)
+{
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		struct slot *s = &slots[i];
+		struct range *r;
+		size_t from;
+		size_t to;
+		int err;
+
+		k_mutex_lock(&lock, K_FOREVER);
+
+		if (!running || s->range) {
+			k_mutex_unlock(&lock);
+			continue;
+		}
+
+		r = range_next();
+		if (!r) {
+			k_mutex_unlock(&lock);
+			break;
+		}
+
+		r->state = RANGE_ACTIVE;
+		s->range = r;
+		s->retries = CONFIG_DOWNLOAD_MANAGER_RETRIES;
+		from = r->received;
+		to = r->end;
+
+		k_mutex_unlock(&lock);
+
+		LOG_DBG("Slot %u: range %u-%u from %s", i, from, to - 1,
+			log_strdup(cfg->hosts[s->host_next]));
+
+		err = slot_start(s, from, to);
+		if (err) {
+			LOG_WRN("Failed to start range on %s (err %d)",
+				log_strdup(cfg->hosts[s->host_next]), err);
+			k_mutex_lock(&lock, K_FOREVER);
+			slot_fail(s, err);
+			k_mutex_unlock(&lock);
+			sched(K_SECONDS(1));
+		}
+	}
+}
+
+static void sched_work_fn(struct k_work *work)
+{
+	int err;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (!running) {
+		k_mutex_unlock(&lock);
+		slots_disconnect();
+		return;
+	}
+
+	if (dl_error) {
+		err = dl_error;
+		running = false;
+		stored_state_update();
+		k_mutex_unlock(&lock);
+
+		slots_disconnect();
+		stored_state_save();
+		evt_send(DOWNLOAD_MANAGER_EVT_ERROR, err);
+		return;
+	}
+
+	if (file_size != 0 && written_total == file_size) {
+		running = false;
+		k_mutex_unlock(&lock);
+
+		LOG_INF("Download complete");
+		slots_disconnect();
+		stored_state_clear();
+		evt_send(DOWNLOAD_MANAGER_EVT_DONE, 0);
+		return;
+	}
+
+	if (file_size != 0) {
+		stored_state_update();
+	}
+
+	k_mutex_unlock(&lock);
+
+	if (file_size != 0) {
+		stored_state_save();
+		evt_send(DOWNLOAD_MANAGER_EVT_PROGRESS, 0);
+	}
+
+	slots_schedule();
+}
+
+int download_manager_init(download_manager_callback_t client_callback)
+{
+	int err;
+
+	if (client_callback == NULL) {
+		return -EINVAL;
+	}
+
+	callback = client_callback;
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		err = download_client_init(&slots[i].dlc, slot_callbacks[i]);
+		if (err) {
+			return err;
+		}
+
+		k_sem_init(&slots[i].space, 0, 1);
+		slots[i].host = -1;
+	}
+
+	k_work_q_start(&work_q, work_q_stack,
+		       K_THREAD_STACK_SIZEOF(work_q_stack),
+		       K_LOWEST_APPLICATION_THREAD_PRIO);
+	k_delayed_work_init(&sched_work, sched_work_fn);
+
+	if (IS_ENABLED(CONFIG_DOWNLOAD_MANAGER_SAVE_PROGRESS)) {
+		static struct settings_handler sh = {
+			.name = MODULE,
+			.h_set = settings_set,
+		};
+
+		/* settings_subsys_init is idempotent so this is safe to do. */
+		err = settings_subsys_init();
+		if (err) {
+			LOG_ERR("settings_subsys_init failed (err %d)", err);
+			return err;
+		}
+
+		err = settings_register(&sh);
+		if (err) {
+			LOG_ERR("Cannot register settings (err %d)", err);
+			return err;
+		}
+
+		err = settings_load();
+		if (err) {
+			LOG_ERR("Cannot load settings (err %d)", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int download_manager_start(const struct download_manager_cfg *config)
+{
+	if (callback == NULL) {
+		return -EACCES;
+	}
+
+	if (config == NULL || config->hosts == NULL || config->host_cnt == 0 ||
+	    config->file == NULL || config->write == NULL) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (running) {
+		k_mutex_unlock(&lock);
+		return -EALREADY;
+	}
+
+	cfg = config;
+	memset(ranges, 0, sizeof(ranges));
+	range_cnt = 0;
+	file_size = 0;
+	written_total = 0;
+	unsent = 0;
+	dl_error = 0;
+
+	if (!stored_state_apply()) {
+		memset(ranges, 0, sizeof(ranges));
+		written_total = 0;
+
+		if (cfg->file_size != 0) {
+			ranges_build(cfg->file_size);
+		} else {
+			/* Retrieve the file size with the first range */
+			file_size = 0;
+			range_cnt = 1;
+			ranges[0] = (struct range){
+				.end = CONFIG_DOWNLOAD_MANAGER_RANGE_SIZE,
+			};
+		}
+	}
+
+	/* In order mode, only a prefix of the file can have been written */
+	sink_off = 0;
+	for (size_t i = 0; i < range_cnt; i++) {
+		sink_off = ranges[i].written;
+		if (ranges[i].written != ranges[i].end) {
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		slots[i].range = NULL;
+		slots[i].buf_len = 0;
+		slots[i].host_next = i % cfg->host_cnt;
+	}
+
+	running = true;
+
+	k_mutex_unlock(&lock);
+
+	sched(K_NO_WAIT);
+
+	return 0;
+}
+
+int download_manager_stop(void)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (!running) {
+		k_mutex_unlock(&lock);
+		return -EALREADY;
+	}
+
+	running = false;
+
+	if (file_size != 0) {
+		stored_state_update();
+	}
+
+	/* Wake up slots waiting for the sink */
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		k_sem_give(&slots[i].space);
+	}
+
+	k_mutex_unlock(&lock);
+
+	if (file_size != 0) {
+		stored_state_save();
+	}
+
+	/* Disconnect from the work queue, to not race with the scheduler */
+	sched(K_NO_WAIT);
+
+	return 0;
+}
+
+int download_manager_reset(void)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (running) {
+		k_mutex_unlock(&lock);
+		return -EBUSY;
+	}
+
+	stored_state_clear();
+
+	k_mutex_unlock(&lock);
+
+	return 0;
+}
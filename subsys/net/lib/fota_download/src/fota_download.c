@@ -5,6 +5,7 @@
  */
 
 #include <zephyr.h>
+#include <string.h>
 #include <logging/log.h>
 #include <net/fota_download.h>
 #include <net/download_client.h>
@@ -24,6 +25,10 @@ static fota_download_callback_t callback;
 static struct download_client   dlc;
 static struct k_delayed_work    dlc_with_offset_work;
 static int socket_retries_left;
+#ifdef CONFIG_DFU_TARGET_STREAM_HASH
+static uint8_t expected_hash[DFU_TARGET_HASH_LEN];
+static bool hash_set;
+#endif
 
 static void send_evt(enum fota_download_evt_id id)
 {
@@ -95,6 +100,19 @@ static int download_client_callback(const struct download_client_evt *event)
 				return err;
 			}
 
+#ifdef CONFIG_DFU_TARGET_STREAM_HASH
+			if (hash_set) {
+				err = dfu_target_hash_set(expected_hash);
+				if (err != 0) {
+					LOG_ERR("dfu_target_hash_set error %d",
+						err);
+					send_evt(FOTA_DOWNLOAD_EVT_ERROR);
+					first_fragment = true;
+					return err;
+				}
+			}
+#endif
+
 			err = dfu_target_offset_get(&offset);
 			if (err != 0) {
 				LOG_DBG("unable to get dfu target offset err: "
@@ -152,6 +170,9 @@ static int download_client_callback(const struct download_client_evt *event)
 	}
 
 	case DOWNLOAD_CLIENT_EVT_DONE:
+#ifdef CONFIG_DFU_TARGET_STREAM_HASH
+		hash_set = false;
+#endif
 		err = dfu_target_done(true);
 		if (err != 0) {
 			LOG_ERR("dfu_target_done error: %d", err);
@@ -279,6 +300,20 @@ int fota_download_start(const char *host, const char *file, int sec_tag,
 	return 0;
 }
 
+#ifdef CONFIG_DFU_TARGET_STREAM_HASH
+int fota_download_hash_set(const uint8_t *hash)
+{
+	if (hash == NULL) {
+		return -EINVAL;
+	}
+
+	memcpy(expected_hash, hash, sizeof(expected_hash));
+	hash_set = true;
+
+	return 0;
+}
+#endif
+
 int fota_download_init(fota_download_callback_t client_callback)
 {
 	if (client_callback == NULL) {
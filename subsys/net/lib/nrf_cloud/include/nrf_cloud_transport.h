@@ -20,6 +20,7 @@ enum nct_evt_type {
 	NCT_EVT_CC_RX_DATA,
 	NCT_EVT_CC_TX_DATA_ACK,
 	NCT_EVT_DC_RX_DATA,
+	NCT_EVT_DC_RX_DATA_CHUNK,
 	NCT_EVT_DC_TX_DATA_ACK,
 	NCT_EVT_CC_DISCONNECTED,
 	NCT_EVT_DC_DISCONNECTED,
@@ -38,6 +39,8 @@ struct nct_dc_data {
 	struct nrf_cloud_data data;
 	struct nrf_cloud_topic topic;
 	uint32_t id;
+	/* Position of the data in the message, for NCT_EVT_DC_RX_DATA_CHUNK. */
+	struct nrf_cloud_rx_chunk chunk;
 };
 
 struct nct_cc_data {
@@ -313,6 +313,22 @@ static void api_event_handler(const struct nrf_cloud_evt *nrf_cloud_evt)
 			(char *)nrf_cloud_evt->topic.ptr;
 		evt.data.msg.endpoint.len = nrf_cloud_evt->topic.len;
 
+		cloud_notify_event(nrf_cloud_backend, &evt, config->user_data);
+		break;
+	case NRF_CLOUD_EVT_RX_DATA_CHUNK:
+		LOG_DBG("NRF_CLOUD_EVT_RX_DATA_CHUNK");
+
+		evt.type = CLOUD_EVT_DATA_RECEIVED_CHUNK;
+		evt.data.chunk.msg.buf = (char *)nrf_cloud_evt->data.ptr;
+		evt.data.chunk.msg.len = nrf_cloud_evt->data.len;
+		evt.data.chunk.msg.endpoint.type = CLOUD_EP_TOPIC_MSG;
+		evt.data.chunk.msg.endpoint.str =
+			(char *)nrf_cloud_evt->topic.ptr;
+		evt.data.chunk.msg.endpoint.len = nrf_cloud_evt->topic.len;
+		evt.data.chunk.offset = nrf_cloud_evt->chunk.offset;
+		evt.data.chunk.total_len = nrf_cloud_evt->chunk.total_len;
+		evt.data.chunk.err = nrf_cloud_evt->chunk.err;
+
 		cloud_notify_event(nrf_cloud_backend, &evt, config->user_data);
 		break;
 	case NRF_CLOUD_EVT_FOTA_DONE:
@@ -8,6 +8,7 @@
 #include <device.h>
 #include <drivers/gps.h>
 #include <net/socket.h>
+#include <sys/byteorder.h>
 #include <nrf_socket.h>
 
 #include <modem/modem_info.h>
@@ -408,7 +409,7 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 		LOG_DBG("A-GPS type: NRF_CLOUD_AGPS_INTEGRITY");
 
 		return send_to_modem(agps_data->integrity,
-				     sizeof(agps_data->integrity),
+				     sizeof(*agps_data->integrity),
 				     NRF_GNSS_AGPS_INTEGRITY);
 	default:
 		LOG_WRN("Unknown AGPS data type: %d", agps_data->type);
@@ -418,95 +419,208 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 	return 0;
 }
 
-static size_t get_next_agps_element(struct nrf_cloud_apgs_element *element,
-				    const char *buf)
-{
-	static uint16_t elements_left_to_process;
-	static enum nrf_cloud_agps_type element_type;
-	size_t len = 0;
+/* Size of a GPS system clock element, the time-of-week array is received as
+ * separate elements.
+ */
+#define SYSTEM_TIME_SIZE (sizeof(struct nrf_cloud_agps_system_time) - \
+	sizeof(((struct nrf_cloud_agps_system_time *)0)->sv_tow) + 4)
+
+#define ARRAY_HEADER_SIZE \
+	(NRF_CLOUD_AGPS_BIN_TYPE_SIZE + NRF_CLOUD_AGPS_BIN_COUNT_SIZE)
 
-	/* Check if there are more elements left in the array to process.
-	 * The element type is only given once before the array, and not for
-	 * each element.
+/* The data is parsed one item at a time: the schema version, the header of an
+ * array of elements of the same type, or an element.
+ */
+enum parse_state {
+	PARSE_IDLE,
+	PARSE_VERSION,
+	PARSE_ARRAY_HEADER,
+	PARSE_ELEMENT,
+	PARSE_DONE,
+	PARSE_FAILED,
+};
+
+/* Storage for an item split across chunks. */
+union agps_item {
+	uint8_t array_header[ARRAY_HEADER_SIZE];
+	struct nrf_cloud_agps_utc utc;
+	struct nrf_cloud_agps_ephemeris ephemeris;
+	struct nrf_cloud_agps_almanac almanac;
+	struct nrf_cloud_agps_klobuchar klobuchar;
+	struct nrf_cloud_agps_tow_element tow;
+	uint8_t system_time[SYSTEM_TIME_SIZE];
+	struct nrf_cloud_agps_location location;
+	struct nrf_cloud_agps_integrity integrity;
+};
+
+static struct {
+	enum parse_state state;
+	enum nrf_cloud_agps_type type;
+	uint16_t elements_left;
+	/* Size of the item being parsed, and bytes of it stored in item when
+	 * it is split across chunks.
 	 */
-	if (elements_left_to_process == 0) {
-		element->type =
-			(enum nrf_cloud_agps_type)buf[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET];
-		element_type = element->type;
-		elements_left_to_process =
-			*(uint16_t *)&buf[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET] - 1;
-		len += NRF_CLOUD_AGPS_BIN_TYPE_SIZE +
-			NRF_CLOUD_AGPS_BIN_COUNT_SIZE;
-	} else {
-		element->type = element_type;
-		elements_left_to_process -= 1;
+	size_t item_size;
+	size_t item_len;
+	union agps_item item;
+	/* Offset of the next chunk. */
+	size_t offset;
+	/* Sent once all time-of-week elements are received. */
+	struct nrf_cloud_agps_system_time sys_time;
+	bool sys_time_received;
+} parser;
+
+static size_t element_size_get(enum nrf_cloud_agps_type type)
+{
+	switch (type) {
+	case NRF_CLOUD_AGPS_UTC_PARAMETERS:
+		return sizeof(struct nrf_cloud_agps_utc);
+	case NRF_CLOUD_AGPS_EPHEMERIDES:
+		return sizeof(struct nrf_cloud_agps_ephemeris);
+	case NRF_CLOUD_AGPS_ALMANAC:
+		return sizeof(struct nrf_cloud_agps_almanac);
+	case NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION:
+		return sizeof(struct nrf_cloud_agps_klobuchar);
+	case NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK:
+		return SYSTEM_TIME_SIZE;
+	case NRF_CLOUD_AGPS_GPS_TOWS:
+		return sizeof(struct nrf_cloud_agps_tow_element);
+	case NRF_CLOUD_AGPS_LOCATION:
+		return sizeof(struct nrf_cloud_agps_location);
+	case NRF_CLOUD_AGPS_INTEGRITY:
+		return sizeof(struct nrf_cloud_agps_integrity);
+	default:
+		return 0;
 	}
+}
+
+static void parse_state_set(enum parse_state state)
+{
+	parser.state = state;
 
-	switch (element->type) {
+	switch (state) {
+	case PARSE_VERSION:
+		parser.item_size = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_SIZE;
+		break;
+	case PARSE_ARRAY_HEADER:
+		parser.item_size = ARRAY_HEADER_SIZE;
+		break;
+	case PARSE_ELEMENT:
+		parser.item_size = element_size_get(parser.type);
+		break;
+	default:
+		parser.item_size = 0;
+		break;
+	}
+}
+
+static int element_process(const char *data)
+{
+	struct nrf_cloud_apgs_element element = {
+		.type = parser.type
+	};
+
+	switch (parser.type) {
 	case NRF_CLOUD_AGPS_UTC_PARAMETERS:
-		element->utc = (struct nrf_cloud_agps_utc *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_utc);
+		element.utc = (struct nrf_cloud_agps_utc *)data;
 		break;
 	case NRF_CLOUD_AGPS_EPHEMERIDES:
-		element->ephemeris = (struct nrf_cloud_agps_ephemeris *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_ephemeris);
+		element.ephemeris = (struct nrf_cloud_agps_ephemeris *)data;
 		break;
 	case NRF_CLOUD_AGPS_ALMANAC:
-		element->almanac = (struct nrf_cloud_agps_almanac *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_almanac);
+		element.almanac = (struct nrf_cloud_agps_almanac *)data;
 		break;
 	case NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION:
-		element->ion_correction.klobuchar =
-			(struct nrf_cloud_agps_klobuchar *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_klobuchar);
+		element.ion_correction.klobuchar =
+			(struct nrf_cloud_agps_klobuchar *)data;
 		break;
 	case NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK:
-		element->time_and_tow =
-			(struct nrf_cloud_agps_system_time *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_system_time) -
-			sizeof(element->time_and_tow->sv_tow) + 4;
-		break;
-	case NRF_CLOUD_AGPS_GPS_TOWS:
-		element->tow =
-			(struct nrf_cloud_agps_tow_element *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_tow_element);
-		break;
+		memcpy(&parser.sys_time, data,
+		       sizeof(parser.sys_time) - sizeof(parser.sys_time.sv_tow));
+		parser.sys_time_received = true;
+
+		LOG_DBG("System time copied, TOW bitmask: 0x%08x",
+			parser.sys_time.sv_mask);
+
+		return 0;
+	case NRF_CLOUD_AGPS_GPS_TOWS: {
+		const struct nrf_cloud_agps_tow_element *tow =
+			(const struct nrf_cloud_agps_tow_element *)data;
+
+		if ((tow->sv_id == 0) ||
+		    (tow->sv_id > NRF_CLOUD_AGPS_MAX_SV_TOW)) {
+			LOG_WRN("Invalid TOW satellite ID: %d", tow->sv_id);
+			return 0;
+		}
+
+		memcpy(&parser.sys_time.sv_tow[tow->sv_id - 1], tow,
+		       sizeof(parser.sys_time.sv_tow[0]));
+
+		LOG_DBG("TOW %d copied", tow->sv_id - 1);
+
+		return 0;
+	}
 	case NRF_CLOUD_AGPS_LOCATION:
-		element->location = (struct nrf_cloud_agps_location *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_location);
+		element.location = (struct nrf_cloud_agps_location *)data;
 		break;
 	case NRF_CLOUD_AGPS_INTEGRITY:
-		element->integrity =
-			(struct nrf_cloud_agps_integrity *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_integrity);
+		element.integrity = (struct nrf_cloud_agps_integrity *)data;
 		break;
 	default:
-		LOG_DBG("Unhandled A-GPS data type: %d", element->type);
 		return 0;
 	}
 
-	return len;
+	return agps_send_to_modem(&element);
 }
 
-int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
+static int item_process(const char *data)
 {
 	int err;
-	struct nrf_cloud_apgs_element element = {};
-	struct nrf_cloud_agps_system_time sys_time;
-	size_t parsed_len = 0;
-	uint8_t version;
 
-	version = buf[NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_INDEX];
-	parsed_len += NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_SIZE;
+	switch (parser.state) {
+	case PARSE_VERSION:
+		if (data[0] != NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION) {
+			LOG_ERR("Cannot parse schema version: %d", data[0]);
+			return -EBADMSG;
+		}
 
-	__ASSERT(version == NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION,
-		 "Cannot parse schema version: %d", version);
+		parse_state_set(PARSE_ARRAY_HEADER);
+		return 0;
+	case PARSE_ARRAY_HEADER:
+		parser.type = (enum nrf_cloud_agps_type)
+			data[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET];
+		parser.elements_left =
+			sys_get_le16(&data[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET]);
+
+		if (element_size_get(parser.type) == 0) {
+			LOG_DBG("Unhandled A-GPS data type: %d", parser.type);
+			parse_state_set(PARSE_DONE);
+		} else if (parser.elements_left > 0) {
+			parse_state_set(PARSE_ELEMENT);
+		}
 
-	LOG_DBG("Receievd AGPS data. Schema version: %d, length: %d",
-		version, buf_len);
+		return 0;
+	case PARSE_ELEMENT:
+		err = element_process(data);
+		if (err) {
+			LOG_ERR("Failed to send data to modem, error: %d", err);
+			return err;
+		}
+
+		if (--parser.elements_left == 0) {
+			parse_state_set(PARSE_ARRAY_HEADER);
+		}
+
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
 
+static int process_start(const int *socket)
+{
 	if (socket) {
-		LOG_DBG("Using user-provided socket, fd %d", fd);
+		LOG_DBG("Using user-provided socket, fd %d", *socket);
 
 		gps_dev = NULL;
 		fd = *socket;
@@ -518,41 +632,127 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
 		}
 	}
 
-	while (parsed_len < buf_len) {
-		size_t element_size =
-			get_next_agps_element(&element, &buf[parsed_len]);
+	memset(&parser, 0, sizeof(parser));
+	parse_state_set(PARSE_VERSION);
 
-		if (element_size == 0) {
-			LOG_DBG("Parsing finished\n");
-			break;
+	return 0;
+}
+
+static int process_end(void)
+{
+	struct nrf_cloud_apgs_element element = {
+		.type = NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK,
+		.time_and_tow = &parser.sys_time
+	};
+	int err = 0;
+
+	if ((parser.state != PARSE_DONE) &&
+	    ((parser.state != PARSE_ARRAY_HEADER) || (parser.item_len > 0))) {
+		LOG_ERR("A-GPS data incomplete");
+		err = -EBADMSG;
+	} else if (parser.sys_time_received) {
+		err = agps_send_to_modem(&element);
+		if (err) {
+			LOG_ERR("Failed to send data to modem, error: %d", err);
 		}
+	}
+
+	parse_state_set(PARSE_IDLE);
+
+	return err;
+}
+
+int nrf_cloud_agps_process_chunk(const char *buf, size_t buf_len,
+				 size_t offset, size_t total_len,
+				 const int *socket)
+{
+	int err;
+	size_t chunk_end = offset + buf_len;
+
+	if ((buf == NULL && buf_len > 0) || (chunk_end > total_len)) {
+		return -EINVAL;
+	}
 
-		parsed_len += element_size;
+	if (offset == 0) {
+		LOG_DBG("Received A-GPS data, length: %d", total_len);
 
-		LOG_DBG("Parsed_len: %d\n", parsed_len);
+		err = process_start(socket);
+		if (err) {
+			return err;
+		}
+	} else if (parser.state == PARSE_FAILED) {
+		if (chunk_end == total_len) {
+			parse_state_set(PARSE_IDLE);
+		}
 
-		if (element.type == NRF_CLOUD_AGPS_GPS_TOWS) {
-			memcpy(&sys_time.sv_tow[element.tow->sv_id - 1],
-				element.tow,
-				sizeof(sys_time.sv_tow[0]));
+		return -ECANCELED;
+	} else if ((parser.state == PARSE_IDLE) || (offset != parser.offset)) {
+		LOG_DBG("Unexpected A-GPS data at offset %d", offset);
+		return -EINVAL;
+	}
 
-			LOG_DBG("TOW %d copied", element.tow->sv_id - 1);
+	while ((buf_len > 0) && (parser.state != PARSE_DONE)) {
+		const char *item = NULL;
+		size_t used;
+
+		if ((parser.item_len == 0) && (buf_len >= parser.item_size)) {
+			/* Parsed in place. */
+			item = buf;
+			used = parser.item_size;
+		} else {
+			used = MIN(buf_len, parser.item_size - parser.item_len);
+			memcpy((uint8_t *)&parser.item + parser.item_len, buf,
+			       used);
+			parser.item_len += used;
+
+			if (parser.item_len == parser.item_size) {
+				item = (const char *)&parser.item;
+				parser.item_len = 0;
+			}
+		}
 
-			continue;
-		} else if (element.type == NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK) {
-			memcpy(&sys_time, element.time_and_tow,
-				sizeof(sys_time) - sizeof(sys_time.sv_tow));
+		buf += used;
+		buf_len -= used;
 
-			LOG_DBG("TOWs copied, bitmask: 0x%08x",
-				element.time_and_tow->sv_mask);
+		if (item == NULL) {
+			/* Rest of the item is in the next chunk. */
+			break;
 		}
 
-		err = agps_send_to_modem(&element);
+		err = item_process(item);
 		if (err) {
-			LOG_ERR("Failed to send data to modem, error: %d", err);
+			parse_state_set((chunk_end == total_len) ?
+					PARSE_IDLE : PARSE_FAILED);
 			return err;
 		}
 	}
 
+	parser.offset = chunk_end;
+
+	if (chunk_end == total_len) {
+		return process_end();
+	}
+
 	return 0;
 }
+
+void nrf_cloud_agps_process_abort(void)
+{
+	if (parser.state != PARSE_IDLE) {
+		LOG_WRN("A-GPS data incomplete, processing aborted");
+		parse_state_set(PARSE_IDLE);
+	}
+}
+
+bool nrf_cloud_agps_is_agps_data(const char *buf, size_t buf_len)
+{
+	return (buf != NULL) &&
+	       (buf_len >= NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_SIZE) &&
+	       (buf[NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_INDEX] ==
+		NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION);
+}
+
+int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
+{
+	return nrf_cloud_agps_process_chunk(buf, buf_len, 0, buf_len, socket);
+}
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <zephyr.h>
 #include <logging/log.h>
+#include <json_tok.h>
 #include "cJSON.h"
 #include "cJSON_os.h"
 
@@ -65,51 +66,54 @@ static int json_add_null(cJSON *parent, const char *str)
 	return json_add_obj(parent, str, json_null);
 }
 
-static cJSON *json_object_decode(cJSON *obj, const char *str)
-{
-	return obj ? cJSON_GetObjectItem(obj, str) : NULL;
-}
+/* Received documents are tokenized into a static array, they are decoded
+ * from the nRF Cloud thread only.
+ */
+static struct json_tok toks[CONFIG_NRF_CLOUD_JSON_TOKENS];
 
-static int json_decode_and_alloc(cJSON *obj, struct nrf_cloud_data *data)
+static int json_decode_and_alloc(const struct json_tok_doc *doc, int tok,
+				 struct nrf_cloud_data *data)
 {
-	if (obj == NULL || (obj->type != cJSON_String)) {
+	int len = json_tok_str_copy(doc, tok, NULL, 0);
+
+	if (len < 0) {
 		data->ptr = NULL;
 		return -ENOENT;
 	}
 
-	data->len = strlen(obj->valuestring);
+	data->len = len;
 	data->ptr = nrf_cloud_malloc(data->len + 1);
 
 	if (data->ptr == NULL) {
 		return -ENOMEM;
 	}
 
-	strncpy((char *)data->ptr, obj->valuestring, data->len + 1);
+	(void)json_tok_str_copy(doc, tok, (char *)data->ptr, data->len + 1);
 
 	return 0;
 }
 
-static bool compare(const char *s1, const char *s2)
+static bool compare(const struct json_tok_doc *doc, int tok, const char *s2)
 {
-	return !strncmp(s1, s2, strlen(s2));
+	size_t len = strlen(s2);
+
+	return tok >= 0 && json_tok_type_get(doc, tok) == JSON_TOK_STRING &&
+	       doc->toks[tok].len >= len &&
+	       !strncmp(&doc->json[doc->toks[tok].start], s2, len);
 }
 
-static void nrf_cloud_decode_desired_obj(cJSON *const root_obj,
-					 cJSON **desired_obj)
+static int nrf_cloud_decode_desired_obj(const struct json_tok_doc *doc)
 {
-	cJSON *state_obj;
-
-	if ((root_obj != NULL) && (desired_obj != NULL)) {
-		/* On initial pairing, a shadow delta event is sent */
-		/* which does not include the "desired" JSON key, */
-		/* "state" is used instead */
-		state_obj = json_object_decode(root_obj, "state");
-		if (state_obj == NULL) {
-			*desired_obj = json_object_decode(root_obj, "desired");
-		} else {
-			*desired_obj = state_obj;
-		}
+	/* On initial pairing, a shadow delta event is sent */
+	/* which does not include the "desired" JSON key, */
+	/* "state" is used instead */
+	int desired = json_tok_find(doc, 0, "state");
+
+	if (desired < 0) {
+		desired = json_tok_find(doc, 0, "desired");
 	}
+
+	return desired;
 }
 
 int nrf_codec_init(void)
@@ -205,54 +209,44 @@ int nrf_cloud_decode_requested_state(const struct nrf_cloud_data *input,
 	__ASSERT_NO_MSG(input->ptr != NULL);
 	__ASSERT_NO_MSG(input->len != 0);
 
-	cJSON *root_obj;
-	cJSON *desired_obj;
-	cJSON *pairing_obj;
-	cJSON *pairing_state_obj;
-	cJSON *topic_prefix_obj;
+	struct json_tok_doc doc;
+	int desired;
+	int err;
+
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
 
-	root_obj = cJSON_Parse(input->ptr);
-	if (root_obj == NULL) {
-		LOG_ERR("cJSON_Parse failed: %s",
-			log_strdup((char *)input->ptr));
+	err = json_tok_parse(&doc, input->ptr, input->len);
+	if (err) {
+		LOG_ERR("JSON parsing failed, error: %d", err);
 		return -ENOENT;
 	}
 
-	nrf_cloud_decode_desired_obj(root_obj, &desired_obj);
+	desired = nrf_cloud_decode_desired_obj(&doc);
 
-	topic_prefix_obj =
-		json_object_decode(desired_obj, "nrfcloud_mqtt_topic_prefix");
-	if (topic_prefix_obj != NULL) {
+	if (json_tok_find(&doc, desired, "nrfcloud_mqtt_topic_prefix") >= 0) {
 		(*requested_state) = STATE_UA_PIN_COMPLETE;
-		cJSON_Delete(root_obj);
 		return 0;
 	}
 
-	pairing_obj = json_object_decode(desired_obj, "pairing");
-	pairing_state_obj = json_object_decode(pairing_obj, "state");
+	int pairing_state = json_tok_find(&doc, desired, "pairing.state");
 
-	if (!pairing_state_obj || pairing_state_obj->type != cJSON_String) {
-		if (cJSON_HasObjectItem(desired_obj, "config") == false) {
+	if (pairing_state < 0 ||
+	    json_tok_type_get(&doc, pairing_state) != JSON_TOK_STRING) {
+		if (json_tok_find(&doc, desired, "config") < 0) {
 			LOG_WRN("Unhandled data received from nRF Cloud.");
 			LOG_INF("Ensure device firmware is up to date.");
 			LOG_INF("Delete and re-add device to nRF Cloud if problem persists.");
 		}
-		cJSON_Delete(root_obj);
 		return -ENOENT;
 	}
 
-	const char *state_str = pairing_state_obj->valuestring;
-
-	if (compare(state_str, DUA_PIN_STR)) {
+	if (compare(&doc, pairing_state, DUA_PIN_STR)) {
 		(*requested_state) = STATE_UA_PIN_WAIT;
 	} else {
 		LOG_ERR("Deprecated state. Delete device from nRF Cloud and update device with JITP certificates.");
-		cJSON_Delete(root_obj);
 		return -ENOTSUP;
 	}
 
-	cJSON_Delete(root_obj);
-
 	return 0;
 }
 
@@ -263,77 +257,58 @@ int nrf_cloud_encode_config_response(struct nrf_cloud_data const *const input,
 	__ASSERT_NO_MSG(output != NULL);
 	__ASSERT_NO_MSG(input != NULL);
 
-	char *buffer = NULL;
-	cJSON *root_obj = NULL;
-	cJSON *desired_obj = NULL;
-	cJSON *null_obj = NULL;
-	cJSON *reported_obj = NULL;
-	cJSON *state_obj = NULL;
-	cJSON *config_obj = NULL;
-	cJSON *input_obj = input ? cJSON_Parse(input->ptr) : NULL;
+	static const char fmt[] =
+		"{\"state\":{\"reported\":{\"config\":%.*s},"
+		"\"desired\":{\"config\":null}}}";
+	struct json_tok_doc doc;
+	const struct json_tok *config_tok;
+	const char *config_str;
+	size_t config_len;
+	char *buffer;
+	int state;
+	int config;
+
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
 
-	if (input_obj == NULL) {
+	if (input == NULL || input->ptr == NULL ||
+	    json_tok_parse(&doc, input->ptr, input->len)) {
 		return -ESRCH; /* invalid input or no JSON parsed */
 	}
 
 	/* A delta update will have the config inside of state */
-	state_obj = cJSON_DetachItemFromObject(input_obj, "state");
-	config_obj = cJSON_DetachItemFromObject(
-		state_obj ? state_obj : input_obj, "config");
-	cJSON_Delete(input_obj);
+	state = json_tok_find(&doc, 0, "state");
+	config = json_tok_find(&doc, (state >= 0) ? state : 0, "config");
 
 	if (has_config) {
-		*has_config = (config_obj != NULL);
+		*has_config = (config >= 0);
 	}
 
 	/* If this is not a delta update, no response data is required */
-	if ((state_obj == NULL) || (config_obj == NULL)) {
-		cJSON_Delete(state_obj);
-		cJSON_Delete(config_obj);
-
+	if ((state < 0) || (config < 0)) {
 		output->ptr = NULL;
 		output->len = 0;
 		return 0;
 	}
 
-	/* Prepare JSON response for the delta */
-	root_obj = cJSON_CreateObject();
-	desired_obj = cJSON_CreateObject();
-	null_obj = cJSON_CreateNull();
-	reported_obj = cJSON_CreateObject();
+	/* Report the delta config as received, and clear the desired one */
+	config_tok = &doc.toks[config];
+	config_str = &doc.json[config_tok->start];
+	config_len = config_tok->len;
 
-	if ((root_obj == NULL) || (desired_obj == NULL) || (null_obj == NULL) ||
-		(reported_obj == NULL)) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(desired_obj);
-		cJSON_Delete(null_obj);
-		cJSON_Delete(reported_obj);
-		cJSON_Delete(config_obj);
-		cJSON_Delete(state_obj);
-		return -ENOMEM;
+	if (json_tok_type_get(&doc, config) == JSON_TOK_STRING) {
+		config_str--;
+		config_len += 2;
 	}
 
-	/* Add delta config to reported */
-	(void)json_add_obj(reported_obj, "config", config_obj);
-	(void)json_add_obj(root_obj, "reported", reported_obj);
-
-	/* Add a null config to desired */
-	(void)json_add_obj(desired_obj, "config", null_obj);
-	(void)json_add_obj(root_obj, "desired", desired_obj);
-
-	/* Cleanup received state obj and re-use for the response */
-	cJSON_Delete(state_obj);
-	state_obj = cJSON_CreateObject();
-	(void)json_add_obj(state_obj, "state", root_obj);
-	buffer = cJSON_PrintUnformatted(state_obj);
-	cJSON_Delete(state_obj);
-
+	output->len = sizeof(fmt) - sizeof("%.*s") + config_len;
+	buffer = nrf_cloud_malloc(output->len + 1);
 	if (buffer == NULL) {
 		return -ENOMEM;
 	}
 
+	(void)snprintf(buffer, output->len + 1, fmt, (int)config_len,
+		       config_str);
 	output->ptr = buffer;
-	output->len = strlen(buffer);
 
 	return 0;
 }
@@ -462,65 +437,46 @@ int nrf_cloud_decode_data_endpoint(const struct nrf_cloud_data *input,
 	__ASSERT_NO_MSG(tx_endpoint != NULL);
 	__ASSERT_NO_MSG(rx_endpoint != NULL);
 
+	struct json_tok_doc doc;
 	int err;
-	cJSON *root_obj;
-	cJSON *m_endpoint_obj = NULL;
-	cJSON *desired_obj = NULL;
+	int desired;
+	int m_endpoint_tok = -ENOENT;
 
-	root_obj = cJSON_Parse(input->ptr);
-	if (root_obj == NULL) {
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
+
+	if (json_tok_parse(&doc, input->ptr, input->len)) {
 		return -ENOENT;
 	}
 
-	nrf_cloud_decode_desired_obj(root_obj, &desired_obj);
+	desired = nrf_cloud_decode_desired_obj(&doc);
 
 	if (m_endpoint != NULL) {
-		m_endpoint_obj = json_object_decode(
-			desired_obj, "nrfcloud_mqtt_topic_prefix");
-	}
-
-	cJSON *pairing_obj = json_object_decode(desired_obj, "pairing");
-	cJSON *pairing_state_obj = json_object_decode(pairing_obj, "state");
-	cJSON *topic_obj = json_object_decode(pairing_obj, "topics");
-
-	if ((pairing_state_obj == NULL) || (topic_obj == NULL) ||
-	    (pairing_state_obj->type != cJSON_String)) {
-		cJSON_Delete(root_obj);
-		return -ENOENT;
+		m_endpoint_tok = json_tok_find(&doc, desired,
+					       "nrfcloud_mqtt_topic_prefix");
 	}
 
-	const char *state_str = pairing_state_obj->valuestring;
+	int pairing_state = json_tok_find(&doc, desired, "pairing.state");
+	int topics = json_tok_find(&doc, desired, "pairing.topics");
 
-	if (!compare(state_str, PAIRED_STR)) {
-		cJSON_Delete(root_obj);
+	if ((topics < 0) || !compare(&doc, pairing_state, PAIRED_STR)) {
 		return -ENOENT;
 	}
 
-	if (m_endpoint_obj != NULL) {
-		err = json_decode_and_alloc(m_endpoint_obj, m_endpoint);
+	if (m_endpoint_tok >= 0) {
+		err = json_decode_and_alloc(&doc, m_endpoint_tok, m_endpoint);
 		if (err) {
-			cJSON_Delete(root_obj);
 			return err;
 		}
 	}
 
-	cJSON *tx_obj = json_object_decode(topic_obj, "d2c");
-
-	err = json_decode_and_alloc(tx_obj, tx_endpoint);
-	if (err) {
-		cJSON_Delete(root_obj);
-		return err;
-	}
-
-	cJSON *rx_obj = json_object_decode(topic_obj, "c2d");
-
-	err = json_decode_and_alloc(rx_obj, rx_endpoint);
+	err = json_decode_and_alloc(&doc, json_tok_find(&doc, topics, "d2c"),
+				    tx_endpoint);
 	if (err) {
-		cJSON_Delete(root_obj);
 		return err;
 	}
 
-	cJSON_Delete(root_obj);
+	err = json_decode_and_alloc(&doc, json_tok_find(&doc, topics, "c2d"),
+				    rx_endpoint);
 
 	return err;
 }
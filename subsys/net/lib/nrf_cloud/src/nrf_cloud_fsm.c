@@ -39,6 +39,7 @@ static int cc_tx_ack_in_state_requested_handler(const struct nct_evt *nct_evt);
 static int cc_disconnection_handler(const struct nct_evt *nct_evt);
 static int dc_connection_handler(const struct nct_evt *nct_evt);
 static int dc_rx_data_handler(const struct nct_evt *nct_evt);
+static int dc_rx_data_chunk_handler(const struct nct_evt *nct_evt);
 static int dc_tx_ack_handler(const struct nct_evt *nct_evt);
 static int dc_disconnection_handler(const struct nct_evt *nct_evt);
 static int cc_rx_data_handler(const struct nct_evt *nct_evt);
@@ -94,6 +95,7 @@ static const fsm_transition dc_connected_fsm_transition[NCT_EVT_TOTAL] = {
 	[NCT_EVT_CC_RX_DATA] = cc_rx_data_handler,
 	[NCT_EVT_CC_TX_DATA_ACK] = cc_tx_ack_handler,
 	[NCT_EVT_DC_RX_DATA] = dc_rx_data_handler,
+	[NCT_EVT_DC_RX_DATA_CHUNK] = dc_rx_data_chunk_handler,
 	[NCT_EVT_DC_TX_DATA_ACK] = dc_tx_ack_handler,
 	[NCT_EVT_CC_DISCONNECTED] = cc_disconnection_handler,
 	[NCT_EVT_DC_DISCONNECTED] = dc_disconnection_handler,
@@ -499,6 +501,20 @@ static int dc_rx_data_handler(const struct nct_evt *nct_evt)
 	return 0;
 }
 
+static int dc_rx_data_chunk_handler(const struct nct_evt *nct_evt)
+{
+	struct nrf_cloud_evt cloud_evt = {
+		.type = NRF_CLOUD_EVT_RX_DATA_CHUNK,
+		.data = nct_evt->param.dc->data,
+		.topic = nct_evt->param.dc->topic,
+		.chunk = nct_evt->param.dc->chunk,
+	};
+
+	nfsm_set_current_state_and_notify(nfsm_get_current_state(), &cloud_evt);
+
+	return 0;
+}
+
 static int dc_tx_ack_handler(const struct nct_evt *nct_evt)
 {
 	return 0; /* Nothing to do */
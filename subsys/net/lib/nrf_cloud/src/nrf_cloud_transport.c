@@ -18,6 +18,9 @@
 
 #if defined(CONFIG_BSD_LIBRARY)
 #include <nrf_socket.h>
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+#include <modem/nrf91_sockets.h>
+#endif
 #endif
 
 #if defined(CONFIG_AWS_FOTA)
@@ -682,6 +685,52 @@ static int publish_get_payload(struct mqtt_client *client, size_t length)
 	return mqtt_readall_publish_payload(client, nct.payload_buf, length);
 }
 
+/* Read a data channel message larger than the payload buffer from the socket,
+ * and notify it one buffer at a time.
+ */
+static int publish_stream_payload(struct mqtt_client *client,
+				  const struct mqtt_publish_param *p)
+{
+	int err;
+	struct nct_dc_data dc = {
+		.id = p->message_id,
+		.data.ptr = nct.payload_buf,
+		.topic.len = p->message.topic.topic.size,
+		.topic.ptr = p->message.topic.topic.utf8,
+		.chunk.total_len = p->message.payload.len,
+	};
+	struct nct_evt evt = {
+		.type = NCT_EVT_DC_RX_DATA_CHUNK,
+		.param.dc = &dc,
+	};
+
+	while (dc.chunk.offset < dc.chunk.total_len) {
+		dc.data.len = MIN(dc.chunk.total_len - dc.chunk.offset,
+				  sizeof(nct.payload_buf));
+
+		err = mqtt_readall_publish_payload(client, nct.payload_buf,
+						   dc.data.len);
+		if (err < 0) {
+			/* Let the application drop the chunks already
+			 * received.
+			 */
+			dc.data.len = 0;
+			dc.chunk.err = err;
+			(void)nct_input(&evt);
+			return err;
+		}
+
+		err = nct_input(&evt);
+		if (err != 0) {
+			LOG_ERR("nct_input: failed %d", err);
+		}
+
+		dc.chunk.offset += dc.data.len;
+	}
+
+	return 0;
+}
+
 /* Handle MQTT events. */
 static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 				 const struct mqtt_evt *_mqtt_evt)
@@ -721,13 +770,23 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 	}
 	case MQTT_EVT_PUBLISH: {
 		const struct mqtt_publish_param *p = &_mqtt_evt->param.publish;
+		bool cc_topic = control_channel_topic_match(NCT_RX_LIST,
+							    &p->message.topic,
+							    &cc.opcode);
+		bool stream = IS_ENABLED(CONFIG_NRF_CLOUD_MQTT_PAYLOAD_STREAM) &&
+			      !cc_topic &&
+			      (p->message.payload.len > sizeof(nct.payload_buf));
 
 		LOG_DBG("MQTT_EVT_PUBLISH: id = %d len = %d",
 			p->message_id,
 			p->message.payload.len);
 
-		int err = publish_get_payload(mqtt_client,
-					      p->message.payload.len);
+		if (stream) {
+			err = publish_stream_payload(mqtt_client, p);
+		} else {
+			err = publish_get_payload(mqtt_client,
+						  p->message.payload.len);
+		}
 
 		if (err < 0) {
 			LOG_ERR("publish_get_payload: failed %d", err);
@@ -739,8 +798,7 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 		/* If the data arrives on one of the subscribed control channel
 		 * topic. Then we notify the same.
 		 */
-		if (control_channel_topic_match(NCT_RX_LIST, &p->message.topic,
-						&cc.opcode)) {
+		if (cc_topic) {
 			cc.id = p->message_id;
 			cc.data.ptr = nct.payload_buf;
 			cc.data.len = p->message.payload.len;
@@ -750,8 +808,10 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 			evt.type = NCT_EVT_CC_RX_DATA;
 			evt.param.cc = &cc;
 			event_notify = true;
-		} else {
-			/* Try to match it with one of the data topics. */
+		} else if (!stream) {
+			/* Try to match it with one of the data topics. Large
+			 * messages were already notified in chunks.
+			 */
 			dc.id = p->message_id;
 			dc.data.ptr = nct.payload_buf;
 			dc.data.len = p->message.payload.len;
@@ -929,6 +989,15 @@ int nct_connect(void)
 	/* Free the address. */
 	freeaddrinfo(result);
 
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+	/* Resolve the broker again on the next connection, in case the cached
+	 * address is no longer reachable.
+	 */
+	if (err) {
+		nrf91_dns_cache_invalidate(NRF_CLOUD_HOSTNAME);
+	}
+#endif
+
 	return err;
 }
 #endif /* defined(CONFIG_NRF_CLOUD_STATIC_IPV4) */
@@ -10,14 +10,44 @@
 #include <sys/util.h>
 #include <sys/byteorder.h>
 #include <zephyr.h>
-#include <SEGGER_RTT.h>
 #include <profiler.h>
 #include <string.h>
 
+#include "profiler_nordic_transport.h"
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+#include "profiler_nordic_ring_buf.h"
+
+#define THREAD_PERIOD_MS	CONFIG_PROFILER_NORDIC_DRAIN_PERIOD_MS
+#else
+#include <SEGGER_RTT.h>
+
+#define THREAD_PERIOD_MS	500
+#endif
+
+/* Record IDs used in the binary stream in addition to event type IDs. */
+#define RECORD_ID_HEADER	0xFD
+#define RECORD_ID_DESCR		0xFE
+#define RECORD_ID_OVERFLOW	0xFF
+
+#define STREAM_VERSION		1
+
+#ifdef CONFIG_ARCH_POSIX
+/* No CMSIS on POSIX architecture. */
+#define __DMB() __sync_synchronize()
+#endif
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+BUILD_ASSERT(CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS <= RECORD_ID_HEADER,
+	     "Event type IDs collide with stream record IDs");
+BUILD_ASSERT(CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS < UINT8_MAX,
+	     "Event type description does not fit in a single record");
+#endif
+
 
 /* By default, when there is no shell, all events are profiled. */
 #ifndef CONFIG_SHELL
-uint32_t profiler_enabled_events = 0xffffffff;
+ATOMIC_DEFINE(profiler_enabled_events, CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 #endif
 
 
@@ -46,16 +76,77 @@ static char *arg_types_encodings[] = {
 
 uint8_t profiler_num_events;
 
-static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
-static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
-static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
-
 static k_tid_t protocol_thread_id;
 
 static K_THREAD_STACK_DEFINE(profiler_nordic_stack,
 			     CONFIG_PROFILER_NORDIC_STACK_SIZE);
 static struct k_thread profiler_nordic_thread;
 
+static size_t encode_varint(uint8_t *dst, uint32_t data)
+{
+	size_t len = 0;
+
+	while (data > 0x7F) {
+		dst[len++] = (data & 0x7F) | 0x80;
+		data >>= 7;
+	}
+	dst[len++] = data;
+
+	return len;
+}
+
+static void send_record(uint8_t id, const void *data, size_t len)
+{
+	__ASSERT_NO_MSG(len < UINT8_MAX);
+	uint8_t hdr[] = {len + 1, id};
+
+	profiler_transport_write(hdr, sizeof(hdr));
+	profiler_transport_write(data, len);
+}
+
+static void send_stream_header(void)
+{
+	uint8_t data[sizeof(uint8_t) + sizeof(uint32_t)];
+
+	data[0] = STREAM_VERSION;
+	sys_put_le32(sys_clock_hw_cycles_per_sec(), &data[1]);
+	send_record(RECORD_ID_HEADER, data, sizeof(data));
+}
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+static void ring_buf_drain(void)
+{
+	static uint8_t drain_buf[UINT8_MAX + 1];
+	size_t len;
+
+	while ((len = profiler_ring_buf_get(drain_buf, sizeof(drain_buf)))) {
+		profiler_transport_write(drain_buf, len);
+	}
+
+	uint32_t dropped = profiler_ring_buf_dropped_get();
+
+	if (dropped > 0) {
+		uint8_t data[5];
+
+		send_record(RECORD_ID_OVERFLOW, data,
+			    encode_varint(data, dropped));
+	}
+}
+
+static void send_system_description(void)
+{
+	uint8_t ne = profiler_num_events;
+
+	__DMB();
+
+	/* Events logged so far must precede the descriptions. */
+	ring_buf_drain();
+
+	for (size_t t = 0; t < ne; t++) {
+		send_record(RECORD_ID_DESCR, descr[t], strlen(descr[t]));
+	}
+}
+#else
 static void send_system_description(void)
 {
 	size_t num_bytes_send;
@@ -86,6 +177,17 @@ static void send_system_description(void)
 			  1);
 	__ASSERT_NO_MSG(num_bytes_send > 0);
 }
+#endif /* CONFIG_PROFILER_NORDIC_RING_BUFFER */
+
+static void start_logging(void)
+{
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_RING_BUFFER) &&
+	    !sending_events) {
+		send_stream_header();
+		send_system_description();
+	}
+	sending_events = true;
+}
 
 static void profiler_nordic_thread_fn(void)
 {
@@ -93,13 +195,11 @@ static void profiler_nordic_thread_fn(void)
 		uint8_t read_data;
 		enum nordic_command command;
 
-		if (SEGGER_RTT_Read(
-		     CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		     &read_data, sizeof(read_data))) {
+		if (!profiler_transport_read_cmd(&read_data)) {
 			command = (enum nordic_command)read_data;
 			switch (command) {
 			case NORDIC_COMMAND_START:
-				sending_events = true;
+				start_logging();
 				break;
 			case NORDIC_COMMAND_STOP:
 				sending_events = false;
@@ -112,42 +212,34 @@ static void profiler_nordic_thread_fn(void)
 				break;
 			}
 		}
-		k_sleep(K_MSEC(500));
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+		ring_buf_drain();
+#endif
+		k_sleep(K_MSEC(THREAD_PERIOD_MS));
 	}
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+	ring_buf_drain();
+#endif
 	k_sem_give(&profiler_sem);
 }
 
 int profiler_init(void)
 {
+	int ret = profiler_transport_init();
+
+	if (ret) {
+		return ret;
+	}
+
 	protocol_running = true;
-	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_START_LOGGING_ON_SYSTEM_START)) {
-		sending_events = true;
+	/* Host cannot request logging if the transport does not support
+	 * commands.
+	 */
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_START_LOGGING_ON_SYSTEM_START) ||
+	    IS_ENABLED(CONFIG_PROFILER_NORDIC_TRANSPORT_FILE)) {
+		start_logging();
 	}
-	int ret;
-
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-		"Nordic profiler data",
-		buffer_data,
-		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-		"Nordic profiler info",
-		buffer_info,
-		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigDownBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		"Nordic profiler command",
-		buffer_commands,
-		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
 
 	protocol_thread_id =  k_thread_create(&profiler_nordic_thread,
 			profiler_nordic_stack,
@@ -180,6 +272,8 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	 */
 	k_sched_lock();
 	uint8_t ne = profiler_num_events;
+
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 	size_t temp = snprintf(descr[ne],
 			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
 			"%s,%d", name, ne);
@@ -212,25 +306,55 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	 */
 	__DMB();
 	profiler_num_events++;
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+	/* Event types registered while logging are described in the stream. */
+	if (sending_events) {
+		uint8_t record[CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS + 1];
+
+		record[0] = RECORD_ID_DESCR;
+		memcpy(&record[1], descr[ne], pos);
+		profiler_ring_buf_put(record, pos + 1);
+	}
+#endif
+
+	if (!IS_ENABLED(CONFIG_SHELL)) {
+		atomic_set_bit(profiler_enabled_events, ne);
+	}
+
 	k_sched_unlock();
 
 	return ne;
 }
 
+static void log_encode_le32(struct log_event_buf *buf, uint32_t data)
+{
+	__ASSERT_NO_MSG(buf->payload - buf->payload_start + sizeof(data)
+			 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+	sys_put_le32(data, buf->payload);
+	buf->payload += sizeof(data);
+}
+
 void profiler_log_start(struct log_event_buf *buf)
 {
 	/* Adding one to pointer to make space for event type ID */
 	__ASSERT_NO_MSG(sizeof(uint8_t) <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
 	buf->payload = buf->payload_start + sizeof(uint8_t);
-	profiler_log_encode_u32(buf, k_cycle_get_32());
+	log_encode_le32(buf, k_cycle_get_32());
 }
 
 void profiler_log_encode_u32(struct log_event_buf *buf, uint32_t data)
 {
-	__ASSERT_NO_MSG(buf->payload - buf->payload_start + sizeof(data)
-			 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
-	sys_put_le32(data, buf->payload);
-	buf->payload += sizeof(data);
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_RING_BUFFER)) {
+		/* Arguments are stored as variable-length integers (7 bits
+		 * per byte, least significant group first).
+		 */
+		__ASSERT_NO_MSG(buf->payload - buf->payload_start + 5
+				 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+		buf->payload += encode_varint(buf->payload, data);
+	} else {
+		log_encode_le32(buf, data);
+	}
 }
 
 void profiler_log_add_mem_address(struct log_event_buf *buf,
@@ -246,14 +370,17 @@ void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
 		uint8_t type_id = event_type_id & UCHAR_MAX;
 
 		buf->payload_start[0] = type_id;
-		int key = irq_lock();
-
-		uint8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
-				CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-				buf->payload_start,
-				buf->payload - buf->payload_start);
-		ARG_UNUSED(num_bytes_send);
-		irq_unlock(key);
-		__ASSERT_NO_MSG(num_bytes_send > 0);
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+		if (profiler_ring_buf_put(buf->payload_start,
+				buf->payload - buf->payload_start) &&
+		    (profiler_ring_buf_used_get() >=
+		     CONFIG_PROFILER_NORDIC_RING_BUFFER_SIZE / 2)) {
+			k_wakeup(protocol_thread_id);
+		}
+#else
+		profiler_transport_write(buf->payload_start,
+					 buf->payload - buf->payload_start);
+#endif
 	}
 }
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+#include <sys/__assert.h>
+
+#include "profiler_nordic_ring_buf.h"
+
+#define RING_BUF_SIZE	CONFIG_PROFILER_NORDIC_RING_BUFFER_SIZE
+#define RING_BUF_MASK	(RING_BUF_SIZE - 1)
+
+BUILD_ASSERT((RING_BUF_SIZE & RING_BUF_MASK) == 0,
+	     "Ring buffer size must be a power of two");
+BUILD_ASSERT(RING_BUF_SIZE > UINT8_MAX + 1,
+	     "Ring buffer must fit the longest record");
+
+/* Head and tail are free running counters. Producers reserve space by moving
+ * the head. The consumer releases space by moving the tail.
+ */
+static uint8_t buf[RING_BUF_SIZE];
+static atomic_t head;
+static atomic_t tail;
+static atomic_t dropped_cnt;
+
+
+bool profiler_ring_buf_put(const uint8_t *data, size_t len)
+{
+	__ASSERT_NO_MSG((len > 0) && (len <= UINT8_MAX));
+
+	atomic_val_t h;
+
+	do {
+		h = atomic_get(&head);
+		atomic_val_t t = atomic_get(&tail);
+
+		if (RING_BUF_SIZE - ((uint32_t)h - (uint32_t)t) < len + 1) {
+			atomic_inc(&dropped_cnt);
+			return false;
+		}
+	} while (!atomic_cas(&head, h, (uint32_t)h + len + 1));
+
+	for (size_t i = 0; i < len; i++) {
+		buf[((uint32_t)h + 1 + i) & RING_BUF_MASK] = data[i];
+	}
+
+	/* Length is stored last to commit the record. */
+	__atomic_store_n(&buf[h & RING_BUF_MASK], (uint8_t)len,
+			 __ATOMIC_RELEASE);
+
+	return true;
+}
+
+size_t profiler_ring_buf_get(uint8_t *data, size_t size)
+{
+	atomic_val_t t = atomic_get(&tail);
+	atomic_val_t h = atomic_get(&head);
+	size_t pos = 0;
+
+	while (t != h) {
+		uint8_t len = __atomic_load_n(&buf[t & RING_BUF_MASK],
+					      __ATOMIC_ACQUIRE);
+
+		/* Record reserved, but not yet committed. */
+		if ((len == 0) || (pos + len + 1 > size)) {
+			break;
+		}
+
+		/* Record is cleared before the space is released to producers,
+		 * so that no stale data is taken as a committed length.
+		 */
+		for (size_t i = 0; i <= len; i++) {
+			uint8_t *b = &buf[((uint32_t)t + i) & RING_BUF_MASK];
+
+			data[pos++] = *b;
+			*b = 0;
+		}
+
+		t = (uint32_t)t + len + 1;
+	}
+
+	atomic_set(&tail, t);
+
+	return pos;
+}
+
+size_t profiler_ring_buf_used_get(void)
+{
+	return (uint32_t)atomic_get(&head) - (uint32_t)atomic_get(&tail);
+}
+
+uint32_t profiler_ring_buf_dropped_get(void)
+{
+	return atomic_set(&dropped_cnt, 0);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _PROFILER_NORDIC_RING_BUF_H_
+#define _PROFILER_NORDIC_RING_BUF_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lock-free multiple producer, single consumer ring buffer of binary records.
+ *
+ * Every record is stored as a length byte followed by the record data.
+ * The length byte is written last and signals that the record is complete.
+ */
+
+/** @brief Store a record in the ring buffer.
+ *
+ * The function can be called from any context, including interrupts.
+ *
+ * @param data Record data.
+ * @param len Length of the record data (1 - 255 bytes).
+ *
+ * @retval true If the record was stored.
+ * @retval false If there was no space and the record was dropped.
+ */
+bool profiler_ring_buf_put(const uint8_t *data, size_t len);
+
+/** @brief Fetch complete records from the ring buffer.
+ *
+ * Records are copied together with their length bytes. A record is never
+ * split between two calls. Only a single thread can fetch records.
+ *
+ * @param data Destination buffer.
+ * @param size Size of the destination buffer.
+ *
+ * @return Number of bytes copied.
+ */
+size_t profiler_ring_buf_get(uint8_t *data, size_t size);
+
+/** @brief Get the number of bytes that are used in the ring buffer.
+ *
+ * @return Number of used bytes.
+ */
+size_t profiler_ring_buf_used_get(void);
+
+/** @brief Get and reset the number of dropped records.
+ *
+ * @return Number of records dropped since the last call.
+ */
+uint32_t profiler_ring_buf_dropped_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROFILER_NORDIC_RING_BUF_H_ */
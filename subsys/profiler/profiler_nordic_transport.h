@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _PROFILER_NORDIC_TRANSPORT_H_
+#define _PROFILER_NORDIC_TRANSPORT_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Initialize the transport used to exchange data with the host.
+ *
+ * @return 0 if the operation was successful. Otherwise, a (negative) error
+ *	   code is returned.
+ */
+int profiler_transport_init(void);
+
+/** @brief Send profiler data to the host.
+ *
+ * @param data Data to send.
+ * @param len Length of the data.
+ */
+void profiler_transport_write(const uint8_t *data, size_t len);
+
+/** @brief Read a command sent by the host.
+ *
+ * @param cmd Pointer to the received command.
+ *
+ * @retval 0 If a command was received.
+ * @retval -EAGAIN If no command is pending.
+ * @retval -ENOTSUP If the transport cannot receive commands.
+ */
+int profiler_transport_read_cmd(uint8_t *cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROFILER_NORDIC_TRANSPORT_H_ */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <zephyr.h>
+#include <errno.h>
+
+#include "profiler_nordic_transport.h"
+
+static FILE *file;
+
+
+int profiler_transport_init(void)
+{
+	file = fopen(CONFIG_PROFILER_NORDIC_FILE_PATH, "wb");
+	if (!file) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void profiler_transport_write(const uint8_t *data, size_t len)
+{
+	size_t written = fwrite(data, 1, len, file);
+
+	ARG_UNUSED(written);
+	__ASSERT_NO_MSG(written == len);
+	fflush(file);
+}
+
+int profiler_transport_read_cmd(uint8_t *cmd)
+{
+	return -ENOTSUP;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <device.h>
+#include <drivers/uart.h>
+
+#include "profiler_nordic_transport.h"
+
+static struct device *uart_dev;
+
+
+int profiler_transport_init(void)
+{
+	uart_dev = device_get_binding(CONFIG_PROFILER_NORDIC_UART_DEV_NAME);
+	if (!uart_dev) {
+		return -ENXIO;
+	}
+
+	return 0;
+}
+
+void profiler_transport_write(const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		uart_poll_out(uart_dev, data[i]);
+	}
+}
+
+int profiler_transport_read_cmd(uint8_t *cmd)
+{
+	if (uart_poll_in(uart_dev, cmd)) {
+		return -EAGAIN;
+	}
+
+	return 0;
+}
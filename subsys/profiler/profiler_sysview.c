@@ -11,7 +11,7 @@
 
 /* By default, when there is no shell, all events are profiled. */
 #ifndef CONFIG_SHELL
-uint32_t profiler_enabled_events = 0xffffffff;
+ATOMIC_DEFINE(profiler_enabled_events, CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 #endif
 
 static char descr[CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS]
@@ -89,6 +89,8 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	k_sched_lock();
 	uint32_t ne = events.NumEvents;
 
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
+
 	size_t temp = snprintf(descr[ne],
 			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
 			"%u %s", ne, name);
@@ -113,6 +115,11 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	__DMB();
 	events.NumEvents++;
 	profiler_num_events = events.NumEvents;
+
+	if (!IS_ENABLED(CONFIG_SHELL)) {
+		atomic_set_bit(profiler_enabled_events, ne);
+	}
+
 	k_sched_unlock();
 	return events.EventOffset + ne;
 }
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <cJSON.h>
+#include "cloud_codec.h"
+
+#include "benchmark.h"
+
+#define BENCHMARK_ROUNDS 1000
+#define HEAP_BLOCKS_MAX 32
+
+#define GPS_NMEA "$GPGGA,090749.00,6325.70852,N,01026.36103,E,1,06,1.62," \
+		 "37.8,M,40.1,M,,*65"
+
+static uint8_t buf[128];
+
+/* Heap usage of cJSON, tracked through its allocation hooks. */
+static struct {
+	void *ptr;
+	size_t size;
+} heap_blocks[HEAP_BLOCKS_MAX];
+static size_t heap_used;
+static size_t heap_peak;
+
+static void *malloc_hook(size_t size)
+{
+	void *ptr = k_malloc(size);
+
+	for (size_t i = 0; ptr && i < ARRAY_SIZE(heap_blocks); i++) {
+		if (heap_blocks[i].ptr == NULL) {
+			heap_blocks[i].ptr = ptr;
+			heap_blocks[i].size = size;
+			heap_used += size;
+			heap_peak = MAX(heap_peak, heap_used);
+			break;
+		}
+	}
+
+	return ptr;
+}
+
+static void free_hook(void *ptr)
+{
+	for (size_t i = 0; ptr && i < ARRAY_SIZE(heap_blocks); i++) {
+		if (heap_blocks[i].ptr == ptr) {
+			heap_used -= heap_blocks[i].size;
+			heap_blocks[i].ptr = NULL;
+			break;
+		}
+	}
+
+	k_free(ptr);
+}
+
+/* The JSON output is released with k_free, outside of the hooks. */
+static void json_release(struct cloud_msg *msg)
+{
+	free_hook(msg->buf);
+}
+
+static void test_cbor_encode_data(void)
+{
+	struct cloud_channel_data data = {
+		.type = CLOUD_CHANNEL_GPS,
+		.data.buf = GPS_NMEA,
+		.data.len = sizeof(GPS_NMEA) - 1,
+	};
+	struct cloud_msg msg;
+	const uint8_t *out;
+	int err;
+
+	err = cloud_encode_data_cbor(&data, CLOUD_CMD_GROUP_DATA, buf,
+				     sizeof(buf), &msg);
+	zassert_equal(err, 0, "Encoding failed: %d", err);
+	zassert_equal_ptr(msg.buf, buf, "Not encoded into the buffer");
+	zassert_equal(msg.len, 1 + 2 + 3 + data.data.len + 2,
+		      "Wrong length: %zu", msg.len);
+
+	out = (const uint8_t *)msg.buf;
+	zassert_equal(out[0], 0xa3, "Not a map of 3 items");
+	zassert_equal(out[1], CLOUD_CBOR_KEY_CHANNEL, "Wrong key");
+	zassert_equal(out[2], CLOUD_CHANNEL_GPS, "Wrong channel");
+	zassert_equal(out[3], CLOUD_CBOR_KEY_DATA, "Wrong key");
+	zassert_equal(out[4], 0x78, "Not a text string");
+	zassert_equal(out[5], data.data.len, "Wrong string length");
+	zassert_mem_equal(&out[6], GPS_NMEA, data.data.len, "Wrong data");
+	zassert_equal(out[msg.len - 2], CLOUD_CBOR_KEY_GROUP, "Wrong key");
+	zassert_equal(out[msg.len - 1], CLOUD_CMD_GROUP_DATA, "Wrong group");
+}
+
+static void test_cbor_encode_env(void)
+{
+	const uint8_t expected[] = {
+		0xa3,
+		CLOUD_CBOR_KEY_CHANNEL, CLOUD_CHANNEL_TEMP,
+		/* 23.5 as a single-precision float */
+		CLOUD_CBOR_KEY_DATA, 0xfa, 0x41, 0xbc, 0x00, 0x00,
+		CLOUD_CBOR_KEY_GROUP, CLOUD_CMD_GROUP_DATA,
+	};
+	env_sensor_data_t env = {
+		.type = ENV_SENSOR_TEMPERATURE,
+		.value = 23.5,
+	};
+	struct cloud_msg msg;
+	int err;
+
+	err = cloud_encode_env_sensors_data_cbor(&env, buf, sizeof(buf), &msg);
+	zassert_equal(err, 0, "Encoding failed: %d", err);
+	zassert_equal(msg.len, sizeof(expected), "Wrong length: %zu",
+		      msg.len);
+	zassert_mem_equal(msg.buf, expected, sizeof(expected), "Wrong data");
+}
+
+static void test_cbor_buffer_too_small(void)
+{
+	struct cloud_channel_data data = {
+		.type = CLOUD_CHANNEL_GPS,
+		.data.buf = GPS_NMEA,
+		.data.len = sizeof(GPS_NMEA) - 1,
+	};
+	env_sensor_data_t env = {
+		.type = ENV_SENSOR_HUMIDITY,
+		.value = 40.0,
+	};
+	struct cloud_msg msg;
+	int err;
+
+	err = cloud_encode_data_cbor(&data, CLOUD_CMD_GROUP_DATA, buf,
+				     data.data.len, &msg);
+	zassert_equal(err, -ENOMEM, "Wrong error: %d", err);
+
+	err = cloud_encode_env_sensors_data_cbor(&env, buf, 8, &msg);
+	zassert_equal(err, -ENOMEM, "Wrong error: %d", err);
+}
+
+static void test_cbor_invalid(void)
+{
+	struct cloud_channel_data data = {
+		.type = CLOUD_CHANNEL_BUTTON,
+		.data.buf = "1",
+		.data.len = 1,
+	};
+	env_sensor_data_t env = { .type = 10 };
+	struct cloud_msg msg;
+	int err;
+
+	err = cloud_encode_data_cbor(&data, CLOUD_CMD_GROUP__TOTAL, buf,
+				     sizeof(buf), &msg);
+	zassert_equal(err, -EINVAL, "Invalid group accepted");
+
+	data.data.len = 0;
+	err = cloud_encode_data_cbor(&data, CLOUD_CMD_GROUP_DATA, buf,
+				     sizeof(buf), &msg);
+	zassert_equal(err, -EINVAL, "Empty data accepted");
+
+	err = cloud_encode_env_sensors_data_cbor(&env, buf, sizeof(buf), &msg);
+	zassert_equal(err, -EINVAL, "Invalid sensor accepted");
+}
+
+static void test_cbor_enabled(void)
+{
+	zassert_true(cloud_encode_cbor_enabled(CLOUD_CHANNEL_GPS), NULL);
+	zassert_true(cloud_encode_cbor_enabled(CLOUD_CHANNEL_BUTTON), NULL);
+	zassert_true(cloud_encode_cbor_enabled(CLOUD_CHANNEL_LTE_LINK_RSRP),
+		     NULL);
+	zassert_false(cloud_encode_cbor_enabled(CLOUD_CHANNEL_TEMP), NULL);
+	zassert_false(cloud_encode_cbor_enabled(CLOUD_CHANNEL_FLIP), NULL);
+}
+
+static void benchmark(const char *name, const struct cloud_channel_data *data)
+{
+	struct cloud_msg msg;
+	size_t json_len;
+	size_t cbor_len;
+	uint32_t json_ns;
+	uint32_t cbor_ns;
+	uint64_t start;
+	int err;
+
+	heap_peak = 0;
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		err = cloud_encode_data(data, CLOUD_CMD_GROUP_DATA, &msg);
+		zassert_equal(err, 0, "JSON encoding failed: %d", err);
+		json_len = msg.len;
+		json_release(&msg);
+	}
+	json_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		err = cloud_encode_data_cbor(data, CLOUD_CMD_GROUP_DATA, buf,
+					     sizeof(buf), &msg);
+		zassert_equal(err, 0, "CBOR encoding failed: %d", err);
+		cbor_len = msg.len;
+	}
+	cbor_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	zassert_equal(heap_used, 0, "JSON output leaked");
+	zassert_true(cbor_len < json_len, "CBOR is not smaller");
+
+	TC_PRINT("%-6s JSON %3zu bytes, %5u ns, %4zu bytes of heap | "
+		 "CBOR %3zu bytes, %5u ns, no heap\n", name,
+		 json_len, json_ns, heap_peak, cbor_len, cbor_ns);
+}
+
+static void test_codec_benchmark(void)
+{
+	cJSON_Hooks hooks = {
+		.malloc_fn = malloc_hook,
+		.free_fn = free_hook,
+	};
+	struct cloud_channel_data gps = {
+		.type = CLOUD_CHANNEL_GPS,
+		.data.buf = GPS_NMEA,
+		.data.len = sizeof(GPS_NMEA) - 1,
+	};
+	struct cloud_channel_data button = {
+		.type = CLOUD_CHANNEL_BUTTON,
+		.data.buf = "1",
+		.data.len = 1,
+	};
+	struct cloud_channel_data rsrp = {
+		.type = CLOUD_CHANNEL_LTE_LINK_RSRP,
+		.data.buf = "-97",
+		.data.len = 3,
+	};
+
+	cJSON_InitHooks(&hooks);
+
+	benchmark("GPS", &gps);
+	benchmark("BUTTON", &button);
+	benchmark("RSRP", &rsrp);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(asset_tracker_cloud_codec_test,
+	     ztest_unit_test(test_cbor_encode_data),
+	     ztest_unit_test(test_cbor_encode_env),
+	     ztest_unit_test(test_cbor_buffer_too_small),
+	     ztest_unit_test(test_cbor_invalid),
+	     ztest_unit_test(test_cbor_enabled),
+	     ztest_unit_test(test_codec_benchmark)
+	 );
+
+	ztest_run_test_suite(asset_tracker_cloud_codec_test);
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+
+#include "slm_util.h"
+#include "slm_at_host.h"
+#include "benchmark.h"
+
+#define TEST_PARAM_COUNT 4
+#define BENCHMARK_ROUNDS 10000
+
+struct at_param_list at_param_list;
+
+/* Last response sent to the host, and the number of responses. */
+static char rsp[16];
+static int rsp_count;
+
+/* Return value of the test handler, and the type it was called with. */
+static int handler_ret;
+static enum at_cmd_type handler_type;
+static int handler_calls;
+
+void rsp_send(const uint8_t *str, size_t len)
+{
+	len = MIN(len, sizeof(rsp) - 1);
+	memcpy(rsp, str, len);
+	rsp[len] = '\0';
+	rsp_count++;
+}
+
+static int handle_at_dummy(enum at_cmd_type cmd_type)
+{
+	return 0;
+}
+
+static int handle_at_test(enum at_cmd_type cmd_type)
+{
+	handler_type = cmd_type;
+	handler_calls++;
+
+	return handler_ret;
+}
+
+/* The commands of serial_lte_modem, in the order of the former parsers. */
+static const char * const names[] = {
+	"AT#XSLMVER", "AT#XSLMUART", "AT#XSLEEP", "AT#XCLAC",
+	"AT#XTCPSVR", "AT#XTCPCLI", "AT#XTCPSEND", "AT#XTCPRECV",
+	"AT#XUDPSVR", "AT#XUDPCLI", "AT#XUDPSEND",
+	"AT#XSOCKET", "AT#XSOCKETOPT", "AT#XBIND", "AT#XCONNECT",
+	"AT#XLISTEN", "AT#XACCEPT", "AT#XSEND", "AT#XRECV", "AT#XSENDTO",
+	"AT#XRECVFROM", "AT#XGETADDRINFO",
+	"AT#XPING",
+	"AT#XGPS",
+	"AT#XMQTTCON", "AT#XMQTTPUB", "AT#XMQTTSUB", "AT#XMQTTUNSUB",
+	"AT#XFTP",
+};
+
+SLM_AT_CMD_DEFINE(XSLMVER, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XSLMUART, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XSLEEP, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XCLAC, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XTCPSVR, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XTCPCLI, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XTCPSEND, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XTCPRECV, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XUDPSVR, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XUDPCLI, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XUDPSEND, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XSOCKET, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XSOCKETOPT, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XBIND, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XCONNECT, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XLISTEN, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XACCEPT, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XSEND, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XRECV, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XSENDTO, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XRECVFROM, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XGETADDRINFO, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XPING, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XGPS, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XMQTTCON, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XMQTTPUB, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XMQTTSUB, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XMQTTUNSUB, handle_at_dummy);
+SLM_AT_CMD_DEFINE(XFTP, handle_at_dummy);
+
+static void find_check(const char *at_cmd, const char *name)
+{
+	const struct slm_at_cmd *cmd = slm_at_cmd_find(at_cmd);
+
+	zassert_not_null(cmd, "%s not found", at_cmd);
+	zassert_true(strcmp(cmd->name, name) == 0, "%s found as %s", at_cmd,
+		     cmd->name);
+	zassert_equal_ptr(cmd->handler, handle_at_dummy, "Wrong handler");
+}
+
+static void test_at_cmd_table_sorted(void)
+{
+	const struct slm_at_cmd *cmd;
+
+	zassert_equal(_slm_at_cmd_list_end - _slm_at_cmd_list_start,
+		      ARRAY_SIZE(names), "Wrong number of commands");
+
+	for (cmd = _slm_at_cmd_list_start + 1; cmd < _slm_at_cmd_list_end;
+	     cmd++) {
+		zassert_true(strcmp(cmd[-1].name, cmd->name) < 0,
+			     "%s not sorted", cmd->name);
+	}
+}
+
+static void test_at_cmd_find(void)
+{
+	char at_cmd[32];
+
+	for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+		find_check(names[i], names[i]);
+
+		sprintf(at_cmd, "%s=1,\"a\"", names[i]);
+		find_check(at_cmd, names[i]);
+
+		sprintf(at_cmd, "%s?", names[i]);
+		find_check(at_cmd, names[i]);
+
+		sprintf(at_cmd, "%s=?", names[i]);
+		find_check(at_cmd, names[i]);
+
+		sprintf(at_cmd, "%s\r\n", names[i]);
+		find_check(at_cmd, names[i]);
+	}
+}
+
+static void test_at_cmd_find_case(void)
+{
+	find_check("at#xsocket=1,1,0", "AT#XSOCKET");
+	find_check("At#XsocketOpt?", "AT#XSOCKETOPT");
+}
+
+static void test_at_cmd_find_prefix(void)
+{
+	/* Names that start with the name of a command */
+	find_check("AT#XSOCKETOPT=1,20,30", "AT#XSOCKETOPT");
+	find_check("AT#XSENDTO=\"a\",1,\"b\"", "AT#XSENDTO");
+	zassert_is_null(slm_at_cmd_find("AT#XSOCKETX=1"), "Prefix found");
+	zassert_is_null(slm_at_cmd_find("AT#XSOCKE"), "Prefix found");
+
+	/* Modem commands */
+	zassert_is_null(slm_at_cmd_find("AT+CFUN?"), "Modem command found");
+	zassert_is_null(slm_at_cmd_find("AT"), "Modem command found");
+	zassert_is_null(slm_at_cmd_find(""), "Empty command found");
+
+	/* Names longer than any command */
+	zassert_is_null(slm_at_cmd_find("AT#XGETADDRINFOXXXXXXXXXXXXXXXXX"),
+			"Long name found");
+}
+
+static void test_at_cmd_check(void)
+{
+	zassert_equal(slm_at_cmd_check(), 0, "Command registered twice");
+}
+
+/* Handles a command that is not registered, and checks the response. */
+static int handle_check(const char *at_cmd, int ret, const char *expected)
+{
+	static const struct slm_at_cmd cmd = {
+		.name = "AT#XTEST",
+		.handler = handle_at_test,
+	};
+	int err;
+
+	rsp_count = 0;
+	handler_calls = 0;
+	handler_ret = ret;
+
+	err = slm_at_cmd_handle(&cmd, at_cmd);
+
+	if (expected == NULL) {
+		zassert_equal(rsp_count, 0, "Response sent: %s", rsp);
+	} else {
+		zassert_equal(rsp_count, 1, "Wrong number of responses");
+		zassert_true(strcmp(rsp, expected) == 0, "Wrong response: %s",
+			     rsp);
+	}
+
+	return err;
+}
+
+static void test_at_cmd_handle(void)
+{
+	int err;
+
+	err = handle_check("AT#XTEST=1,\"a\"", 0, OK_STR);
+	zassert_equal(err, 0, "Wrong return value: %d", err);
+	zassert_equal(handler_calls, 1, "Handler not called");
+	zassert_equal(handler_type, AT_CMD_TYPE_SET_COMMAND, "Wrong type");
+	zassert_equal(at_params_valid_count_get(&at_param_list), 3,
+		      "Parameters not parsed");
+
+	handle_check("AT#XTEST?", 0, OK_STR);
+	zassert_equal(handler_type, AT_CMD_TYPE_READ_COMMAND, "Wrong type");
+
+	handle_check("AT#XTEST=?", 0, OK_STR);
+	zassert_equal(handler_type, AT_CMD_TYPE_TEST_COMMAND, "Wrong type");
+
+	err = handle_check("AT#XTEST=1", -EINVAL, ERROR_STR);
+	zassert_equal(err, -EINVAL, "Wrong return value: %d", err);
+	zassert_equal(handler_calls, 1, "Handler not called");
+
+	/* The handler sends the response itself. */
+	err = handle_check("AT#XTEST=1", SLM_AT_RSP_SENT, NULL);
+	zassert_equal(err, SLM_AT_RSP_SENT, "Wrong return value: %d", err);
+	zassert_equal(handler_calls, 1, "Handler not called");
+}
+
+static void test_at_cmd_handle_parse_error(void)
+{
+	int err;
+
+	/* More parameters than the list holds */
+	err = handle_check("AT#XTEST=1,2,3,4,5,6", 0, ERROR_STR);
+	zassert_equal(err, -EINVAL, "Wrong return value: %d", err);
+	zassert_equal(handler_calls, 0, "Handler called");
+}
+
+/* Reports the time to find each command with the former chain of
+ * comparisons, and with the table.
+ */
+static void test_at_cmd_benchmark(void)
+{
+	char at_cmd[32];
+	uint32_t chain_ns;
+	uint32_t table_ns;
+	uint64_t start;
+
+	for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+		sprintf(at_cmd, "%s=1,2\r\n", names[i]);
+
+		start = benchmark_time_us();
+		for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+			size_t j;
+
+			for (j = 0; j < ARRAY_SIZE(names); j++) {
+				if (slm_util_cmd_casecmp(at_cmd, names[j])) {
+					break;
+				}
+			}
+			zassert_equal(j, i, "Wrong command");
+		}
+		chain_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+		start = benchmark_time_us();
+		for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+			zassert_not_null(slm_at_cmd_find(at_cmd), "Not found");
+		}
+		table_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+		TC_PRINT("%-16s chain %5u ns, table %5u ns\n", names[i],
+			 chain_ns, table_ns);
+	}
+}
+
+void test_main(void)
+{
+	at_params_list_init(&at_param_list, TEST_PARAM_COUNT);
+
+	ztest_test_suite(at_cmd_table_test,
+		ztest_unit_test(test_at_cmd_table_sorted),
+		ztest_unit_test(test_at_cmd_find),
+		ztest_unit_test(test_at_cmd_find_case),
+		ztest_unit_test(test_at_cmd_find_prefix),
+		ztest_unit_test(test_at_cmd_check),
+		ztest_unit_test(test_at_cmd_handle),
+		ztest_unit_test(test_at_cmd_handle_parse_error),
+		ztest_unit_test(test_at_cmd_benchmark)
+	);
+
+	ztest_run_test_suite(at_cmd_table_test);
+}
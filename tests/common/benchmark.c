@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Ensure 'clock_gettime' is available from the host libc on native_posix */
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <zephyr.h>
+
+#include "benchmark.h"
+
+#ifdef CONFIG_BOARD_NATIVE_POSIX
+#include <time.h>
+#endif
+
+uint64_t benchmark_time_us(void)
+{
+#ifdef CONFIG_BOARD_NATIVE_POSIX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+#else
+	return k_cyc_to_us_floor64(k_cycle_get_32());
+#endif
+}
@@ -0,0 +1,9 @@
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+#
+
+# Timing helper of the tests that report benchmarks, see benchmark.h.
+target_sources(app PRIVATE ${CMAKE_CURRENT_LIST_DIR}/benchmark.c)
+target_include_directories(app PRIVATE ${CMAKE_CURRENT_LIST_DIR})
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BENCHMARK_H__
+#define BENCHMARK_H__
+
+#include <zephyr/types.h>
+
+/** @brief Get the current time in microseconds.
+ *
+ *  On native_posix, the host clock is used, as the simulated time does not
+ *  advance while the CPU is busy.
+ */
+uint64_t benchmark_time_us(void);
+
+/** @brief Get the time of one round of a benchmark, in nanoseconds.
+ *
+ *  @param start  Time returned by benchmark_time_us() before the rounds
+ *                were run.
+ *  @param rounds Number of rounds that were run.
+ */
+static inline uint32_t benchmark_round_ns(uint64_t start, uint32_t rounds)
+{
+	return 1000ULL * (benchmark_time_us() - start) / rounds;
+}
+
+#endif /* BENCHMARK_H__ */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef MOCK_NET_SOCKET_H__
+#define MOCK_NET_SOCKET_H__
+
+/* Replaces the socket API for the AT command interface with the mock of the
+ * AT socket implemented by the test.
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifndef AF_LTE
+#define AF_LTE 102
+#endif
+#ifndef SOCK_DGRAM
+#define SOCK_DGRAM 2
+#endif
+#ifndef NPROTO_AT
+#define NPROTO_AT 513
+#endif
+
+int mock_socket(int family, int type, int proto);
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags);
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags);
+int mock_close(int sock);
+
+#define socket(family, type, proto) mock_socket(family, type, proto)
+#define send(sock, buf, len, flags) mock_send(sock, buf, len, flags)
+#define recv(sock, buf, max_len, flags) mock_recv(sock, buf, max_len, flags)
+#define close(sock) mock_close(sock)
+
+#endif /* MOCK_NET_SOCKET_H__ */
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <modem/at_cmd.h>
+
+#define SYNC_CMD  "AT+CMEE?;+CNEC?"
+#define SYNC_RESP "+CMEE: 1\r\n+CNEC: 24\r\nOK\r\n"
+
+#define LINE_MAX_LEN 64
+#define MOCK_TIMEOUT K_MSEC(500)
+
+struct line {
+	char str[LINE_MAX_LEN];
+};
+
+/* Command lines written to the AT socket */
+K_MSGQ_DEFINE(sent_msgq, sizeof(struct line), 8, 4);
+
+/* Responses returned by the AT socket, as pointers to strings */
+K_MSGQ_DEFINE(resp_msgq, sizeof(const char *), 8, 4);
+
+static K_SEM_DEFINE(notif_sem, 0, 1);
+static struct line notif;
+
+static K_SEM_DEFINE(done_sem, 0, 1);
+static k_tid_t done_thread;
+
+
+int mock_socket(int family, int type, int proto)
+{
+	zassert_equal(family, AF_LTE, "Not an AT socket");
+	zassert_equal(proto, NPROTO_AT, "Not an AT socket");
+
+	return 1;
+}
+
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags)
+{
+	struct line line = {0};
+
+	zassert_true(len < sizeof(line.str), "Command too long");
+	memcpy(line.str, buf, len);
+	zassert_equal(k_msgq_put(&sent_msgq, &line, K_NO_WAIT), 0,
+		      "Too many commands written");
+
+	return len;
+}
+
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags)
+{
+	const char *resp;
+	size_t len;
+
+	k_msgq_get(&resp_msgq, &resp, K_FOREVER);
+
+	/* Responses are received with the terminating null character */
+	len = strlen(resp) + 1;
+	zassert_true(len <= max_len, "Response too long");
+	memcpy(buf, resp, len);
+
+	return len;
+}
+
+int mock_close(int sock)
+{
+	return 0;
+}
+
+void bsdlib_shutdown_wait(void)
+{
+}
+
+static void respond(const char *resp)
+{
+	zassert_equal(k_msgq_put(&resp_msgq, &resp, K_NO_WAIT), 0,
+		      "Too many responses");
+}
+
+static void sent_check(const char *cmd)
+{
+	struct line line;
+
+	zassert_equal(k_msgq_get(&sent_msgq, &line, MOCK_TIMEOUT), 0,
+		      "%s not written", cmd);
+	zassert_true(strcmp(line.str, cmd) == 0, "%s written instead of %s",
+		     line.str, cmd);
+}
+
+static void nothing_sent_check(void)
+{
+	struct line line;
+
+	zassert_equal(k_msgq_get(&sent_msgq, &line, K_MSEC(50)), -EAGAIN,
+		      "Unexpected command written");
+}
+
+static void req_init(struct at_cmd_req *req, const char *cmd, char *resp,
+		     size_t resp_size)
+{
+	at_cmd_req_init(req, cmd);
+	req->resp = resp;
+	req->resp_size = resp_size;
+}
+
+static void notification_handler(const char *response)
+{
+	strncpy(notif.str, response, sizeof(notif.str) - 1);
+	k_sem_give(&notif_sem);
+}
+
+static void req_done(struct at_cmd_req *req)
+{
+	done_thread = k_current_get();
+	k_sem_give(&done_sem);
+}
+
+static void test_init(void)
+{
+	zassert_equal(at_cmd_init(), 0, "Initialization failed");
+	at_cmd_set_notification_handler(notification_handler);
+}
+
+static void test_write_response(void)
+{
+	struct at_cmd_req req;
+	char resp[32];
+
+	req_init(&req, "AT+CFUN=1", resp, sizeof(resp));
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+CFUN=1");
+
+	respond("+CFUN: 1\r\nOK\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), 0, "Wrong code");
+	zassert_equal(req.state, AT_CMD_OK, "Wrong state");
+	zassert_true(strcmp(resp, "+CFUN: 1\r\n") == 0, "Wrong response");
+}
+
+static void test_write_errors(void)
+{
+	struct at_cmd_req req;
+
+	at_cmd_req_init(&req, "AT+CFUN=1");
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+CFUN=1");
+	respond("ERROR\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), -ENOEXEC,
+		      "Wrong code");
+	zassert_equal(req.state, AT_CMD_ERROR, "Wrong state");
+
+	at_cmd_req_init(&req, "AT+CFUN=1");
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+CFUN=1");
+	respond("+CME ERROR: 10\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), 10, "Wrong code");
+	zassert_equal(req.state, AT_CMD_ERROR_CME, "Wrong state");
+}
+
+static void test_queue_order(void)
+{
+	static const char * const cmds[] = {
+		"AT+CFUN=0", "AT+CFUN=1", "AT+CFUN=4"
+	};
+	struct at_cmd_req reqs[ARRAY_SIZE(cmds)];
+
+	for (size_t i = 0; i < ARRAY_SIZE(cmds); i++) {
+		at_cmd_req_init(&reqs[i], cmds[i]);
+		zassert_equal(at_cmd_req_submit(&reqs[i]), 0, "Submit failed");
+	}
+
+	/* Commands are written one by one, after the previous response */
+	for (size_t i = 0; i < ARRAY_SIZE(cmds); i++) {
+		sent_check(cmds[i]);
+		nothing_sent_check();
+		zassert_equal(at_cmd_req_wait(&reqs[i], K_NO_WAIT), -EAGAIN,
+			      "Completed before the response");
+
+		respond("OK\r\n");
+		zassert_equal(at_cmd_req_wait(&reqs[i], MOCK_TIMEOUT), 0,
+			      "Wrong code");
+	}
+}
+
+static void test_notification(void)
+{
+	struct at_cmd_req req;
+
+	at_cmd_req_init(&req, "AT+CEREG=5");
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+CEREG=5");
+
+	/* A notification does not complete the request in flight */
+	respond("+CEREG: 1\r\n");
+	zassert_equal(k_sem_take(&notif_sem, MOCK_TIMEOUT), 0,
+		      "Notification not received");
+	zassert_true(strcmp(notif.str, "+CEREG: 1\r\n") == 0,
+		     "Wrong notification");
+	zassert_equal(at_cmd_req_wait(&req, K_MSEC(50)), -EAGAIN,
+		      "Completed by notification");
+
+	respond("OK\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), 0, "Wrong code");
+}
+
+static void test_callback_context(void)
+{
+	struct at_cmd_req req;
+
+	at_cmd_req_init(&req, "AT+CFUN=1");
+	req.done = req_done;
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+CFUN=1");
+	respond("OK\r\n");
+
+	/* Response is handled in the AT socket thread */
+	zassert_equal(k_sem_take(&done_sem, MOCK_TIMEOUT), 0, "Not completed");
+	zassert_not_equal(done_thread, k_current_get(), "Wrong context");
+	zassert_not_equal(done_thread, &k_sys_work_q.thread, "Wrong context");
+	zassert_equal(req.code, 0, "Wrong code");
+
+	at_cmd_req_init(&req, "AT+CFUN=1");
+	req.done = req_done;
+	req.timeout_ms = 50;
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+CFUN=1");
+
+	/* Timeout is handled in the system workqueue */
+	zassert_equal(k_sem_take(&done_sem, MOCK_TIMEOUT), 0, "Not completed");
+	zassert_equal(done_thread, &k_sys_work_q.thread, "Wrong context");
+	zassert_equal(req.code, -ETIMEDOUT, "Wrong code");
+
+	sent_check(SYNC_CMD);
+	respond("OK\r\n");
+	respond(SYNC_RESP);
+	nothing_sent_check();
+}
+
+static void test_timeout_late_response(void)
+{
+	struct at_cmd_req req;
+	char resp[32];
+
+	at_cmd_req_init(&req, "AT+COPS=0");
+	req.timeout_ms = 50;
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+COPS=0");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), -ETIMEDOUT,
+		      "Request not timed out");
+
+	/* Next command is written when the sync command is answered */
+	sent_check(SYNC_CMD);
+	req_init(&req, "AT+CFUN=1", resp, sizeof(resp));
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	nothing_sent_check();
+
+	/* Late response to the timed out command is dropped */
+	respond("+CME ERROR: 516\r\n");
+	nothing_sent_check();
+
+	respond(SYNC_RESP);
+	sent_check("AT+CFUN=1");
+	respond("+CFUN: 1\r\nOK\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), 0, "Wrong code");
+	zassert_true(strcmp(resp, "+CFUN: 1\r\n") == 0, "Wrong response");
+}
+
+static void test_timeout_no_response(void)
+{
+	struct at_cmd_req req;
+	char resp[32];
+
+	at_cmd_req_init(&req, "AT+COPS=0");
+	req.timeout_ms = 50;
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+COPS=0");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), -ETIMEDOUT,
+		      "Request not timed out");
+	sent_check(SYNC_CMD);
+
+	req_init(&req, "AT+CFUN=1", resp, sizeof(resp));
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+
+	/* The modem never answers the timed out command. The response to
+	 * the next command must not be dropped.
+	 */
+	respond(SYNC_RESP);
+	sent_check("AT+CFUN=1");
+	respond("+CFUN: 1\r\nOK\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), 0, "Wrong code");
+	zassert_true(strcmp(resp, "+CFUN: 1\r\n") == 0, "Wrong response");
+}
+
+static void test_timeout_sync_no_response(void)
+{
+	struct at_cmd_req req;
+
+	at_cmd_req_init(&req, "AT+COPS=0");
+	req.timeout_ms = 50;
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check("AT+COPS=0");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), -ETIMEDOUT,
+		      "Request not timed out");
+	sent_check(SYNC_CMD);
+
+	at_cmd_req_init(&req, "AT+CFUN=1");
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+
+	/* The modem never answers the sync command. It is written again a
+	 * bounded number of times, then the queued request fails.
+	 */
+	for (size_t i = 0; i < CONFIG_AT_CMD_SYNC_RETRIES; i++) {
+		sent_check(SYNC_CMD);
+	}
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), -ETIMEDOUT,
+		      "Queued request not failed");
+	nothing_sent_check();
+
+	/* Responses are synchronized again before the next command */
+	at_cmd_req_init(&req, "AT+CFUN=1");
+	zassert_equal(at_cmd_req_submit(&req), 0, "Submit failed");
+	sent_check(SYNC_CMD);
+	respond(SYNC_RESP);
+	sent_check("AT+CFUN=1");
+	respond("OK\r\n");
+	zassert_equal(at_cmd_req_wait(&req, MOCK_TIMEOUT), 0, "Wrong code");
+}
+
+static void test_batch(void)
+{
+	struct at_cmd_req reqs[3];
+	char cereg[32];
+	char cesq[32];
+
+	at_cmd_req_init(&reqs[0], "AT+CFUN=1");
+	req_init(&reqs[1], "AT+CEREG?", cereg, sizeof(cereg));
+	req_init(&reqs[2], "AT+CESQ?", cesq, sizeof(cesq));
+
+	for (size_t i = 0; i < ARRAY_SIZE(reqs); i++) {
+		zassert_equal(at_cmd_req_submit(&reqs[i]), 0, "Submit failed");
+	}
+
+	sent_check("AT+CFUN=1");
+	respond("OK\r\n");
+	zassert_equal(at_cmd_req_wait(&reqs[0], MOCK_TIMEOUT), 0,
+		      "Wrong code");
+
+	/* Queued read commands are written in one line */
+	sent_check("AT+CEREG?;+CESQ?");
+	respond("+CEREG: 0,1\r\n+CESQ: 99,99\r\nOK\r\n");
+
+	zassert_equal(at_cmd_req_wait(&reqs[1], MOCK_TIMEOUT), 0,
+		      "Wrong code");
+	zassert_equal(at_cmd_req_wait(&reqs[2], MOCK_TIMEOUT), 0,
+		      "Wrong code");
+	zassert_true(strcmp(cereg, "+CEREG: 0,1\r\n") == 0, "Wrong response");
+	zassert_true(strcmp(cesq, "+CESQ: 99,99\r\n") == 0, "Wrong response");
+}
+
+/* Must be the last test, as batching stays disabled after a fallback. */
+static void test_batch_fallback(void)
+{
+	struct at_cmd_req reqs[3];
+	char cereg[32];
+	char cesq[32];
+
+	at_cmd_req_init(&reqs[0], "AT+CFUN=1");
+	req_init(&reqs[1], "AT+CEREG?", cereg, sizeof(cereg));
+	req_init(&reqs[2], "AT+CESQ?", cesq, sizeof(cesq));
+
+	for (size_t i = 0; i < ARRAY_SIZE(reqs); i++) {
+		zassert_equal(at_cmd_req_submit(&reqs[i]), 0, "Submit failed");
+	}
+
+	sent_check("AT+CFUN=1");
+	respond("OK\r\n");
+	sent_check("AT+CEREG?;+CESQ?");
+
+	/* Rejected line is sent again one command at a time */
+	respond("ERROR\r\n");
+	sent_check("AT+CEREG?");
+	respond("+CEREG: 0,1\r\nOK\r\n");
+	sent_check("AT+CESQ?");
+	respond("+CESQ: 99,99\r\nOK\r\n");
+
+	zassert_equal(at_cmd_req_wait(&reqs[1], MOCK_TIMEOUT), 0,
+		      "Wrong code");
+	zassert_equal(at_cmd_req_wait(&reqs[2], MOCK_TIMEOUT), 0,
+		      "Wrong code");
+	zassert_true(strcmp(cereg, "+CEREG: 0,1\r\n") == 0, "Wrong response");
+	zassert_true(strcmp(cesq, "+CESQ: 99,99\r\n") == 0, "Wrong response");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_cmd_test,
+		ztest_unit_test(test_init),
+		ztest_unit_test(test_write_response),
+		ztest_unit_test(test_write_errors),
+		ztest_unit_test(test_queue_order),
+		ztest_unit_test(test_notification),
+		ztest_unit_test(test_callback_context),
+		ztest_unit_test(test_timeout_late_response),
+		ztest_unit_test(test_timeout_no_response),
+		ztest_unit_test(test_timeout_sync_no_response),
+		ztest_unit_test(test_batch),
+		ztest_unit_test(test_batch_fallback)
+	);
+
+	ztest_run_test_suite(at_cmd_test);
+}
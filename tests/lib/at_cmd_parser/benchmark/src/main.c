@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+
+#define BENCHMARK_ITERATIONS	100
+#define MAX_PARAMS		20
+#define MAX_STRING_LEN		32
+
+static const char * const notifications[] = {
+	"+CEREG: 5,\"0A0B\",\"01020304\",7,,,\"00001000\",\"00101000\"\r\n",
+	"%XMONITOR: 1,\"EDU Network\",\"EDU\",\"26295\",\"00B7\",7,4,"
+	"\"00011B07\",7,2300,63,39,\"\",\"11100000\",\"11100000\","
+	"\"01001001\"\r\n",
+	"+CESQ: 99,99,255,255,31,62\r\n",
+	"%XCBAND: (1,2,3,4,12,13)\r\n",
+};
+
+static size_t malloc_cnt;
+
+void *__real_k_malloc(size_t size);
+
+void *__wrap_k_malloc(size_t size)
+{
+	malloc_cnt++;
+	return __real_k_malloc(size);
+}
+
+struct benchmark_result {
+	uint32_t cycles;
+	size_t malloc_cnt;
+};
+
+static void parse(const char *str, struct at_param_list *list,
+		  struct benchmark_result *result)
+{
+	size_t start_malloc_cnt = malloc_cnt;
+	uint32_t start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		int err = at_parser_params_from_str(str, NULL, list);
+
+		zassert_equal(err, 0, "Parsing failed: %d", err);
+	}
+
+	result->cycles = (k_cycle_get_32() - start) / BENCHMARK_ITERATIONS;
+	result->malloc_cnt = (malloc_cnt - start_malloc_cnt) /
+			     BENCHMARK_ITERATIONS;
+}
+
+static void compare_lists(const struct at_param_list *copy,
+			  const struct at_param_list *ref)
+{
+	zassert_equal(at_params_valid_count_get(copy),
+		      at_params_valid_count_get(ref),
+		      "Different number of parameters");
+
+	for (size_t i = 0; i < at_params_valid_count_get(copy); i++) {
+		enum at_param_type type = at_params_type_get(copy, i);
+		size_t len1;
+		size_t len2;
+		int err;
+
+		zassert_equal(type, at_params_type_get(ref, i),
+			      "Different type of parameter %zu", i);
+
+		if (type == AT_PARAM_TYPE_STRING) {
+			char str1[MAX_STRING_LEN];
+			const char *str2;
+
+			len1 = sizeof(str1);
+			err = at_params_string_get(copy, i, str1, &len1);
+			zassert_equal(err, 0, "Cannot get string");
+			err = at_params_string_ptr_get(ref, i, &str2, &len2);
+			zassert_equal(err, 0, "Cannot get string reference");
+			zassert_equal(len1, len2, "Different string length");
+			zassert_mem_equal(str1, str2, len1,
+					  "Different string value");
+		} else if (type == AT_PARAM_TYPE_ARRAY) {
+			uint32_t arr1[MAX_PARAMS];
+			uint32_t arr2[MAX_PARAMS];
+
+			len1 = sizeof(arr1);
+			len2 = sizeof(arr2);
+			err = at_params_array_get(copy, i, arr1, &len1);
+			zassert_equal(err, 0, "Cannot get array");
+			err = at_params_array_get(ref, i, arr2, &len2);
+			zassert_equal(err, 0, "Cannot get array reference");
+			zassert_equal(len1, len2, "Different array length");
+			zassert_mem_equal(arr1, arr2, len1,
+					  "Different array value");
+		} else if (type != AT_PARAM_TYPE_EMPTY) {
+			uint32_t val1;
+			uint32_t val2;
+
+			err = at_params_int_get(copy, i, &val1);
+			zassert_equal(err, 0, "Cannot get number");
+			err = at_params_int_get(ref, i, &val2);
+			zassert_equal(err, 0, "Cannot get number");
+			zassert_equal(val1, val2, "Different number value");
+		}
+	}
+}
+
+static void test_parser_benchmark(void)
+{
+	struct at_param_list copy_list;
+	struct at_param_list ref_list;
+	static struct at_param ref_params[MAX_PARAMS];
+
+	int err;
+
+	err = at_params_list_init(&copy_list, MAX_PARAMS);
+	zassert_equal(err, 0, "Cannot initialize list");
+	err = at_params_list_init_static(&ref_list, ref_params,
+					 ARRAY_SIZE(ref_params), true);
+	zassert_equal(err, 0, "Cannot initialize zero-copy list");
+
+	for (size_t i = 0; i < ARRAY_SIZE(notifications); i++) {
+		struct benchmark_result copy_result;
+		struct benchmark_result ref_result;
+
+		parse(notifications[i], &copy_list, &copy_result);
+		parse(notifications[i], &ref_list, &ref_result);
+
+		compare_lists(&copy_list, &ref_list);
+
+		TC_PRINT("%.12s\n", notifications[i]);
+		TC_PRINT("\tcopy:      %u cycles, %zu allocations\n",
+			 copy_result.cycles, copy_result.malloc_cnt);
+		TC_PRINT("\tzero-copy: %u cycles, %zu allocations\n",
+			 ref_result.cycles, ref_result.malloc_cnt);
+
+		zassert_equal(ref_result.malloc_cnt, 0,
+			      "Zero-copy parsing allocates memory");
+	}
+
+	at_params_list_free(&copy_list);
+	at_params_list_free(&ref_list);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_cmd_parser_benchmark,
+			 ztest_unit_test(test_parser_benchmark)
+			);
+
+	ztest_run_test_suite(at_cmd_parser_benchmark);
+}
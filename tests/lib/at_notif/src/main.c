@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <modem/at_cmd.h>
+#include <modem/at_notif.h>
+
+#define DISPATCH_STACK_SIZE 1024
+#define DISPATCH_PRIO 5
+#define HANDLER_DELAY K_MSEC(100)
+
+struct counter {
+	int calls;
+	int order;
+};
+
+/* Notification handler registered by the notification manager */
+static at_cmd_handler_t notif_dispatch;
+
+/* Incremented on each handler call, to check the order of the calls */
+static int call_seq;
+
+static K_THREAD_STACK_DEFINE(dispatch_stack, DISPATCH_STACK_SIZE);
+static struct k_thread dispatch_thread;
+
+static K_SEM_DEFINE(handler_entered, 0, 1);
+static K_SEM_DEFINE(dispatch_done, 0, 1);
+static bool handler_returned;
+
+
+void at_cmd_set_notification_handler(at_cmd_handler_t handler)
+{
+	notif_dispatch = handler;
+}
+
+static void counter_handler(void *context, const char *response)
+{
+	struct counter *counter = context;
+
+	counter->calls++;
+	counter->order = ++call_seq;
+}
+
+static void counters_reset(struct counter *counters, size_t cnt)
+{
+	memset(counters, 0, cnt * sizeof(*counters));
+	call_seq = 0;
+}
+
+static void test_init(void)
+{
+	zassert_equal(at_notif_init(), 0, "Init failed");
+	zassert_not_null(notif_dispatch, "No notification handler set");
+}
+
+static void test_prefix_invalid(void)
+{
+	struct counter counter;
+
+	zassert_equal(at_notif_register_prefix("+CEREG", &counter, NULL),
+		      -EINVAL, "NULL handler registered");
+	zassert_equal(at_notif_register_prefix(NULL, &counter,
+					       counter_handler),
+		      -EINVAL, "NULL prefix registered");
+	zassert_equal(at_notif_register_prefix("", &counter, counter_handler),
+		      -EINVAL, "Empty prefix registered");
+	zassert_equal(at_notif_register_prefix("+CEREG: 1", &counter,
+					       counter_handler),
+		      -EINVAL, "Prefix with parameters registered");
+	zassert_equal(at_notif_register_prefix("+ABCDEFGHIJKLMNOPQ", &counter,
+					       counter_handler),
+		      -EINVAL, "Too long prefix registered");
+}
+
+static void test_prefix_dispatch(void)
+{
+	static const char * const prefixes[] = {
+		"+CEREG", "+CSCON:", "%CESQ", "%XSIM", "+CEREGX",
+	};
+	struct counter counters[ARRAY_SIZE(prefixes)];
+	struct counter all;
+
+	for (size_t i = 0; i < ARRAY_SIZE(prefixes); i++) {
+		zassert_equal(at_notif_register_prefix(prefixes[i],
+						       &counters[i],
+						       counter_handler),
+			      0, "Failed to register %s", prefixes[i]);
+	}
+	zassert_equal(at_notif_register_handler(&all, counter_handler), 0,
+		      "Failed to register");
+
+	/* Only the handler of the prefix is called, before the handlers of
+	 * all notifications.
+	 */
+	counters_reset(counters, ARRAY_SIZE(counters));
+	counters_reset(&all, 1);
+	notif_dispatch("+CEREG: 1,\"002F\",\"0012BEEF\",7\r\n");
+	zassert_equal(counters[0].calls, 1, "Prefix handler not called");
+	zassert_equal(counters[0].order, 1, "Prefix handler called late");
+	for (size_t i = 1; i < ARRAY_SIZE(counters); i++) {
+		zassert_equal(counters[i].calls, 0, "%s called", prefixes[i]);
+	}
+	zassert_equal(all.calls, 1, "Handler of all notifications not called");
+	zassert_equal(all.order, 2, "Handler of all called early");
+
+	/* The trailing ':' of a prefix is optional */
+	counters_reset(counters, ARRAY_SIZE(counters));
+	notif_dispatch("+CSCON: 0\r\n");
+	zassert_equal(counters[1].calls, 1, "+CSCON handler not called");
+
+	/* Notifications without parameters */
+	counters_reset(counters, ARRAY_SIZE(counters));
+	notif_dispatch("%XSIM\r\n");
+	zassert_equal(counters[3].calls, 1, "%%XSIM handler not called");
+
+	/* A prefix of the notification name is not a match */
+	counters_reset(counters, ARRAY_SIZE(counters));
+	notif_dispatch("+CEREGX: 1\r\n");
+	zassert_equal(counters[0].calls, 0, "+CEREG handler called");
+	zassert_equal(counters[4].calls, 1, "+CEREGX handler not called");
+	counters_reset(counters, ARRAY_SIZE(counters));
+	notif_dispatch("+CERE: 1\r\n");
+	zassert_equal(counters[0].calls, 0, "+CEREG handler called");
+
+	/* Unknown and too long notification names */
+	counters_reset(counters, ARRAY_SIZE(counters));
+	counters_reset(&all, 1);
+	notif_dispatch("%ABCDEFGHIJKLMNOPQRSTUVWXYZ: 1\r\n");
+	for (size_t i = 0; i < ARRAY_SIZE(counters); i++) {
+		zassert_equal(counters[i].calls, 0, "%s called", prefixes[i]);
+	}
+	zassert_equal(all.calls, 1, "Handler of all notifications not called");
+
+	for (size_t i = 0; i < ARRAY_SIZE(prefixes); i++) {
+		zassert_equal(at_notif_deregister_prefix(prefixes[i],
+							 &counters[i],
+							 counter_handler),
+			      0, "Failed to deregister %s", prefixes[i]);
+	}
+	zassert_equal(at_notif_deregister_handler(&all, counter_handler), 0,
+		      "Failed to deregister");
+
+	counters_reset(counters, ARRAY_SIZE(counters));
+	counters_reset(&all, 1);
+	notif_dispatch("+CEREG: 1\r\n");
+	zassert_equal(counters[0].calls, 0, "Deregistered handler called");
+	zassert_equal(all.calls, 0, "Deregistered handler called");
+}
+
+static void test_register_twice(void)
+{
+	struct counter counter = {0};
+
+	zassert_equal(at_notif_register_prefix("+CEREG", &counter,
+					       counter_handler), 0,
+		      "Failed to register");
+	zassert_equal(at_notif_register_prefix("+CEREG:", &counter,
+					       counter_handler), 0,
+		      "Failed to register");
+
+	notif_dispatch("+CEREG: 1\r\n");
+	zassert_equal(counter.calls, 1, "Handler called more than once");
+
+	zassert_equal(at_notif_deregister_prefix("+CEREG", &counter,
+						 counter_handler), 0,
+		      "Failed to deregister");
+}
+
+static struct counter self_counter;
+static struct counter other_counter;
+
+static void self_deregister_handler(void *context, const char *response)
+{
+	counter_handler(context, response);
+
+	zassert_equal(at_notif_deregister_prefix("+CSCON", context,
+						 self_deregister_handler),
+		      0, "Failed to deregister in handler");
+	zassert_equal(at_notif_deregister_handler(&other_counter,
+						  counter_handler),
+		      0, "Failed to deregister in handler");
+}
+
+static void test_deregister_in_handler(void)
+{
+	zassert_equal(at_notif_register_handler(&other_counter,
+						counter_handler), 0,
+		      "Failed to register");
+	zassert_equal(at_notif_register_prefix("+CSCON", &self_counter,
+					       self_deregister_handler), 0,
+		      "Failed to register");
+
+	/* The handler of all notifications is deregistered before the
+	 * dispatcher reaches it.
+	 */
+	notif_dispatch("+CSCON: 1\r\n");
+	zassert_equal(self_counter.calls, 1, "Handler not called");
+	zassert_equal(other_counter.calls, 0, "Deregistered handler called");
+
+	notif_dispatch("+CSCON: 0\r\n");
+	zassert_equal(self_counter.calls, 1, "Deregistered handler called");
+	zassert_equal(other_counter.calls, 0, "Deregistered handler called");
+}
+
+static void blocking_handler(void *context, const char *response)
+{
+	struct counter *counter = context;
+
+	k_sem_give(&handler_entered);
+	k_sleep(HANDLER_DELAY);
+
+	/* The deregistration waiting for this dispatch must not keep other
+	 * registration changes waiting.
+	 */
+	zassert_equal(at_notif_register_prefix("%XSIM", counter,
+					       counter_handler), 0,
+		      "Failed to register in handler");
+
+	handler_returned = true;
+}
+
+static void dispatch_fn(void *p1, void *p2, void *p3)
+{
+	notif_dispatch("+CEREG: 5\r\n");
+	k_sem_give(&dispatch_done);
+}
+
+static void test_deregister_waits_for_dispatch(void)
+{
+	struct counter counter = {0};
+
+	zassert_equal(at_notif_register_prefix("+CEREG", &counter,
+					       blocking_handler), 0,
+		      "Failed to register");
+
+	k_thread_create(&dispatch_thread, dispatch_stack,
+			K_THREAD_STACK_SIZEOF(dispatch_stack), dispatch_fn,
+			NULL, NULL, NULL, DISPATCH_PRIO, 0, K_NO_WAIT);
+	zassert_equal(k_sem_take(&handler_entered, K_SECONDS(1)), 0,
+		      "Handler not called");
+
+	/* Returns only once the handler has returned */
+	zassert_equal(at_notif_deregister_prefix("+CEREG", &counter,
+						 blocking_handler), 0,
+		      "Failed to deregister");
+	zassert_true(handler_returned, "Deregistered while being called");
+	zassert_equal(k_sem_take(&dispatch_done, K_SECONDS(1)), 0,
+		      "Dispatch not finished");
+
+	/* The element of the deregistered handler can be reused */
+	notif_dispatch("%XSIM\r\n");
+	zassert_equal(counter.calls, 1, "Handler not called");
+	zassert_equal(at_notif_deregister_prefix("%XSIM", &counter,
+						 counter_handler), 0,
+		      "Failed to deregister");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_notif_test,
+		ztest_unit_test(test_init),
+		ztest_unit_test(test_prefix_invalid),
+		ztest_unit_test(test_prefix_dispatch),
+		ztest_unit_test(test_register_twice),
+		ztest_unit_test(test_deregister_in_handler),
+		ztest_unit_test(test_deregister_waits_for_dispatch)
+	);
+
+	ztest_run_test_suite(at_notif_test);
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/util.h>
+#include <nrf_socket.h>
+#include <bsd_limits.h>
+
+#include "bsdlib_stub.h"
+
+/* Events reported by nrf_poll() for each modem socket. */
+short stub_revents[BSD_MAX_SOCKET_COUNT];
+int stub_poll_errno;
+
+int stub_getaddrinfo_err;
+int stub_getaddrinfo_calls;
+
+int stub_sendto_calls;
+const void *stub_sendto_buf;
+uint8_t stub_sent[STUB_DATA_SIZE];
+size_t stub_sent_len;
+
+int stub_recvfrom_calls;
+void *stub_recvfrom_buf;
+int stub_recvfrom_flags;
+uint8_t stub_recv[STUB_DATA_SIZE];
+size_t stub_recv_len;
+
+static struct nrf_sockaddr_in stub_addr = {
+	.sin_len = sizeof(struct nrf_sockaddr_in),
+	.sin_family = NRF_AF_INET,
+	.sin_addr.s_addr = STUB_ADDR,
+};
+
+static struct nrf_addrinfo stub_addrinfo = {
+	.ai_family = NRF_AF_INET,
+	.ai_socktype = NRF_SOCK_STREAM,
+	.ai_protocol = NRF_IPPROTO_TCP,
+	.ai_addrlen = sizeof(struct nrf_sockaddr_in),
+	.ai_addr = (struct nrf_sockaddr *)&stub_addr,
+};
+
+static bool allocated[BSD_MAX_SOCKET_COUNT];
+
+int nrf_socket(int family, int type, int protocol)
+{
+	for (int sd = 0; sd < BSD_MAX_SOCKET_COUNT; sd++) {
+		if (!allocated[sd]) {
+			allocated[sd] = true;
+			stub_revents[sd] = 0;
+			return sd;
+		}
+	}
+
+	errno = ENOBUFS;
+	return -1;
+}
+
+int nrf_close(int fildes)
+{
+	if (fildes < 0 || fildes >= BSD_MAX_SOCKET_COUNT ||
+	    !allocated[fildes]) {
+		errno = EBADF;
+		return -1;
+	}
+
+	allocated[fildes] = false;
+	return 0;
+}
+
+int nrf_poll(struct nrf_pollfd *fds, nrf_nfds_t nfds, int timeout)
+{
+	int ready = 0;
+
+	if (stub_poll_errno) {
+		errno = stub_poll_errno;
+		return -1;
+	}
+
+	for (nrf_nfds_t i = 0; i < nfds; i++) {
+		int sd = fds[i].fd;
+
+		if (sd < 0) {
+			fds[i].revents = 0;
+			continue;
+		}
+
+		if (sd >= BSD_MAX_SOCKET_COUNT || !allocated[sd]) {
+			fds[i].revents = NRF_POLLNVAL;
+		} else {
+			fds[i].revents = stub_revents[sd] &
+					 (fds[i].events | NRF_POLLERR |
+					  NRF_POLLHUP | NRF_POLLNVAL);
+		}
+
+		if (fds[i].revents) {
+			ready++;
+		}
+	}
+
+	return ready;
+}
+
+int nrf_getaddrinfo(const char *nodename, const char *servname,
+		    const struct nrf_addrinfo *hints,
+		    struct nrf_addrinfo **res)
+{
+	stub_getaddrinfo_calls++;
+
+	if (stub_getaddrinfo_err) {
+		return stub_getaddrinfo_err;
+	}
+
+	*res = &stub_addrinfo;
+	return 0;
+}
+
+void nrf_freeaddrinfo(struct nrf_addrinfo *ai)
+{
+}
+
+ssize_t nrf_sendto(int socket, const void *message, size_t length,
+		   int flags, const struct nrf_sockaddr *dest_addr,
+		   nrf_socklen_t dest_len)
+{
+	stub_sendto_calls++;
+	stub_sendto_buf = message;
+
+	length = MIN(length, sizeof(stub_sent) - stub_sent_len);
+	memcpy(stub_sent + stub_sent_len, message, length);
+	stub_sent_len += length;
+
+	return length;
+}
+
+/* Returns the datagram in stub_recv, truncated to the buffer. */
+ssize_t nrf_recvfrom(int socket, void *buffer, size_t length, int flags,
+		     struct nrf_sockaddr *address,
+		     nrf_socklen_t *address_len)
+{
+	stub_recvfrom_calls++;
+	stub_recvfrom_buf = buffer;
+	stub_recvfrom_flags = flags;
+
+	memcpy(buffer, stub_recv, MIN(length, stub_recv_len));
+
+	if (address != NULL) {
+		memcpy(address, &stub_addr, sizeof(stub_addr));
+		*address_len = sizeof(stub_addr);
+	}
+
+	/* The real length of the datagram is returned with NRF_MSG_TRUNC. */
+	return (flags & NRF_MSG_TRUNC) ? stub_recv_len :
+					 MIN(length, stub_recv_len);
+}
+
+/* The rest of the API is not used by the tests. */
+
+int nrf_bind(int socket, const struct nrf_sockaddr *address,
+	     nrf_socklen_t address_len)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+int nrf_connect(int socket, const struct nrf_sockaddr *address,
+		nrf_socklen_t address_len)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+int nrf_listen(int sock, int backlog)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+int nrf_accept(int socket, struct nrf_sockaddr *address,
+	       nrf_socklen_t *address_len)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+int nrf_setsockopt(int socket, int level, int option_name,
+		   const void *option_value, nrf_socklen_t option_len)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+int nrf_getsockopt(int socket, int level, int option_name,
+		   void *option_value, nrf_socklen_t *option_len)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+int nrf_fcntl(int fd, int cmd, int flags)
+{
+	errno = EOPNOTSUPP;
+	return -1;
+}
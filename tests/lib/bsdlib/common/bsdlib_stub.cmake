@@ -0,0 +1,28 @@
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+#
+
+# The socket offload layer is built against a stub of bsdlib, as bsdlib is
+# only available for the nRF9160.
+target_sources(app
+  PRIVATE
+  ${CMAKE_CURRENT_LIST_DIR}/bsdlib_stub.c
+  ${NRF_DIR}/lib/bsdlib/nrf91_sockets.c
+  )
+
+target_include_directories(app
+  PRIVATE
+  ${CMAKE_CURRENT_LIST_DIR}
+  ${NRFXLIB_DIR}/bsdlib/include
+  ${ZEPHYR_BASE}/subsys/net/lib/sockets
+  )
+
+# The Kconfig options of bsdlib are not available on native_posix, set the
+# ones that are used by the offload layer here.
+target_compile_options(app
+  PRIVATE
+  -DCONFIG_NRF91_SOCKET_BLOCK_LIMIT=2048
+  -DCONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE=128
+  )
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BSDLIB_STUB_H__
+#define BSDLIB_STUB_H__
+
+#include <stddef.h>
+#include <zephyr/types.h>
+#include <bsd_limits.h>
+
+/** Events reported by nrf_poll() for each modem socket, masked with the
+ *  events that are polled for.
+ */
+extern short stub_revents[BSD_MAX_SOCKET_COUNT];
+
+/** errno set by nrf_poll(), which then fails, or 0. */
+extern int stub_poll_errno;
+
+/** Address returned by nrf_getaddrinfo(), 192.0.2.1 in network order
+ *  on native_posix.
+ */
+#define STUB_ADDR 0x010200c0
+
+/** Error returned by nrf_getaddrinfo(), or 0 to return @ref STUB_ADDR. */
+extern int stub_getaddrinfo_err;
+
+/** Number of calls to nrf_getaddrinfo(). */
+extern int stub_getaddrinfo_calls;
+
+/** Size of the data buffers of the stub. */
+#define STUB_DATA_SIZE 512
+
+/** Number of calls to nrf_sendto(). */
+extern int stub_sendto_calls;
+
+/** Buffer passed to the last call to nrf_sendto(). */
+extern const void *stub_sendto_buf;
+
+/** Data sent by all calls to nrf_sendto(), and its length. */
+extern uint8_t stub_sent[STUB_DATA_SIZE];
+extern size_t stub_sent_len;
+
+/** Number of calls to nrf_recvfrom(). */
+extern int stub_recvfrom_calls;
+
+/** Buffer and flags passed to the last call to nrf_recvfrom(). */
+extern void *stub_recvfrom_buf;
+extern int stub_recvfrom_flags;
+
+/** Datagram returned by nrf_recvfrom(), from @ref STUB_ADDR, and its
+ *  length. The datagram is truncated to the buffer, but its length is
+ *  returned if NRF_MSG_TRUNC is set.
+ */
+extern uint8_t stub_recv[STUB_DATA_SIZE];
+extern size_t stub_recv_len;
+
+#endif /* BSDLIB_STUB_H__ */
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/dns_resolve.h>
+#include <modem/nrf91_sockets.h>
+
+#include "bsdlib_stub.h"
+#include "nrf91_dns_cache.h"
+
+static struct nrf91_dns_cache_stats stats_start;
+
+static void cache_reset(void)
+{
+	nrf91_dns_cache_flush();
+	nrf91_dns_cache_stats_get(&stats_start);
+	stub_getaddrinfo_err = 0;
+	stub_getaddrinfo_calls = 0;
+}
+
+static void stats_check(uint32_t hits, uint32_t negative_hits,
+			uint32_t misses, uint32_t evictions)
+{
+	struct nrf91_dns_cache_stats s;
+
+	nrf91_dns_cache_stats_get(&s);
+
+	zassert_equal(s.hits - stats_start.hits, hits, "Wrong hits");
+	zassert_equal(s.negative_hits - stats_start.negative_hits,
+		      negative_hits, "Wrong negative hits");
+	zassert_equal(s.misses - stats_start.misses, misses, "Wrong misses");
+	zassert_equal(s.evictions - stats_start.evictions, evictions,
+		      "Wrong evictions");
+}
+
+/* Resolves a name and checks that the stub address is returned. */
+static void resolve(const char *node, const char *service,
+		    const struct addrinfo *hints)
+{
+	struct addrinfo *res;
+	struct sockaddr_in *addr;
+	int err;
+
+	err = getaddrinfo(node, service, hints, &res);
+	zassert_equal(err, 0, "%s not resolved: %d", node, err);
+	zassert_not_null(res, "No address");
+	zassert_is_null(res->ai_next, "Too many addresses");
+	zassert_equal(res->ai_family, AF_INET, "Wrong family");
+	zassert_equal(res->ai_addrlen, sizeof(struct sockaddr_in),
+		      "Wrong address length");
+
+	addr = (struct sockaddr_in *)res->ai_addr;
+	zassert_equal(addr->sin_addr.s_addr, STUB_ADDR, "Wrong address");
+
+	freeaddrinfo(res);
+}
+
+static void test_dns_cache_hit(void)
+{
+	cache_reset();
+
+	resolve("example.com", "80", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 1, "Modem not queried");
+
+	resolve("example.com", "80", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 1, "Cached name resolved");
+
+	stats_check(1, 0, 1, 0);
+}
+
+static void test_dns_cache_key(void)
+{
+	struct addrinfo hints = {
+		.ai_family = AF_INET,
+		.ai_socktype = SOCK_STREAM,
+	};
+
+	cache_reset();
+
+	resolve("example.com", "80", NULL);
+	resolve("example.com", "443", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 2, "Service not in the key");
+
+	resolve("example.com", "80", &hints);
+	zassert_equal(stub_getaddrinfo_calls, 3, "Hints not in the key");
+
+	resolve("example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 4, "Service not in the key");
+
+	resolve("example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 4, "Cached name resolved");
+}
+
+static void test_dns_cache_expiry(void)
+{
+	cache_reset();
+
+	resolve("example.com", NULL, NULL);
+	k_sleep(K_MSEC(500));
+	resolve("example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 1, "Entry expired early");
+
+	k_sleep(K_MSEC(600));
+	resolve("example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 2, "Entry not expired");
+
+	stats_check(1, 0, 2, 0);
+}
+
+static void test_dns_cache_negative(void)
+{
+	struct addrinfo *res;
+	int err;
+
+	cache_reset();
+
+	/* The modem reports names that do not exist with EAFNOSUPPORT. */
+	stub_getaddrinfo_err = NRF_EAFNOSUPPORT;
+
+	for (int i = 0; i < 2; i++) {
+		err = getaddrinfo("nonexistent.example.com", NULL, NULL, &res);
+		zassert_equal(err, DNS_EAI_NONAME, "Wrong error: %d", err);
+	}
+	zassert_equal(stub_getaddrinfo_calls, 1, "Failure not cached");
+
+	/* Temporary failures are retried. */
+	stub_getaddrinfo_err = NRF_EAGAIN;
+
+	for (int i = 0; i < 2; i++) {
+		err = getaddrinfo("example.com", NULL, NULL, &res);
+		zassert_equal(err, DNS_EAI_AGAIN, "Wrong error: %d", err);
+	}
+	zassert_equal(stub_getaddrinfo_calls, 3, "Temporary failure cached");
+
+	stub_getaddrinfo_err = 0;
+	k_sleep(K_MSEC(1100));
+	resolve("nonexistent.example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 4, "Failure not expired");
+
+	stats_check(0, 1, 4, 0);
+}
+
+static void test_dns_cache_eviction(void)
+{
+	cache_reset();
+
+	/* The cache holds two entries, the least recently used is evicted. */
+	resolve("a.example.com", NULL, NULL);
+	k_sleep(K_MSEC(10));
+	resolve("b.example.com", NULL, NULL);
+	k_sleep(K_MSEC(10));
+	resolve("a.example.com", NULL, NULL);
+	k_sleep(K_MSEC(10));
+	resolve("c.example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 3, "Wrong number of queries");
+
+	resolve("a.example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 3, "Recently used entry evicted");
+
+	resolve("b.example.com", NULL, NULL);
+	zassert_equal(stub_getaddrinfo_calls, 4, "Least recent entry kept");
+
+	stats_check(2, 0, 4, 2);
+}
+
+static void test_dns_cache_prefetch(void)
+{
+	int err;
+
+	cache_reset();
+
+	err = nrf91_dns_cache_prefetch("example.com", "80", NULL);
+	zassert_equal(err, 0, "Prefetch failed: %d", err);
+
+	/* A prefetch refreshes a cached entry. */
+	err = nrf91_dns_cache_prefetch("example.com", "80", NULL);
+	zassert_equal(err, 0, "Prefetch failed: %d", err);
+	zassert_equal(stub_getaddrinfo_calls, 2, "Entry not refreshed");
+
+	resolve("example.com", "80", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 2, "Prefetched name resolved");
+
+	nrf91_dns_cache_flush();
+	resolve("example.com", "80", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 3, "Entry not flushed");
+}
+
+static void test_dns_cache_invalidate(void)
+{
+	cache_reset();
+
+	resolve("example.com", "80", NULL);
+	resolve("example.com", "443", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 2, "Wrong number of queries");
+
+	/* All the entries of the host are removed. */
+	nrf91_dns_cache_invalidate("example.com");
+	resolve("example.com", "80", NULL);
+	resolve("example.com", "443", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 4, "Entry not invalidated");
+
+	nrf91_dns_cache_invalidate("other.example.com");
+	resolve("example.com", "80", NULL);
+	zassert_equal(stub_getaddrinfo_calls, 4, "Other host invalidated");
+}
+
+static void test_dns_cache_canonname(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = STUB_ADDR,
+	};
+	struct addrinfo second = {
+		.ai_family = AF_INET,
+		.ai_socktype = SOCK_STREAM,
+		.ai_addrlen = sizeof(addr),
+		.ai_addr = (struct sockaddr *)&addr,
+	};
+	struct addrinfo first = {
+		.ai_next = &second,
+		.ai_flags = AI_CANONNAME,
+		.ai_family = AF_INET,
+		.ai_socktype = SOCK_STREAM,
+		.ai_addrlen = sizeof(addr),
+		.ai_addr = (struct sockaddr *)&addr,
+		.ai_canonname = "host.example.com",
+	};
+	struct addrinfo *res;
+	bool cached;
+	int err;
+
+	cache_reset();
+
+	nrf91_dns_cache_store("example.com", NULL, NULL, 0, &first);
+
+	cached = nrf91_dns_cache_lookup("example.com", NULL, NULL, &res, &err);
+	zassert_true(cached, "Entry not cached");
+	zassert_equal(err, 0, "Wrong error: %d", err);
+
+	zassert_equal(res->ai_flags, AI_CANONNAME, "Flags not copied");
+	zassert_not_null(res->ai_canonname, "Canonical name not copied");
+	zassert_true(strcmp(res->ai_canonname, "host.example.com") == 0,
+		     "Wrong canonical name");
+	zassert_not_equal(res->ai_canonname, first.ai_canonname,
+			  "Canonical name not allocated");
+
+	zassert_not_null(res->ai_next, "Second address not copied");
+	zassert_equal(res->ai_next->ai_flags, 0, "Wrong flags");
+	zassert_is_null(res->ai_next->ai_canonname, "Canonical name repeated");
+
+	freeaddrinfo(res);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf91_dns_cache_test,
+		ztest_unit_test(test_dns_cache_hit),
+		ztest_unit_test(test_dns_cache_key),
+		ztest_unit_test(test_dns_cache_expiry),
+		ztest_unit_test(test_dns_cache_negative),
+		ztest_unit_test(test_dns_cache_eviction),
+		ztest_unit_test(test_dns_cache_prefetch),
+		ztest_unit_test(test_dns_cache_invalidate),
+		ztest_unit_test(test_dns_cache_canonname)
+	);
+
+	ztest_run_test_suite(nrf91_dns_cache_test);
+}
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <modem/nrf91_sockets.h>
+#include <nrf_socket.h>
+
+#include "bsdlib_stub.h"
+#include "benchmark.h"
+
+#define BENCHMARK_ROUNDS 10000
+
+/* CoAP header and payload. */
+#define HEADER_LEN 4
+#define PAYLOAD_LEN 60
+
+static int fd;
+static uint8_t header[HEADER_LEN];
+static uint8_t payload[CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE * 2];
+
+static void stub_reset(void)
+{
+	stub_sendto_calls = 0;
+	stub_sent_len = 0;
+	stub_recvfrom_calls = 0;
+}
+
+static void msg_init(struct msghdr *msg, struct iovec *iov, size_t iovlen)
+{
+	memset(msg, 0, sizeof(*msg));
+	msg->msg_iov = iov;
+	msg->msg_iovlen = iovlen;
+}
+
+static void data_init(void)
+{
+	for (size_t i = 0; i < sizeof(header); i++) {
+		header[i] = 0x40 + i;
+	}
+
+	for (size_t i = 0; i < sizeof(payload); i++) {
+		payload[i] = i;
+	}
+
+	for (size_t i = 0; i < sizeof(stub_recv); i++) {
+		stub_recv[i] = ~i;
+	}
+}
+
+static void setup(void)
+{
+	fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(fd >= 0, "Socket not created");
+}
+
+static void teardown(void)
+{
+	zassert_equal(close(fd), 0, "Socket not closed");
+}
+
+static void test_sendmsg_single(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = header, .iov_len = 0 },
+		{ .iov_base = payload, .iov_len = PAYLOAD_LEN },
+	};
+	struct msghdr msg;
+	ssize_t ret;
+
+	stub_reset();
+	msg_init(&msg, iov, ARRAY_SIZE(iov));
+
+	ret = sendmsg(fd, &msg, 0);
+	zassert_equal(ret, PAYLOAD_LEN, "Wrong length: %zd", ret);
+	zassert_equal(stub_sendto_calls, 1, "Wrong number of calls");
+	zassert_equal_ptr(stub_sendto_buf, payload, "Payload copied");
+}
+
+static void test_sendmsg_gather(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = header, .iov_len = HEADER_LEN },
+		{ .iov_base = payload, .iov_len = PAYLOAD_LEN },
+	};
+	struct msghdr msg;
+	ssize_t ret;
+
+	stub_reset();
+	msg_init(&msg, iov, ARRAY_SIZE(iov));
+
+	ret = sendmsg(fd, &msg, 0);
+	zassert_equal(ret, HEADER_LEN + PAYLOAD_LEN, "Wrong length: %zd", ret);
+	zassert_equal(stub_sendto_calls, 1, "Datagram split");
+	zassert_mem_equal(stub_sent, header, HEADER_LEN, "Wrong header");
+	zassert_mem_equal(stub_sent + HEADER_LEN, payload, PAYLOAD_LEN,
+			  "Wrong payload");
+}
+
+static void test_sendmsg_large(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = header, .iov_len = HEADER_LEN },
+		{ .iov_base = payload, .iov_len = sizeof(payload) },
+	};
+	struct msghdr msg;
+	ssize_t ret;
+
+	stub_reset();
+	msg_init(&msg, iov, ARRAY_SIZE(iov));
+
+	/* Parts that do not fit into the buffer are sent separately. */
+	ret = sendmsg(fd, &msg, 0);
+	zassert_equal(ret, HEADER_LEN + sizeof(payload), "Wrong length: %zd",
+		      ret);
+	zassert_equal(stub_sendto_calls, 2, "Wrong number of calls");
+	zassert_equal_ptr(stub_sendto_buf, payload, "Payload copied");
+	zassert_mem_equal(stub_sent + HEADER_LEN, payload, sizeof(payload),
+			  "Wrong payload");
+}
+
+static void test_recvmsg_single(void)
+{
+	uint8_t buf[PAYLOAD_LEN];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct sockaddr_in from;
+	struct msghdr msg;
+	ssize_t ret;
+
+	stub_reset();
+	stub_recv_len = PAYLOAD_LEN / 2;
+	msg_init(&msg, &iov, 1);
+	msg.msg_name = &from;
+	msg.msg_namelen = sizeof(from);
+
+	ret = nrf91_socket_recvmsg(fd, &msg, 0);
+	zassert_equal(ret, PAYLOAD_LEN / 2, "Wrong length: %zd", ret);
+	zassert_equal(stub_recvfrom_calls, 1, "Wrong number of calls");
+	zassert_equal_ptr(stub_recvfrom_buf, buf, "Data copied");
+	zassert_mem_equal(buf, stub_recv, ret, "Wrong data");
+	zassert_equal(msg.msg_namelen, sizeof(from), "Wrong address length");
+	zassert_equal(from.sin_family, AF_INET, "Wrong family");
+	zassert_equal(from.sin_addr.s_addr, STUB_ADDR, "Wrong address");
+}
+
+static void test_recvmsg_scatter(void)
+{
+	uint8_t hdr[HEADER_LEN];
+	uint8_t buf[sizeof(payload)];
+	struct iovec iov[] = {
+		{ .iov_base = hdr, .iov_len = sizeof(hdr) },
+		{ .iov_base = buf, .iov_len = PAYLOAD_LEN },
+	};
+	struct msghdr msg;
+	ssize_t ret;
+
+	stub_reset();
+	stub_recv_len = HEADER_LEN + PAYLOAD_LEN / 2;
+	msg_init(&msg, iov, ARRAY_SIZE(iov));
+
+	/* The datagram is received in one call. */
+	ret = nrf91_socket_recvmsg(fd, &msg, 0);
+	zassert_equal(ret, stub_recv_len, "Wrong length: %zd", ret);
+	zassert_equal(stub_recvfrom_calls, 1, "Datagram split");
+	zassert_mem_equal(hdr, stub_recv, HEADER_LEN, "Wrong header");
+	zassert_mem_equal(buf, stub_recv + HEADER_LEN, PAYLOAD_LEN / 2,
+			  "Wrong payload");
+
+	/* Datagrams larger than the intermediate buffer are received too. */
+	stub_recv_len = sizeof(stub_recv);
+	iov[1].iov_len = sizeof(buf);
+	memset(buf, 0, sizeof(buf));
+
+	ret = nrf91_socket_recvmsg(fd, &msg, 0);
+	zassert_equal(ret, HEADER_LEN + sizeof(buf), "Wrong length: %zd", ret);
+	zassert_equal(stub_recvfrom_calls, 2, "Datagram split");
+	zassert_mem_equal(buf, stub_recv + HEADER_LEN, sizeof(buf),
+			  "Wrong payload");
+}
+
+static void test_recvmsg_trunc(void)
+{
+	uint8_t hdr[HEADER_LEN];
+	uint8_t buf[PAYLOAD_LEN];
+	struct iovec iov[] = {
+		{ .iov_base = hdr, .iov_len = sizeof(hdr) },
+		{ .iov_base = buf, .iov_len = sizeof(buf) },
+	};
+	struct msghdr msg;
+	ssize_t ret;
+	int tcp;
+
+	stub_reset();
+	stub_recv_len = HEADER_LEN + PAYLOAD_LEN;
+
+	/* A datagram that fits is not truncated. */
+	msg_init(&msg, iov, ARRAY_SIZE(iov));
+	ret = nrf91_socket_recvmsg(fd, &msg, 0);
+	zassert_equal(ret, stub_recv_len, "Wrong length: %zd", ret);
+	zassert_equal(msg.msg_flags, 0, "Datagram truncated");
+
+	/* Longer datagrams are truncated, into one or several buffers. */
+	stub_recv_len = HEADER_LEN + PAYLOAD_LEN + 1;
+
+	ret = nrf91_socket_recvmsg(fd, &msg, 0);
+	zassert_equal(ret, HEADER_LEN + PAYLOAD_LEN, "Wrong length: %zd", ret);
+	zassert_equal(msg.msg_flags, MSG_TRUNC, "Truncation not reported");
+	zassert_mem_equal(buf, stub_recv + HEADER_LEN, PAYLOAD_LEN,
+			  "Wrong payload");
+
+	msg_init(&msg, &iov[1], 1);
+	ret = nrf91_socket_recvmsg(fd, &msg, 0);
+	zassert_equal(ret, PAYLOAD_LEN, "Wrong length: %zd", ret);
+	zassert_equal(msg.msg_flags, MSG_TRUNC, "Truncation not reported");
+
+	/* The real length is returned when requested. */
+	ret = nrf91_socket_recvmsg(fd, &msg, MSG_TRUNC);
+	zassert_equal(ret, stub_recv_len, "Wrong length: %zd", ret);
+	zassert_equal(msg.msg_flags, MSG_TRUNC, "Truncation not reported");
+
+	/* Stream sockets have no datagrams to truncate. */
+	tcp = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(tcp >= 0, "Socket not created");
+
+	ret = nrf91_socket_recvmsg(tcp, &msg, 0);
+	zassert_equal(ret, PAYLOAD_LEN, "Wrong length: %zd", ret);
+	zassert_equal(msg.msg_flags, 0, "Stream truncated");
+	zassert_false(stub_recvfrom_flags & NRF_MSG_TRUNC,
+		      "Real length requested on a stream");
+
+	zassert_equal(close(tcp), 0, "Socket not closed");
+}
+
+static void test_recvmsg_invalid(void)
+{
+	uint8_t buf[HEADER_LEN];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct msghdr msg;
+
+	msg_init(&msg, &iov, 1);
+
+	zassert_equal(nrf91_socket_recvmsg(fd, NULL, 0), -1, NULL);
+	zassert_equal(errno, EINVAL, "Wrong errno: %d", errno);
+	zassert_equal(nrf91_socket_recvmsg(0x7fff, &msg, 0), -1, NULL);
+	zassert_equal(errno, EBADF, "Wrong errno: %d", errno);
+}
+
+/* Reports the calls to the modem and the copies of the payload made for
+ * each datagram.
+ */
+static void benchmark(const char *name, struct iovec *iov, size_t iovlen)
+{
+	struct msghdr msg;
+	uint32_t send_ns;
+	uint32_t recv_ns;
+	int copies = 0;
+	uint64_t start;
+	ssize_t ret;
+
+	msg_init(&msg, iov, iovlen);
+	stub_recv_len = HEADER_LEN + PAYLOAD_LEN;
+	stub_reset();
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		stub_sent_len = 0;
+		ret = sendmsg(fd, &msg, 0);
+		zassert_equal(ret, HEADER_LEN + PAYLOAD_LEN, "sendmsg failed");
+		copies += stub_sendto_buf != iov[iovlen - 1].iov_base;
+	}
+	send_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	TC_PRINT("sendmsg, %s: %d calls, %d copies for %d datagrams, "
+		 "%5u ns per datagram\n", name, stub_sendto_calls, copies,
+		 BENCHMARK_ROUNDS, send_ns);
+
+	copies = 0;
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		ret = nrf91_socket_recvmsg(fd, &msg, 0);
+		zassert_equal(ret, HEADER_LEN + PAYLOAD_LEN, "recvmsg failed");
+		copies += stub_recvfrom_buf != iov[0].iov_base;
+	}
+	recv_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	TC_PRINT("recvmsg, %s: %d calls, %d copies for %d datagrams, "
+		 "%5u ns per datagram\n", name, stub_recvfrom_calls, copies,
+		 BENCHMARK_ROUNDS, recv_ns);
+}
+
+static void test_msg_benchmark(void)
+{
+	uint8_t datagram[HEADER_LEN + PAYLOAD_LEN];
+	uint8_t hdr[HEADER_LEN];
+	struct iovec single[] = {
+		{ .iov_base = datagram, .iov_len = sizeof(datagram) },
+	};
+	struct iovec parts[] = {
+		{ .iov_base = hdr, .iov_len = sizeof(hdr) },
+		{ .iov_base = payload, .iov_len = PAYLOAD_LEN },
+	};
+
+	benchmark("1 part ", single, ARRAY_SIZE(single));
+	benchmark("2 parts", parts, ARRAY_SIZE(parts));
+}
+
+void test_main(void)
+{
+	data_init();
+
+	ztest_test_suite(nrf91_sockets_msg_test,
+		ztest_unit_test_setup_teardown(test_sendmsg_single,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_sendmsg_gather,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_sendmsg_large,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_recvmsg_single,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_recvmsg_scatter,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_recvmsg_trunc,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_recvmsg_invalid,
+					       setup, teardown),
+		ztest_unit_test_setup_teardown(test_msg_benchmark,
+					       setup, teardown)
+	);
+
+	ztest_run_test_suite(nrf91_sockets_msg_test);
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <modem/nrf91_sockets.h>
+
+#include "bsdlib_stub.h"
+#include "benchmark.h"
+
+#define BENCHMARK_ROUNDS 10000
+
+static int fds[BSD_MAX_SOCKET_COUNT];
+
+static void sockets_open(size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		fds[i] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		zassert_true(fds[i] >= 0, "Socket %zu not created", i);
+	}
+
+	memset(stub_revents, 0, sizeof(stub_revents));
+}
+
+static void sockets_close(size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		zassert_equal(close(fds[i]), 0, "Socket %zu not closed", i);
+	}
+}
+
+static void test_poll(void)
+{
+	struct pollfd pfds[3];
+	int ret;
+
+	sockets_open(2);
+
+	/* Modem sockets are allocated in order by the stub. */
+	stub_revents[1] = NRF_POLLIN | NRF_POLLOUT | NRF_POLLHUP;
+
+	pfds[0].fd = fds[0];
+	pfds[0].events = POLLIN;
+	pfds[1].fd = fds[1];
+	pfds[1].events = POLLIN;
+	pfds[2].fd = -1;
+	pfds[2].events = POLLIN;
+	pfds[2].revents = POLLIN;
+
+	ret = poll(pfds, ARRAY_SIZE(pfds), 0);
+	zassert_equal(ret, 1, "Wrong number of ready sockets: %d", ret);
+	zassert_equal(pfds[0].revents, 0, "Idle socket reported");
+	zassert_equal(pfds[1].revents, POLLIN | POLLHUP, "Wrong events: %x",
+		      pfds[1].revents);
+	zassert_equal(pfds[2].revents, 0, "Negative fd not ignored");
+
+	sockets_close(2);
+}
+
+static void test_pollset(void)
+{
+	struct nrf91_pollset set;
+	struct nrf91_poll_event events[BSD_MAX_SOCKET_COUNT];
+	int ret;
+
+	nrf91_pollset_init(&set);
+	sockets_open(BSD_MAX_SOCKET_COUNT);
+
+	zassert_equal(nrf91_pollset_wait(&set, events, 1, 0), -EINVAL,
+		      "Empty set waited on");
+	zassert_equal(nrf91_pollset_add(&set, 0x7fff, POLLIN), -EBADF, NULL);
+
+	for (int i = 0; i < BSD_MAX_SOCKET_COUNT; i++) {
+		ret = nrf91_pollset_add(&set, fds[i], POLLIN);
+		zassert_equal(ret, 0, "Socket %d not added: %d", i, ret);
+	}
+
+	zassert_equal(nrf91_pollset_add(&set, fds[0], POLLIN), -EEXIST, NULL);
+	zassert_equal(nrf91_pollset_add(&set, 0, POLLIN), -ENOMEM, NULL);
+	zassert_equal(nrf91_pollset_modify(&set, 0x7fff, POLLIN), -ENOENT,
+		      NULL);
+	zassert_equal(nrf91_pollset_remove(&set, 0x7fff), -ENOENT, NULL);
+
+	ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+	zassert_equal(ret, 0, "Idle sockets reported: %d", ret);
+
+	/* Only the sockets with events are reported, with native flags. */
+	stub_revents[2] = NRF_POLLIN;
+	stub_revents[5] = NRF_POLLOUT | NRF_POLLERR;
+	ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+	zassert_equal(ret, 2, "Wrong number of events: %d", ret);
+	zassert_equal(events[0].fd, fds[2], "Wrong socket");
+	zassert_equal(events[0].revents, POLLIN, "Wrong events");
+	zassert_equal(events[1].fd, fds[5], "Wrong socket");
+	zassert_equal(events[1].revents, POLLERR, "Wrong events");
+
+	ret = nrf91_pollset_modify(&set, fds[5], POLLIN | POLLOUT);
+	zassert_equal(ret, 0, "Events not modified: %d", ret);
+	ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+	zassert_equal(ret, 2, "Wrong number of events: %d", ret);
+	zassert_equal(events[1].revents, POLLOUT | POLLERR, "Wrong events");
+
+	/* With fewer event slots, the sockets are served in turn. */
+	ret = nrf91_pollset_wait(&set, events, 1, 0);
+	zassert_equal(ret, 1, "Wrong number of events: %d", ret);
+	zassert_equal(events[0].fd, fds[2], "Wrong socket");
+	ret = nrf91_pollset_wait(&set, events, 1, 0);
+	zassert_equal(ret, 1, "Wrong number of events: %d", ret);
+	zassert_equal(events[0].fd, fds[5], "Socket starved");
+	ret = nrf91_pollset_wait(&set, events, 1, 0);
+	zassert_equal(ret, 1, "Wrong number of events: %d", ret);
+	zassert_equal(events[0].fd, fds[2], "Socket starved");
+
+	ret = nrf91_pollset_remove(&set, fds[2]);
+	zassert_equal(ret, 0, "Socket not removed: %d", ret);
+	ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+	zassert_equal(ret, 1, "Removed socket reported: %d", ret);
+	zassert_equal(events[0].fd, fds[5], "Wrong socket");
+
+	ret = nrf91_pollset_add(&set, fds[2], POLLOUT);
+	zassert_equal(ret, 0, "Socket not added back: %d", ret);
+
+	sockets_close(BSD_MAX_SOCKET_COUNT);
+}
+
+static void test_pollset_error(void)
+{
+	struct nrf91_pollset set;
+	struct nrf91_poll_event events[1];
+	int ret;
+
+	nrf91_pollset_init(&set);
+	sockets_open(1);
+	zassert_equal(nrf91_pollset_add(&set, fds[0], POLLIN), 0, NULL);
+
+	stub_poll_errno = ENOMEM;
+	ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+	zassert_equal(ret, -ENOMEM, "Wrong error: %d", ret);
+
+	/* Set by bsd_os_errno_set() for an untranslated error */
+	stub_poll_errno = (int)0xBAADBAAD;
+	ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+	zassert_equal(ret, -EIO, "Wrong error: %d", ret);
+
+	stub_poll_errno = 0;
+	sockets_close(1);
+}
+
+static void benchmark(size_t count)
+{
+	struct pollfd pfds[BSD_MAX_SOCKET_COUNT];
+	struct nrf91_pollset set;
+	struct nrf91_poll_event events[BSD_MAX_SOCKET_COUNT];
+	uint32_t poll_ns;
+	uint32_t pollset_ns;
+	uint64_t start;
+	int ret;
+
+	sockets_open(count);
+	nrf91_pollset_init(&set);
+
+	for (size_t i = 0; i < count; i++) {
+		pfds[i].fd = fds[i];
+		pfds[i].events = POLLIN;
+		zassert_equal(nrf91_pollset_add(&set, fds[i], POLLIN), 0,
+			      NULL);
+	}
+
+	/* Data is always available on the last socket. */
+	stub_revents[count - 1] = NRF_POLLIN;
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		ret = poll(pfds, count, 0);
+		zassert_equal(ret, 1, "poll() failed: %d", ret);
+	}
+	poll_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		ret = nrf91_pollset_wait(&set, events, ARRAY_SIZE(events), 0);
+		zassert_equal(ret, 1, "Wait failed: %d", ret);
+	}
+	pollset_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	TC_PRINT("%zu socket(s): poll() %5u ns, pollset %5u ns per wakeup\n",
+		 count, poll_ns, pollset_ns);
+
+	sockets_close(count);
+}
+
+static void test_poll_benchmark(void)
+{
+	benchmark(1);
+	benchmark(4);
+	benchmark(8);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf91_sockets_poll_test,
+	     ztest_unit_test(test_poll),
+	     ztest_unit_test(test_pollset),
+	     ztest_unit_test(test_pollset_error),
+	     ztest_unit_test(test_poll_benchmark)
+	 );
+
+	ztest_run_test_suite(nrf91_sockets_poll_test);
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <cJSON.h>
+#include <json_tok.h>
+
+#include "benchmark.h"
+
+#define BENCHMARK_ROUNDS 1000
+#define HEAP_BLOCKS_MAX 128
+#define TOKENS_MAX 64
+
+/* Shadow delta received from nRF Cloud when the device is paired. */
+static const char shadow_delta[] =
+	"{\"version\":204,\"timestamp\":1592310000,\"state\":{"
+	"\"pairing\":{\"state\":\"paired\",\"topics\":{"
+	"\"d2c\":\"prod/a0b1c2d3/nrf-352656100000000/d2c\","
+	"\"c2d\":\"prod/a0b1c2d3/nrf-352656100000000/c2d\"}},"
+	"\"nrfcloud_mqtt_topic_prefix\":\"prod/a0b1c2d3/\","
+	"\"config\":{\"GPS\":{\"enable\":true},\"TEMP\":{\"enable\":false},"
+	"\"HUMID\":{\"enable\":true}}},"
+	"\"metadata\":{\"pairing\":{\"state\":{\"timestamp\":1592310000}}}}";
+
+/* DescribeJobExecution response received from AWS IoT Jobs. */
+static const char job_document[] =
+	"{\"clientToken\":\"\",\"timestamp\":1592310000,\"execution\":{"
+	"\"jobId\":\"9b5caac6-3e8a-45dd-9273-c1b995762f4a\","
+	"\"status\":\"QUEUED\",\"queuedAt\":1592309990,"
+	"\"lastUpdatedAt\":1592309990,\"versionNumber\":1,"
+	"\"executionNumber\":1,\"jobDocument\":{"
+	"\"operation\":\"app_fw_update\",\"fwversion\":\"v1.0.2\","
+	"\"size\":181124,\"location\":{\"protocol\":\"https:\","
+	"\"host\":\"fota-update-bucket.s3.eu-central-1.amazonaws.com\","
+	"\"path\":\"/update.bin?X-Amz-Algorithm=AWS4-HMAC-SHA256&X-Amz-Date="
+	"20200616T120000Z&X-Amz-Expires=604800\"}}}}";
+
+static struct json_tok toks[TOKENS_MAX];
+static struct json_tok_doc doc;
+
+/* Heap usage of cJSON, tracked through its allocation hooks. */
+static struct {
+	void *ptr;
+	size_t size;
+} heap_blocks[HEAP_BLOCKS_MAX];
+static size_t heap_used;
+static size_t heap_peak;
+
+static void *malloc_hook(size_t size)
+{
+	void *ptr = k_malloc(size);
+
+	for (size_t i = 0; ptr && i < ARRAY_SIZE(heap_blocks); i++) {
+		if (heap_blocks[i].ptr == NULL) {
+			heap_blocks[i].ptr = ptr;
+			heap_blocks[i].size = size;
+			heap_used += size;
+			heap_peak = MAX(heap_peak, heap_used);
+			break;
+		}
+	}
+
+	return ptr;
+}
+
+static void free_hook(void *ptr)
+{
+	for (size_t i = 0; ptr && i < ARRAY_SIZE(heap_blocks); i++) {
+		if (heap_blocks[i].ptr == ptr) {
+			heap_used -= heap_blocks[i].size;
+			heap_blocks[i].ptr = NULL;
+			break;
+		}
+	}
+
+	k_free(ptr);
+}
+
+static int parse(const char *json)
+{
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
+
+	return json_tok_parse(&doc, json, strlen(json));
+}
+
+static void test_parse(void)
+{
+	int err;
+
+	err = parse("{\"a\":[1,-2.5e3,\"x\",true,false,null,{},[]],\"b\":{}}");
+	zassert_equal(err, 0, "Parsing failed: %d", err);
+	zassert_equal(doc.count, 13, "Wrong token count: %d", doc.count);
+	zassert_equal(json_tok_type_get(&doc, 0), JSON_TOK_OBJECT, NULL);
+	zassert_equal(doc.toks[0].next, doc.count, "Root does not span all");
+	zassert_equal(json_tok_type_get(&doc, 2), JSON_TOK_ARRAY, NULL);
+	zassert_equal(doc.toks[2].next, 11, "Wrong next token");
+	zassert_equal(json_tok_type_get(&doc, 4), JSON_TOK_NUMBER, NULL);
+	zassert_equal(json_tok_type_get(&doc, 6), JSON_TOK_TRUE, NULL);
+	zassert_equal(json_tok_type_get(&doc, 8), JSON_TOK_NULL, NULL);
+
+	err = parse(" \"top\" ");
+	zassert_equal(err, 0, "Parsing of a string failed: %d", err);
+	zassert_equal(json_tok_type_get(&doc, 0), JSON_TOK_STRING, NULL);
+
+	/* Only the given length is tokenized. */
+	json_tok_init(&doc, toks, ARRAY_SIZE(toks));
+	err = json_tok_parse(&doc, "{\"a\":1}garbage", 7);
+	zassert_equal(err, 0, "Length not respected: %d", err);
+}
+
+static void test_parse_invalid(void)
+{
+	static const char * const invalid[] = {
+		"", "{", "}", "[1,]", "{\"a\"}", "{\"a\":1,}", "{\"a\":1]",
+		"[1}", "[1 2]", "{1:2}", "tru", "nul", "\"abc", "\"\\x\"",
+		"\"\\u12g4\"", "\"a\nb\"", "{} {}", "[1]]", "+1", "[,1]",
+		"{\"a\":1\"b\":2}",
+	};
+	char deep[2 * CONFIG_JSON_TOK_MAX_DEPTH + 3] = { 0 };
+	size_t depth = CONFIG_JSON_TOK_MAX_DEPTH + 1;
+	struct json_tok few[2];
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(invalid); i++) {
+		err = parse(invalid[i]);
+		zassert_equal(err, -EINVAL, "'%s' accepted: %d", invalid[i],
+			      err);
+		zassert_equal(doc.count, 0, "Tokens kept after error");
+	}
+
+	json_tok_init(&doc, few, ARRAY_SIZE(few));
+	err = json_tok_parse(&doc, "[1,2]", 5);
+	zassert_equal(err, -ENOMEM, "Token overflow not detected: %d", err);
+
+	memset(deep, '[', depth);
+	memset(&deep[depth], ']', depth);
+	err = parse(deep);
+	zassert_equal(err, -E2BIG, "Nesting overflow not detected: %d", err);
+
+	/* Drop one level on both ends. */
+	deep[2 * depth - 1] = '\0';
+	err = parse(&deep[1]);
+	zassert_equal(err, 0, "Maximum nesting rejected: %d", err);
+}
+
+static void test_find(void)
+{
+	int err;
+	int tok;
+
+	err = parse(shadow_delta);
+	zassert_equal(err, 0, "Parsing failed: %d", err);
+
+	tok = json_tok_find(&doc, 0, "state.pairing.state");
+	zassert_true(json_tok_str_eq(&doc, tok, "paired"), "Wrong state");
+
+	tok = json_tok_find(&doc, 0, "state.pairing.topics");
+	zassert_equal(json_tok_type_get(&doc, tok), JSON_TOK_OBJECT, NULL);
+	tok = json_tok_find(&doc, tok, "c2d");
+	zassert_true(json_tok_str_eq(&doc, tok,
+				     "prod/a0b1c2d3/nrf-352656100000000/c2d"),
+		     "Wrong topic");
+
+	/* Keys are matched at the right level only. */
+	tok = json_tok_find(&doc, 0, "metadata.pairing.state.timestamp");
+	zassert_true(tok > 0, "Nested key not found");
+	zassert_equal(json_tok_find(&doc, 0, "pairing"), -ENOENT, NULL);
+	zassert_equal(json_tok_find(&doc, 0, "state.config.GPS.enabled"),
+		      -ENOENT, NULL);
+	zassert_equal(json_tok_find(&doc, 0, "version.x"), -ENOENT, NULL);
+
+	/* Errors are passed through. */
+	zassert_equal(json_tok_find(&doc, -ENOENT, "state"), -ENOENT, NULL);
+
+	err = parse("{\"a\":[{\"b\":1},{\"b\":[7,8,9]}]}");
+	zassert_equal(err, 0, "Parsing failed: %d", err);
+	tok = json_tok_find(&doc, 0, "a.1.b.2");
+	zassert_equal(doc.json[doc.toks[tok].start], '9', "Wrong element");
+	zassert_equal(json_tok_find(&doc, 0, "a.2"), -ENOENT, NULL);
+	zassert_equal(json_tok_find(&doc, 0, "a.x"), -ENOENT, NULL);
+	zassert_equal(json_tok_find(&doc, 0, ""), 0, "Empty path not root");
+}
+
+static void test_str_copy(void)
+{
+	char buf[16];
+	int len;
+	int err;
+
+	err = parse("[\"a\\\"b\\\\c\\/\\n\",\"\\u00e6\\u20ac\\ud83d\\ude00\","
+		    "\"\\ud83d\",\"0123456789abcdef\",\"\\u20ac\\u20ac\",1]");
+	zassert_equal(err, 0, "Parsing failed: %d", err);
+
+	len = json_tok_str_copy(&doc, 1, buf, sizeof(buf));
+	zassert_equal(len, 7, "Wrong length: %d", len);
+	zassert_equal(strcmp(buf, "a\"b\\c/\n"), 0, "Wrong string");
+
+	len = json_tok_str_copy(&doc, 2, buf, sizeof(buf));
+	zassert_equal(len, 9, "Wrong length: %d", len);
+	zassert_equal(strcmp(buf, "\xc3\xa6\xe2\x82\xac\xf0\x9f\x98\x80"), 0,
+		      "Wrong UTF-8");
+
+	len = json_tok_str_copy(&doc, 3, buf, sizeof(buf));
+	zassert_equal(strcmp(buf, "\xef\xbf\xbd"), 0, "Surrogate not replaced");
+
+	/* Truncated like snprintf, without splitting characters. */
+	len = json_tok_str_copy(&doc, 4, buf, sizeof(buf));
+	zassert_equal(len, 16, "Wrong length: %d", len);
+	zassert_equal(strcmp(buf, "0123456789abcde"), 0, "Wrong truncation");
+
+	len = json_tok_str_copy(&doc, 5, buf, 5);
+	zassert_equal(len, 6, "Wrong length: %d", len);
+	zassert_equal(strcmp(buf, "\xe2\x82\xac"), 0, "Character split");
+
+	len = json_tok_str_copy(&doc, 4, NULL, 0);
+	zassert_equal(len, 16, "Wrong length: %d", len);
+
+	len = json_tok_str_copy(&doc, 6, buf, sizeof(buf));
+	zassert_equal(len, -EINVAL, "Number copied as a string");
+}
+
+static void test_int_get(void)
+{
+	int value;
+	int err;
+
+	err = parse("[0,-17,2147483647,-2147483648,2147483648,1.5,\"1\"]");
+	zassert_equal(err, 0, "Parsing failed: %d", err);
+
+	zassert_equal(json_tok_int_get(&doc, 1, &value), 0, NULL);
+	zassert_equal(value, 0, NULL);
+	zassert_equal(json_tok_int_get(&doc, 2, &value), 0, NULL);
+	zassert_equal(value, -17, NULL);
+	zassert_equal(json_tok_int_get(&doc, 3, &value), 0, NULL);
+	zassert_equal(value, INT32_MAX, NULL);
+	zassert_equal(json_tok_int_get(&doc, 4, &value), 0, NULL);
+	zassert_equal(value, INT32_MIN, NULL);
+	zassert_equal(json_tok_int_get(&doc, 5, &value), -ERANGE, NULL);
+	zassert_equal(json_tok_int_get(&doc, 6, &value), -EINVAL, NULL);
+	zassert_equal(json_tok_int_get(&doc, 7, &value), -EINVAL, NULL);
+}
+
+static void benchmark(const char *name, const char *json, const char *path)
+{
+	uint32_t cjson_ns;
+	uint32_t tok_ns;
+	uint64_t start;
+	int err;
+
+	heap_peak = 0;
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		cJSON *root = cJSON_Parse(json);
+		cJSON *obj = root;
+
+		zassert_not_null(root, "cJSON parsing failed");
+
+		for (const char *key = path; obj && key; ) {
+			char tmp[32];
+			const char *end = strchr(key, '.');
+			size_t len = end ? end - key : strlen(key);
+
+			memcpy(tmp, key, len);
+			tmp[len] = '\0';
+			obj = cJSON_GetObjectItem(obj, tmp);
+			key = end ? end + 1 : NULL;
+		}
+
+		zassert_not_null(obj, "cJSON lookup failed");
+		cJSON_Delete(root);
+	}
+	cjson_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		err = parse(json);
+		zassert_equal(err, 0, "Tokenizing failed: %d", err);
+		zassert_true(json_tok_find(&doc, 0, path) > 0,
+			     "Lookup failed");
+	}
+	tok_ns = benchmark_round_ns(start, BENCHMARK_ROUNDS);
+
+	zassert_equal(heap_used, 0, "cJSON tree leaked");
+
+	TC_PRINT("%-7s %4zu bytes | cJSON %6u ns, %5zu bytes of heap | "
+		 "json_tok %6u ns, %3u tokens (%4zu bytes), no heap\n",
+		 name, strlen(json),
+		 cjson_ns, heap_peak, tok_ns, doc.count,
+		 doc.count * sizeof(struct json_tok));
+}
+
+static void test_benchmark(void)
+{
+	cJSON_Hooks hooks = {
+		.malloc_fn = malloc_hook,
+		.free_fn = free_hook,
+	};
+
+	cJSON_InitHooks(&hooks);
+
+	benchmark("shadow", shadow_delta, "state.pairing.topics.d2c");
+	benchmark("job", job_document, "execution.jobDocument.location.path");
+
+	cJSON_InitHooks(NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(json_tok_test,
+	     ztest_unit_test(test_parse),
+	     ztest_unit_test(test_parse_invalid),
+	     ztest_unit_test(test_find),
+	     ztest_unit_test(test_str_copy),
+	     ztest_unit_test(test_int_get),
+	     ztest_unit_test(test_benchmark)
+	 );
+
+	ztest_run_test_suite(json_tok_test);
+}
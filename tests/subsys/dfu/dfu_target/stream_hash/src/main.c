@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <string.h>
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <dfu/dfu_target.h>
+
+#define FILE_SIZE 0x1000
+#define FRAG_SIZE 700
+
+/* SHA-256 of the image generated by image_fill() */
+static const uint8_t image_hash[DFU_TARGET_HASH_LEN] = {
+	0xfd, 0x5b, 0x7b, 0x36, 0x6b, 0x3f, 0xf3, 0xae,
+	0xd6, 0x5f, 0x6e, 0x6d, 0x87, 0xe7, 0xec, 0x92,
+	0xeb, 0x27, 0xff, 0x46, 0xac, 0xdf, 0x22, 0x44,
+	0x08, 0x7f, 0x04, 0x4d, 0xca, 0x6c, 0x64, 0xd8,
+};
+
+static uint8_t image[FILE_SIZE];
+static size_t written;
+static int done_param;
+
+bool dfu_target_mcuboot_identify(const void *const buf)
+{
+	return true;
+}
+
+int dfu_target_mcuboot_init(size_t file_size, dfu_target_callback_t cb)
+{
+	return 0;
+}
+
+int dfu_target_mcuboot_offset_get(size_t *offset)
+{
+	*offset = written;
+	return 0;
+}
+
+int dfu_target_mcuboot_write(const void *const buf, size_t len)
+{
+	written += len;
+	return 0;
+}
+
+int dfu_target_mcuboot_done(bool successful)
+{
+	done_param = successful;
+	written = 0;
+	return 0;
+}
+
+static void image_fill(void)
+{
+	for (size_t i = 0; i < sizeof(image); i++) {
+		image[i] = (uint8_t)(i * 13);
+	}
+}
+
+static void image_write_part(size_t from, size_t to)
+{
+	int err;
+
+	for (size_t i = from; i < to; i += FRAG_SIZE) {
+		err = dfu_target_write(image + i, MIN(FRAG_SIZE, to - i));
+		zassert_equal(err, 0, NULL);
+	}
+}
+
+static void image_write(size_t from)
+{
+	image_write_part(from, sizeof(image));
+}
+
+static void init(void)
+{
+	int err;
+
+	image_fill();
+	done_param = -1;
+
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, FILE_SIZE, NULL);
+	zassert_equal(err, 0, NULL);
+}
+
+static void test_hash_match(void)
+{
+	int err;
+
+	init();
+	err = dfu_target_hash_set(image_hash);
+	zassert_equal(err, 0, NULL);
+
+	image_write(0);
+
+	err = dfu_target_done(true);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(done_param, true, "Upgrade not scheduled");
+}
+
+static void test_hash_mismatch(void)
+{
+	int err;
+
+	init();
+	err = dfu_target_hash_set(image_hash);
+	zassert_equal(err, 0, NULL);
+
+	image[FILE_SIZE / 2] ^= 1;
+	image_write(0);
+
+	err = dfu_target_done(true);
+	zassert_equal(err, -EBADMSG, NULL);
+	zassert_equal(done_param, false, "Corrupted upgrade not aborted");
+
+	/* The DFU procedure can be started over */
+	init();
+	image_write(0);
+	err = dfu_target_done(true);
+	zassert_equal(err, 0, "Digest not cleared");
+}
+
+static void test_hash_resumed(void)
+{
+	int err;
+
+	/* A download resumed after reboot cannot be verified */
+	written = FILE_SIZE / 2;
+	init();
+	err = dfu_target_hash_set(image_hash);
+	zassert_equal(err, 0, NULL);
+
+	image_write(FILE_SIZE / 2);
+
+	err = dfu_target_done(true);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(done_param, true, NULL);
+
+	/* The next download from the start is verified again */
+	init();
+	err = dfu_target_hash_set(image_hash);
+	zassert_equal(err, 0, NULL);
+
+	image[0] ^= 1;
+	image_write(0);
+
+	err = dfu_target_done(true);
+	zassert_equal(err, -EBADMSG, "Digest not verified");
+}
+
+static void test_hash_resumed_in_session(void)
+{
+	int err;
+
+	/* The hash covers the bytes written before the download was
+	 * interrupted, so it is still verified.
+	 */
+	init();
+	err = dfu_target_hash_set(image_hash);
+	zassert_equal(err, 0, NULL);
+
+	image[FILE_SIZE - 1] ^= 1;
+	image_write_part(0, 2 * FRAG_SIZE);
+
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, FILE_SIZE, NULL);
+	zassert_equal(err, 0, NULL);
+
+	image_write(2 * FRAG_SIZE);
+
+	err = dfu_target_done(true);
+	zassert_equal(err, -EBADMSG, "Digest not verified");
+}
+
+static void test_hash_restarted(void)
+{
+	int err;
+
+	/* The download starts over after half of the image was written */
+	init();
+	err = dfu_target_hash_set(image_hash);
+	zassert_equal(err, 0, NULL);
+
+	image[0] ^= 1;
+	image_write_part(0, FILE_SIZE / 2);
+	image[0] ^= 1;
+
+	written = 0;
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, FILE_SIZE, NULL);
+	zassert_equal(err, 0, NULL);
+
+	image_write(0);
+
+	err = dfu_target_done(true);
+	zassert_equal(err, 0, "Earlier writes hashed");
+	zassert_equal(done_param, true, "Upgrade not scheduled");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(dfu_target_stream_hash_test,
+			 ztest_unit_test(test_hash_match),
+			 ztest_unit_test(test_hash_mismatch),
+			 ztest_unit_test(test_hash_resumed),
+			 ztest_unit_test(test_hash_resumed_in_session),
+			 ztest_unit_test(test_hash_restarted)
+			 );
+
+	ztest_run_test_suite(dfu_target_stream_hash_test);
+}
@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+"""Generate an image with the structure of application firmware.
+
+Code is built from a limited set of instruction idioms with varying
+operands, followed by constant data, a string table and erased flash.
+"""
+
+import os
+import random
+import struct
+import sys
+
+SIZE = 128 * 1024
+
+
+def main(out_file):
+    rnd = random.Random(0xf07a)
+    idioms = [bytes(rnd.getrandbits(8) for _ in range(rnd.randint(2, 12)))
+              for _ in range(400)]
+    words = [b'error', b'init', b'socket', b'lte', b'modem', b'fota',
+             b'cloud', b'%d', b'failed', b'connect', b'(err %d)\n']
+
+    image = bytearray()
+    while len(image) < SIZE * 6 // 10:
+        image += rnd.choice(idioms)
+        # Branch offsets and literal pool addresses
+        image += struct.pack('<H', rnd.getrandbits(12))
+    while len(image) < SIZE * 75 // 100:
+        image += struct.pack('<I', 0x20000000 + rnd.getrandbits(16) * 4)
+    while len(image) < SIZE * 85 // 100:
+        image += b' '.join(rnd.choice(words)
+                           for _ in range(rnd.randint(2, 6))) + b'\0'
+    image += b'\xff' * (SIZE - len(image))
+
+    with open(out_file, 'wb') as f:
+        f.write(image[:SIZE])
+
+
+if __name__ == "__main__":
+    main(sys.argv[1])
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <dfu/dfu_target.h>
+#include <dfu_target_mcuboot.h>
+#include <dfu_target_compressed.h>
+
+#include "benchmark.h"
+
+#define FRAG_SIZE 1024
+#define BENCHMARK_ROUNDS 10
+
+/* Generated by image.py and scripts/dfu/compress_image.py */
+static const uint8_t image[] = {
+#include "image.bin.inc"
+};
+
+static uint8_t compressed[] = {
+#include "image_w12.lz.inc"
+};
+
+/* Compressed with a window larger than the one configured */
+static const uint8_t compressed_w14[] = {
+#include "image_w14.lz.inc"
+};
+
+/* Stubs and mocks, the secondary slot receives the data written to the
+ * MCUBoot target.
+ */
+static uint8_t secondary[sizeof(image)];
+static size_t secondary_len;
+static int mcuboot_done_param;
+static bool mcuboot_initialized;
+
+int dfu_target_mcuboot_init(size_t file_size, dfu_target_callback_t cb)
+{
+	zassert_equal(file_size, sizeof(image), NULL);
+	mcuboot_initialized = true;
+	return 0;
+}
+
+int dfu_target_mcuboot_offset_get(size_t *offset)
+{
+	*offset = secondary_len;
+	return 0;
+}
+
+int dfu_target_mcuboot_write(const void *const buf, size_t len)
+{
+	zassert_true(secondary_len + len <= sizeof(secondary),
+		     "Secondary slot overflow");
+	memcpy(&secondary[secondary_len], buf, len);
+	secondary_len += len;
+	return 0;
+}
+
+int dfu_target_mcuboot_done(bool successful)
+{
+	mcuboot_done_param = successful;
+	return 0;
+}
+
+/* END stubs and mocks */
+
+static void init(void)
+{
+	int err;
+
+	secondary_len = 0;
+	mcuboot_done_param = -1;
+	mcuboot_initialized = false;
+
+	err = dfu_target_compressed_init(sizeof(compressed), NULL);
+	zassert_equal(err, 0, NULL);
+}
+
+static int compressed_write(const uint8_t *data, size_t len, size_t frag_size)
+{
+	int err;
+
+	for (size_t i = 0; i < len; i += frag_size) {
+		err = dfu_target_compressed_write(data + i,
+						  MIN(frag_size, len - i));
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static void decompress(size_t frag_size)
+{
+	size_t offset;
+	int err;
+
+	init();
+
+	err = compressed_write(compressed, sizeof(compressed), frag_size);
+	zassert_equal(err, 0, NULL);
+
+	err = dfu_target_compressed_offset_get(&offset);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(offset, sizeof(compressed), NULL);
+
+	err = dfu_target_compressed_done(true);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(mcuboot_done_param, true, NULL);
+
+	zassert_equal(secondary_len, sizeof(image), NULL);
+	zassert_mem_equal(secondary, image, sizeof(image), NULL);
+}
+
+static void test_compressed_identify(void)
+{
+	static const uint8_t mcuboot_header[] = {0x3d, 0xb8, 0xf3, 0x96};
+
+	zassert_true(dfu_target_compressed_identify(compressed), NULL);
+	zassert_false(dfu_target_compressed_identify(mcuboot_header), NULL);
+}
+
+static void test_compressed_decompress(void)
+{
+	/* Sequences split across fragments */
+	decompress(1);
+	decompress(7);
+	decompress(FRAG_SIZE);
+	decompress(sizeof(compressed));
+}
+
+static void test_compressed_window_too_large(void)
+{
+	int err;
+
+	init();
+	err = compressed_write(compressed_w14, sizeof(compressed_w14),
+			       FRAG_SIZE);
+	zassert_equal(err, -ENOMEM, "Window larger than configured accepted");
+	zassert_false(mcuboot_initialized, NULL);
+
+	err = dfu_target_compressed_done(false);
+	zassert_equal(err, 0, NULL);
+}
+
+static void test_compressed_truncated(void)
+{
+	int err;
+
+	init();
+	err = compressed_write(compressed, sizeof(compressed) - 1, FRAG_SIZE);
+	zassert_equal(err, 0, NULL);
+
+	err = dfu_target_compressed_done(true);
+	zassert_equal(err, -EBADMSG, "Incomplete image accepted");
+	zassert_equal(mcuboot_done_param, false, "Upgrade scheduled");
+}
+
+/* Offset of the match distance in the first sequence */
+static size_t first_distance_offset(void)
+{
+	size_t pos = 12;
+	size_t literals = compressed[pos++] >> 4;
+
+	if (literals == 15) {
+		do {
+			literals += compressed[pos];
+		} while (compressed[pos++] == 0xff);
+	}
+
+	return pos + literals;
+}
+
+static void test_compressed_corrupt(void)
+{
+	/* Most significant byte of the distance */
+	size_t pos = first_distance_offset() + 1;
+	uint8_t saved = compressed[pos];
+	int err;
+
+	/* Refer to data outside of the window */
+	compressed[pos] = 0xff;
+
+	init();
+	err = compressed_write(compressed, sizeof(compressed), FRAG_SIZE);
+	zassert_equal(err, -EBADMSG, "Corrupt image accepted");
+
+	err = dfu_target_compressed_done(false);
+	zassert_equal(err, 0, NULL);
+
+	compressed[pos] = saved;
+}
+
+static void test_compressed_benchmark(void)
+{
+	uint64_t start;
+	uint32_t elapsed;
+
+	start = benchmark_time_us();
+	for (int i = 0; i < BENCHMARK_ROUNDS; i++) {
+		decompress(FRAG_SIZE);
+	}
+	elapsed = MAX(benchmark_time_us() - start, 1);
+
+	TC_PRINT("Window %d bytes: %zu byte image compressed to %zu bytes "
+		 "(%zu%%), %zu bytes with a %d byte window\n",
+		 CONFIG_DFU_TARGET_COMPRESSED_WINDOW_SIZE, sizeof(image),
+		 sizeof(compressed), 100 * sizeof(compressed) / sizeof(image),
+		 sizeof(compressed_w14), 1 << 14);
+	TC_PRINT("Decompressed %zu KB in %u us, %u KB/s\n",
+		 BENCHMARK_ROUNDS * sizeof(image) / 1024, elapsed,
+		 (uint32_t)((uint64_t)BENCHMARK_ROUNDS * sizeof(image) *
+			    USEC_PER_SEC / 1024 / elapsed));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lib_dfu_target_compressed_test,
+	     ztest_unit_test(test_compressed_identify),
+	     ztest_unit_test(test_compressed_decompress),
+	     ztest_unit_test(test_compressed_window_too_large),
+	     ztest_unit_test(test_compressed_truncated),
+	     ztest_unit_test(test_compressed_corrupt),
+	     ztest_unit_test(test_compressed_benchmark)
+	 );
+
+	ztest_run_test_suite(lib_dfu_target_compressed_test);
+}
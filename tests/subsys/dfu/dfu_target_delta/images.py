@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+"""Generate a source and a target image with typical firmware changes."""
+
+import os
+import random
+import sys
+
+SIZE = 48 * 1024
+
+
+def main(out_dir):
+    rnd = random.Random(0x5eed)
+    source = bytearray(rnd.getrandbits(8) for _ in range(SIZE))
+
+    target = bytearray(source)
+    # Addresses changed in place
+    for off in range(0, SIZE, 509):
+        target[off] ^= 0x04
+    # Code inserted, removed and moved
+    target[10000:10000] = bytes(rnd.getrandbits(8) for _ in range(300))
+    del target[30000:30200]
+    target += target[2000:6000]
+    target[40000:44000] = b'\xff' * 4000
+
+    for name, data in (('source.bin', source), ('target.bin', target)):
+        with open(os.path.join(out_dir, name), 'wb') as f:
+            f.write(data)
+
+
+if __name__ == "__main__":
+    main(sys.argv[1])
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <sys/crc.h>
+#include <sys/byteorder.h>
+#include <storage/flash_map.h>
+#include <dfu/dfu_target.h>
+#include <dfu_target_mcuboot.h>
+#include <dfu_target_delta.h>
+
+/* Generated by images.py and scripts/dfu/delta_patch.py */
+static uint8_t source_img[] = {
+#include "source.bin.inc"
+};
+
+static const uint8_t target_img[] = {
+#include "target.bin.inc"
+};
+
+static const uint8_t patch[] = {
+#include "patch.bin.inc"
+};
+
+/* Stubs and mocks, the primary slot holds source_img and the secondary slot
+ * receives the data written to the MCUBoot target.
+ */
+static const struct flash_area primary = {
+	.fa_size = sizeof(source_img),
+};
+static bool primary_open;
+
+static uint8_t secondary[sizeof(target_img) + 1024];
+static size_t secondary_len;
+static int mcuboot_done_param;
+
+int flash_area_open(uint8_t id, const struct flash_area **fa)
+{
+	*fa = &primary;
+	primary_open = true;
+	return 0;
+}
+
+void flash_area_close(const struct flash_area *fa)
+{
+	primary_open = false;
+}
+
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst,
+		    size_t len)
+{
+	zassert_true(off + len <= sizeof(source_img), "Read outside of slot");
+	memcpy(dst, &source_img[off], len);
+	return 0;
+}
+
+int dfu_target_mcuboot_init(size_t file_size, dfu_target_callback_t cb)
+{
+	zassert_equal(file_size, sizeof(target_img), NULL);
+	return 0;
+}
+
+int dfu_target_mcuboot_offset_get(size_t *offset)
+{
+	*offset = secondary_len;
+	return 0;
+}
+
+int dfu_target_mcuboot_write(const void *const buf, size_t len)
+{
+	zassert_true(secondary_len + len <= sizeof(secondary),
+		     "Secondary slot overflow");
+	memcpy(&secondary[secondary_len], buf, len);
+	secondary_len += len;
+	return 0;
+}
+
+int dfu_target_mcuboot_done(bool successful)
+{
+	mcuboot_done_param = successful;
+	return 0;
+}
+
+/* END stubs and mocks */
+
+static void init(void)
+{
+	int err;
+
+	secondary_len = 0;
+	mcuboot_done_param = -1;
+
+	err = dfu_target_delta_init(sizeof(patch), NULL);
+	zassert_equal(err, 0, NULL);
+}
+
+static int patch_write(size_t len, size_t frag_size)
+{
+	int err;
+
+	for (size_t i = 0; i < len; i += frag_size) {
+		err = dfu_target_delta_write(patch + i,
+					     MIN(frag_size, len - i));
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static void patch_apply(size_t frag_size)
+{
+	size_t offset;
+	int err;
+
+	init();
+
+	err = patch_write(sizeof(patch), frag_size);
+	zassert_equal(err, 0, NULL);
+
+	err = dfu_target_delta_offset_get(&offset);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(offset, sizeof(patch), NULL);
+
+	err = dfu_target_delta_done(true);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(mcuboot_done_param, true, NULL);
+	zassert_false(primary_open, "Primary slot not closed");
+
+	zassert_equal(secondary_len, sizeof(target_img), NULL);
+	zassert_equal(crc32_ieee(secondary, secondary_len),
+		      crc32_ieee(target_img, sizeof(target_img)),
+		      "Image checksum mismatch");
+	zassert_mem_equal(secondary, target_img, sizeof(target_img), NULL);
+}
+
+static void test_delta_identify(void)
+{
+	static const uint8_t mcuboot_header[] = {0x3d, 0xb8, 0xf3, 0x96};
+
+	zassert_true(dfu_target_delta_identify(patch), NULL);
+	zassert_false(dfu_target_delta_identify(mcuboot_header), NULL);
+}
+
+static void test_delta_apply(void)
+{
+	TC_PRINT("%zu byte patch for %zu byte image\n", sizeof(patch),
+		 sizeof(target_img));
+
+	zassert_true(sizeof(patch) < sizeof(target_img) / 4,
+		     "Patch not smaller than the image");
+
+	/* Operations and literals split across fragments */
+	patch_apply(1);
+	patch_apply(13);
+	patch_apply(1024);
+	patch_apply(sizeof(patch));
+}
+
+static void test_delta_wrong_source(void)
+{
+	int err;
+
+	source_img[sizeof(source_img) / 2] ^= 0x01;
+
+	init();
+	err = patch_write(sizeof(patch), 1024);
+	zassert_equal(err, -EINVAL, "Patch applied to the wrong image");
+	zassert_equal(secondary_len, 0, "Data written to secondary slot");
+
+	err = dfu_target_delta_done(false);
+	zassert_equal(err, 0, NULL);
+	zassert_false(primary_open, NULL);
+
+	source_img[sizeof(source_img) / 2] ^= 0x01;
+}
+
+static void test_delta_truncated(void)
+{
+	int err;
+
+	init();
+	err = patch_write(sizeof(patch) - 1, 1024);
+	zassert_equal(err, 0, NULL);
+
+	err = dfu_target_delta_done(true);
+	zassert_equal(err, -EBADMSG, "Incomplete patch accepted");
+	zassert_equal(mcuboot_done_param, false, "Upgrade scheduled");
+}
+
+static void test_delta_restart(void)
+{
+	int err;
+
+	/* Aborted procedure restarted without re-initializing */
+	init();
+	err = patch_write(sizeof(patch) / 2, 1024);
+	zassert_equal(err, 0, NULL);
+
+	err = dfu_target_delta_done(false);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(mcuboot_done_param, false, NULL);
+
+	secondary_len = 0;
+	err = patch_write(sizeof(patch), 1024);
+	zassert_equal(err, 0, NULL);
+
+	err = dfu_target_delta_done(true);
+	zassert_equal(err, 0, NULL);
+	zassert_mem_equal(secondary, target_img, sizeof(target_img), NULL);
+}
+
+static void test_delta_add_overflow(void)
+{
+	/* ADD of 4 bytes, with a run of 8 unchanged bytes */
+	uint8_t bad_patch[] = {
+		0x44, 0x45, 0x4c, 0x54, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		4, 4, 0x00, 8,
+	};
+	int err;
+
+	sys_put_le32(16, &bad_patch[4]);
+	sys_put_le32(crc32_ieee(source_img, 16), &bad_patch[8]);
+	sys_put_le32(sizeof(target_img), &bad_patch[12]);
+
+	init();
+	err = dfu_target_delta_write(bad_patch, sizeof(bad_patch));
+	zassert_equal(err, -EBADMSG, "Run outside of the operation accepted");
+	zassert_equal(secondary_len, 0, "Data written to secondary slot");
+
+	err = dfu_target_delta_done(false);
+	zassert_equal(err, 0, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lib_dfu_target_delta_test,
+	     ztest_unit_test(test_delta_identify),
+	     ztest_unit_test(test_delta_apply),
+	     ztest_unit_test(test_delta_wrong_source),
+	     ztest_unit_test(test_delta_truncated),
+	     ztest_unit_test(test_delta_add_overflow),
+	     ztest_unit_test(test_delta_restart)
+	 );
+
+	ztest_run_test_suite(lib_dfu_target_delta_test);
+}
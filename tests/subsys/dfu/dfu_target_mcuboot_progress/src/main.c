@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <dfu/flash_img.h>
+#include <settings/settings.h>
+#include <dfu_target.h>
+#include <dfu_target_mcuboot.h>
+
+#define IMAGE_SIZE (256 * 1024)
+#define FRAG_SIZE 1024
+#define BLOCK_SIZE CONFIG_IMG_BLOCK_BUF_SIZE
+
+/* Stubs and mocks, modelling flash_img block buffering */
+static size_t buffered;
+static size_t flushed;
+static size_t flash_write_cnt;
+static size_t settings_write_cnt;
+static size_t stored;
+
+int flash_img_init(struct flash_img_context *ctx)
+{
+	buffered = 0;
+	flushed = 0;
+	return 0;
+}
+
+size_t flash_img_bytes_written(struct flash_img_context *ctx)
+{
+	return flushed;
+}
+
+int flash_img_buffered_write(struct flash_img_context *ctx, const uint8_t *data,
+			     size_t len, bool flush)
+{
+	buffered += len;
+
+	while (buffered >= BLOCK_SIZE) {
+		buffered -= BLOCK_SIZE;
+		flushed += BLOCK_SIZE;
+		flash_write_cnt++;
+	}
+
+	if (flush && buffered) {
+		flushed += buffered;
+		buffered = 0;
+		flash_write_cnt++;
+	}
+
+	return 0;
+}
+
+int boot_request_upgrade(int permanent)
+{
+	return 0;
+}
+
+int settings_subsys_init(void)
+{
+	return 0;
+}
+
+int settings_register(struct settings_handler *cf)
+{
+	return 0;
+}
+
+int settings_load(void)
+{
+	return 0;
+}
+
+int settings_save_one(const char *name, const void *value, size_t val_len)
+{
+	zassert_equal(val_len, sizeof(stored), NULL);
+	memcpy(&stored, value, sizeof(stored));
+	settings_write_cnt++;
+
+	/* Only data that reached flash can be resumed from */
+	zassert_true(stored <= flushed, "Stored progress not in flash");
+	return 0;
+}
+
+/* END stubs and mocks */
+
+static void test_progress_batched(void)
+{
+	static uint8_t frag[FRAG_SIZE];
+	size_t offset;
+	int err;
+
+	err = dfu_target_mcuboot_init(IMAGE_SIZE, NULL);
+	zassert_equal(err, 0, NULL);
+
+	flash_write_cnt = 0;
+	settings_write_cnt = 0;
+
+	for (size_t i = 0; i < IMAGE_SIZE / FRAG_SIZE; i++) {
+		err = dfu_target_mcuboot_write(frag, sizeof(frag));
+		zassert_equal(err, 0, NULL);
+
+		/* A reset never loses more than the interval and a block */
+		zassert_true(flushed - stored <=
+			CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS_INTERVAL +
+			BLOCK_SIZE, "Progress stored too rarely");
+	}
+
+	err = dfu_target_mcuboot_offset_get(&offset);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(offset, IMAGE_SIZE, NULL);
+
+	TC_PRINT("%d KB image: %d flash writes, %d settings writes\n",
+		 IMAGE_SIZE / 1024, flash_write_cnt, settings_write_cnt);
+
+	zassert_equal(flash_write_cnt, IMAGE_SIZE / BLOCK_SIZE, NULL);
+	zassert_equal(settings_write_cnt,
+		      IMAGE_SIZE / CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS_INTERVAL,
+		      "Progress not batched");
+
+	err = dfu_target_mcuboot_done(true);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(stored, 0, "Progress not reset when done");
+}
+
+static void test_progress_partial_block(void)
+{
+	static uint8_t frag[BLOCK_SIZE / 2];
+	int err;
+
+	err = dfu_target_mcuboot_init(IMAGE_SIZE, NULL);
+	zassert_equal(err, 0, NULL);
+
+	settings_write_cnt = 0;
+
+	/* Data still buffered by flash_img is never stored as progress */
+	err = dfu_target_mcuboot_write(frag, sizeof(frag));
+	zassert_equal(err, 0, NULL);
+	zassert_equal(settings_write_cnt, 0, NULL);
+
+	err = dfu_target_mcuboot_done(false);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(stored, 0, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lib_dfu_target_mcuboot_progress_test,
+	     ztest_unit_test(test_progress_batched),
+	     ztest_unit_test(test_progress_partial_block)
+	 );
+
+	ztest_run_test_suite(lib_dfu_target_mcuboot_progress_test);
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "coalesce_event.h"
+
+static bool merge_coalesce_event(struct event_header *pending,
+				 const struct event_header *eh)
+{
+	struct coalesce_event *dst = cast_coalesce_event(pending);
+	const struct coalesce_event *src = cast_coalesce_event(eh);
+
+	dst->sum += src->sum;
+	dst->cnt += src->cnt;
+
+	return true;
+}
+
+EVENT_TYPE_DEFINE(coalesce_event,
+		  true,
+		  NULL,
+		  NULL,
+		  EVENT_ATTR_COALESCE(merge_coalesce_event),
+		  EVENT_ATTR_MEM_SLAB(COALESCE_EVENT_BLOCK_CNT));
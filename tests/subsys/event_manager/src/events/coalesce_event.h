@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _COALESCE_EVENT_H_
+#define _COALESCE_EVENT_H_
+
+/**
+ * @brief Coalesce Event
+ * @defgroup coalesce_event Coalesce Event
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Coalescing events also get a memory slab of their own size. */
+#define COALESCE_EVENT_BLOCK_CNT 2
+
+struct coalesce_event {
+	struct event_header header;
+
+	int sum;
+	int cnt;
+};
+
+EVENT_TYPE_DECLARE(coalesce_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _COALESCE_EVENT_H_ */
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "dispatch_event.h"
+
+
+EVENT_TYPE_DEFINE(dispatch_event,
+		  false,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_DEFINE(dispatch_typed_event,
+		  false,
+		  NULL,
+		  NULL);
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _DISPATCH_EVENT_H_
+#define _DISPATCH_EVENT_H_
+
+/**
+ * @brief Dispatch Events
+ * @defgroup dispatch_event Dispatch Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event handled by listeners that check the event type. */
+struct dispatch_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(dispatch_event);
+
+/* Event handled by listeners subscribed with a dedicated handler. */
+struct dispatch_typed_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(dispatch_typed_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _DISPATCH_EVENT_H_ */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _HISTOGRAM_EVENT_H_
+#define _HISTOGRAM_EVENT_H_
+
+/**
+ * @brief Histogram Event
+ * @defgroup histogram_event Histogram Event
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct histogram_event {
+	struct event_header header;
+
+	uint32_t busy_us;
+};
+
+EVENT_TYPE_DECLARE(histogram_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _HISTOGRAM_EVENT_H_ */
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "lane_event.h"
+
+
+EVENT_TYPE_DEFINE(realtime_lane_event,
+		  true,
+		  NULL,
+		  NULL,
+		  EVENT_ATTR_LANE(EVENT_LANE_REALTIME));
+
+EVENT_TYPE_DEFINE(background_lane_event,
+		  true,
+		  NULL,
+		  NULL,
+		  EVENT_ATTR_LANE(EVENT_LANE_BACKGROUND));
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _LANE_EVENT_H_
+#define _LANE_EVENT_H_
+
+/**
+ * @brief Lane Events
+ * @defgroup lane_event Lane Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct realtime_lane_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(realtime_lane_event);
+
+struct background_lane_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(background_lane_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _LANE_EVENT_H_ */
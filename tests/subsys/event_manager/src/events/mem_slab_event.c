@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "mem_slab_event.h"
+
+
+EVENT_TYPE_DEFINE(mem_slab_event,
+		  true,
+		  NULL,
+		  NULL,
+		  EVENT_ATTR_MEM_SLAB(MEM_SLAB_EVENT_BLOCK_CNT));
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _MEM_SLAB_EVENT_H_
+#define _MEM_SLAB_EVENT_H_
+
+/**
+ * @brief Memory Slab Event
+ * @defgroup mem_slab_event Memory Slab Event
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of events in the memory slab of the event type. */
+#define MEM_SLAB_EVENT_BLOCK_CNT 2
+
+struct mem_slab_event {
+	struct event_header header;
+
+	uint8_t val;
+};
+
+EVENT_TYPE_DECLARE(mem_slab_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _MEM_SLAB_EVENT_H_ */
@@ -27,6 +27,11 @@ enum test_id {
 	TEST_SUBSCRIBER_ORDER,
 	TEST_OOM_RESET,
 	TEST_MULTICONTEXT,
+	TEST_DISPATCH,
+	TEST_COALESCE,
+	TEST_MEM_SLAB,
+	TEST_LANES,
+	TEST_HISTOGRAMS,
 
 	TEST_CNT
 };
@@ -15,6 +15,8 @@ static K_SEM_DEFINE(test_end_sem, 0, 1);
 void test_init(void)
 {
 	zassert_false(event_manager_init(), "Error when initializing");
+	zassert_equal(event_manager_init(), -EALREADY,
+		      "Initialized twice");
 }
 
 static void test_start(enum test_id test_id)
@@ -59,6 +61,31 @@ static void test_multicontext(void)
 	test_start(TEST_MULTICONTEXT);
 }
 
+static void test_dispatch(void)
+{
+	test_start(TEST_DISPATCH);
+}
+
+static void test_coalesce(void)
+{
+	test_start(TEST_COALESCE);
+}
+
+static void test_mem_slab(void)
+{
+	test_start(TEST_MEM_SLAB);
+}
+
+static void test_lanes(void)
+{
+	test_start(TEST_LANES);
+}
+
+static void test_histograms(void)
+{
+	test_start(TEST_HISTOGRAMS);
+}
+
 void test_main(void)
 {
 	ztest_test_suite(event_manager_tests,
@@ -68,7 +95,12 @@ void test_main(void)
 			 ztest_unit_test(test_event_order),
 			 ztest_unit_test(test_subs_order),
 			 ztest_unit_test(test_oom_reset),
-			 ztest_unit_test(test_multicontext)
+			 ztest_unit_test(test_multicontext),
+			 ztest_unit_test(test_dispatch),
+			 ztest_unit_test(test_coalesce),
+			 ztest_unit_test(test_mem_slab),
+			 ztest_unit_test(test_lanes),
+			 ztest_unit_test(test_histograms)
 			 );
 
 	ztest_run_test_suite(event_manager_tests);
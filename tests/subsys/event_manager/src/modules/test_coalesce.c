@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <coalesce_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_coalesce
+
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id != TEST_COALESCE) {
+			return false;
+		}
+
+		/* Attributes of an event type combine. */
+		zassert_not_null(_EVENT_ID(coalesce_event)->coalesce,
+				 "Event type not coalescing");
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+		zassert_equal(
+			_EVENT_ID(coalesce_event)->mem_pool->slab->num_blocks,
+			COALESCE_EVENT_BLOCK_CNT, "Wrong memory slab size");
+#endif
+
+		/* Events are merged, because the Event Manager does not
+		 * process them until this handler returns.
+		 */
+		for (size_t i = 0; i < TEST_COALESCE_EVENT_CNT; i++) {
+			struct coalesce_event *event = new_coalesce_event();
+
+			event->sum = i;
+			event->cnt = 1;
+			EVENT_SUBMIT(event);
+		}
+
+		return false;
+	}
+
+	if (is_coalesce_event(eh)) {
+		struct coalesce_event *event = cast_coalesce_event(eh);
+		const struct event_coalesce *ec =
+			_EVENT_ID(coalesce_event)->coalesce;
+		int expected_sum = 0;
+
+		for (size_t i = 0; i < TEST_COALESCE_EVENT_CNT; i++) {
+			expected_sum += i;
+		}
+
+		zassert_equal(event->cnt, TEST_COALESCE_EVENT_CNT,
+			      "Events not merged");
+		zassert_equal(event->sum, expected_sum, "Wrong merged value");
+		zassert_equal(atomic_get(&ec->merged_cnt),
+			      TEST_COALESCE_EVENT_CNT - 1,
+			      "Wrong number of merged events");
+
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_COALESCE;
+		EVENT_SUBMIT(te);
+
+		return false;
+	}
+
+	zassert_true(false, "Wrong event type received");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, coalesce_event);
@@ -19,3 +19,19 @@
 
 /* TEST_EVENT_ORDER */
 #define TEST_EVENT_ORDER_CNT 20
+
+
+/* TEST_DISPATCH */
+#define TEST_DISPATCH_EVENT_CNT 16
+
+
+/* TEST_COALESCE */
+#define TEST_COALESCE_EVENT_CNT 10
+
+
+/* TEST_LANES */
+#define TEST_LANES_EVENT_CNT 8
+
+
+/* TEST_HISTOGRAMS */
+#define TEST_HISTOGRAMS_BUSY_US 300
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <data_event.h>
+#include <order_event.h>
+#include <multicontext_event.h>
+#include <dispatch_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_dispatch
+
+
+static uint32_t dispatch_start;
+static uint32_t generic_time;
+static uint32_t typed_time;
+static size_t generic_cnt;
+static size_t typed_cnt;
+
+static void submit_typed_events(void)
+{
+	for (size_t i = 0; i < TEST_DISPATCH_EVENT_CNT; i++) {
+		struct dispatch_typed_event *event =
+			new_dispatch_typed_event();
+
+		event->val = i;
+		EVENT_SUBMIT(event);
+	}
+}
+
+static void submit_generic_events(void)
+{
+	for (size_t i = 0; i < TEST_DISPATCH_EVENT_CNT; i++) {
+		struct dispatch_event *event = new_dispatch_event();
+
+		event->val = i;
+		EVENT_SUBMIT(event);
+	}
+}
+
+static void report_results(void)
+{
+	TC_PRINT("Dispatch with type check: %u cycles per event\n",
+		 generic_time / TEST_DISPATCH_EVENT_CNT);
+	TC_PRINT("Dispatch with dedicated handler: %u cycles per event\n",
+		 typed_time / TEST_DISPATCH_EVENT_CNT);
+
+	struct test_end_event *te = new_test_end_event();
+
+	te->test_id = TEST_DISPATCH;
+	EVENT_SUBMIT(te);
+}
+
+/* Handler checking the event type like a module subscribed to many event
+ * types does.
+ */
+static bool generic_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		return false;
+	}
+
+	if (is_data_event(eh)) {
+		return false;
+	}
+
+	if (is_order_event(eh)) {
+		return false;
+	}
+
+	if (is_multicontext_event(eh)) {
+		return false;
+	}
+
+	if (is_dispatch_event(eh)) {
+		const struct dispatch_event *event = cast_dispatch_event(eh);
+
+		zassert_true(event->val < TEST_DISPATCH_EVENT_CNT,
+			     "Wrong event value");
+		return false;
+	}
+
+	zassert_true(false, "Wrong event type received");
+
+	return false;
+}
+
+/* Listener notified first about the dispatch events. It stores the time
+ * at which the dispatch starts, so that the allocation, submission and
+ * queueing of the events are not measured.
+ */
+static bool stamp_dispatch_event(const struct dispatch_event *event)
+{
+	dispatch_start = k_cycle_get_32();
+	return false;
+}
+
+static bool stamp_dispatch_typed_event(const struct dispatch_typed_event *event)
+{
+	dispatch_start = k_cycle_get_32();
+	return false;
+}
+
+EVENT_LISTENER(dispatch_stamp, NULL);
+EVENT_SUBSCRIBE_EARLY_HANDLER(dispatch_stamp, dispatch_event,
+			      stamp_dispatch_event);
+EVENT_SUBSCRIBE_EARLY_HANDLER(dispatch_stamp, dispatch_typed_event,
+			      stamp_dispatch_typed_event);
+
+
+EVENT_LISTENER(generic1, generic_handler);
+EVENT_SUBSCRIBE(generic1, dispatch_event);
+
+EVENT_LISTENER(generic2, generic_handler);
+EVENT_SUBSCRIBE(generic2, dispatch_event);
+
+EVENT_LISTENER(generic3, generic_handler);
+EVENT_SUBSCRIBE(generic3, dispatch_event);
+
+
+static bool typed_handler(const struct dispatch_typed_event *event)
+{
+	zassert_true(event->val < TEST_DISPATCH_EVENT_CNT,
+		     "Wrong event value");
+	return false;
+}
+
+EVENT_LISTENER(typed1, NULL);
+EVENT_SUBSCRIBE_HANDLER(typed1, dispatch_typed_event, typed_handler);
+
+EVENT_LISTENER(typed2, NULL);
+EVENT_SUBSCRIBE_HANDLER(typed2, dispatch_typed_event, typed_handler);
+
+EVENT_LISTENER(typed3, NULL);
+EVENT_SUBSCRIBE_HANDLER(typed3, dispatch_typed_event, typed_handler);
+
+
+static bool handle_test_start_event(const struct test_start_event *event)
+{
+	if (event->test_id == TEST_DISPATCH) {
+		generic_cnt = 0;
+		typed_cnt = 0;
+		generic_time = 0;
+		typed_time = 0;
+		submit_generic_events();
+	}
+
+	return false;
+}
+
+static bool handle_dispatch_event(const struct dispatch_event *event)
+{
+	generic_time += k_cycle_get_32() - dispatch_start;
+	generic_cnt++;
+
+	if (generic_cnt == TEST_DISPATCH_EVENT_CNT) {
+		submit_typed_events();
+	}
+
+	return false;
+}
+
+static bool handle_dispatch_typed_event(
+		const struct dispatch_typed_event *event)
+{
+	typed_time += k_cycle_get_32() - dispatch_start;
+	typed_cnt++;
+
+	if (typed_cnt == TEST_DISPATCH_EVENT_CNT) {
+		report_results();
+	}
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, NULL);
+EVENT_SUBSCRIBE_HANDLER(MODULE, test_start_event, handle_test_start_event);
+EVENT_SUBSCRIBE_FINAL_HANDLER(MODULE, dispatch_event, handle_dispatch_event);
+EVENT_SUBSCRIBE_FINAL_HANDLER(MODULE, dispatch_typed_event,
+			      handle_dispatch_typed_event);
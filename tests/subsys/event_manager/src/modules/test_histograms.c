@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <histogram_event.h>
+
+#include "test_config.h"
+
+/* The busy listener is executed first. Its histogram is updated before the
+ * final listener checks it.
+ */
+#define MODULE test_histograms
+#define MODULE_BUSY test_histograms_busy
+
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+static size_t bucket_get(uint32_t time)
+{
+	size_t bucket = (time > 0) ? (31 - __builtin_clz(time)) : 0;
+
+	return MIN(bucket,
+		   CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAM_BUCKET_CNT - 1);
+}
+
+static void histogram_check(struct event_histogram *hist, uint32_t min_time)
+{
+	struct event_histogram h;
+
+	event_manager_histogram_get(hist, &h);
+
+	zassert_equal(h.cnt, 1, "Wrong number of samples");
+	zassert_equal(h.min, h.max, "Wrong minimum or maximum");
+	zassert_equal(h.total, h.min, "Wrong sum of samples");
+	zassert_true(h.min >= min_time, "Sample too small");
+
+	for (size_t i = 0; i < ARRAY_SIZE(h.buckets); i++) {
+		zassert_equal(h.buckets[i], (i == bucket_get(h.min)) ? 1 : 0,
+			      "Sample in wrong bucket");
+	}
+}
+
+extern const struct event_listener _CONCAT(__event_listener_, MODULE_BUSY);
+
+static void test_histograms_check(void)
+{
+	const struct event_listener *el =
+		&_CONCAT(__event_listener_, MODULE_BUSY);
+
+	/* Cycles are rounded down to microseconds. */
+	histogram_check(el->exec_hist, TEST_HISTOGRAMS_BUSY_US - 1);
+
+	/* Busy wait time is between 2^8 and 2^9 - 1 microseconds. */
+	BUILD_ASSERT(CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAM_BUCKET_CNT > 8);
+	zassert_equal(el->exec_hist->buckets[8], 1, "Sample in wrong bucket");
+
+	histogram_check(_EVENT_ID(histogram_event)->wait_hist, 0);
+
+	event_manager_histograms_reset();
+
+	zassert_equal(el->exec_hist->cnt, 0, "Histogram not reset");
+	zassert_equal(el->exec_hist->buckets[8], 0, "Histogram not reset");
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS */
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id != TEST_HISTOGRAMS) {
+			return false;
+		}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+		event_manager_histograms_reset();
+#endif
+
+		struct histogram_event *event = new_histogram_event();
+
+		event->busy_us = TEST_HISTOGRAMS_BUSY_US;
+		EVENT_SUBMIT(event);
+
+		return false;
+	}
+
+	if (is_histogram_event(eh)) {
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_HISTOGRAMS
+		test_histograms_check();
+#endif
+
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_HISTOGRAMS;
+		EVENT_SUBMIT(te);
+
+		return false;
+	}
+
+	zassert_true(false, "Wrong event type received");
+
+	return false;
+}
+
+static bool busy_handler(const struct histogram_event *event)
+{
+	k_busy_wait(event->busy_us);
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE_FINAL(MODULE, histogram_event);
+
+EVENT_LISTENER(MODULE_BUSY, NULL);
+EVENT_SUBSCRIBE_HANDLER(MODULE_BUSY, histogram_event, busy_handler);
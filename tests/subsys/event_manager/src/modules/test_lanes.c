@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <lane_event.h>
+
+#include "test_config.h"
+
+/* Every listener subscribes to event types from a single lane. */
+#define MODULE test_lanes
+#define MODULE_REALTIME test_lanes_realtime
+#define MODULE_BACKGROUND test_lanes_background
+
+static k_tid_t submit_thread;
+static k_tid_t realtime_thread;
+static k_tid_t background_thread;
+static int realtime_cnt;
+static int background_cnt;
+static atomic_t lanes_done;
+
+
+static void lane_done(void)
+{
+	/* The lane that finishes last ends the test. */
+	if (atomic_inc(&lanes_done) == 1) {
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_LANES;
+		EVENT_SUBMIT(te);
+	}
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id != TEST_LANES) {
+			return false;
+		}
+
+		submit_thread = k_current_get();
+
+		/* Background events are submitted first, but realtime
+		 * events are processed first if lanes are enabled.
+		 */
+		for (int i = 0; i < TEST_LANES_EVENT_CNT; i++) {
+			struct background_lane_event *event =
+				new_background_lane_event();
+
+			event->val = i;
+			EVENT_SUBMIT(event);
+		}
+
+		for (int i = 0; i < TEST_LANES_EVENT_CNT; i++) {
+			struct realtime_lane_event *event =
+				new_realtime_lane_event();
+
+			event->val = i;
+			EVENT_SUBMIT(event);
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Wrong event type received");
+
+	return false;
+}
+
+static bool realtime_handler(const struct realtime_lane_event *event)
+{
+	if (realtime_cnt == 0) {
+		realtime_thread = k_current_get();
+	}
+
+	zassert_equal(realtime_thread, k_current_get(), "Wrong thread");
+	zassert_equal(event->val, realtime_cnt, "Wrong event order");
+
+	if (IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES)) {
+		zassert_not_equal(realtime_thread, submit_thread,
+				  "Not processed in the realtime lane");
+		zassert_equal(background_cnt, 0,
+			      "Background lane not preempted");
+	} else {
+		zassert_equal(realtime_thread, submit_thread,
+			      "Not processed in the system workqueue");
+	}
+
+	realtime_cnt++;
+	if (realtime_cnt == TEST_LANES_EVENT_CNT) {
+		lane_done();
+	}
+
+	return false;
+}
+
+static bool background_handler(const struct background_lane_event *event)
+{
+	if (background_cnt == 0) {
+		background_thread = k_current_get();
+	}
+
+	zassert_equal(background_thread, k_current_get(), "Wrong thread");
+	zassert_equal(event->val, background_cnt, "Wrong event order");
+
+	if (IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_LANES)) {
+		zassert_not_equal(background_thread, submit_thread,
+				  "Not processed in the background lane");
+		zassert_not_equal(background_thread, realtime_thread,
+				  "Not processed in the background lane");
+		zassert_equal(realtime_cnt, TEST_LANES_EVENT_CNT,
+			      "Realtime lane not processed first");
+	} else {
+		zassert_equal(background_thread, submit_thread,
+			      "Not processed in the system workqueue");
+		zassert_equal(realtime_cnt, 0,
+			      "Events not processed in submission order");
+	}
+
+	background_cnt++;
+	if (background_cnt == TEST_LANES_EVENT_CNT) {
+		lane_done();
+	}
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+
+EVENT_LISTENER(MODULE_REALTIME, NULL);
+EVENT_SUBSCRIBE_HANDLER(MODULE_REALTIME, realtime_lane_event,
+			realtime_handler);
+
+EVENT_LISTENER(MODULE_BACKGROUND, NULL);
+EVENT_SUBSCRIBE_HANDLER(MODULE_BACKGROUND, background_lane_event,
+			background_handler);
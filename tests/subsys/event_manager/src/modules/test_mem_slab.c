@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <mem_slab_event.h>
+
+#define MODULE test_mem_slab
+
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+static void test_mem_slab_stats(void)
+{
+	struct event_mem_pool *pool = _EVENT_ID(mem_slab_event)->mem_pool;
+	const struct event_mem_pool *small_pool = event_manager_mem_pool_get(0);
+	struct mem_slab_event *events[MEM_SLAB_EVENT_BLOCK_CNT + 1];
+	atomic_val_t fallback_cnt = atomic_get(&pool->stats.fallback_cnt);
+	atomic_val_t failed_cnt = atomic_get(&pool->stats.failed_cnt);
+	uint32_t small_used = k_mem_slab_num_used_get(small_pool->slab);
+
+	zassert_equal(pool->slab->block_size % sizeof(void *), 0,
+		      "Block size not aligned");
+	zassert_equal(pool->stats.max_used, 0, "Memory slab already used");
+
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		events[i] = new_mem_slab_event();
+	}
+
+	/* The last event is taken from the small size-class memory slab. */
+	zassert_equal(pool->stats.max_used, MEM_SLAB_EVENT_BLOCK_CNT,
+		      "Wrong high-water mark");
+	zassert_equal(atomic_get(&pool->stats.fallback_cnt),
+		      fallback_cnt + 1, "Fallback not counted");
+	zassert_equal(atomic_get(&pool->stats.failed_cnt), failed_cnt,
+		      "Fallback counted as failure");
+	zassert_equal(k_mem_slab_num_used_get(small_pool->slab),
+		      small_used + 1, "Size-class memory slab not used");
+	zassert_true(small_pool->stats.max_used >= small_used + 1,
+		     "Wrong size-class high-water mark");
+
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		event_manager_free(events[i]);
+	}
+
+	zassert_equal(k_mem_slab_num_used_get(pool->slab), 0,
+		      "Events not freed");
+	zassert_equal(k_mem_slab_num_used_get(small_pool->slab), small_used,
+		      "Events not freed");
+	zassert_equal(pool->stats.max_used, MEM_SLAB_EVENT_BLOCK_CNT,
+		      "High-water mark not kept");
+}
+
+static void test_mem_slab_failure(void)
+{
+	const struct event_type *et = _EVENT_ID(mem_slab_event);
+	struct event_mem_pool *pool = et->mem_pool;
+	void *events[MEM_SLAB_EVENT_BLOCK_CNT +
+		     CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_SMALL_CNT +
+		     CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_MEDIUM_CNT +
+		     CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB_LARGE_CNT + 1];
+	atomic_val_t fallback_cnt = atomic_get(&pool->stats.fallback_cnt);
+	atomic_val_t failed_cnt = atomic_get(&pool->stats.failed_cnt);
+	size_t cnt;
+
+	/* Exhaust the memory slab of the event type and all size-class
+	 * memory slabs.
+	 */
+	for (cnt = 0; cnt < ARRAY_SIZE(events); cnt++) {
+		events[cnt] = _event_mem_alloc(et,
+					       sizeof(struct mem_slab_event));
+		if (events[cnt] == NULL) {
+			break;
+		}
+
+		/* The event type tells which memory slab to free to. */
+		((struct event_header *)events[cnt])->type_id = et;
+	}
+
+	zassert_true(cnt > MEM_SLAB_EVENT_BLOCK_CNT, "No fallback");
+	zassert_true(cnt < ARRAY_SIZE(events), "Allocation did not fail");
+	zassert_equal(atomic_get(&pool->stats.fallback_cnt),
+		      fallback_cnt + cnt - MEM_SLAB_EVENT_BLOCK_CNT,
+		      "Wrong number of fallbacks");
+	zassert_equal(atomic_get(&pool->stats.failed_cnt), failed_cnt + 1,
+		      "Failure not counted");
+
+	for (size_t i = 0; i < cnt; i++) {
+		event_manager_free(events[i]);
+	}
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB */
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id != TEST_MEM_SLAB) {
+			return false;
+		}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_MEM_SLAB
+		test_mem_slab_stats();
+		test_mem_slab_failure();
+#endif
+
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_MEM_SLAB;
+		EVENT_SUBMIT(te);
+
+		return false;
+	}
+
+	zassert_true(false, "Wrong event type received");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
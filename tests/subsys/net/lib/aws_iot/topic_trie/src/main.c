@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include "topic_trie.h"
+
+#define NODE_COUNT 32
+
+enum route {
+	ROUTE_APP,
+	ROUTE_FOTA,
+	ROUTE_GET_ACCEPTED,
+	ROUTE_UPDATE_DELTA,
+	ROUTE_SENSORS,
+	ROUTE_ALL,
+};
+
+static struct topic_trie_node nodes[NODE_COUNT];
+static struct topic_trie trie;
+
+static int add(const char *filter, int route)
+{
+	return topic_trie_add(&trie, filter, strlen(filter), route);
+}
+
+static int match(const char *topic)
+{
+	return topic_trie_match(&trie, topic, strlen(topic));
+}
+
+static void setup(void)
+{
+	topic_trie_init(&trie, nodes, ARRAY_SIZE(nodes));
+
+	zassert_equal(add("$aws/things/my-thing/jobs/#", ROUTE_FOTA), 0, NULL);
+	zassert_equal(add("$aws/things/my-thing/shadow/get/accepted",
+			  ROUTE_GET_ACCEPTED), 0, NULL);
+	zassert_equal(add("$aws/things/my-thing/shadow/update/delta",
+			  ROUTE_UPDATE_DELTA), 0, NULL);
+	zassert_equal(add("my-thing/+/config", ROUTE_APP), 0, NULL);
+	zassert_equal(add("my-thing/sensors/+", ROUTE_SENSORS), 0, NULL);
+}
+
+static void test_topic_trie_literal(void)
+{
+	setup();
+
+	zassert_equal(match("$aws/things/my-thing/shadow/get/accepted"),
+		      ROUTE_GET_ACCEPTED, NULL);
+	zassert_equal(match("$aws/things/my-thing/shadow/update/delta"),
+		      ROUTE_UPDATE_DELTA, NULL);
+	zassert_equal(match("$aws/things/my-thing/shadow/get"),
+		      TOPIC_TRIE_NO_ROUTE, NULL);
+	zassert_equal(match("$aws/things/my-thing/shadow/get/accepted/x"),
+		      TOPIC_TRIE_NO_ROUTE, NULL);
+	zassert_equal(match("$aws/things/other/shadow/get/accepted"),
+		      TOPIC_TRIE_NO_ROUTE, NULL);
+	zassert_equal(match(""), TOPIC_TRIE_NO_ROUTE, NULL);
+
+	/* Topics are not NULL terminated */
+	zassert_equal(topic_trie_match(&trie,
+			"$aws/things/my-thing/shadow/update/deltaXYZ",
+			strlen("$aws/things/my-thing/shadow/update/delta")),
+		      ROUTE_UPDATE_DELTA, NULL);
+}
+
+static void test_topic_trie_wildcards(void)
+{
+	setup();
+
+	zassert_equal(match("$aws/things/my-thing/jobs/notify-next"),
+		      ROUTE_FOTA, NULL);
+	zassert_equal(match("$aws/things/my-thing/jobs/$next/get/accepted"),
+		      ROUTE_FOTA, NULL);
+	/* '#' also matches the parent level */
+	zassert_equal(match("$aws/things/my-thing/jobs"), ROUTE_FOTA, NULL);
+
+	zassert_equal(match("my-thing/led/config"), ROUTE_APP, NULL);
+	zassert_equal(match("my-thing/led/config/x"), TOPIC_TRIE_NO_ROUTE,
+		      NULL);
+	zassert_equal(match("my-thing/sensors/temp"), ROUTE_SENSORS, NULL);
+	/* '+' matches empty levels */
+	zassert_equal(match("my-thing//config"), ROUTE_APP, NULL);
+}
+
+static void test_topic_trie_precedence(void)
+{
+	setup();
+
+	/* Matches both filters, the literal level takes precedence */
+	zassert_equal(match("my-thing/sensors/config"), ROUTE_SENSORS, NULL);
+
+	zassert_equal(add("#", ROUTE_ALL), 0, NULL);
+	zassert_equal(match("other/topic"), ROUTE_ALL, NULL);
+	zassert_equal(match("my-thing/led/config"), ROUTE_APP, NULL);
+	zassert_equal(match("my-thing/led/state"), ROUTE_ALL, NULL);
+
+	/* Wildcards at the first level do not match topics starting with $ */
+	zassert_equal(match("$SYS/uptime"), TOPIC_TRIE_NO_ROUTE, NULL);
+	zassert_equal(match("$aws/things/my-thing/shadow/get"),
+		      TOPIC_TRIE_NO_ROUTE, NULL);
+}
+
+static void test_topic_trie_invalid(void)
+{
+	setup();
+
+	zassert_equal(add("a/#/b", ROUTE_APP), -EINVAL, NULL);
+	zassert_equal(add("a/b#", ROUTE_APP), -EINVAL, NULL);
+	zassert_equal(add("a+/b", ROUTE_APP), -EINVAL, NULL);
+	zassert_equal(add("", ROUTE_APP), -EINVAL, NULL);
+	zassert_equal(add("a", -1), -EINVAL, NULL);
+
+	/* Same filter again */
+	zassert_equal(add("my-thing/+/config", ROUTE_APP), 0, NULL);
+	zassert_equal(add("my-thing/+/config", ROUTE_ALL), -EEXIST, NULL);
+}
+
+static void test_topic_trie_full(void)
+{
+	/* Filters are referenced by the trie, not copied */
+	static char filters[NODE_COUNT][sizeof("full/a")];
+	int err = 0;
+
+	setup();
+
+	for (size_t i = 0; i < ARRAY_SIZE(filters) && err == 0; i++) {
+		strcpy(filters[i], "full/a");
+		filters[i][5] += i;
+		err = add(filters[i], ROUTE_APP);
+	}
+
+	zassert_equal(err, -ENOMEM, NULL);
+	zassert_equal(match("full/a"), ROUTE_APP, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(topic_trie_test,
+			 ztest_unit_test(test_topic_trie_literal),
+			 ztest_unit_test(test_topic_trie_wildcards),
+			 ztest_unit_test(test_topic_trie_precedence),
+			 ztest_unit_test(test_topic_trie_invalid),
+			 ztest_unit_test(test_topic_trie_full)
+			 );
+
+	ztest_run_test_suite(topic_trie_test);
+}
@@ -0,0 +1,5 @@
+/* generated file copied to simplify building the test */
+#ifndef PM_CONFIG_H__
+#define PM_CONFIG_H__
+#define PM_CLOUD_QUEUE_STORAGE_ID 0
+#endif /* PM_CONFIG_H__ */
@@ -0,0 +1,632 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <fs/fcb.h>
+#include <storage/flash_map.h>
+#include <net/cloud_queue.h>
+
+#define SECTOR_COUNT 3
+#define SECTOR_SIZE 256
+#define ALIGN 4
+#define ELEM_HDR_SIZE 4
+#define ELEM_DONE 0xa5a5
+
+#define SENT_MAX 16
+
+/* Stubs and mocks, a flash circular buffer in RAM. Elements are a length and
+ * a completion marker followed by the data. The sectors in use are kept
+ * across initializations to simulate a reset.
+ */
+static uint8_t flash[SECTOR_COUNT * SECTOR_SIZE];
+static struct flash_area fake_area = {
+	.fa_size = sizeof(flash),
+};
+static struct {
+	struct flash_sector *sectors;
+	int oldest;
+	int active;
+	size_t write_off[SECTOR_COUNT];
+} fake_fcb;
+
+int flash_area_get_sectors(int fa_id, uint32_t *count,
+			   struct flash_sector *sectors)
+{
+	zassert_true(*count >= SECTOR_COUNT, NULL);
+
+	for (int i = 0; i < SECTOR_COUNT; i++) {
+		sectors[i].fs_off = i * SECTOR_SIZE;
+		sectors[i].fs_size = SECTOR_SIZE;
+	}
+
+	*count = SECTOR_COUNT;
+	return 0;
+}
+
+int flash_area_open(uint8_t id, const struct flash_area **fa)
+{
+	*fa = &fake_area;
+	return 0;
+}
+
+void flash_area_close(const struct flash_area *fa)
+{
+}
+
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst,
+		    size_t len)
+{
+	zassert_true(off + len <= sizeof(flash), "Read out of bounds");
+	memcpy(dst, &flash[off], len);
+	return 0;
+}
+
+int flash_area_write(const struct flash_area *fa, off_t off, const void *src,
+		     size_t len)
+{
+	zassert_true(off + len <= sizeof(flash), "Write out of bounds");
+	zassert_equal(off % ALIGN, 0, "Unaligned write");
+	zassert_equal(len % ALIGN, 0, "Unaligned write length");
+
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(flash[off + i], 0xff, "Write to unerased flash");
+	}
+
+	memcpy(&flash[off], src, len);
+	return 0;
+}
+
+int flash_area_erase(const struct flash_area *fa, off_t off, size_t len)
+{
+	memset(&flash[off], 0xff, len);
+	memset(&fake_fcb.write_off, 0, sizeof(fake_fcb.write_off));
+	fake_fcb.oldest = 0;
+	fake_fcb.active = 0;
+	return 0;
+}
+
+static void fcb_sectors_update(struct fcb *fcb)
+{
+	fcb->f_oldest = &fake_fcb.sectors[fake_fcb.oldest];
+	fcb->f_active.fe_sector = &fake_fcb.sectors[fake_fcb.active];
+}
+
+int fcb_init(int f_area_id, struct fcb *fcb)
+{
+	fake_fcb.sectors = fcb->f_sectors;
+	fcb->fap = &fake_area;
+	fcb->f_align = ALIGN;
+	fcb_sectors_update(fcb);
+	return 0;
+}
+
+int fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *loc)
+{
+	size_t elem_len = ELEM_HDR_SIZE + ROUND_UP(len, ALIGN);
+	int sector = fake_fcb.active;
+	uint16_t hdr = len;
+
+	if (fake_fcb.write_off[sector] + elem_len > SECTOR_SIZE) {
+		sector = (sector + 1) % SECTOR_COUNT;
+		if (sector == fake_fcb.oldest) {
+			return -ENOSPC;
+		}
+		fake_fcb.active = sector;
+		fcb_sectors_update(fcb);
+	}
+
+	loc->fe_sector = &fake_fcb.sectors[sector];
+	loc->fe_elem_off = fake_fcb.write_off[sector];
+	loc->fe_data_off = loc->fe_elem_off + ELEM_HDR_SIZE;
+	loc->fe_data_len = len;
+	memcpy(&flash[sector * SECTOR_SIZE + loc->fe_elem_off], &hdr,
+	       sizeof(hdr));
+	fake_fcb.write_off[sector] += elem_len;
+
+	return 0;
+}
+
+int fcb_append_finish(struct fcb *fcb, struct fcb_entry *append_loc)
+{
+	uint16_t done = ELEM_DONE;
+
+	memcpy(&flash[append_loc->fe_sector->fs_off +
+		      append_loc->fe_elem_off + sizeof(uint16_t)],
+	       &done, sizeof(done));
+	return 0;
+}
+
+int fcb_walk(struct fcb *fcb, struct flash_sector *sector, fcb_walk_cb cb,
+	     void *cb_arg)
+{
+	struct fcb_entry_ctx ctx = {
+		.fap = &fake_area,
+	};
+	int i = fake_fcb.oldest;
+
+	while (true) {
+		for (size_t off = 0; off < fake_fcb.write_off[i];) {
+			uint8_t *elem = &flash[i * SECTOR_SIZE + off];
+			uint16_t len;
+			uint16_t done;
+			int err;
+
+			memcpy(&len, elem, sizeof(len));
+			memcpy(&done, elem + sizeof(len), sizeof(done));
+
+			ctx.loc.fe_sector = &fake_fcb.sectors[i];
+			ctx.loc.fe_elem_off = off;
+			ctx.loc.fe_data_off = off + ELEM_HDR_SIZE;
+			ctx.loc.fe_data_len = len;
+
+			if (done == ELEM_DONE) {
+				err = cb(&ctx, cb_arg);
+				if (err) {
+					return err;
+				}
+			}
+
+			off += ELEM_HDR_SIZE + ROUND_UP(len, ALIGN);
+		}
+
+		if (i == fake_fcb.active) {
+			return 0;
+		}
+
+		i = (i + 1) % SECTOR_COUNT;
+	}
+}
+
+int fcb_rotate(struct fcb *fcb)
+{
+	int oldest = fake_fcb.oldest;
+
+	memset(&flash[oldest * SECTOR_SIZE], 0xff, SECTOR_SIZE);
+	fake_fcb.write_off[oldest] = 0;
+
+	if (oldest == fake_fcb.active) {
+		fake_fcb.active = (oldest + 1) % SECTOR_COUNT;
+	}
+
+	fake_fcb.oldest = (oldest + 1) % SECTOR_COUNT;
+	fcb_sectors_update(fcb);
+
+	return 0;
+}
+
+int fcb_is_empty(struct fcb *fcb)
+{
+	return fake_fcb.oldest == fake_fcb.active &&
+	       fake_fcb.write_off[fake_fcb.active] == 0;
+}
+
+/* Messages sent to the backend */
+static struct {
+	char buf[CONFIG_CLOUD_QUEUE_BATCH_BUF_SIZE + 1];
+	enum cloud_endpoint_type endpoint;
+	enum cloud_qos qos;
+} sent[SENT_MAX];
+static size_t sent_count;
+/* Sends left before send errors are returned, or -1 */
+static int sends_left;
+/* Message queued while the next message is sent, or NULL */
+static const char *add_on_send;
+
+static void add_msg(const char *data, enum cloud_queue_priority priority);
+
+static int api_send(const struct cloud_backend *const backend,
+		    const struct cloud_msg *const msg)
+{
+	if (sends_left == 0) {
+		return -ENOTCONN;
+	} else if (sends_left > 0) {
+		sends_left--;
+	}
+
+	zassert_true(sent_count < SENT_MAX, "Too many messages sent");
+	zassert_true(msg->len < sizeof(sent[0].buf), NULL);
+
+	if (add_on_send) {
+		const char *data = add_on_send;
+
+		add_on_send = NULL;
+		add_msg(data, CLOUD_QUEUE_PRIORITY_LOW);
+	}
+
+	memcpy(sent[sent_count].buf, msg->buf, msg->len);
+	sent[sent_count].buf[msg->len] = '\0';
+	sent[sent_count].endpoint = msg->endpoint.type;
+	sent[sent_count].qos = msg->qos;
+	sent_count++;
+
+	return 0;
+}
+
+static const struct cloud_api api = {
+	.send = api_send,
+};
+
+static struct cloud_backend backend = {
+	.api = &api,
+};
+
+/* END stubs and mocks */
+
+static void init(void)
+{
+	int err;
+
+	memset(flash, 0xff, sizeof(flash));
+	memset(&fake_fcb.write_off, 0, sizeof(fake_fcb.write_off));
+	fake_fcb.oldest = 0;
+	fake_fcb.active = 0;
+
+	memset(sent, 0, sizeof(sent));
+	sent_count = 0;
+	sends_left = -1;
+	add_on_send = NULL;
+
+	err = cloud_queue_init(&backend);
+	zassert_equal(err, 0, NULL);
+}
+
+static void add(const char *data, enum cloud_endpoint_type endpoint,
+		enum cloud_queue_priority priority, uint32_t ttl)
+{
+	struct cloud_msg msg = {
+		.buf = (char *)data,
+		.len = strlen(data),
+		.qos = CLOUD_QOS_AT_MOST_ONCE,
+		.endpoint.type = endpoint,
+	};
+	int err;
+
+	err = cloud_queue_add(&msg, priority, ttl);
+	zassert_equal(err, 0, NULL);
+}
+
+static void add_msg(const char *data, enum cloud_queue_priority priority)
+{
+	add(data, CLOUD_EP_TOPIC_MSG, priority, 0);
+}
+
+static void sent_check(size_t index, const char *data,
+		       enum cloud_endpoint_type endpoint)
+{
+	zassert_true(index < sent_count, "Message %zu not sent", index);
+	zassert_equal(strcmp(sent[index].buf, data), 0,
+		      "Sent %s, expected %s", sent[index].buf, data);
+	zassert_equal(sent[index].endpoint, endpoint, NULL);
+}
+
+static void test_queue_invalid(void)
+{
+	char large[CONFIG_CLOUD_QUEUE_BATCH_BUF_SIZE];
+	struct cloud_msg msg = {
+		.buf = "1",
+		.len = 1,
+		.endpoint.type = CLOUD_EP_TOPIC_MSG,
+	};
+	int err;
+
+	init();
+
+	err = cloud_queue_add(NULL, CLOUD_QUEUE_PRIORITY_LOW, 0);
+	zassert_equal(err, -EINVAL, NULL);
+
+	err = cloud_queue_add(&msg, CLOUD_QUEUE_PRIORITY_COUNT, 0);
+	zassert_equal(err, -EINVAL, NULL);
+
+	msg.endpoint.str = "topic";
+	msg.endpoint.len = strlen("topic");
+	err = cloud_queue_add(&msg, CLOUD_QUEUE_PRIORITY_LOW, 0);
+	zassert_equal(err, -ENOTSUP, NULL);
+
+	memset(large, 'x', sizeof(large));
+	msg.buf = large;
+	msg.len = sizeof(large);
+	msg.endpoint.str = NULL;
+	msg.endpoint.len = 0;
+	err = cloud_queue_add(&msg, CLOUD_QUEUE_PRIORITY_LOW, 0);
+	zassert_equal(err, -EMSGSIZE, NULL);
+
+	zassert_equal(cloud_queue_count(), 0, NULL);
+}
+
+static void test_queue_send_disabled(void)
+{
+	int err;
+
+	init();
+
+	add_msg("1", CLOUD_QUEUE_PRIORITY_HIGH);
+	k_sleep(K_SECONDS(CONFIG_CLOUD_QUEUE_FLUSH_DELAY + 1));
+
+	err = cloud_queue_flush();
+	zassert_equal(err, -EAGAIN, NULL);
+	zassert_equal(sent_count, 0, "Message sent while disabled");
+	zassert_equal(cloud_queue_count(), 1, NULL);
+
+	cloud_queue_send_enable(true);
+	k_sleep(K_MSEC(1));
+	zassert_equal(sent_count, 1, NULL);
+	zassert_equal(cloud_queue_count(), 0, NULL);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_priority(void)
+{
+	init();
+
+	add_msg("1", CLOUD_QUEUE_PRIORITY_LOW);
+	add("2", CLOUD_EP_TOPIC_STATE, CLOUD_QUEUE_PRIORITY_LOW, 0);
+	add_msg("3", CLOUD_QUEUE_PRIORITY_NORMAL);
+	add_msg("4", CLOUD_QUEUE_PRIORITY_HIGH);
+	add_msg("5", CLOUD_QUEUE_PRIORITY_NORMAL);
+
+	/* The high priority message is sent right away */
+	cloud_queue_send_enable(true);
+	k_sleep(K_MSEC(1));
+
+	zassert_equal(sent_count, 2, NULL);
+	sent_check(0, "[4,3,5,1]", CLOUD_EP_TOPIC_MSG);
+	sent_check(1, "[2]", CLOUD_EP_TOPIC_STATE);
+	zassert_equal(cloud_queue_count(), 0, NULL);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_flush_delay(void)
+{
+	init();
+
+	cloud_queue_send_enable(true);
+
+	add_msg("1", CLOUD_QUEUE_PRIORITY_LOW);
+	k_sleep(K_SECONDS(CONFIG_CLOUD_QUEUE_FLUSH_DELAY + 1));
+	zassert_equal(sent_count, 0, "Low priority message sent alone");
+
+	add_msg("2", CLOUD_QUEUE_PRIORITY_NORMAL);
+	k_sleep(K_SECONDS(CONFIG_CLOUD_QUEUE_FLUSH_DELAY - 1));
+	zassert_equal(sent_count, 0, "Sent before the flush delay");
+
+	add_msg("3", CLOUD_QUEUE_PRIORITY_NORMAL);
+	k_sleep(K_SECONDS(2));
+	zassert_equal(sent_count, 1, NULL);
+	sent_check(0, "[2,3,1]", CLOUD_EP_TOPIC_MSG);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_threshold(void)
+{
+	char data[2] = "0";
+
+	init();
+
+	cloud_queue_send_enable(true);
+
+	for (int i = 0; i < CONFIG_CLOUD_QUEUE_FLUSH_THRESHOLD - 1; i++) {
+		data[0] = '0' + i;
+		add_msg(data, CLOUD_QUEUE_PRIORITY_LOW);
+	}
+
+	k_sleep(K_MSEC(1));
+	zassert_equal(sent_count, 0, NULL);
+
+	add_msg("5", CLOUD_QUEUE_PRIORITY_LOW);
+	k_sleep(K_MSEC(1));
+	zassert_equal(sent_count, 2, NULL);
+	sent_check(0, "[0,1,2,3]", CLOUD_EP_TOPIC_MSG);
+	sent_check(1, "[4,5]", CLOUD_EP_TOPIC_MSG);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_send_error(void)
+{
+	int err;
+
+	init();
+
+	add_msg("1", CLOUD_QUEUE_PRIORITY_LOW);
+	add("2", CLOUD_EP_TOPIC_STATE, CLOUD_QUEUE_PRIORITY_LOW, 0);
+
+	cloud_queue_send_enable(true);
+	sends_left = 0;
+	err = cloud_queue_flush();
+	zassert_equal(err, -ENOTCONN, NULL);
+	zassert_equal(cloud_queue_count(), 2, "Messages lost");
+
+	sends_left = -1;
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cloud_queue_count(), 0, NULL);
+	sent_check(0, "[1]", CLOUD_EP_TOPIC_MSG);
+	sent_check(1, "[2]", CLOUD_EP_TOPIC_STATE);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_restore(void)
+{
+	int err;
+
+	init();
+
+	add_msg("1", CLOUD_QUEUE_PRIORITY_LOW);
+	add("2", CLOUD_EP_TOPIC_STATE, CLOUD_QUEUE_PRIORITY_LOW, 0);
+	add_msg("3", CLOUD_QUEUE_PRIORITY_LOW);
+
+	cloud_queue_send_enable(true);
+	sends_left = 1;
+	err = cloud_queue_flush();
+	zassert_equal(err, -ENOTCONN, NULL);
+	sent_check(0, "[1,3]", CLOUD_EP_TOPIC_MSG);
+	cloud_queue_send_enable(false);
+
+	/* Reset, only the message that was not sent is restored */
+	err = cloud_queue_init(&backend);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cloud_queue_count(), 1, NULL);
+
+	sends_left = -1;
+	sent_count = 0;
+	cloud_queue_send_enable(true);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	zassert_equal(sent_count, 1, NULL);
+	sent_check(0, "[2]", CLOUD_EP_TOPIC_STATE);
+
+	/* Messages queued after the reset are not mixed up with sent ones */
+	add_msg("4", CLOUD_QUEUE_PRIORITY_LOW);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	sent_check(1, "[4]", CLOUD_EP_TOPIC_MSG);
+	cloud_queue_send_enable(false);
+
+	err = cloud_queue_init(&backend);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cloud_queue_count(), 0, "Sent messages restored");
+}
+
+static void test_queue_ttl(void)
+{
+	int err;
+
+	init();
+
+	add("1", CLOUD_EP_TOPIC_MSG, CLOUD_QUEUE_PRIORITY_LOW, 1);
+	add("2", CLOUD_EP_TOPIC_MSG, CLOUD_QUEUE_PRIORITY_LOW, 10);
+	k_sleep(K_SECONDS(2));
+
+	cloud_queue_send_enable(true);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	zassert_equal(sent_count, 1, NULL);
+	sent_check(0, "[2]", CLOUD_EP_TOPIC_MSG);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_ttl_restore(void)
+{
+	int err;
+
+	init();
+
+	add("1", CLOUD_EP_TOPIC_MSG, CLOUD_QUEUE_PRIORITY_LOW, 10);
+	add("2", CLOUD_EP_TOPIC_MSG, CLOUD_QUEUE_PRIORITY_LOW, 20);
+	k_sleep(K_SECONDS(6));
+	add_msg("3", CLOUD_QUEUE_PRIORITY_LOW);
+
+	/* Reset, the time to live continues from the last record written */
+	err = cloud_queue_init(&backend);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cloud_queue_count(), 3, NULL);
+	k_sleep(K_SECONDS(5));
+
+	cloud_queue_send_enable(true);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	zassert_equal(sent_count, 1, NULL);
+	sent_check(0, "[2,3]", CLOUD_EP_TOPIC_MSG);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_add_while_sending(void)
+{
+	int err;
+
+	init();
+
+	add_msg("1", CLOUD_QUEUE_PRIORITY_LOW);
+	add("2", CLOUD_EP_TOPIC_STATE, CLOUD_QUEUE_PRIORITY_LOW, 0);
+
+	/* The batch being sent is not overwritten */
+	add_on_send = "3";
+	cloud_queue_send_enable(true);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	zassert_equal(sent_count, 3, NULL);
+	sent_check(0, "[1]", CLOUD_EP_TOPIC_MSG);
+	sent_check(1, "[2]", CLOUD_EP_TOPIC_STATE);
+	sent_check(2, "[3]", CLOUD_EP_TOPIC_MSG);
+	zassert_equal(cloud_queue_count(), 0, NULL);
+
+	cloud_queue_send_enable(false);
+}
+
+static void test_queue_full(void)
+{
+	/* Two messages fit in a sector */
+	char data[100];
+	char expected[20];
+	int err;
+
+	init();
+
+	/* Index full, the oldest message is dropped */
+	for (int i = 0; i < CONFIG_CLOUD_QUEUE_MAX_MESSAGES + 1; i++) {
+		snprintf(data, sizeof(data), "%d", i);
+		add_msg(data, CLOUD_QUEUE_PRIORITY_LOW);
+	}
+
+	zassert_equal(cloud_queue_count(), CONFIG_CLOUD_QUEUE_MAX_MESSAGES,
+		      NULL);
+
+	cloud_queue_send_enable(true);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	sent_check(0, "[1,2,3,4]", CLOUD_EP_TOPIC_MSG);
+	sent_check(1, "[5,6,7,8]", CLOUD_EP_TOPIC_MSG);
+	cloud_queue_send_enable(false);
+
+	/* Flash full, the messages of the oldest sector are dropped */
+	init();
+
+	for (int i = 0; i < 2 * SECTOR_COUNT + 1; i++) {
+		memset(data, 'a' + i, sizeof(data) - 1);
+		data[sizeof(data) - 1] = '\0';
+		add_msg(data, CLOUD_QUEUE_PRIORITY_LOW);
+	}
+
+	zassert_equal(cloud_queue_count(), 2 * SECTOR_COUNT - 1, NULL);
+
+	cloud_queue_send_enable(true);
+	err = cloud_queue_flush();
+	zassert_equal(err, 0, NULL);
+	zassert_equal(sent_count, 2 * SECTOR_COUNT - 1, NULL);
+	snprintf(expected, sizeof(expected), "[%c", 'a' + 2);
+	zassert_equal(strncmp(sent[0].buf, expected, strlen(expected)), 0,
+		      NULL);
+	cloud_queue_send_enable(false);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lib_cloud_queue_test,
+	     ztest_unit_test(test_queue_invalid),
+	     ztest_unit_test(test_queue_send_disabled),
+	     ztest_unit_test(test_queue_priority),
+	     ztest_unit_test(test_queue_flush_delay),
+	     ztest_unit_test(test_queue_threshold),
+	     ztest_unit_test(test_queue_send_error),
+	     ztest_unit_test(test_queue_restore),
+	     ztest_unit_test(test_queue_ttl),
+	     ztest_unit_test(test_queue_ttl_restore),
+	     ztest_unit_test(test_queue_add_while_sending),
+	     ztest_unit_test(test_queue_full)
+	 );
+
+	ztest_run_test_suite(lib_cloud_queue_test);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef MOCK_NET_SOCKET_H__
+#define MOCK_NET_SOCKET_H__
+
+/* Replaces the socket API for the download client with the mock of an
+ * HTTP server implemented by the test.
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <net/net_ip.h>
+#include <net/tls_credentials.h>
+
+#ifndef AF_LTE
+#define AF_LTE 102
+#endif
+#ifndef SOCK_MGMT
+#define SOCK_MGMT 4
+#endif
+#ifndef NPROTO_PDN
+#define NPROTO_PDN 514
+#endif
+#ifndef SOL_SOCKET
+#define SOL_SOCKET 1
+#endif
+#ifndef SO_RCVTIMEO
+#define SO_RCVTIMEO 20
+#endif
+#ifndef SO_BINDTODEVICE
+#define SO_BINDTODEVICE 25
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TLS_SEC_TAG_LIST
+#define TLS_SEC_TAG_LIST 1
+#endif
+#ifndef TLS_PEER_VERIFY
+#define TLS_PEER_VERIFY 5
+#endif
+#ifndef IFNAMSIZ
+#define IFNAMSIZ 64
+#endif
+
+#define timeval mock_timeval
+#define addrinfo mock_addrinfo
+
+struct mock_timeval {
+	long tv_sec;
+	long tv_usec;
+};
+
+struct mock_addrinfo {
+	struct mock_addrinfo *ai_next;
+	int ai_flags;
+	int ai_family;
+	int ai_socktype;
+	int ai_protocol;
+	socklen_t ai_addrlen;
+	struct sockaddr *ai_addr;
+	char *ai_canonname;
+};
+
+int mock_socket(int family, int type, int proto);
+int mock_setsockopt(int sock, int level, int optname, const void *optval,
+		    socklen_t optlen);
+int mock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen);
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags);
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags);
+int mock_close(int sock);
+int mock_getaddrinfo(const char *host, const char *service,
+		     const struct mock_addrinfo *hints,
+		     struct mock_addrinfo **res);
+void mock_freeaddrinfo(struct mock_addrinfo *ai);
+
+#define socket(family, type, proto) mock_socket(family, type, proto)
+#define setsockopt(sock, level, optname, optval, optlen) \
+	mock_setsockopt(sock, level, optname, optval, optlen)
+#define connect(sock, addr, addrlen) mock_connect(sock, addr, addrlen)
+#define send(sock, buf, len, flags) mock_send(sock, buf, len, flags)
+#define recv(sock, buf, max_len, flags) mock_recv(sock, buf, max_len, flags)
+#define close(sock) mock_close(sock)
+#define getaddrinfo(host, service, hints, res) \
+	mock_getaddrinfo(host, service, hints, res)
+#define freeaddrinfo(ai) mock_freeaddrinfo(ai)
+
+#endif /* MOCK_NET_SOCKET_H__ */
@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/download_client.h>
+
+#define HTTP_HOST "http://example.com"
+#define HTTPS_HOST "https://example.com"
+#define FILE_NAME "file.bin"
+#define FILE_SIZE 2000
+#define FRAG_SIZE CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE
+#define SEC_TAG 42
+
+/* Responses are read in pieces, so headers and the start of the next
+ * pipelined response are split across recv() calls.
+ */
+#define RECV_MAX_LEN 100
+
+#define STREAM_SIZE 8192
+#define REQ_MAX 32
+#define DONE_TIMEOUT K_SECONDS(10)
+
+/* The mock HTTP server, one connection at a time */
+static struct {
+	int fd;
+	/* Request bytes received but not yet served */
+	char req[256];
+	size_t req_len;
+	/* Response bytes sent on the connection */
+	char stream[STREAM_SIZE];
+	size_t stream_len;
+	size_t stream_off;
+	/* Stream offset where each response ends */
+	size_t resp_end[REQ_MAX];
+	size_t resp_cnt;
+	size_t resp_read;
+	/* The server stops answering after this many stream bytes */
+	size_t stall_len;
+	bool stall;
+} conn;
+
+static int conn_cnt;
+static size_t max_in_flight;
+
+/* Ranges requested, on all connections */
+static struct {
+	int conn;
+	size_t from;
+	size_t to;
+} reqs[REQ_MAX];
+static size_t req_cnt;
+
+/* The next connection stalls in the body of this response, if set */
+static bool next_stall;
+static size_t next_stall_resp;
+static size_t next_stall_off;
+
+static struct download_client client;
+static K_SEM_DEFINE(done_sem, 0, 1);
+static uint8_t received[FILE_SIZE];
+static size_t received_from;
+static size_t received_len;
+static int error_cnt;
+
+
+static uint8_t file_byte(size_t off)
+{
+	return (uint8_t)(off % 251);
+}
+
+static void response_queue(size_t from, size_t to)
+{
+	int len;
+
+	len = snprintf(&conn.stream[conn.stream_len],
+		       sizeof(conn.stream) - conn.stream_len,
+		       "HTTP/1.1 206 Partial Content\r\n"
+		       "Content-Range: bytes %u-%u/%u\r\n"
+		       "Content-Length: %u\r\n"
+		       "\r\n",
+		       from, to, FILE_SIZE, to - from + 1);
+	conn.stream_len += len;
+
+	if (conn.stall && conn.resp_cnt == next_stall_resp) {
+		conn.stall_len = conn.stream_len + next_stall_off;
+	}
+
+	zassert_true(conn.stream_len + (to - from + 1) <= sizeof(conn.stream),
+		     "Stream buffer too small");
+
+	for (size_t off = from; off <= to; off++) {
+		conn.stream[conn.stream_len++] = file_byte(off);
+	}
+
+	conn.resp_end[conn.resp_cnt++] = conn.stream_len;
+}
+
+static void request_serve(const char *req)
+{
+	const char *range = strstr(req, "Range: bytes=");
+	char *end;
+	size_t from;
+	size_t to;
+
+	zassert_not_null(strstr(req, "GET /" FILE_NAME " HTTP/1.1\r\n"),
+			 "Wrong request line");
+	zassert_not_null(range, "Not a range request");
+
+	from = strtoul(range + strlen("Range: bytes="), &end, 10);
+	zassert_equal(*end, '-', "Malformed range");
+	if (end[1] == '\r') {
+		to = FILE_SIZE - 1;
+	} else {
+		to = strtoul(end + 1, NULL, 10);
+	}
+
+	zassert_true(req_cnt < ARRAY_SIZE(reqs), "Too many requests");
+	reqs[req_cnt].conn = conn_cnt;
+	reqs[req_cnt].from = from;
+	reqs[req_cnt].to = to;
+	req_cnt++;
+
+	response_queue(from, to);
+
+	max_in_flight = MAX(max_in_flight, conn.resp_cnt - conn.resp_read);
+}
+
+int mock_socket(int family, int type, int proto)
+{
+	zassert_equal(conn.fd, -1, "Socket already open");
+
+	memset(&conn, 0, sizeof(conn));
+	conn.fd = ++conn_cnt;
+	conn.stall = next_stall;
+	next_stall = false;
+
+	return conn.fd;
+}
+
+int mock_setsockopt(int sock, int level, int optname, const void *optval,
+		    socklen_t optlen)
+{
+	return 0;
+}
+
+int mock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen)
+{
+	zassert_equal(sock, conn.fd, "Wrong socket");
+	zassert_equal(addr->sa_family, AF_INET, "Wrong family");
+
+	return 0;
+}
+
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags)
+{
+	char *end;
+
+	zassert_equal(sock, conn.fd, "Wrong socket");
+	zassert_true(conn.req_len + len < sizeof(conn.req), "Request too long");
+
+	memcpy(&conn.req[conn.req_len], buf, len);
+	conn.req_len += len;
+	conn.req[conn.req_len] = '\0';
+
+	while ((end = strstr(conn.req, "\r\n\r\n")) != NULL) {
+		size_t req_len = end + strlen("\r\n\r\n") - conn.req;
+
+		*end = '\0';
+		request_serve(conn.req);
+
+		conn.req_len -= req_len;
+		memmove(conn.req, &conn.req[req_len], conn.req_len + 1);
+	}
+
+	return len;
+}
+
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags)
+{
+	size_t avail = conn.stream_len;
+	size_t len;
+
+	zassert_equal(sock, conn.fd, "Wrong socket");
+
+	if (conn.stall_len != 0) {
+		avail = MIN(avail, conn.stall_len);
+	}
+
+	if (conn.stream_off == avail) {
+		k_sleep(K_MSEC(CONFIG_DOWNLOAD_CLIENT_SOCK_TIMEOUT_MS));
+		errno = ETIMEDOUT;
+		return -1;
+	}
+
+	len = MIN(MIN(max_len, RECV_MAX_LEN), avail - conn.stream_off);
+	memcpy(buf, &conn.stream[conn.stream_off], len);
+	conn.stream_off += len;
+
+	while (conn.resp_read < conn.resp_cnt &&
+	       conn.resp_end[conn.resp_read] <= conn.stream_off) {
+		conn.resp_read++;
+	}
+
+	return len;
+}
+
+int mock_close(int sock)
+{
+	zassert_equal(sock, conn.fd, "Wrong socket");
+	conn.fd = -1;
+
+	return 0;
+}
+
+int mock_getaddrinfo(const char *host, const char *service,
+		     const struct mock_addrinfo *hints,
+		     struct mock_addrinfo **res)
+{
+	static struct sockaddr_in addr;
+	static struct mock_addrinfo ai;
+
+	zassert_true(strcmp(host, "example.com") == 0, "Wrong host %s", host);
+
+	if (hints->ai_family != AF_INET) {
+		return -1;
+	}
+
+	addr.sin_family = AF_INET;
+	ai.ai_family = AF_INET;
+	ai.ai_addr = (struct sockaddr *)&addr;
+	ai.ai_addrlen = sizeof(addr);
+	*res = &ai;
+
+	return 0;
+}
+
+void mock_freeaddrinfo(struct mock_addrinfo *ai)
+{
+}
+
+static int callback(const struct download_client_evt *evt)
+{
+	switch (evt->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		zassert_true(received_len + evt->fragment.len <=
+			     sizeof(received) - received_from,
+			     "Too many bytes received");
+		memcpy(&received[received_from + received_len],
+		       evt->fragment.buf, evt->fragment.len);
+		received_len += evt->fragment.len;
+		break;
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		error_cnt++;
+		break;
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		k_sem_give(&done_sem);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static void download_reset(void)
+{
+	memset(received, 0, sizeof(received));
+	received_from = 0;
+	received_len = 0;
+	error_cnt = 0;
+	req_cnt = 0;
+	conn_cnt = 0;
+	max_in_flight = 0;
+	next_stall = false;
+	k_sem_reset(&done_sem);
+}
+
+static void download_run(const char *host, size_t from, size_t to)
+{
+	const struct download_client_cfg config = {
+		.sec_tag = SEC_TAG,
+	};
+
+	received_from = from;
+
+	zassert_equal(download_client_connect(&client, host, &config), 0,
+		      "Failed to connect");
+	zassert_equal(download_client_range_start(&client, FILE_NAME, from, to),
+		      0, "Failed to start");
+	zassert_equal(k_sem_take(&done_sem, DONE_TIMEOUT), 0,
+		      "Download not done");
+	zassert_equal(download_client_disconnect(&client), 0,
+		      "Failed to disconnect");
+}
+
+static void received_check(size_t from, size_t to)
+{
+	zassert_equal(received_len, to - from, "Wrong number of bytes");
+
+	for (size_t off = from; off < to; off++) {
+		zassert_equal(received[off], file_byte(off),
+			      "Wrong byte at %u", off);
+	}
+}
+
+/* Checks that the ranges were requested in order on the given connection,
+ * starting from the given offset, and returns the next offset.
+ */
+static size_t ranges_check(size_t *req, int conn_id, size_t from, size_t to)
+{
+	for (; *req < req_cnt && reqs[*req].conn == conn_id; (*req)++) {
+		zassert_equal(reqs[*req].from, from, "Wrong range start");
+		zassert_equal(reqs[*req].to, MIN(from + FRAG_SIZE, to) - 1,
+			      "Wrong range end");
+		from += FRAG_SIZE;
+	}
+
+	return from;
+}
+
+static void test_init(void)
+{
+	conn.fd = -1;
+	zassert_equal(download_client_init(&client, callback), 0,
+		      "Failed to initialize");
+}
+
+static void test_https_pipelined(void)
+{
+	size_t req = 0;
+
+	download_reset();
+	download_run(HTTPS_HOST, 0, 0);
+
+	received_check(0, FILE_SIZE);
+	zassert_equal(error_cnt, 0, "Error reported");
+	zassert_equal(conn_cnt, 1, "Reconnected");
+	zassert_equal(req_cnt, DIV_ROUND_UP(FILE_SIZE, FRAG_SIZE),
+		      "Wrong number of requests");
+	ranges_check(&req, 1, 0, FILE_SIZE);
+	zassert_equal(max_in_flight, CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH,
+		      "Requests not pipelined");
+}
+
+/* The server stops answering in the middle of a response. The responses
+ * to the requests in flight never arrive, and the download continues from
+ * the last byte received on a new connection.
+ */
+static void timeout_check(size_t resp, size_t off)
+{
+	size_t stall = resp * FRAG_SIZE + off;
+	size_t req = 0;
+	size_t from;
+
+	download_reset();
+	next_stall = true;
+	next_stall_resp = resp;
+	next_stall_off = off;
+	download_run(HTTPS_HOST, 0, 0);
+
+	received_check(0, FILE_SIZE);
+	zassert_equal(error_cnt, 0, "Error reported");
+	zassert_equal(conn_cnt, 2, "Not reconnected");
+
+	/* Nothing is requested again on the stalled connection */
+	ranges_check(&req, 1, 0, FILE_SIZE);
+	zassert_true(req < req_cnt, "No request on the new connection");
+	zassert_equal(reqs[req].from, stall, "Not resumed from the last byte");
+
+	for (from = stall; req < req_cnt; req++) {
+		zassert_equal(reqs[req].conn, 2, "Wrong connection");
+		zassert_equal(reqs[req].from, from, "Wrong range start");
+		from = reqs[req].to + 1;
+	}
+	zassert_equal(from, FILE_SIZE, "File not requested to the end");
+}
+
+static void test_https_timeout_pipelined(void)
+{
+	/* Several requests are in flight */
+	timeout_check(2, 100);
+}
+
+static void test_https_timeout_last(void)
+{
+	/* Only the last request is in flight */
+	timeout_check(DIV_ROUND_UP(FILE_SIZE, FRAG_SIZE) - 1, 100);
+}
+
+static void test_http(void)
+{
+	download_reset();
+	download_run(HTTP_HOST, 0, 0);
+
+	received_check(0, FILE_SIZE);
+	zassert_equal(error_cnt, 0, "Error reported");
+	zassert_equal(req_cnt, 1, "Wrong number of requests");
+	zassert_equal(reqs[0].from, 0, "Wrong range start");
+	zassert_equal(reqs[0].to, FILE_SIZE - 1, "Wrong range end");
+}
+
+/* Over HTTP, a range larger than a fragment is requested at once */
+static void test_http_range(void)
+{
+	download_reset();
+	download_run(HTTP_HOST, 300, 1500);
+
+	received_check(300, 1500);
+	zassert_equal(error_cnt, 0, "Error reported");
+	zassert_equal(req_cnt, 1, "Wrong number of requests");
+	zassert_equal(reqs[0].from, 300, "Wrong range start");
+	zassert_equal(reqs[0].to, 1499, "Wrong range end");
+}
+
+static void test_https_range(void)
+{
+	size_t req = 0;
+
+	download_reset();
+	download_run(HTTPS_HOST, 300, 1500);
+
+	received_check(300, 1500);
+	zassert_equal(error_cnt, 0, "Error reported");
+	zassert_equal(ranges_check(&req, 1, 300, 1500),
+		      300 + DIV_ROUND_UP(1200, FRAG_SIZE) * FRAG_SIZE,
+		      "Wrong ranges");
+	zassert_equal(req, req_cnt, "Requests on another connection");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(download_client_test,
+		ztest_unit_test(test_init),
+		ztest_unit_test(test_https_pipelined),
+		ztest_unit_test(test_https_timeout_pipelined),
+		ztest_unit_test(test_https_timeout_last),
+		ztest_unit_test(test_http),
+		ztest_unit_test(test_http_range),
+		ztest_unit_test(test_https_range)
+	);
+
+	ztest_run_test_suite(download_client_test);
+}
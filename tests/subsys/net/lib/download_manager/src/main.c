@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <settings/settings.h>
+#include <net/download_client.h>
+#include <net/download_manager.h>
+
+#define FILE_SIZE 4096
+#define RANGE_SIZE CONFIG_DOWNLOAD_MANAGER_RANGE_SIZE
+#define FRAG_SIZE 256
+
+/* Stubs and mocks */
+struct range_start {
+	struct download_client *client;
+	const char *host;
+	size_t from;
+	size_t to;
+};
+
+static struct range_start starts[16];
+static size_t start_cnt;
+static size_t file_size_reported;
+
+static uint8_t sink[FILE_SIZE];
+static size_t sink_next;
+static bool sink_in_order;
+
+static enum download_manager_evt_id last_evt;
+static size_t evt_cnt;
+
+static uint8_t settings_buf[512];
+static size_t settings_len;
+static struct settings_handler *settings_h;
+
+int download_client_init(struct download_client *client,
+			 download_client_callback_t callback)
+{
+	client->fd = -1;
+	client->callback = callback;
+	return 0;
+}
+
+int download_client_connect(struct download_client *client, const char *host,
+			    const struct download_client_cfg *config)
+{
+	client->fd = 1;
+	client->host = host;
+	return 0;
+}
+
+int download_client_disconnect(struct download_client *client)
+{
+	client->fd = -1;
+	return 0;
+}
+
+int download_client_range_start(struct download_client *client,
+				const char *file, size_t from, size_t to)
+{
+	zassert_true(start_cnt < ARRAY_SIZE(starts), "Too many ranges");
+
+	starts[start_cnt++] = (struct range_start){
+		.client = client,
+		.host = client->host,
+		.from = from,
+		.to = to,
+	};
+	return 0;
+}
+
+int download_client_file_size_get(struct download_client *client, size_t *size)
+{
+	*size = file_size_reported;
+	return 0;
+}
+
+int settings_subsys_init(void)
+{
+	return 0;
+}
+
+int settings_register(struct settings_handler *cf)
+{
+	settings_h = cf;
+	return 0;
+}
+
+static ssize_t settings_read(void *cb_arg, void *data, size_t len)
+{
+	len = MIN(len, settings_len);
+	memcpy(data, settings_buf, len);
+	return len;
+}
+
+int settings_load(void)
+{
+	if (settings_len) {
+		return settings_h->h_set("state", settings_len,
+					 settings_read, NULL);
+	}
+	return 0;
+}
+
+int settings_save_one(const char *name, const void *value, size_t val_len)
+{
+	zassert_true(val_len <= sizeof(settings_buf), NULL);
+	memcpy(settings_buf, value, val_len);
+	settings_len = val_len;
+	return 0;
+}
+
+int settings_delete(const char *name)
+{
+	settings_len = 0;
+	return 0;
+}
+
+/* END stubs and mocks */
+
+static int sink_write(size_t offset, const void *buf, size_t len)
+{
+	zassert_true(offset + len <= sizeof(sink), "Write out of bounds");
+	if (sink_in_order) {
+		zassert_equal(offset, sink_next, "Write out of order");
+	}
+
+	memcpy(sink + offset, buf, len);
+	sink_next = offset + len;
+	return 0;
+}
+
+static void manager_callback(const struct download_manager_evt *evt)
+{
+	last_evt = evt->id;
+	evt_cnt++;
+}
+
+static const char *const hosts[] = { "a.example.com", "b.example.com" };
+
+static struct download_manager_cfg cfg = {
+	.hosts = hosts,
+	.host_cnt = ARRAY_SIZE(hosts),
+	.file = "fw.bin",
+	.write = sink_write,
+	.client = {
+		.sec_tag = -1,
+	},
+};
+
+static int fragment_send(const struct range_start *s, size_t from, size_t to)
+{
+	uint8_t buf[FRAG_SIZE];
+	struct download_client_evt evt = {
+		.id = DOWNLOAD_CLIENT_EVT_FRAGMENT,
+		.fragment = {
+			.buf = buf,
+		},
+	};
+	int err;
+
+	for (size_t off = from; off < to; off += evt.fragment.len) {
+		evt.fragment.len = MIN(sizeof(buf), to - off);
+		for (size_t i = 0; i < evt.fragment.len; i++) {
+			buf[i] = (uint8_t)((off + i) * 7);
+		}
+
+		err = s->client->callback(&evt);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static void range_complete(const struct range_start *s)
+{
+	const struct download_client_evt evt = {
+		.id = DOWNLOAD_CLIENT_EVT_DONE,
+	};
+	int err;
+
+	err = fragment_send(s, s->from, s->to);
+	zassert_equal(err, 0, NULL);
+
+	err = s->client->callback(&evt);
+	zassert_equal(err, 0, NULL);
+}
+
+static int error_send(const struct range_start *s, int error)
+{
+	const struct download_client_evt evt = {
+		.id = DOWNLOAD_CLIENT_EVT_ERROR,
+		.error = error,
+	};
+
+	return s->client->callback(&evt);
+}
+
+static void sink_verify(void)
+{
+	for (size_t i = 0; i < FILE_SIZE; i++) {
+		zassert_equal(sink[i], (uint8_t)(i * 7), "Bad data at %d", i);
+	}
+}
+
+static void test_reset(void)
+{
+	memset(starts, 0, sizeof(starts));
+	start_cnt = 0;
+	memset(sink, 0, sizeof(sink));
+	sink_next = 0;
+	evt_cnt = 0;
+	last_evt = DOWNLOAD_MANAGER_EVT_PROGRESS;
+	file_size_reported = FILE_SIZE;
+	settings_len = 0;
+	cfg.file_size = FILE_SIZE;
+	cfg.in_order = false;
+	sink_in_order = false;
+}
+
+static void test_download_manager_init(void)
+{
+	int err;
+
+	err = download_manager_init(manager_callback);
+	zassert_equal(err, 0, NULL);
+}
+
+static void test_download_manager_in_order(void)
+{
+	size_t done = 0;
+	int err;
+
+	test_reset();
+	cfg.in_order = true;
+	sink_in_order = true;
+
+	err = download_manager_start(&cfg);
+	zassert_equal(err, 0, NULL);
+	err = download_manager_start(&cfg);
+	zassert_equal(err, -EALREADY, NULL);
+
+	k_sleep(K_MSEC(50));
+
+	/* One range per connection, on different hosts */
+	zassert_equal(start_cnt, CONFIG_DOWNLOAD_MANAGER_CONN_CNT, NULL);
+	zassert_equal(starts[0].from, 0, NULL);
+	zassert_equal(starts[0].to, RANGE_SIZE, NULL);
+	zassert_equal(starts[1].from, RANGE_SIZE, NULL);
+	zassert_equal(starts[1].to, 2 * RANGE_SIZE, NULL);
+	zassert_not_equal(starts[0].client, starts[1].client, NULL);
+	zassert_not_equal(starts[0].host, starts[1].host, NULL);
+
+	/* The second range arrives first and is held back */
+	range_complete(&starts[1]);
+	zassert_equal(sink_next, 0, "Data written ahead of the sink");
+
+	range_complete(&starts[0]);
+	zassert_equal(sink_next, 2 * RANGE_SIZE, NULL);
+	done = 2;
+
+	while (last_evt != DOWNLOAD_MANAGER_EVT_DONE) {
+		k_sleep(K_MSEC(50));
+		zassert_true(done < start_cnt, "No range started");
+		range_complete(&starts[done++]);
+		k_sleep(K_MSEC(50));
+	}
+
+	zassert_equal(done, FILE_SIZE / RANGE_SIZE, NULL);
+	zassert_equal(sink_next, FILE_SIZE, NULL);
+	zassert_equal(settings_len, 0, "Progress not deleted");
+	sink_verify();
+}
+
+static void test_download_manager_retry(void)
+{
+	size_t done = 0;
+	int err;
+
+	test_reset();
+	/* Let the first range retrieve the file size */
+	cfg.file_size = 0;
+
+	err = download_manager_start(&cfg);
+	zassert_equal(err, 0, NULL);
+
+	k_sleep(K_MSEC(50));
+	zassert_equal(start_cnt, 1, "Started before the file size is known");
+
+	/* The connection is reset once, then fails */
+	err = fragment_send(&starts[0], 0, FRAG_SIZE);
+	zassert_equal(err, 0, NULL);
+	k_sleep(K_MSEC(50));
+	zassert_equal(start_cnt, 2, "File size known, second slot idle");
+
+	err = error_send(&starts[0], -ECONNRESET);
+	zassert_equal(err, 0, "First reset not retried");
+	err = error_send(&starts[0], -ECONNRESET);
+	zassert_not_equal(err, 0, "Retries not limited");
+	k_sleep(K_MSEC(50));
+
+	/* The range resumes where it failed, on the next host */
+	zassert_equal(start_cnt, 3, NULL);
+	zassert_equal(starts[2].from, FRAG_SIZE, NULL);
+	zassert_equal(starts[2].to, RANGE_SIZE, NULL);
+	zassert_not_equal(strcmp(starts[2].host, starts[0].host), 0, NULL);
+
+	for (done = 1; last_evt != DOWNLOAD_MANAGER_EVT_DONE; done++) {
+		zassert_true(done < start_cnt, "No range started");
+		range_complete(&starts[done]);
+		k_sleep(K_MSEC(50));
+	}
+
+	sink_verify();
+}
+
+static void test_download_manager_resume(void)
+{
+	int err;
+
+	test_reset();
+
+	err = download_manager_start(&cfg);
+	zassert_equal(err, 0, NULL);
+	k_sleep(K_MSEC(50));
+
+	/* Complete the second range and half of the first one */
+	range_complete(&starts[1]);
+	err = fragment_send(&starts[0], 0, RANGE_SIZE / 2);
+	zassert_equal(err, 0, NULL);
+
+	err = download_manager_stop();
+	zassert_equal(err, 0, NULL);
+	k_sleep(K_MSEC(50));
+	zassert_not_equal(settings_len, 0, "Progress not stored");
+
+	/* Further data is refused */
+	err = fragment_send(&starts[0], RANGE_SIZE / 2, RANGE_SIZE);
+	zassert_not_equal(err, 0, NULL);
+
+	start_cnt = 0;
+	err = download_manager_start(&cfg);
+	zassert_equal(err, 0, NULL);
+	k_sleep(K_MSEC(50));
+
+	/* Only the missing data is requested */
+	zassert_equal(start_cnt, 2, NULL);
+	zassert_equal(starts[0].from, RANGE_SIZE / 2, NULL);
+	zassert_equal(starts[0].to, RANGE_SIZE, NULL);
+	zassert_equal(starts[1].from, 2 * RANGE_SIZE, NULL);
+
+	download_manager_stop();
+	k_sleep(K_MSEC(50));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lib_download_manager_test,
+	     ztest_unit_test(test_download_manager_init),
+	     ztest_unit_test(test_download_manager_in_order),
+	     ztest_unit_test(test_download_manager_retry),
+	     ztest_unit_test(test_download_manager_resume)
+	 );
+
+	ztest_run_test_suite(lib_download_manager_test);
+}
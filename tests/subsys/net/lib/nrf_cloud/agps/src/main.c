@@ -0,0 +1,456 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <nrf_socket.h>
+#include <modem/modem_info.h>
+#include <net/nrf_cloud_agps.h>
+
+#include "nrf_cloud_transport.h"
+#include "nrf_cloud_agps_schema_v1.h"
+
+#define GNSS_SOCKET 3
+
+/* Size of a GPS system clock element in the A-GPS data. */
+#define SYSTEM_TIME_SIZE (sizeof(struct nrf_cloud_agps_system_time) - \
+	sizeof(((struct nrf_cloud_agps_system_time *)0)->sv_tow) + 4)
+
+#define TOW_COUNT 2
+
+/* Data sent to the modem for each element, in order, with the system time
+ * and time-of-week elements sent last.
+ */
+#define RECORD_COUNT 7
+
+static const nrf_gnss_agps_data_type_t record_types[RECORD_COUNT] = {
+	NRF_GNSS_AGPS_UTC_PARAMETERS,
+	NRF_GNSS_AGPS_EPHEMERIDES,
+	NRF_GNSS_AGPS_EPHEMERIDES,
+	NRF_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION,
+	NRF_GNSS_AGPS_LOCATION,
+	NRF_GNSS_AGPS_INTEGRITY,
+	NRF_GNSS_AGPS_GPS_SYSTEM_CLOCK_AND_TOWS,
+};
+
+struct record {
+	nrf_gnss_agps_data_type_t type;
+	size_t len;
+	union {
+		nrf_gnss_agps_data_utc_t utc;
+		nrf_gnss_agps_data_ephemeris_t ephemeris;
+		nrf_gnss_agps_data_klobuchar_t klobuchar;
+		nrf_gnss_agps_data_location_t location;
+		struct nrf_cloud_agps_integrity integrity;
+		nrf_gnss_agps_data_system_time_and_sv_tow_t time_and_tow;
+	};
+};
+
+static char agps_data[512];
+static size_t agps_len;
+
+/* Data sent to the modem for the complete A-GPS data, and in a test. */
+static struct record expected[RECORD_COUNT];
+static struct record records[RECORD_COUNT + 1];
+static size_t record_count;
+/* Record at which nrf_sendto() fails, or -1. */
+static int send_fail_at = -1;
+
+ssize_t nrf_sendto(int socket, const void *message, size_t length, int flags,
+		   const void *dest_addr, nrf_socklen_t dest_len)
+{
+	struct record *record = &records[record_count];
+
+	zassert_equal(socket, GNSS_SOCKET, "Wrong socket");
+	zassert_equal(dest_len, sizeof(nrf_gnss_agps_data_type_t),
+		      "Wrong type length");
+	zassert_true(record_count < ARRAY_SIZE(records), "Too much data sent");
+	zassert_true(length <= sizeof(record->time_and_tow), "Data too long");
+
+	if ((int)record_count == send_fail_at) {
+		errno = EIO;
+		return -1;
+	}
+
+	memset(record, 0, sizeof(*record));
+	record->type = *(const nrf_gnss_agps_data_type_t *)dest_addr;
+	record->len = length;
+	memcpy(&record->utc, message, length);
+	record_count++;
+
+	return length;
+}
+
+int modem_info_init(void)
+{
+	return -ENOTSUP;
+}
+
+int modem_info_params_init(struct modem_param_info *modem)
+{
+	return -ENOTSUP;
+}
+
+int modem_info_params_get(struct modem_param_info *modem)
+{
+	return -ENOTSUP;
+}
+
+int nct_dc_send(const struct nct_dc_data *dc)
+{
+	return -ENOTSUP;
+}
+
+void agps_print(enum nrf_cloud_agps_type type, void *data)
+{
+}
+
+static void *data_append(const void *data, size_t len)
+{
+	void *start = &agps_data[agps_len];
+
+	zassert_true(agps_len + len <= sizeof(agps_data), "Data too long");
+	memcpy(start, data, len);
+	agps_len += len;
+
+	return start;
+}
+
+/* Appends an array of elements, with the bytes of the elements set to
+ * varying values.
+ */
+static void *array_append(enum nrf_cloud_agps_type type, uint16_t count,
+			  size_t element_size)
+{
+	uint8_t header[NRF_CLOUD_AGPS_BIN_TYPE_SIZE +
+		       NRF_CLOUD_AGPS_BIN_COUNT_SIZE] = {
+		type, count & 0xFF, count >> 8
+	};
+	void *elements;
+
+	data_append(header, sizeof(header));
+	elements = &agps_data[agps_len];
+
+	for (size_t i = 0; i < count * element_size; i++) {
+		uint8_t byte = 3 + 7 * agps_len;
+
+		data_append(&byte, 1);
+	}
+
+	return elements;
+}
+
+static void agps_data_create(void)
+{
+	uint8_t version = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+	struct nrf_cloud_agps_tow_element *tow;
+	struct nrf_cloud_agps_system_time *sys_time;
+
+	agps_len = 0;
+	data_append(&version, sizeof(version));
+	array_append(NRF_CLOUD_AGPS_UTC_PARAMETERS, 1,
+		     sizeof(struct nrf_cloud_agps_utc));
+	array_append(NRF_CLOUD_AGPS_EPHEMERIDES, 2,
+		     sizeof(struct nrf_cloud_agps_ephemeris));
+	array_append(NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION, 1,
+		     sizeof(struct nrf_cloud_agps_klobuchar));
+
+	sys_time = (struct nrf_cloud_agps_system_time *)
+		array_append(NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK, 1,
+			     SYSTEM_TIME_SIZE);
+	sys_time->sv_mask = BIT(0) | BIT(4);
+
+	tow = (struct nrf_cloud_agps_tow_element *)
+		array_append(NRF_CLOUD_AGPS_GPS_TOWS, TOW_COUNT,
+			     sizeof(struct nrf_cloud_agps_tow_element));
+	tow[0].sv_id = 1;
+	tow[1].sv_id = 5;
+
+	array_append(NRF_CLOUD_AGPS_LOCATION, 1,
+		     sizeof(struct nrf_cloud_agps_location));
+	array_append(NRF_CLOUD_AGPS_INTEGRITY, 1,
+		     sizeof(struct nrf_cloud_agps_integrity));
+}
+
+static void records_reset(void)
+{
+	record_count = 0;
+	send_fail_at = -1;
+}
+
+/* Compares the fields of the data sent to the modem, the structures may have
+ * padding.
+ */
+static void record_check(const struct record *r, const struct record *e)
+{
+	zassert_equal(r->type, e->type, "Wrong type");
+	zassert_equal(r->len, e->len, "Wrong length");
+
+	switch (e->type) {
+	case NRF_GNSS_AGPS_UTC_PARAMETERS:
+		zassert_equal(r->utc.a1, e->utc.a1, "Wrong UTC");
+		zassert_equal(r->utc.delta_tlsf, e->utc.delta_tlsf,
+			      "Wrong UTC");
+		break;
+	case NRF_GNSS_AGPS_EPHEMERIDES:
+		zassert_equal(r->ephemeris.sv_id, e->ephemeris.sv_id,
+			      "Wrong ephemeris");
+		zassert_equal(r->ephemeris.sqrt_a, e->ephemeris.sqrt_a,
+			      "Wrong ephemeris");
+		zassert_equal(r->ephemeris.cuc, e->ephemeris.cuc,
+			      "Wrong ephemeris");
+		break;
+	case NRF_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION:
+		zassert_equal(r->klobuchar.alpha0, e->klobuchar.alpha0,
+			      "Wrong Klobuchar");
+		zassert_equal(r->klobuchar.beta3, e->klobuchar.beta3,
+			      "Wrong Klobuchar");
+		break;
+	case NRF_GNSS_AGPS_LOCATION:
+		zassert_equal(r->location.latitude, e->location.latitude,
+			      "Wrong location");
+		zassert_equal(r->location.confidence, e->location.confidence,
+			      "Wrong location");
+		break;
+	case NRF_GNSS_AGPS_INTEGRITY:
+		zassert_equal(r->integrity.integrity_mask,
+			      e->integrity.integrity_mask, "Wrong integrity");
+		break;
+	case NRF_GNSS_AGPS_GPS_SYSTEM_CLOCK_AND_TOWS:
+		zassert_equal(r->time_and_tow.date_day,
+			      e->time_and_tow.date_day, "Wrong time");
+		zassert_equal(r->time_and_tow.sv_mask,
+			      e->time_and_tow.sv_mask, "Wrong time");
+		for (size_t i = 0; i < NRF_CLOUD_AGPS_MAX_SV_TOW; i++) {
+			zassert_equal(r->time_and_tow.sv_tow[i].tlm,
+				      e->time_and_tow.sv_tow[i].tlm,
+				      "Wrong TOW %d", i);
+		}
+		break;
+	default:
+		zassert_unreachable("Unexpected type %d", e->type);
+		break;
+	}
+}
+
+static void records_check(void)
+{
+	zassert_equal(record_count, RECORD_COUNT, "Wrong data sent");
+
+	for (size_t i = 0; i < RECORD_COUNT; i++) {
+		record_check(&records[i], &expected[i]);
+	}
+}
+
+static int chunk_process(size_t offset, size_t len)
+{
+	int socket = GNSS_SOCKET;
+
+	return nrf_cloud_agps_process_chunk(&agps_data[offset], len, offset,
+					    agps_len, &socket);
+}
+
+static void test_agps_process(void)
+{
+	int socket = GNSS_SOCKET;
+	int err;
+
+	agps_data_create();
+	records_reset();
+
+	err = nrf_cloud_agps_process(agps_data, agps_len, &socket);
+	zassert_equal(err, 0, "A-GPS data not processed: %d", err);
+	zassert_equal(record_count, RECORD_COUNT, "Wrong data sent");
+
+	for (size_t i = 0; i < RECORD_COUNT; i++) {
+		zassert_equal(records[i].type, record_types[i],
+			      "Wrong type at %d", i);
+	}
+
+	zassert_not_equal(records[0].utc.a1, 0, "UTC not sent");
+	zassert_not_equal(records[6].time_and_tow.sv_tow[0].tlm, 0,
+			  "TOW not sent");
+	zassert_not_equal(records[6].time_and_tow.sv_tow[4].tlm, 0,
+			  "TOW not sent");
+
+	memcpy(expected, records, sizeof(expected));
+}
+
+/* Splits the data in two chunks at every offset, so items are split at every
+ * byte and chunks end on every item boundary.
+ */
+static void test_agps_chunk_split(void)
+{
+	int err;
+
+	for (size_t split = 1; split < agps_len; split++) {
+		records_reset();
+
+		err = chunk_process(0, split);
+		zassert_equal(err, 0, "First chunk failed at %d: %d", split,
+			      err);
+
+		err = chunk_process(split, agps_len - split);
+		zassert_equal(err, 0, "Second chunk failed at %d: %d", split,
+			      err);
+
+		records_check();
+	}
+}
+
+static void test_agps_chunk_bytes(void)
+{
+	int err;
+
+	records_reset();
+
+	for (size_t offset = 0; offset < agps_len; offset++) {
+		err = chunk_process(offset, 1);
+		zassert_equal(err, 0, "Chunk failed at %d: %d", offset, err);
+	}
+
+	records_check();
+}
+
+static void test_agps_chunk_empty(void)
+{
+	int err;
+
+	records_reset();
+
+	err = chunk_process(0, 0);
+	zassert_equal(err, 0, "Empty chunk failed: %d", err);
+
+	err = chunk_process(0, agps_len / 2);
+	zassert_equal(err, 0, "First chunk failed: %d", err);
+
+	err = chunk_process(agps_len / 2, 0);
+	zassert_equal(err, 0, "Empty chunk failed: %d", err);
+
+	err = chunk_process(agps_len / 2, agps_len - agps_len / 2);
+	zassert_equal(err, 0, "Last chunk failed: %d", err);
+
+	records_check();
+}
+
+static void test_agps_chunk_offset(void)
+{
+	int err;
+
+	records_reset();
+
+	err = chunk_process(10, 10);
+	zassert_equal(err, -EINVAL, "Chunk accepted without start: %d", err);
+
+	err = chunk_process(0, 10);
+	zassert_equal(err, 0, "First chunk failed: %d", err);
+
+	err = chunk_process(11, 10);
+	zassert_equal(err, -EINVAL, "Chunk accepted at wrong offset: %d", err);
+
+	err = chunk_process(10, agps_len - 10);
+	zassert_equal(err, 0, "Last chunk failed: %d", err);
+
+	records_check();
+}
+
+static void test_agps_chunk_abort(void)
+{
+	int err;
+
+	records_reset();
+
+	err = chunk_process(0, agps_len - 1);
+	zassert_equal(err, 0, "First chunk failed: %d", err);
+
+	nrf_cloud_agps_process_abort();
+
+	/* Neither the last element nor the system time is sent. */
+	zassert_equal(record_count, RECORD_COUNT - 2, "Data sent after abort");
+
+	err = chunk_process(agps_len - 1, 1);
+	zassert_equal(err, -EINVAL, "Chunk accepted after abort: %d", err);
+
+	/* The next data is processed again. */
+	records_reset();
+
+	err = chunk_process(0, agps_len);
+	zassert_equal(err, 0, "Data not processed after abort: %d", err);
+
+	records_check();
+}
+
+static void test_agps_chunk_send_failure(void)
+{
+	int err;
+
+	records_reset();
+	send_fail_at = 1;
+
+	err = chunk_process(0, agps_len / 2);
+	zassert_equal(err, -EIO, "Send failure not reported: %d", err);
+
+	err = chunk_process(agps_len / 2, agps_len / 4);
+	zassert_equal(err, -ECANCELED, "Chunk processed after failure: %d",
+		      err);
+
+	err = chunk_process(agps_len / 2 + agps_len / 4,
+			    agps_len - agps_len / 2 - agps_len / 4);
+	zassert_equal(err, -ECANCELED, "Chunk processed after failure: %d",
+		      err);
+	zassert_equal(record_count, 1, "Data sent after failure");
+
+	records_reset();
+
+	err = chunk_process(0, agps_len);
+	zassert_equal(err, 0, "Data not processed after failure: %d", err);
+
+	records_check();
+}
+
+static void test_agps_truncated(void)
+{
+	int socket = GNSS_SOCKET;
+	int err;
+
+	records_reset();
+
+	/* Ends inside the last element */
+	err = nrf_cloud_agps_process(agps_data, agps_len - 1, &socket);
+	zassert_equal(err, -EBADMSG, "Truncated data processed: %d", err);
+}
+
+static void test_agps_is_agps_data(void)
+{
+	zassert_true(nrf_cloud_agps_is_agps_data(agps_data, 1),
+		     "A-GPS data not detected");
+	zassert_false(nrf_cloud_agps_is_agps_data("{\"appId\":\"AGPS\"}", 16),
+		      "JSON detected as A-GPS data");
+	zassert_false(nrf_cloud_agps_is_agps_data(agps_data, 0),
+		      "Empty data detected as A-GPS data");
+	zassert_false(nrf_cloud_agps_is_agps_data(NULL, 0),
+		      "No data detected as A-GPS data");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_agps_test,
+		ztest_unit_test(test_agps_process),
+		ztest_unit_test(test_agps_chunk_split),
+		ztest_unit_test(test_agps_chunk_bytes),
+		ztest_unit_test(test_agps_chunk_empty),
+		ztest_unit_test(test_agps_chunk_offset),
+		ztest_unit_test(test_agps_chunk_abort),
+		ztest_unit_test(test_agps_chunk_send_failure),
+		ztest_unit_test(test_agps_truncated),
+		ztest_unit_test(test_agps_is_agps_data)
+	);
+
+	ztest_run_test_suite(nrf_cloud_agps_test);
+}
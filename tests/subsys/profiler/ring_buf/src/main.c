@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+
+#include "profiler_nordic_ring_buf.h"
+
+#define RING_BUF_SIZE CONFIG_PROFILER_NORDIC_RING_BUFFER_SIZE
+
+static uint8_t record[UINT8_MAX];
+static uint8_t out[RING_BUF_SIZE];
+
+static void record_fill(uint8_t seed, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		record[i] = seed + i;
+	}
+}
+
+/* Verifies that the fetched data holds len byte records with given seeds. */
+static void records_check(const uint8_t *data, size_t size,
+			  uint8_t first_seed, size_t cnt, size_t len)
+{
+	zassert_equal(size, cnt * (len + 1), "Wrong number of bytes fetched");
+
+	for (size_t r = 0; r < cnt; r++) {
+		const uint8_t *rec = &data[r * (len + 1)];
+
+		zassert_equal(rec[0], len, "Wrong record length");
+		for (size_t i = 0; i < len; i++) {
+			zassert_equal(rec[1 + i], (uint8_t)(first_seed + r + i),
+				      "Wrong record data");
+		}
+	}
+}
+
+static void test_put_get(void)
+{
+	zassert_equal(profiler_ring_buf_get(out, sizeof(out)), 0,
+		      "Data in empty buffer");
+
+	for (uint8_t seed = 0; seed < 4; seed++) {
+		record_fill(seed, 10);
+		zassert_true(profiler_ring_buf_put(record, 10),
+			     "Record not stored");
+	}
+	zassert_equal(profiler_ring_buf_used_get(), 4 * 11, "Wrong usage");
+
+	records_check(out, profiler_ring_buf_get(out, sizeof(out)), 0, 4, 10);
+	zassert_equal(profiler_ring_buf_used_get(), 0, "Buffer not empty");
+	zassert_equal(profiler_ring_buf_dropped_get(), 0, "Records dropped");
+}
+
+static void test_get_complete_records(void)
+{
+	record_fill(0, 10);
+	zassert_true(profiler_ring_buf_put(record, 10), "Record not stored");
+	record_fill(1, 10);
+	zassert_true(profiler_ring_buf_put(record, 10), "Record not stored");
+
+	/* Records are never split between two calls. */
+	zassert_equal(profiler_ring_buf_get(out, 10), 0, "Record split");
+	records_check(out, profiler_ring_buf_get(out, 21), 0, 1, 10);
+	records_check(out, profiler_ring_buf_get(out, sizeof(out)), 1, 1, 10);
+}
+
+static void test_wraparound(void)
+{
+	/* Record length that does not divide the buffer size, so the
+	 * records are split at the end of the buffer in all positions.
+	 */
+	const size_t len = 100;
+	const size_t rounds = 8 * RING_BUF_SIZE / (len + 1);
+
+	for (size_t r = 0; r < rounds; r++) {
+		record_fill(2 * r, len);
+		zassert_true(profiler_ring_buf_put(record, len),
+			     "Record not stored");
+		record_fill(2 * r + 1, len);
+		zassert_true(profiler_ring_buf_put(record, len),
+			     "Record not stored");
+
+		records_check(out, profiler_ring_buf_get(out, sizeof(out)),
+			      2 * r, 2, len);
+	}
+
+	zassert_equal(profiler_ring_buf_used_get(), 0, "Buffer not empty");
+	zassert_equal(profiler_ring_buf_dropped_get(), 0, "Records dropped");
+}
+
+static void test_overflow(void)
+{
+	const size_t len = 200;
+	size_t stored = 0;
+
+	record_fill(0, len);
+	while (profiler_ring_buf_put(record, len)) {
+		stored++;
+	}
+
+	zassert_equal(stored, RING_BUF_SIZE / (len + 1), "Wrong capacity");
+	zassert_false(profiler_ring_buf_put(record, len), "Record stored");
+	zassert_equal(profiler_ring_buf_dropped_get(), 2,
+		      "Wrong number of dropped records");
+	zassert_equal(profiler_ring_buf_dropped_get(), 0,
+		      "Dropped records not reset");
+
+	/* Short records still fit into the remaining space. */
+	size_t free_space = RING_BUF_SIZE - profiler_ring_buf_used_get();
+
+	if (free_space > 1) {
+		zassert_true(profiler_ring_buf_put(record, free_space - 1),
+			     "Record not stored");
+	}
+	zassert_equal(profiler_ring_buf_used_get(), RING_BUF_SIZE,
+		      "Buffer not full");
+
+	/* Fetching records releases the space for new records. */
+	zassert_equal(profiler_ring_buf_get(out, len + 1), len + 1,
+		      "Record not fetched");
+	zassert_true(profiler_ring_buf_put(record, len), "Record not stored");
+
+	while (profiler_ring_buf_get(out, sizeof(out))) {
+	}
+	zassert_equal(profiler_ring_buf_used_get(), 0, "Buffer not empty");
+	zassert_equal(profiler_ring_buf_dropped_get(), 0, "Records dropped");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(profiler_ring_buf_test,
+		ztest_unit_test(test_put_get),
+		ztest_unit_test(test_get_complete_records),
+		ztest_unit_test(test_wraparound),
+		ztest_unit_test(test_overflow)
+	);
+
+	ztest_run_test_suite(profiler_ring_buf_test);
+}